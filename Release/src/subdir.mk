@@ -7,6 +7,7 @@ CPP_SRCS += \
 ../src/ActionEffector.cpp \
 ../src/Agent.cpp \
 ../src/Analyser.cpp \
+../src/Assignment.cpp \
 ../src/BaseState.cpp \
 ../src/BasicCommand.cpp \
 ../src/BehaviorAttack.cpp \
@@ -33,6 +34,7 @@ CPP_SRCS += \
 ../src/DecisionTree.cpp \
 ../src/DynamicDebug.cpp \
 ../src/Evaluation.cpp \
+../src/EventLoop.cpp \
 ../src/Formation.cpp \
 ../src/FormationTactics.cpp \
 ../src/Geometry.cpp \
@@ -40,6 +42,7 @@ CPP_SRCS += \
 ../src/InterceptInfo.cpp \
 ../src/InterceptModel.cpp \
 ../src/Kicker.cpp \
+../src/Localization.cpp \
 ../src/Logger.cpp \
 ../src/Net.cpp \
 ../src/NetworkTest.cpp \
@@ -51,12 +54,16 @@ CPP_SRCS += \
 ../src/PlayerState.cpp \
 ../src/Plotter.cpp \
 ../src/PositionInfo.cpp \
+../src/RcgReader.cpp \
+../src/Rollout.cpp \
 ../src/ServerParam.cpp \
 ../src/Simulator.cpp \
 ../src/Strategy.cpp \
 ../src/Tackler.cpp \
 ../src/Thread.cpp \
+../src/ThreadPool.cpp \
 ../src/TimeTest.cpp \
+../src/Tracer.cpp \
 ../src/Trainer.cpp \
 ../src/Types.cpp \
 ../src/UDPSocket.cpp \
@@ -70,6 +77,7 @@ OBJS += \
 ./src/ActionEffector.o \
 ./src/Agent.o \
 ./src/Analyser.o \
+./src/Assignment.o \
 ./src/BaseState.o \
 ./src/BasicCommand.o \
 ./src/BehaviorAttack.o \
@@ -96,6 +104,7 @@ OBJS += \
 ./src/DecisionTree.o \
 ./src/DynamicDebug.o \
 ./src/Evaluation.o \
+./src/EventLoop.o \
 ./src/Formation.o \
 ./src/FormationTactics.o \
 ./src/Geometry.o \
@@ -103,6 +112,7 @@ OBJS += \
 ./src/InterceptInfo.o \
 ./src/InterceptModel.o \
 ./src/Kicker.o \
+./src/Localization.o \
 ./src/Logger.o \
 ./src/Net.o \
 ./src/NetworkTest.o \
@@ -114,12 +124,16 @@ OBJS += \
 ./src/PlayerState.o \
 ./src/Plotter.o \
 ./src/PositionInfo.o \
+./src/RcgReader.o \
+./src/Rollout.o \
 ./src/ServerParam.o \
 ./src/Simulator.o \
 ./src/Strategy.o \
 ./src/Tackler.o \
 ./src/Thread.o \
+./src/ThreadPool.o \
 ./src/TimeTest.o \
+./src/Tracer.o \
 ./src/Trainer.o \
 ./src/Types.o \
 ./src/UDPSocket.o \
@@ -133,6 +147,7 @@ CPP_DEPS += \
 ./src/ActionEffector.d \
 ./src/Agent.d \
 ./src/Analyser.d \
+./src/Assignment.d \
 ./src/BaseState.d \
 ./src/BasicCommand.d \
 ./src/BehaviorAttack.d \
@@ -159,6 +174,7 @@ CPP_DEPS += \
 ./src/DecisionTree.d \
 ./src/DynamicDebug.d \
 ./src/Evaluation.d \
+./src/EventLoop.d \
 ./src/Formation.d \
 ./src/FormationTactics.d \
 ./src/Geometry.d \
@@ -166,6 +182,7 @@ CPP_DEPS += \
 ./src/InterceptInfo.d \
 ./src/InterceptModel.d \
 ./src/Kicker.d \
+./src/Localization.d \
 ./src/Logger.d \
 ./src/Net.d \
 ./src/NetworkTest.d \
@@ -177,12 +194,16 @@ CPP_DEPS += \
 ./src/PlayerState.d \
 ./src/Plotter.d \
 ./src/PositionInfo.d \
+./src/RcgReader.d \
+./src/Rollout.d \
 ./src/ServerParam.d \
 ./src/Simulator.d \
 ./src/Strategy.d \
 ./src/Tackler.d \
 ./src/Thread.d \
+./src/ThreadPool.d \
 ./src/TimeTest.d \
+./src/Tracer.d \
 ./src/Trainer.d \
 ./src/Types.d \
 ./src/UDPSocket.d \
@@ -1241,8 +1241,8 @@ Vector ActionEffector::GetBallVelWithQueuedActions()
 /**
  * 向server发送命令队列中的命令
  * Send commands in queue to server.
- * \param msg if save_server_msg is on and a c-style string is passed to this method, it will record
- *            this string to msg-log as well.
+ * \param msg if save_server_msg or simulator_mode is on and a c-style string is passed to this method,
+ *            the commands are appended to it as well.
  */
 void ActionEffector::SendCommands(char *msg)
 {
@@ -1295,14 +1295,21 @@ void ActionEffector::SendCommands(char *msg)
 		{
 			if (PlayerParam::instance().DynamicDebugMode())
 			{
-				std::cerr << std::endl << command_msg; // 动态调试模式，直接输出命令即可
+				if (PlayerParam::instance().DynamicDebugBenchmark().empty())
+				{
+					std::cerr << std::endl << command_msg; // 动态调试模式，直接输出命令即可
+				}
+			}
+			else if (PlayerParam::instance().SimulatorMode())
+			{
+				// 离线比赛模拟模式，命令通过msg交给Simulator::Match执行
 			}
 			else if (UDPSocket::instance().Send(command_msg) < 0) // 发送命令
 			{
 				PRINT_ERROR("UDPSocket error!");
 			}
 		}
-		if (PlayerParam::instance().SaveServerMessage() && msg != 0) //说明要记录命令信息
+		if ((PlayerParam::instance().SaveServerMessage() || PlayerParam::instance().SimulatorMode()) && msg != 0) //说明要记录命令信息
 		{
 			strcat(msg, command_msg);
 		}
@@ -47,8 +47,11 @@ Agent::Agent(Unum unum, WorldModel *world_model, bool reverse):
 	mpStrategy(0),
 	mpAnalyser(0),
     mpActionEffector(0),
-    mpFormation(0)
+    mpFormation(0),
+	mCurrentBank(0)
 {
+	mActiveBehaviorBank[0].resize(BT_Max, ActiveBehavior(*this, BT_None));
+	mActiveBehaviorBank[1].resize(BT_Max, ActiveBehavior(*this, BT_None));
 }
 
 /**
@@ -56,12 +59,6 @@ Agent::Agent(Unum unum, WorldModel *world_model, bool reverse):
  */
 Agent::~Agent()
 {
-	SetHistoryActiveBehaviors();
-
-	for (int type = BT_None + 1; type < BT_Max; ++type) {
-		delete mLastActiveBehavior[type];
-	}
-
 	delete mpInfoState;
     delete mpFormation;
 	delete mpActionEffector;
@@ -101,12 +98,12 @@ void Agent::SaveActiveBehavior(const ActiveBehavior & beh)
 
 	if (mActiveBehavior[type] != 0) {
 		if (*mActiveBehavior[type] < beh) {
-			delete mActiveBehavior[type];
-			mActiveBehavior[type] = new ActiveBehavior(beh);
+			*mActiveBehavior[type] = beh;
 		}
 	}
 	else {
-		mActiveBehavior[type] = new ActiveBehavior(beh);
+		mActiveBehavior[type] = & mActiveBehaviorBank[mCurrentBank][type];
+		*mActiveBehavior[type] = beh;
 	}
 }
 
@@ -125,9 +122,9 @@ void Agent::SetActiveBehaviorInAct(BehaviorType type)
 	mActiveBehavior[0] = mActiveBehavior[type];
 }
 
-void Agent::SaveActiveBehaviorList(const std::list<ActiveBehavior> & behavior_list)
+void Agent::SaveActiveBehaviorList(const ActiveBehaviorList & behavior_list)
 {
-	for (std::list<ActiveBehavior>::const_iterator it = behavior_list.begin(); it != behavior_list.end(); ++it) {
+	for (ActiveBehaviorList::const_iterator it = behavior_list.begin(); it != behavior_list.end(); ++it) {
 		SaveActiveBehavior(*it);
 	}
 }
@@ -135,13 +132,13 @@ void Agent::SaveActiveBehaviorList(const std::list<ActiveBehavior> & behavior_li
 void Agent::SetHistoryActiveBehaviors()
 {
     for (int type = BT_None + 1; type < BT_Max; ++type) {
-        delete mLastActiveBehavior[type];
-
         mLastActiveBehavior[type] = mActiveBehavior[type];
         mActiveBehavior[type] = 0;
     }
 
     mLastActiveBehavior[0] = mActiveBehavior[0];
     mActiveBehavior[0] = 0;
+
+    mCurrentBank = 1 - mCurrentBank; //上周期的那组存储已经不再被引用，本周期重新使用
 }
 
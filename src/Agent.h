@@ -313,7 +313,7 @@ private:
 
     friend class DecisionTree;
 
-    void SaveActiveBehaviorList(const std::list<ActiveBehavior> & behavior_list);
+    void SaveActiveBehaviorList(const ActiveBehaviorList & behavior_list);
 
     /**
      * 设置本周期实际执行的activebehavior -- excute时设置
@@ -324,6 +324,12 @@ private:
 private:
 	Array<ActiveBehavior*, BT_Max, true> mActiveBehavior;
 	Array<ActiveBehavior*, BT_Max, true> mLastActiveBehavior;
+
+	/**
+	 * 保存activebehavior的两组存储，本周期和上周期各用一组，每周期交换，避免每周期new/delete
+	 */
+	std::vector<ActiveBehavior> mActiveBehaviorBank[2];
+	int mCurrentBank;
 };
 
 #endif /* AGENT_H_ */
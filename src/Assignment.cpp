@@ -0,0 +1,198 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+
+#include "Assignment.h"
+#include "Utilities.h"
+#include <algorithm>
+
+const double Assignment::INF = 1.0e9;
+
+Assignment::Assignment(int rows, int cols):
+	mRows(rows),
+	mCols(cols),
+	mCost(rows * cols, INF)
+{
+	Assert(rows <= cols);
+}
+
+/**
+ * 带势函数的匈牙利算法：逐行加入，每次沿最短增广路调整，
+ * u、v为行和列的势，p[j]为第j列分到的行（下标从1开始，0为虚拟的列）
+ */
+double Assignment::Solve(std::vector<int> & row_to_col) const
+{
+	const int n = mRows;
+	const int m = mCols;
+
+	std::vector<double> u(n + 1, 0.0), v(m + 1, 0.0), min_v(m + 1);
+	std::vector<int> p(m + 1, 0), way(m + 1, 0);
+	std::vector<char> used(m + 1);
+
+	for (int i = 1; i <= n; ++i) {
+		p[0] = i;
+		int j0 = 0;
+		std::fill(min_v.begin(), min_v.end(), INF * 2.0);
+		std::fill(used.begin(), used.end(), 0);
+
+		do {
+			used[j0] = 1;
+			const int i0 = p[j0];
+			const double *cost = &mCost[(i0 - 1) * m];
+			double delta = INF * 2.0;
+			int j1 = 0;
+
+			for (int j = 1; j <= m; ++j) {
+				if (!used[j]) {
+					const double cur = cost[j - 1] - u[i0] - v[j];
+					if (cur < min_v[j]) {
+						min_v[j] = cur;
+						way[j] = j0;
+					}
+					if (min_v[j] < delta) {
+						delta = min_v[j];
+						j1 = j;
+					}
+				}
+			}
+
+			for (int j = 0; j <= m; ++j) {
+				if (used[j]) {
+					u[p[j]] += delta;
+					v[j] -= delta;
+				}
+				else {
+					min_v[j] -= delta;
+				}
+			}
+			j0 = j1;
+		} while (p[j0] != 0);
+
+		do {
+			const int j1 = way[j0];
+			p[j0] = p[j1];
+			j0 = j1;
+		} while (j0 != 0);
+	}
+
+	row_to_col.assign(n, -1);
+	for (int j = 1; j <= m; ++j) {
+		if (p[j] != 0) {
+			row_to_col[p[j] - 1] = j - 1;
+		}
+	}
+
+	double total = 0.0;
+	for (int i = 0; i < n; ++i) {
+		const double cost = Cost(i, row_to_col[i]);
+		if (cost >= INF) {
+			return INF;
+		}
+		total += cost;
+	}
+	return total;
+}
+
+namespace {
+
+/**
+ * Murty方法中的一个子问题及其最优解
+ */
+struct Candidate {
+	Assignment mProblem;
+	std::vector<int> mRowToCol;
+	double mCost;
+
+	Candidate(const Assignment & problem): mProblem(problem), mCost(Assignment::INF) {}
+};
+
+}
+
+/**
+ * Murty方法：把已求出的指派按行拆分成互不相交的子问题——第t个子问题固定前t行的配对、禁止第t行的配对，
+ * 所有子问题的最优解中代价最小的就是下一个指派
+ */
+int Assignment::SolveKBest(int k, std::vector<std::vector<int> > & row_to_cols, std::vector<double> & costs) const
+{
+	row_to_cols.clear();
+	costs.clear();
+
+	std::vector<Candidate> candidates;
+	candidates.push_back(Candidate(*this));
+	candidates.back().mCost = Solve(candidates.back().mRowToCol);
+
+	while ((int)row_to_cols.size() < k && !candidates.empty()) {
+		int best = 0;
+		for (unsigned i = 1; i < candidates.size(); ++i) {
+			if (candidates[i].mCost < candidates[best].mCost) {
+				best = i;
+			}
+		}
+		if (candidates[best].mCost >= INF) {
+			break;
+		}
+
+		const Candidate node = candidates[best];
+		candidates.erase(candidates.begin() + best);
+		row_to_cols.push_back(node.mRowToCol);
+		costs.push_back(node.mCost);
+
+		if ((int)row_to_cols.size() >= k) {
+			break;
+		}
+
+		Assignment problem = node.mProblem;
+		for (int t = 0; t < mRows; ++t) {
+			const int col = node.mRowToCol[t];
+
+			Candidate child(problem);
+			child.mProblem.Cost(t, col) = INF;
+			child.mCost = child.mProblem.Solve(child.mRowToCol);
+			if (child.mCost < INF) {
+				candidates.push_back(child);
+			}
+
+			for (int j = 0; j < mCols; ++j) { //之后的子问题中第t行固定分到col
+				if (j != col) {
+					problem.Cost(t, j) = INF;
+				}
+			}
+			for (int i = 0; i < mRows; ++i) {
+				if (i != t) {
+					problem.Cost(i, col) = INF;
+				}
+			}
+		}
+	}
+
+	return row_to_cols.size();
+}
@@ -0,0 +1,78 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+
+#ifndef __Assignment_H__
+#define __Assignment_H__
+
+#include <vector>
+
+/**
+ * 最小代价指派：n行m列的代价矩阵（n <= m），每一行分到不同的一列，使总代价最小。
+ * 用匈牙利算法求解，时间为O(n^2 m)，与代价的分布无关；不允许的配对用INF表示。
+ * 还可以用Murty方法求出总代价第二小、第三小……的指派，作为备选的假设。
+ * Minimum cost assignment (Hungarian algorithm) with k-best enumeration.
+ */
+class Assignment
+{
+public:
+	static const double INF;
+
+	Assignment(int rows, int cols);
+
+	int Rows() const { return mRows; }
+	int Cols() const { return mCols; }
+
+	double & Cost(int row, int col) { return mCost[row * mCols + col]; }
+	const double & Cost(int row, int col) const { return mCost[row * mCols + col]; }
+
+	/**
+	 * 求最优指派
+	 * @param row_to_col 每一行分到的列
+	 * @return 总代价，不存在不含INF的指派时返回INF
+	 */
+	double Solve(std::vector<int> & row_to_col) const;
+
+	/**
+	 * 求总代价最小的至多k个指派，按代价从小到大排列，第一个就是Solve的结果。
+	 * 每多求一个指派最多需要再求解n次
+	 * @return 求出的指派个数
+	 */
+	int SolveKBest(int k, std::vector<std::vector<int> > & row_to_cols, std::vector<double> & costs) const;
+
+private:
+	int mRows;
+	int mCols;
+	std::vector<double> mCost;
+};
+
+#endif
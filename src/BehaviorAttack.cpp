@@ -38,7 +38,37 @@
 #include "BehaviorPosition.h"
 #include "WorldState.h"
 #include "BehaviorHold.h"
+#include "PositionInfo.h"
+#include "ThreadPool.h"
+#include "Rollout.h"
+#include "Tracer.h"
 
+namespace {
+
+const std::size_t ROLLOUT_CANDIDATES = 3; // 做蒙特卡洛模拟的候选行为数
+
+/**
+ * 在线程池中依次运行一组planner，候选行为放在自己的列表中，由决策线程合并
+ * Runs a group of planners in order on the thread pool, into a private list.
+ */
+class PlannerTask: public ThreadTask
+{
+public:
+	void Add(BehaviorPlannerBase<BehaviorAttackData> *planner) { mPlanners.push_back(planner); }
+
+	void Run() {
+		for (std::vector<BehaviorPlannerBase<BehaviorAttackData>*>::iterator it = mPlanners.begin(); it != mPlanners.end(); ++it) {
+			(*it)->Plan(mBehaviorList);
+		}
+	}
+
+	ActiveBehaviorList mBehaviorList;
+
+private:
+	std::vector<BehaviorPlannerBase<BehaviorAttackData>*> mPlanners;
+};
+
+}
 
 BehaviorAttackPlanner::BehaviorAttackPlanner(Agent & agent): BehaviorPlannerBase<BehaviorAttackData>( agent )
 {
@@ -48,19 +78,30 @@ BehaviorAttackPlanner::~BehaviorAttackPlanner()
 {
 }
 
-void BehaviorAttackPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
+void BehaviorAttackPlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_AttackPlanner);
+
 	if (mSelfState.IsBallCatchable()  && mStrategy.IsLastOppControl() &&(!(mAgent.IsLastActiveBehaviorInActOf(BT_Pass)||mAgent.IsLastActiveBehaviorInActOf(BT_Dribble)))) return;
 
-	BehaviorInterceptPlanner(mAgent).Plan(mActiveBehaviorList);
-	BehaviorShootPlanner(mAgent).Plan(mActiveBehaviorList);
-	BehaviorPassPlanner(mAgent).Plan(mActiveBehaviorList);
-	BehaviorDribblePlanner(mAgent).Plan(mActiveBehaviorList);
-	BehaviorPositionPlanner(mAgent).Plan(mActiveBehaviorList);
-	BehaviorHoldPlanner(mAgent).Plan(mActiveBehaviorList);
+	if (ThreadPool::instance().IsRunning()) {
+		ParallelPlan();
+	}
+	else {
+		BehaviorInterceptPlanner(mAgent).Plan(mActiveBehaviorList);
+		BehaviorShootPlanner(mAgent).Plan(mActiveBehaviorList);
+		BehaviorPassPlanner(mAgent).Plan(mActiveBehaviorList);
+		BehaviorDribblePlanner(mAgent).Plan(mActiveBehaviorList);
+		BehaviorPositionPlanner(mAgent).Plan(mActiveBehaviorList);
+		BehaviorHoldPlanner(mAgent).Plan(mActiveBehaviorList);
+	}
 
 	if (!mActiveBehaviorList.empty()) {
-		mActiveBehaviorList.sort(std::greater<ActiveBehavior>());
+		if (PlayerParam::instance().RolloutCount() > 0) {
+			RolloutTopBehaviors();
+		}
+
+		SelectTopBehaviors(mActiveBehaviorList, mActiveBehaviorList.size());
 		behavior_list.push_back(mActiveBehaviorList.front());
 
 		if (mActiveBehaviorList.size() > 1) { //允许非最优行为提交视觉请求
@@ -73,3 +114,78 @@ void BehaviorAttackPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
 		}
 	}
 }
+
+/**
+ * 并行运行各子planner，合并后的候选行为列表与顺序运行时完全一致：
+ * 1. Intercept、Shoot、Pass共用InterceptInfo、Kicker和Tackler中的缓存，且Pass会改写截球信息，放在同一个任务中按原顺序运行；
+ *    Dribble、Position、Hold只读取本周期的WorldState/InfoState，各自一个任务；
+ * 2. planner的构造和析构会修改Formation，都在决策线程中进行；按需计算的数据在分派前算好；
+ * 3. Position只在之前的planner都没有产生行为时才有效，这里先算出来，合并时再按这个条件取舍。
+ */
+void BehaviorAttackPlanner::ParallelPlan()
+{
+	BehaviorInterceptPlanner intercept_planner(mAgent);
+	BehaviorShootPlanner shoot_planner(mAgent);
+	BehaviorPassPlanner pass_planner(mAgent);
+	BehaviorDribblePlanner dribble_planner(mAgent);
+	BehaviorPositionPlanner position_planner(mAgent);
+	BehaviorHoldPlanner hold_planner(mAgent);
+
+	mPositionInfo.PrecomputeLists();
+	mBallState.GetPredictedPos(MobileState::Predictor::MAX_STEP);
+	mSelfState.GetPredictedPos(MobileState::Predictor::MAX_STEP);
+
+	PlannerTask kick_task;
+	kick_task.Add(&intercept_planner);
+	kick_task.Add(&shoot_planner);
+	kick_task.Add(&pass_planner);
+
+	PlannerTask dribble_task;
+	dribble_task.Add(&dribble_planner);
+
+	PlannerTask position_task;
+	position_task.Add(&position_planner);
+
+	PlannerTask hold_task;
+	hold_task.Add(&hold_planner);
+
+	ThreadPool::instance().Submit(&kick_task); // 最重的任务先提交，由决策线程自己执行
+	ThreadPool::instance().Submit(&dribble_task);
+	ThreadPool::instance().Submit(&position_task);
+	ThreadPool::instance().Submit(&hold_task);
+	ThreadPool::instance().Wait();
+
+	mActiveBehaviorList.insert(mActiveBehaviorList.end(), kick_task.mBehaviorList.begin(), kick_task.mBehaviorList.end());
+	mActiveBehaviorList.insert(mActiveBehaviorList.end(), dribble_task.mBehaviorList.begin(), dribble_task.mBehaviorList.end());
+	if (mActiveBehaviorList.empty()) {
+		mActiveBehaviorList.insert(mActiveBehaviorList.end(), position_task.mBehaviorList.begin(), position_task.mBehaviorList.end());
+	}
+	mActiveBehaviorList.insert(mActiveBehaviorList.end(), hold_task.mBehaviorList.begin(), hold_task.mBehaviorList.end());
+}
+
+/**
+ * 对评价最高的几个候选行为做蒙特卡洛模拟，时间预算在它们之间平分。
+ * 同一组候选的评价都乘以各自模拟出的成功概率，这样各候选中已经考虑的风险在比较时同等对待；
+ * 有候选不能模拟或没有完成模拟时保持原来的评价。模拟后只在这组候选中选择，其余候选没有模拟，不再参与比较
+ */
+void BehaviorAttackPlanner::RolloutTopBehaviors()
+{
+	const std::size_t count = std::min(ROLLOUT_CANDIDATES, mActiveBehaviorList.size());
+	SelectTopBehaviors(mActiveBehaviorList, count);
+
+	for (std::size_t i = 0; i < count; ++i) {
+		if (!Rollout::IsSupported(mActiveBehaviorList[i])) return;
+	}
+
+	double success[ROLLOUT_CANDIDATES];
+	for (std::size_t i = 0; i < count; ++i) {
+		RolloutResult result = Rollout::instance().Evaluate(mActiveBehaviorList[i], PlayerParam::instance().RolloutCount(), PlayerParam::instance().RolloutBudget() / int(count));
+		if (result.mCount == 0) return;
+		success[i] = result.mSuccess;
+	}
+
+	for (std::size_t i = 0; i < count; ++i) {
+		mActiveBehaviorList[i].mEvaluation *= success[i];
+	}
+	mActiveBehaviorList.erase(mActiveBehaviorList.begin() + count, mActiveBehaviorList.end());
+}
@@ -40,7 +40,11 @@ public:
 	BehaviorAttackPlanner(Agent & agent);
 	virtual ~BehaviorAttackPlanner();
 
-	void Plan(std::list<ActiveBehavior> & behavior_list);
+	void Plan(ActiveBehaviorList & behavior_list);
+
+private:
+	void ParallelPlan();
+	void RolloutTopBehaviors();
 };
 
 #endif /* BEHAVIORATTACK_H_ */
@@ -37,6 +37,65 @@
 #include "Strategy.h"
 #include "Analyser.h"
 #include "Logger.h"
+#include "Thread.h"
+#include <algorithm>
+
+BehaviorArena::BehaviorArena():
+	mBuffer(new char[ARENA_SIZE]),
+	mUsed(0)
+{
+}
+
+BehaviorArena::~BehaviorArena()
+{
+	delete [] mBuffer;
+}
+
+BehaviorArena & BehaviorArena::instance()
+{
+	static BehaviorArena behavior_arena;
+	return behavior_arena;
+}
+
+void *BehaviorArena::Allocate(std::size_t size)
+{
+	std::size_t aligned = (size + 15) & ~std::size_t(15);
+	std::size_t offset = AtomicAdd(&mUsed, aligned);
+
+	if (offset + aligned <= ARENA_SIZE) {
+		return mBuffer + offset;
+	}
+	return ::operator new(size); //本周期用完了
+}
+
+void BehaviorArena::Deallocate(void *p)
+{
+	char *c = static_cast<char *>(p);
+
+	if (c < mBuffer || c >= mBuffer + ARENA_SIZE) {
+		::operator delete(p);
+	}
+}
+
+void BehaviorArena::Reset()
+{
+	mUsed = 0;
+}
+
+void SelectTopBehaviors(ActiveBehaviorList & behavior_list, std::size_t k)
+{
+	k = std::min(k, behavior_list.size());
+
+	for (std::size_t i = 0; i < k; ++i) {
+		ActiveBehaviorPtr best = behavior_list.begin() + i;
+		for (ActiveBehaviorPtr it = best + 1; it != behavior_list.end(); ++it) {
+			if (*it > *best) {
+				best = it;
+			}
+		}
+		std::rotate(behavior_list.begin() + i, best, best + 1);
+	}
+}
 
 BehaviorAttackData::BehaviorAttackData(Agent & agent):
 	mAgent ( agent ),
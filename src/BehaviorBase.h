@@ -35,6 +35,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 #include "Geometry.h"
 #include "ActionEffector.h"
 #include "Formation.h"
@@ -192,6 +193,88 @@ public:
 	double mBuffer; //有些行为执行时的buffer是在plan时算好的，要先存到这个变量里
 };
 
+/**
+ * 行为候选的内存池，从一块连续内存中顺序分配，每周期决策结束后（Player::Run最后）一次性全部释放。
+ * 可以被并行的planner同时分配；用完时退回到operator new。
+ * Per-cycle bump allocator for behavior candidates, reset in one shot at the end of Player::Run.
+ */
+class BehaviorArena {
+	BehaviorArena();
+
+public:
+	~BehaviorArena();
+
+	static BehaviorArena & instance();
+
+	void *Allocate(std::size_t size);
+	void Deallocate(void *p);
+
+	/**
+	 * 释放本周期分配的所有内存，调用时不能有候选列表还在使用
+	 */
+	void Reset();
+
+private:
+	enum {
+		ARENA_SIZE = 1024 * 1024
+	};
+
+	char *mBuffer;
+	volatile std::size_t mUsed;
+};
+
+template <typename _Tp>
+class ArenaAllocator {
+public:
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef _Tp * pointer;
+	typedef const _Tp * const_pointer;
+	typedef _Tp & reference;
+	typedef const _Tp & const_reference;
+	typedef _Tp value_type;
+
+	template <typename _Tp1>
+	struct rebind {
+		typedef ArenaAllocator<_Tp1> other;
+	};
+
+	ArenaAllocator() {}
+	ArenaAllocator(const ArenaAllocator &) {}
+	template <typename _Tp1>
+	ArenaAllocator(const ArenaAllocator<_Tp1> &) {}
+
+	pointer address(reference x) const { return &x; }
+	const_pointer address(const_reference x) const { return &x; }
+
+	pointer allocate(size_type n, const void * = 0) {
+		return static_cast<pointer>(BehaviorArena::instance().Allocate(n * sizeof(_Tp)));
+	}
+	void deallocate(pointer p, size_type) { BehaviorArena::instance().Deallocate(p); }
+
+	size_type max_size() const { return std::size_t(-1) / sizeof(_Tp); }
+
+	void construct(pointer p, const _Tp & val) { ::new((void *)p) _Tp(val); }
+	void destroy(pointer p) { p->~_Tp(); }
+
+	bool operator==(const ArenaAllocator &) const { return true; }
+	bool operator!=(const ArenaAllocator &) const { return false; }
+};
+
+/**
+ * 行为候选列表，存放在BehaviorArena中，不能跨周期保存
+ */
+typedef std::vector<ActiveBehavior, ArenaAllocator<ActiveBehavior> > ActiveBehaviorList;
+typedef ActiveBehaviorList::iterator ActiveBehaviorPtr;
+
+/**
+ * 把评价最高的k个行为按评价从高到低移到列表前面，其余行为的相对顺序不变，
+ * 结果与稳定排序后的前k个相同（评价相同时先加入的在前）。只需要最优行为时k取1即可，不必全排序
+ * @param behavior_list
+ * @param k
+ */
+void SelectTopBehaviors(ActiveBehaviorList & behavior_list, std::size_t k);
+
 class BehaviorAttackData {
 public:
 	BehaviorAttackData(Agent & agent);
@@ -231,15 +314,15 @@ public:
 	/**
 	* 做决策，产生最好的ActiveBehavior，存到behavior_list里面
 	*/
-	virtual void Plan(std::list<ActiveBehavior> & behavior_list) = 0;
+	virtual void Plan(ActiveBehaviorList & behavior_list) = 0;
 
 public:
-	const std::list<ActiveBehavior> & GetActiveBehaviorList() {
+	const ActiveBehaviorList & GetActiveBehaviorList() {
 		return mActiveBehaviorList;
 	}
 
 protected:
-	std::list<ActiveBehavior> mActiveBehaviorList; // record the active behaviors for each high level behavior
+	ActiveBehaviorList mActiveBehaviorList; // record the active behaviors for each high level behavior
 };
 
 class BehaviorExecutable {
@@ -297,9 +380,6 @@ public:
 };
 
 
-typedef std::list<ActiveBehavior> ActiveBehaviorList;
-typedef std::list<ActiveBehavior>::iterator ActiveBehaviorPtr;
-
 #define TeammateFormationTactic(TacticName) (*(FormationTactic##TacticName *)mFormation.GetTeammateTactic(FTT_##TacticName))
 #define OpponentFormationTactic(TacticName) (*(FormationTactic##TacticName *)mFormation.GetOpponentTactic(FTT_##TacticName))
 
@@ -40,6 +40,7 @@
 #include "PositionInfo.h"
 #include "Logger.h"
 #include "Evaluation.h"
+#include "Tracer.h"
 
 const BehaviorType BehaviorBlockExecuter::BEHAVIOR_TYPE = BT_Block;
 
@@ -74,8 +75,10 @@ BehaviorBlockPlanner::~BehaviorBlockPlanner()
 {
 }
 
-void BehaviorBlockPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
+void BehaviorBlockPlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_BlockPlanner);
+
 	Unum closest_tm = mPositionInfo.GetClosestTeammateToBall();
 	if(mWorldState.GetPlayMode() >= PM_Opp_Corner_Kick &&
 			mWorldState.GetPlayMode() <=PM_Opp_Offside_Kick){
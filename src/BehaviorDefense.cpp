@@ -40,6 +40,7 @@
 #include "Dasher.h"
 #include "Logger.h"
 #include "BehaviorIntercept.h"
+#include "Tracer.h"
 
 BehaviorDefensePlanner::BehaviorDefensePlanner(Agent & agent): BehaviorPlannerBase <BehaviorDefenseData>( agent )
 {
@@ -49,14 +50,16 @@ BehaviorDefensePlanner::~BehaviorDefensePlanner()
 {
 }
 
-void BehaviorDefensePlanner::Plan(std::list<ActiveBehavior> & behavior_list)
+void BehaviorDefensePlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_DefensePlanner);
+
 	BehaviorFormationPlanner(mAgent).Plan(behavior_list);
 	BehaviorBlockPlanner(mAgent).Plan(behavior_list);
 	BehaviorMarkPlanner(mAgent).Plan(behavior_list);
 
 	if (!mActiveBehaviorList.empty()) {
-		mActiveBehaviorList.sort(std::greater<ActiveBehavior>());
+		SelectTopBehaviors(mActiveBehaviorList, mActiveBehaviorList.size());
 		behavior_list.push_back(mActiveBehaviorList.front());
 
 		if (mActiveBehaviorList.size() > 1) { //允许非最优行为提交视觉请求
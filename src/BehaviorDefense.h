@@ -42,7 +42,7 @@ public:
 	BehaviorDefensePlanner(Agent & agent);
 	virtual ~BehaviorDefensePlanner();
 
-	void Plan(std::list<ActiveBehavior> & behavior_list);
+	void Plan(ActiveBehaviorList & behavior_list);
 };
 
 #endif /* BEHAVIORDEFENSE_H_ */
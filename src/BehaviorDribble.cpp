@@ -46,6 +46,7 @@
 #include <vector>
 #include <utility>
 #include "Evaluation.h"
+#include "Tracer.h"
 #include <cmath>
 
 
@@ -142,12 +143,16 @@ BehaviorDribblePlanner::~BehaviorDribblePlanner(void)
 }
 
 
-void BehaviorDribblePlanner::Plan(std::list<ActiveBehavior> & behavior_list)
+void BehaviorDribblePlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_DribblePlanner);
+
 	if (!mSelfState.IsKickable()) return;
 	if (mStrategy.IsForbidenDribble()) return;
 	if (mSelfState.IsGoalie()) return;
 
+	mActiveBehaviorList.reserve(144); //两种带球各72个方向
+
 	for (AngleDeg dir = -90.0; dir < 90.0; dir += 2.5) {
 		ActiveBehavior dribble(mAgent, BT_Dribble, BDT_Dribble_Normal);
 
@@ -198,9 +203,15 @@ void BehaviorDribblePlanner::Plan(std::list<ActiveBehavior> & behavior_list)
 		if(!ok){
 			continue;
 		}
-		dribble.mEvaluation = 0;
+		Vector path[8];
+		double evaluation[8];
 		for (int i = 1; i <= 8; ++i) {
-			dribble.mEvaluation += Evaluation::instance().EvaluatePosition(mBallState.GetPos() + Polar2Vector(dribble.mKickSpeed * i, dribble.mAngle), true);
+			path[i - 1] = mBallState.GetPos() + Polar2Vector(dribble.mKickSpeed * i, dribble.mAngle);
+		}
+		Evaluation::instance().EvaluatePositions(path, 8, true, evaluation);
+		dribble.mEvaluation = 0;
+		for (int i = 0; i < 8; ++i) {
+			dribble.mEvaluation += evaluation[i];
 		}
 		dribble.mEvaluation /= 8;
 		dribble.mTarget = target;
@@ -209,7 +220,7 @@ void BehaviorDribblePlanner::Plan(std::list<ActiveBehavior> & behavior_list)
 	}
 
 	if (!mActiveBehaviorList.empty()) {
-		mActiveBehaviorList.sort(std::greater<ActiveBehavior>());
+		SelectTopBehaviors(mActiveBehaviorList, 1);
 		behavior_list.push_back(mActiveBehaviorList.front());
 	}
 }
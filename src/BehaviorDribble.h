@@ -63,7 +63,7 @@ public:
     BehaviorDribblePlanner(Agent & agent);
     virtual ~BehaviorDribblePlanner(void);
 
-    void Plan(std::list<ActiveBehavior> & behavior_list);
+    void Plan(ActiveBehaviorList & behavior_list);
 };
 
 
@@ -41,6 +41,7 @@
 #include "Logger.h"
 #include <cstdlib>
 #include "Evaluation.h"
+#include "Tracer.h"
 
 const BehaviorType BehaviorFormationExecuter::BEHAVIOR_TYPE = BT_Formation;
 
@@ -75,8 +76,10 @@ BehaviorFormationPlanner::~BehaviorFormationPlanner()
 {
 }
 
-void BehaviorFormationPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
+void BehaviorFormationPlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_FormationPlanner);
+
 	ActiveBehavior formation(mAgent, BT_Formation);
 
 	formation.mBuffer = 1.0;
@@ -51,7 +51,7 @@ public:
 	BehaviorFormationPlanner(Agent & agent);
 	virtual ~BehaviorFormationPlanner();
 
-	void Plan(std::list<ActiveBehavior> & behavior_list);
+	void Plan(ActiveBehaviorList & behavior_list);
 };
 
 #endif /* BEHAVIORFORMATION_H_ */
@@ -35,6 +35,7 @@
 #include "TimeTest.h"
 #include "Utilities.h"
 #include "Evaluation.h"
+#include "Tracer.h"
 
 const BehaviorType BehaviorGoalieExecuter::BEHAVIOR_TYPE = BT_Goalie;
 
@@ -74,8 +75,10 @@ BehaviorGoalieExecuter::~BehaviorGoalieExecuter(void)
 {
 }
 
-void BehaviorGoaliePlanner::Plan(std::list<ActiveBehavior>& behavior_list)
+void BehaviorGoaliePlanner::Plan(ActiveBehaviorList& behavior_list)
 {
+	TRACE_SPAN(TS_GoaliePlanner);
+
 	if(mAgent.IsLastActiveBehaviorInActOf(BT_Pass) || mAgent.IsLastActiveBehaviorInActOf(BT_Dribble))
 		return;
 
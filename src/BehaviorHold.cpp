@@ -37,6 +37,7 @@
 #include <vector>
 #include <utility>
 #include "Evaluation.h"
+#include "Tracer.h"
 
 
 
@@ -80,8 +81,10 @@ BehaviorHoldPlanner::~BehaviorHoldPlanner(void)
 }
 
 
-void BehaviorHoldPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
+void BehaviorHoldPlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_HoldPlanner);
+
 	if (!mSelfState.IsKickable()) return;
 	if (mSelfState.IsGoalie()) return;
 	if(mStrategy.GetSureOppInterCycle() <= 2 &&
@@ -126,7 +129,7 @@ void BehaviorHoldPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
 		}
 
 		if (!mActiveBehaviorList.empty()) {
-			mActiveBehaviorList.sort(std::greater<ActiveBehavior>());
+			SelectTopBehaviors(mActiveBehaviorList, 1);
 			behavior_list.push_back(mActiveBehaviorList.front());
 		}
 	}
@@ -42,6 +42,7 @@
 #include "BehaviorDribble.h"
 #include "Evaluation.h"
 #include "BehaviorBase.h"
+#include "Tracer.h"
 
 using namespace std;
 
@@ -73,8 +74,10 @@ BehaviorInterceptPlanner::BehaviorInterceptPlanner(Agent & agent): BehaviorPlann
 BehaviorInterceptPlanner::~BehaviorInterceptPlanner() {
 }
 
-void BehaviorInterceptPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
+void BehaviorInterceptPlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_InterceptPlanner);
+
 	if (mSelfState.IsKickable()) return;
 	PlayMode play_mode = mWorldState.GetPlayMode();
 	if ( play_mode != PM_Play_On &&
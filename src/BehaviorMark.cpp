@@ -40,6 +40,7 @@
 #include "PositionInfo.h"
 #include "Logger.h"
 #include "Evaluation.h"
+#include "Tracer.h"
 
 const BehaviorType BehaviorMarkExecuter::BEHAVIOR_TYPE = BT_Mark;
 
@@ -74,8 +75,10 @@ BehaviorMarkPlanner::~BehaviorMarkPlanner()
 {
 }
 
-void BehaviorMarkPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
+void BehaviorMarkPlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_MarkPlanner);
+
 	Unum closest_opp = mPositionInfo.GetClosestOpponentToTeammate(mSelfState.GetUnum());
 	Unum closest_tm = mPositionInfo.GetClosestTeammateToOpponent(closest_opp);
 
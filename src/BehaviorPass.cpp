@@ -47,6 +47,7 @@
 #include "CommunicateSystem.h"
 #include "TimeTest.h"
 #include "Evaluation.h"
+#include "Tracer.h"
 
 #include <sstream>
 using namespace std;
@@ -95,8 +96,10 @@ BehaviorPassPlanner::~BehaviorPassPlanner(void)
 {
 }
 
-void BehaviorPassPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
+void BehaviorPassPlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_PassPlanner);
+
 	if (!mSelfState.IsKickable()) return;
 
 	const std::vector<Unum> & tm2ball = mPositionInfo.GetCloseTeammateToTeammate(mSelfState.GetUnum());
@@ -142,7 +145,7 @@ void BehaviorPassPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
 		mActiveBehaviorList.push_back(pass);
 	}
 	if (!mActiveBehaviorList.empty()) {
-		mActiveBehaviorList.sort(std::greater<ActiveBehavior>());
+		SelectTopBehaviors(mActiveBehaviorList, 1);
 		if(mActiveBehaviorList.front().mDetailType == BDT_Pass_Clear){
 			mActiveBehaviorList.front().mEvaluation = 1.0 + FLOAT_EPS;
 		}
@@ -168,27 +171,39 @@ void BehaviorPassPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
 				}
 				else
 					SimBall.UpdateVel(Polar2Vector(Max(Tackler::instance().GetBallVelAfterTackle(mAgent,dir).Mod(), Kicker::instance().GetMaxSpeed(mAgent,mSelfState.GetBodyDir() + dir,1)),mSelfState.GetBodyDir() + dir),0,1.0);
+				PlayerInterceptInfo* tm_info[TEAMSIZE];
+				Unum tm_unum[TEAMSIZE];
+				int tm_count = 0;
 				for(int i = 2 ; i <= 11 ; i ++){
 					if(fabs((mWorldState.GetTeammate(i).GetPos() - mSelfState.GetPos()).Dir() - dir) > 45 ){
 						continue;
 					}
 					if(!mWorldState.GetPlayer(i).IsAlive()){continue;}
-					PlayerInterceptInfo* a = mInterceptInfo.GetPlayerInterceptInfo(i);
-					mInterceptInfo.CalcTightInterception(SimBall,a,true);
+					tm_unum[tm_count] = i;
+					tm_info[tm_count++] = mInterceptInfo.GetPlayerInterceptInfo(i);
+				}
+				mInterceptInfo.CalcTightInterception(SimBall,tm_info,tm_count,true); //模拟的球对这些队友一起求解
+				for(int k = 0 ; k < tm_count ; k++){
+					PlayerInterceptInfo* a = tm_info[k];
 					if(MinTmInter > (*a).mMinCycle){
-						MinTm= i;
+						MinTm= tm_unum[k];
 						MinTmInter = (*a).mMinCycle;
 						MinTmPos = (*a).mInterPos;
 					}
 				}
+				PlayerInterceptInfo* opp_info[TEAMSIZE];
+				int opp_count = 0;
 				for(int i = 1 ; i <= 11 ; i++){
 					if(fabs((mWorldState.GetOpponent(i).GetPos() - mSelfState.GetPos()).Dir() - dir) > 45 ){
 						continue;
 					}
-					PlayerInterceptInfo* a = mInterceptInfo.GetPlayerInterceptInfo(-i);
-					mInterceptInfo.CalcTightInterception(SimBall,a,true);
-					if(MinOppInter > (*a).mMinCycle){
-						MinOppInter = (*a).mMinCycle;
+					if(!mWorldState.GetPlayer(-i).IsAlive()){continue;}
+					opp_info[opp_count++] = mInterceptInfo.GetPlayerInterceptInfo(-i);
+				}
+				mInterceptInfo.CalcTightInterception(SimBall,opp_info,opp_count,true);
+				for(int k = 0 ; k < opp_count ; k++){
+					if(MinOppInter > (*opp_info[k]).mMinCycle){
+						MinOppInter = (*opp_info[k]).mMinCycle;
 					}
 				}
 				if(MinOppInter > MinTmInter){
@@ -208,7 +223,7 @@ void BehaviorPassPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
 				}
 			}
 			if (!mActiveBehaviorList.empty()) {
-				mActiveBehaviorList.sort(std::greater<ActiveBehavior>());
+				SelectTopBehaviors(mActiveBehaviorList, 1);
 				behavior_list.push_back(mActiveBehaviorList.front());
 			}
 		}
@@ -40,6 +40,7 @@
 #include "Kicker.h"
 #include "Dasher.h"
 #include "VisualSystem.h"
+#include "Tracer.h"
 
 const BehaviorType BehaviorPenaltyExecuter::BEHAVIOR_TYPE = BT_Penalty;
 
@@ -131,8 +132,10 @@ BehaviorPenaltyPlanner::~BehaviorPenaltyPlanner()
 }
 
 //==============================================================================
-void BehaviorPenaltyPlanner::Plan(std::list<ActiveBehavior> &behaviorlist)
+void BehaviorPenaltyPlanner::Plan(ActiveBehaviorList &behaviorlist)
 {
+	TRACE_SPAN(TS_PenaltyPlanner);
+
 	ActiveBehavior penaltyKO(mAgent, BT_Penalty);
 
     if (mSelfState.IsGoalie())
@@ -41,6 +41,7 @@
 #include "TimeTest.h"
 #include <sstream>
 #include "Evaluation.h"
+#include "Tracer.h"
 
 
 using namespace std;
@@ -81,6 +82,8 @@ BehaviorPositionPlanner::BehaviorPositionPlanner(Agent &agent) :
 
 void BehaviorPositionPlanner::Plan(ActiveBehaviorList &behavior_list)
 {
+	TRACE_SPAN(TS_PositionPlanner);
+
 	if (!behavior_list.empty()) return;
 
 	if (mSelfState.IsGoalie()) return;
@@ -42,6 +42,7 @@
 #include "BehaviorIntercept.h"
 #include "Evaluation.h"
 #include "Utilities.h"
+#include "Tracer.h"
 #include <stdio.h>
 #include <algorithm>
 using namespace std;
@@ -103,8 +104,10 @@ BehaviorSetplayPlanner::~BehaviorSetplayPlanner(void)
 {
 }
 
-void BehaviorSetplayPlanner::Plan(std::list<ActiveBehavior> & behavior_list)
+void BehaviorSetplayPlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_SetplayPlanner);
+
 	ActiveBehavior setplay(mAgent, BT_Setplay);
 
 	setplay.mBuffer = 0.5;
@@ -47,6 +47,7 @@
 #include "PositionInfo.h"
 #include "Geometry.h"
 #include "BehaviorBase.h"
+#include "Tracer.h"
 
 using namespace std;
 
@@ -105,8 +106,10 @@ BehaviorShootPlanner::~BehaviorShootPlanner()
  * Plan.
  * None or one ActiveBehavior will be push back to behavior_list.
  */
-void BehaviorShootPlanner::Plan(list<ActiveBehavior> & behavior_list)
+void BehaviorShootPlanner::Plan(ActiveBehaviorList & behavior_list)
 {
+	TRACE_SPAN(TS_ShootPlanner);
+
 	if (!mSelfState.IsKickable()) return;
 
 	if (mWorldState.GetPlayMode() == PM_Our_Foul_Charge_Kick ||
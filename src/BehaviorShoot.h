@@ -66,7 +66,7 @@ public:
 	BehaviorShootPlanner(Agent & agent);
 	virtual ~BehaviorShootPlanner();
 
-	void Plan(std::list<ActiveBehavior> & behavior_list);
+	void Plan(ActiveBehaviorList & behavior_list);
 };
 
 #endif /* BehaviorShoot_H_ */
@@ -48,7 +48,51 @@
 #include "TimeTest.h"
 #include "VisualSystem.h"
 #include "InterceptModel.h"
+#include "Net.h"
 #include "Plotter.h"
+#include "Simulator.h"
+#include "Tracer.h"
+#include "EventLoop.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace {
+/**
+ * 解析一条消息并累计解析耗时（微秒），离线模拟时用来评估解析器的性能
+ */
+void TimedParse(Parser *parser, char *msg, long & usec, int & count)
+{
+	RealTime begin = GetRealTime();
+	parser->Parse(msg);
+	usec += RealTime(GetRealTime()).Sub(begin);
+	++count;
+}
+
+/**
+ * 输出某一阶段每周期耗时（微秒）的分布
+ */
+void PrintLatency(const char *stage, std::vector<long> & costs)
+{
+	if (costs.empty()) {
+		return;
+	}
+
+	std::sort(costs.begin(), costs.end());
+
+	double sum = 0.0;
+	for (std::vector<long>::const_iterator it = costs.begin(); it != costs.end(); ++it) {
+		sum += *it;
+	}
+
+	const int n = costs.size();
+	std::cout << std::setw(10) << stage
+			<< std::setw(10) << sum / n
+			<< std::setw(10) << costs[(n - 1) * 50 / 100]
+			<< std::setw(10) << costs[(n - 1) * 99 / 100]
+			<< std::setw(10) << costs.back() << std::endl;
+}
+}
 
 Client::Client() {
 	srand(time(0)); //global srand once
@@ -56,6 +100,7 @@ Client::Client() {
 
 	/** Observer and World Model */
 	mpAgent         = 0;
+	mpEventLoop     = 0;
     mpObserver      = new Observer;
 	mpWorldModel    = new WorldModel;
 
@@ -65,6 +110,7 @@ Client::Client() {
 
 	TimeTest::instance();
     NetworkTest::instance();
+    Tracer::instance();
     DynamicDebug::instance();
     Logger::instance().Initial(mpObserver, &(mpWorldModel->World(false)));
     Plotter::instance();
@@ -95,12 +141,15 @@ Client::Client() {
 
 	mpParser        = new Parser(mpObserver);
 
+	mUpdateCost     = 0;
+	mDecisionCost   = 0;
 }
 
 Client::~Client()
 {  
 	delete mpCommandSender;
 	delete mpParser;
+	delete mpEventLoop;
 
 	delete mpObserver;
 	delete mpWorldModel;
@@ -149,17 +198,104 @@ void Client::RunDynamicDebug()
 	}
 }
 
+void Client::RunDynamicDebugBenchmark()
+{
+	static char msg[MAX_MESSAGE];
+	Tracer::instance().SetThreadName("Main"); // 解析、决策和发送命令都在这个线程中
+	DynamicDebug::instance().Initial(mpObserver);
+
+	if (!DynamicDebug::instance().Load(PlayerParam::instance().DynamicDebugBenchmark().c_str(), msg)) {
+		return;
+	}
+	mpParser->ParseInitializeMsg(msg);
+
+	ConstructAgent();
+
+	enum { STAGE_PARSE, STAGE_UPDATE, STAGE_DECISION, STAGE_SEND, STAGE_TOTAL, STAGE_MAX };
+	const char *stage_names[STAGE_MAX] = { "parse", "update", "decision", "send", "total" };
+	std::vector<long> costs[STAGE_MAX];
+	long cycle_cost[STAGE_MAX] = { 0, 0, 0, 0, 0 };
+
+	MessageType msg_type;
+	bool first_parse = true;
+	RealTime begin = GetRealTime();
+
+	while ((msg_type = DynamicDebug::instance().GetMessage(msg)) != MT_Null)
+	{
+		RealTime stage_begin = GetRealTime();
+
+		switch (msg_type)
+		{
+		case MT_Parse:
+			if (first_parse) {
+				mpObserver->Reset();
+				first_parse = false;
+			}
+			mpParser->Parse(msg);
+			cycle_cost[STAGE_PARSE] += RealTime(GetRealTime()).Sub(stage_begin);
+			break;
+		case MT_Run:
+			Run();
+			Logger::instance().Flush(); //flush log
+			mpObserver->SetPlanned();
+			cycle_cost[STAGE_UPDATE] = mUpdateCost;
+			cycle_cost[STAGE_DECISION] = mDecisionCost;
+			break;
+		case MT_Send:
+			mpCommandSender->Run();
+			cycle_cost[STAGE_SEND] = RealTime(GetRealTime()).Sub(stage_begin);
+			cycle_cost[STAGE_TOTAL] = cycle_cost[STAGE_PARSE] + cycle_cost[STAGE_UPDATE] + cycle_cost[STAGE_DECISION] + cycle_cost[STAGE_SEND];
+
+			for (int i = 0; i < STAGE_MAX; ++i) {
+				costs[i].push_back(cycle_cost[i]);
+				cycle_cost[i] = 0;
+			}
+			first_parse = true;
+			break;
+		default:
+			break;
+		}
+	}
+
+	std::cout << PlayerParam::instance().DynamicDebugBenchmark() << ": " << costs[STAGE_TOTAL].size() << " cycles replayed in "
+			<< (RealTime(GetRealTime()) - begin) << " ms" << std::endl;
+	std::cout << "reverse world state built in " << mpWorldModel->GetReverseCount() << " of " << mpWorldModel->GetUpdateCount() << " cycles" << std::endl;
+	std::cout << std::setw(10) << "stage(us)" << std::setw(10) << "mean" << std::setw(10) << "p50"
+			<< std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+	for (int i = 0; i < STAGE_MAX; ++i) {
+		PrintLatency(stage_names[i], costs[i]);
+	}
+}
+
 void Client::RunNormal()
 {
+	if (PlayerParam::instance().EventLoop())
+	{
+		mpEventLoop = new EventLoop;
+		if (!mpEventLoop->Initial(UDPSocket::instance().GetSocket()))
+		{
+			delete mpEventLoop; // 不支持时仍然用多线程运行
+			mpEventLoop = 0;
+		}
+	}
 
-	mpCommandSender->Start(); //发送命令线程，向server发送信息
-	Logger::instance().Start(); //log线程
-	mpParser->Start(); //分析线程，接受server发来的信息
+	if (mpEventLoop)
+	{
+		Tracer::instance().SetThreadName("EventLoop");
+		Logger::instance().Start(); //log线程，不在收发信息的路径上
+		mpParser->SendInitialLizeMsg();
+	}
+	else
+	{
+		mpCommandSender->Start(); //发送命令线程，向server发送信息
+		Logger::instance().Start(); //log线程
+		mpParser->Start(); //分析线程，接受server发来的信息
+	}
 
 	int past_cycle = 0;
 	do
 	{
-		WaitFor(100); // wait for the parser thread to connect the server
+		WaitForServer(100, false); // wait for the parser thread to connect the server
 		if (++past_cycle > 20)
 		{
 			std::cout << PlayerParam::instance().teamName() << ": Connect Server Error ..." << std::endl;
@@ -171,6 +307,16 @@ void Client::RunNormal()
 
 	SendOptionToServer();
 
+	if (PlayerParam::instance().KickerMode() == 1) // 离线计算mKickerValue表，需要server发来的异构球员参数
+	{
+		while (!Parser::IsPlayerTypesReady())
+		{
+			WaitForServer(100, false);
+		}
+		Kicker::instance().ComputeUtilityTable();
+		return;
+	}
+
 	MainLoop();
 
 	WaitFor(mpObserver->SelfUnum() * 100);
@@ -184,6 +330,127 @@ void Client::RunNormal()
     }
 }
 
+void Client::RunSimulation()
+{
+	static char msg[MAX_MESSAGE];
+	static const char *cmd_head = "record_cmd: ";
+	Tracer::instance().SetThreadName("Main"); // 解析、决策和发送命令都在这个线程中
+
+	if (PlayerParam::instance().SimulatorSeed() != 0) {
+		srand(PlayerParam::instance().SimulatorSeed());
+		srand48(PlayerParam::instance().SimulatorSeed());
+	}
+
+	Simulator::Match match(PlayerParam::instance().SimulatorUnum());
+
+	match.GetInitMsg(msg);
+	mpParser->ParseInitializeMsg(msg);
+	DynamicDebug::instance().Initial(mpObserver); // 和正常比赛一样记录server信息，可以用动态调试复现
+	DynamicDebug::instance().AddMessage(msg, MT_Parse);
+
+	ConstructAgent();
+
+	enum { PARSE_SENSE, PARSE_HEAR, PARSE_SIGHT, PARSE_MAX };
+	long parse_usec[PARSE_MAX] = { 0, 0, 0 };
+	int parse_count[PARSE_MAX] = { 0, 0, 0 };
+
+	RealTime begin = GetRealTime();
+
+	while (!match.IsOver())
+	{
+		mpObserver->Reset();
+
+		match.GetSenseMsg(msg);
+		DynamicDebug::instance().AddMessage(msg, MT_Parse);
+		TimedParse(mpParser, msg, parse_usec[PARSE_SENSE], parse_count[PARSE_SENSE]);
+
+		while (match.GetHearMsg(msg)) {
+			DynamicDebug::instance().AddMessage(msg, MT_Parse);
+			TimedParse(mpParser, msg, parse_usec[PARSE_HEAR], parse_count[PARSE_HEAR]);
+		}
+
+		if (match.GetSightMsg(msg)) {
+			DynamicDebug::instance().AddMessage(msg, MT_Parse);
+			TimedParse(mpParser, msg, parse_usec[PARSE_SIGHT], parse_count[PARSE_SIGHT]);
+		}
+
+		DynamicDebug::instance().AddMessage("\0", MT_Run);
+		Run();
+		Logger::instance().Flush(); //flush log
+		mpObserver->SetPlanned();
+
+		strcpy(msg, cmd_head);
+		mpCommandSender->Run(msg);
+		DynamicDebug::instance().AddMessage(msg, MT_Send);
+
+		match.ExecuteCommands(msg + strlen(cmd_head));
+		match.Step();
+	}
+
+	std::cout << PlayerParam::instance().teamName() << " " << mpObserver->SelfUnum() << ": simulation over, "
+			<< match.OurScore() << ":" << match.OppScore() << " in " << match.CurrentTime() << " cycles, "
+			<< (RealTime(GetRealTime()) - begin) << " ms" << std::endl;
+	std::cout << "reverse world state built in " << mpWorldModel->GetReverseCount() << " of " << mpWorldModel->GetUpdateCount() << " cycles" << std::endl;
+
+	const char *parse_names[PARSE_MAX] = { "sense", "hear", "see" };
+	std::cout << "parse time per message:";
+	for (int i = 0; i < PARSE_MAX; ++i) {
+		std::cout << " " << parse_names[i] << " " << (parse_count[i] > 0 ? double(parse_usec[i]) / parse_count[i] : 0.0) << " us (" << parse_count[i] << ")";
+	}
+	std::cout << std::endl;
+}
+
+void Client::RunKickerGenerator()
+{
+	std::ifstream in_file(PlayerParam::instance().KickerParamFile().c_str());
+	if (!in_file)
+	{
+		PRINT_ERROR("open file error " << PlayerParam::instance().KickerParamFile());
+		return;
+	}
+
+	std::string line;
+	while (std::getline(in_file, line))
+	{
+		if (line.compare(0, 13, "(server_param") == 0
+				|| line.compare(0, 13, "(player_param") == 0
+				|| line.compare(0, 12, "(player_type") == 0)
+		{
+			std::vector<char> msg(line.begin(), line.end());
+			msg.push_back('\0');
+			mpParser->Parse(& msg[0]);
+		}
+	}
+
+	if (!Parser::IsPlayerTypesReady())
+	{
+		PRINT_ERROR("no player types in " << PlayerParam::instance().KickerParamFile());
+		return;
+	}
+
+	RealTime begin = GetRealTime();
+	if (Kicker::instance().ComputeUtilityTable())
+	{
+		std::cout << "kicker_value generated in " << RealTime(GetRealTime()) - begin << " ms" << std::endl;
+	}
+}
+
+void Client::RunNetTrainer()
+{
+	const PlayerParam & param = PlayerParam::instance();
+	Net net(param.NetFile().c_str());
+
+	net.SetBatchSize(param.NetBatchSize());
+	net.SetThreads(param.NetThreads());
+
+	RealTime begin = GetRealTime();
+	net.TrainOnFile(param.NetTrainFile().c_str());
+	std::cout << "net trained in " << RealTime(GetRealTime()) - begin << " ms, error "
+		<< net.TestOnFile(param.NetTrainFile().c_str()) << std::endl;
+
+	net.Save(param.NetFile().c_str(), true);
+}
+
 void Client::ConstructAgent()
 {
 	Assert(mpAgent == 0);
@@ -210,7 +477,12 @@ void Client::ConstructAgent()
 
 void Client::MainLoop()
 {
-	while (mpObserver->WaitForNewInfo()) // 等待新视觉
+	if (mpEventLoop == 0)
+	{
+		Tracer::instance().SetThreadName("Decision");
+	}
+
+	while (mpEventLoop? ReceiveNewInfo(): mpObserver->WaitForNewInfo()) // 等待新视觉
 	{
         NetworkTest::instance().AddDecisionBegin();
 
@@ -221,7 +493,7 @@ void Client::MainLoop()
             mpAgent->Bye();
 
             mpObserver->SetPlanned();
-            mpObserver->SetCommandSend();
+            SendCommands();
             Logger::instance().SetFlushCond();
 
             break;
@@ -231,9 +503,119 @@ void Client::MainLoop()
         Run();
 
 		mpObserver->SetPlanned();
-		mpObserver->SetCommandSend(); //唤醒发送命令的线程
+		SendCommands(); //唤醒发送命令的线程，单线程时直接发送
 		Logger::instance().SetFlushCond(); // set flush cond and let the logger thread flush the logs to file.
 
         NetworkTest::instance().AddDecisionEnd(mpObserver->CurrentTime());
 	}
 }
+
+bool Client::ReceiveNewInfo()
+{
+	mpObserver->Lock();
+	mpObserver->Reset();
+	mpObserver->UnLock();
+
+	const int slow_down = ServerParam::instance().slowDownFactor();
+	const int time_out = PlayerParam::instance().WaitTimeOut() * 1000 * slow_down;
+
+	if (ServerParam::instance().synchMode()) {
+		return ReceiveUntil(time_out, &Observer::CheckNewThink);
+	}
+
+	bool flag = false;
+	if (PlayerParam::instance().isCoach() || PlayerParam::instance().isTrainer()) {
+		flag = ReceiveUntil(time_out, &Observer::CheckNewSight); //see_global 信息
+		ReceiveUntil(PlayerParam::instance().WaitHearBuffer() * slow_down); // 与WaitForCoachNewHear一致，等满hear的时间
+	}
+	else {
+		flag = ReceiveUntil(time_out, &Observer::CheckNewSense); //首先等到sense信息，然后在等一下hear和sight
+		ReceiveUntil((ServerParam::instance().synchSeeOffset() + PlayerParam::instance().WaitSightBuffer()) * slow_down, &Observer::CheckNewSight);
+	}
+
+	return flag;
+}
+
+bool Client::ReceiveUntil(int max_time, bool (Observer::*arrived)())
+{
+	if (arrived != 0 && (mpObserver->*arrived)()) {
+		return true;
+	}
+
+	mpEventLoop->SetTimer(max_time);
+
+	while (true) {
+		switch (mpEventLoop->Wait()) {
+		case EventLoop::E_Receive:
+			ReceiveMessages();
+			if (arrived != 0 && (mpObserver->*arrived)()) {
+				return true;
+			}
+			break;
+		case EventLoop::E_Timeout:
+		default:
+			return false;
+		}
+	}
+}
+
+void Client::ReceiveMessages()
+{
+	static char msg[MAX_MESSAGE];
+
+	while (UDPSocket::instance().Receive(msg, false) > 0)
+	{
+		if (!mpParser->IsConnectServerOk())
+		{
+			mpParser->ParseConnectMsg(msg); // 连上之前只接受init的回复
+			continue;
+		}
+
+		NetworkTest::instance().AddParserBegin();
+
+		DynamicDebug::instance().AddMessage(msg, MT_Parse); // 动态调试记录Parser信息
+
+		mpObserver->Lock();
+		mpParser->Parse(msg);
+		mpObserver->UnLock();
+
+		NetworkTest::instance().AddParserEnd(mpObserver->CurrentTime());
+	}
+}
+
+void Client::SendCommands()
+{
+	if (mpEventLoop == 0)
+	{
+		mpObserver->SetCommandSend();
+		return;
+	}
+
+	static char msg[MAX_MESSAGE];
+
+	NetworkTest::instance().AddCommandSendBegin();
+
+	strcpy(msg, "record_cmd: ");
+	mpCommandSender->Run(msg);
+	DynamicDebug::instance().AddMessage(msg, MT_Send);
+
+	NetworkTest::instance().AddCommandSendEnd(mpObserver->CurrentTime());
+	NetworkTest::instance().AddWakeupEnd(mpObserver->CurrentTime());
+}
+
+void Client::WaitForServer(int ms, bool send_commands)
+{
+	if (send_commands)
+	{
+		SendCommands();
+	}
+
+	if (mpEventLoop)
+	{
+		ReceiveUntil(ms);
+	}
+	else
+	{
+		WaitFor(ms);
+	}
+}
@@ -38,6 +38,7 @@ class WorldModel;
 class Agent;
 class Parser;
 class CommandSender;
+class EventLoop;
 
 class Client {
 	friend class Player;
@@ -50,6 +51,10 @@ class Client {
 
 	Parser 		    *mpParser;
 	CommandSender   *mpCommandSender;
+	EventLoop       *mpEventLoop; // 单线程运行时不为0，此时不启动Parser和CommandSender线程
+
+	long            mUpdateCost; // 本周期世界模型更新的耗时（微秒），由Run()填写
+	long            mDecisionCost; // 本周期决策的耗时（微秒），由Run()填写
 
 public:
 	Client();
@@ -61,15 +66,67 @@ public:
 	void RunDynamicDebug();
 
 	/**
-	* 正常比赛时的球员入口函数
+	* 回放测速的入口函数，把记录的server信息尽快地走一遍解析、更新、决策和发送，
+	* 统计每周期各阶段耗时的分布，用来在比赛前发现性能退化
+	*/
+	void RunDynamicDebugBenchmark();
+
+	/**
+	* 正常比赛时的球员入口函数，event_loop打开时接收、解析、决策和发送都在一个线程中完成
 	*/
 	void RunNormal();
 
+	/**
+	* 离线比赛模拟时的球员入口函数，由Simulator::Match代替server
+	*/
+	void RunSimulation();
+
+	/**
+	* 离线计算kicker_value的入口函数，从kicker_param_file读取server_param、player_param和player_type，
+	* 不需要连接server，方便server参数变化后在部署脚本里重新生成
+	*/
+	void RunKickerGenerator();
+
+	/**
+	* 离线训练神经网络的入口函数，读取net_file中的网络，用net_train_file中的样本按
+	* net_batch_size和net_threads做小批量训练，训练后以二进制格式写回net_file
+	*/
+	void RunNetTrainer();
+
 	/**
 	* 正常比赛时的球员主循环函数
 	*/
 	void MainLoop();
 
+	/**
+	 * 单线程运行时代替Observer::WaitForNewInfo：接收并解析server信息，直到可以决策或等待超时
+	 */
+	bool ReceiveNewInfo();
+
+	/**
+	 * 单线程运行时接收并解析server信息
+	 * @param max_time 最多等待的毫秒数
+	 * @param arrived 检查所等的信息是否到达，为0时等满max_time
+	 * @return 所等的信息是否到达
+	 */
+	bool ReceiveUntil(int max_time, bool (Observer::*arrived)() = 0);
+
+	/**
+	 * 单线程运行时解析socket中已经到达的所有信息
+	 */
+	void ReceiveMessages();
+
+	/**
+	 * 发送本周期的命令：多线程时唤醒发送命令的线程，单线程时直接发送
+	 */
+	void SendCommands();
+
+	/**
+	 * 发送命令后等待server的回复，SendOptionToServer中使用
+	 * @param send_commands 是否先发送Agent中的命令
+	 */
+	void WaitForServer(int ms, bool send_commands = true);
+
 	/**
 	 * 创建Agent，并完成相关调用
 	 */
@@ -62,7 +62,7 @@ void Coach::SendOptionToServer()
 	while (!mpParser->IsEyeOnOk())
 	{
 		UDPSocket::instance().Send("(eye on)");
-		WaitFor(200);
+		WaitForServer(200, false);
 	}
 	vector<pair<int , double> > a ;
 	for (int i=0 ;i <= 17 ; ++i){  //这里的18不知道如何去引用PlayerParam::DEFAULT_PLAYER_TYPES
@@ -78,8 +78,7 @@ void Coach::SendOptionToServer()
         		mpAgent->ChangePlayerType(i, a.back().first);
         		a.pop_back();
         	}
-            mpObserver->SetCommandSend();
-            WaitFor(5);
+            WaitForServer(5);
         }
 	}
 	for (int i = 1; i <= TEAMSIZE; ++i)
@@ -91,8 +90,7 @@ void Coach::SendOptionToServer()
         		mpAgent->ChangePlayerType(i, a.back().first);
         	a.pop_back();
         	}
-            mpObserver->SetCommandSend();
-            WaitFor(5);
+            WaitForServer(5);
         }
 	}
 	if(mpObserver->Teammate_Fullstate(PlayerParam::instance().ourGoalieUnum()).IsAlive()){
@@ -109,7 +107,7 @@ void Coach::SendOptionToServer()
 	a.erase(goalie);
 	}
 
-    mpObserver->SetCommandSend();
+    SendCommands();
 	for (int i = 1; i <= TEAMSIZE; ++i)
     {
         if (i != PlayerParam::instance().ourGoalieUnum() && mpObserver->Teammate_Fullstate(i).IsAlive())
@@ -119,13 +117,12 @@ void Coach::SendOptionToServer()
         		mpAgent->ChangePlayerType(i, a.back().first);
         	a.pop_back();
     		}
-            mpObserver->SetCommandSend();
-            WaitFor(5);
+            WaitForServer(5);
         }
 	}
 
     /** check whether each player's type is changed OK */
-	WaitFor(200);
+	WaitForServer(200, false);
 /*	for (int i = 1; i <= TEAMSIZE; ++i)
     {
         if (i != PlayerParam::instance().ourGoalieUnum() && mpObserver->Teammate_Fullstate(i).IsAlive())
@@ -36,6 +36,7 @@
 #include "Agent.h"
 #include "Logger.h"
 #include "NetworkTest.h"
+#include "Tracer.h"
 
 CommandSender::CommandSender(Observer *pObserver): mpObserver(pObserver), mpAgent(0)
 {
@@ -50,6 +51,8 @@ void CommandSender::StartRoutine()
 {
 	static char msg[MAX_MESSAGE];
 
+	Tracer::instance().SetThreadName("CommandSender");
+
     while (mpObserver->WaitForCommandSend())
     {
         NetworkTest::instance().AddCommandSendBegin();
@@ -59,11 +62,14 @@ void CommandSender::StartRoutine()
         DynamicDebug::instance().AddMessage(msg, MT_Send);
 
         NetworkTest::instance().AddCommandSendEnd(mpObserver->CurrentTime());
+        NetworkTest::instance().AddWakeupEnd(mpObserver->CurrentTime());
     }
 }
 
 void CommandSender::Run(char *msg)
 {
+	TRACE_SPAN(TS_CommandSend);
+
 	if (mpAgent != 0){
 		mpAgent->SendCommands(msg);
 	}
@@ -41,6 +41,7 @@
 #include "PlayerParam.h"
 #include "Logger.h"
 #include "Formation.h"
+#include "Tracer.h"
 using namespace std;
 
 const unsigned char *CommunicateSystem::CODE = (const unsigned char *)"uMKJNPpA1Yh0)f6_x3WU<>SgQ4wbDizV5dc9t2XZ?(/7*s.FEHvLG8yRTkej-OlB+armnoqCI";
@@ -426,6 +427,8 @@ bool CommunicateSystem::SendOpponentStatus(const WorldState *pWorldState, Unum n
 
 void CommunicateSystem::Decision()
 {
+	TRACE_SPAN(TS_CommunicateDecision);
+
 	DoCommunication();
 
 	if (mBitsUsed != 0){
@@ -38,6 +38,107 @@
 
 double Dasher::GETBALL_BUFFER = 0.1;
 
+namespace {
+
+/**
+ * 跑位周期表的格点：目标方向与身体方向的夹角、身体方向上的速度；
+ * 每个格点上存放各周期数能跑到的最远距离。
+ * 夹角用不需要三角函数的伪角度表示，见PseudoAngle
+ */
+const int REACH_ANGLE_NUM = 37; //0~180度，每格4~5.6度
+const double REACH_ANGLE_STEP = 2.0 / (REACH_ANGLE_NUM - 1);
+const double REACH_SPEED_STEP = 0.2;
+const int REACH_SPEED_NUM = 7; //0~1.2
+const int REACH_CYCLE_NUM = 64; //2的幂，查询时用无分支的二分
+const double REACH_MIN_DIST = 2.0; //更近时可踢范围的判断使周期数不单调，不查表
+const double REACH_MAX_DIST = 40.0;
+const double REACH_DIST_STEP = 0.5; //生成表时先按这个间隔找周期数变化的位置，再二分
+const double REACH_DIST_PRECISION = 0.0001;
+const double REACH_SIDE_SPEED = 0.05; //垂直于身体方向的速度超过这个值时不查表
+const int REACH_ERROR_SAMPLES = 2000;
+const float REACH_BOUNDARY_MARGIN = 0.2; //目标离某个格点的周期边界比这个近时，格点之间的差异可能改变结果，不查表
+
+/**
+ * (x, y)与x轴夹角的单调函数，0~180度对应0~2
+ */
+inline double PseudoAngle(double x, double y)
+{
+	const double t = fabs(y) / (fabs(x) + fabs(y) + FLOAT_EPS);
+	return x >= 0.0? t: 2.0 - t;
+}
+
+/**
+ * PseudoAngle的反函数，返回单位向量
+ */
+inline Vector PseudoAngleDir(double p)
+{
+	const Vector dir = p <= 1.0? Vector(1.0 - p, p): Vector(1.0 - p, 2.0 - p);
+	return dir / dir.Mod();
+}
+
+inline int ReachIndex(int angle, int speed)
+{
+	return (angle * REACH_SPEED_NUM + speed) * REACH_CYCLE_NUM;
+}
+
+/**
+ * 在周围4个格点的最远距离按双线性插值得到的序列中找第一个不小于dist的周期数（即lower_bound），
+ * 用条件传送代替难以预测的分支
+ */
+inline int ReachCycle(const float *r00, const float *r10, const float *r01, const float *r11, float ta, float ts, float dist)
+{
+	const float w00 = (1.0f - ta) * (1.0f - ts);
+	const float w10 = ta * (1.0f - ts);
+	const float w01 = (1.0f - ta) * ts;
+	const float w11 = ta * ts;
+
+	int first = 0;
+	for (int len = REACH_CYCLE_NUM; len > 1; ) {
+		const int half = len / 2;
+		const int c = first + half;
+		first = (w00 * r00[c] + w10 * r10[c] + w01 * r01[c] + w11 * r11[c] < dist)? c: first;
+		len -= half;
+	}
+	return (w00 * r00[first] + w10 * r10[first] + w01 * r01[first] + w11 * r11[first] < dist) + first;
+}
+
+/**
+ * 单个格点上dist对应的周期数是否就是cycle，并且dist离这个格点的周期边界足够远
+ */
+inline bool IsReachCycle(const float *reach, int cycle, float dist)
+{
+	return (cycle == 0 || reach[cycle - 1] + REACH_BOUNDARY_MARGIN < dist) && dist + REACH_BOUNDARY_MARGIN <= reach[cycle];
+}
+
+/**
+ * 满体力阶段的周期数，与CycleNeedToPointWithCertainPosture中的full_cyc相同
+ */
+inline int FullStaminaCycle(double stamina, double stamina_inc_max, bool inverse)
+{
+	const double stamina_recovery_thr = ServerParam::instance().recoverDecThr() * ServerParam::instance().staminaMax();
+	const double stamina_used_per_cycle = inverse? ServerParam::instance().maxDashPower() * 2.0: ServerParam::instance().maxDashPower();
+	return int((stamina - stamina_recovery_thr) / (stamina_used_per_cycle - stamina_inc_max));
+}
+
+}
+
+/**
+ * 某一球员类型的跑位周期表。mReach[inverse]中每个(夹角, 速度)格点上依次存放REACH_CYCLE_NUM个距离，
+ * 第c个为身体朝向0度、速度沿身体方向、满体力时，CycleNeedToPointWithCertainPosture不超过c的最远距离，
+ * 查询时在周围4个格点之间插值，找第一个不小于目标距离的周期数。只有4个格点给出相同的周期数、
+ * 并且目标离各格点的周期边界都不太近时才使用查表结果，否则精确计算。这只是经验规则，不能保证与精确计算一致：
+ * 建表时抽样REACH_ERROR_SAMPLES个查询记录最大误差mMaxError，debug版本中每次查表都与精确计算比较。
+ * 结果小于查询球员满体力阶段的周期数时与体力无关，否则仍然精确计算
+ */
+struct Dasher::ReachabilityTable
+{
+	double mEffort;
+	double mKickableArea; //VisualSystem和Strategy中的派生类会改变可踢范围，这时不能查表
+	int mFullCycle[2];
+	std::vector<float> mReach[2];
+	int mMaxError;
+};
+
 Array<double, 8> Dasher::DASH_DIR;
 Array<int, 8> Dasher::ANTI_DIR_IDX;
 Array<double, 8> Dasher::DIR_RATE;
@@ -54,11 +155,18 @@ Dasher::Dasher()
 	for (int i = 0; i < 8; ++i) {
 		ANTI_DIR_IDX[i] = GetDashDirIdx(DASH_DIR[i] + 180.0);
 	}
+
+	for (int i = 0; i < MAX_PLAYER_TYPES; ++i) {
+		mReachabilityTable[i] = 0;
+	}
 }
 
 //==============================================================================
 Dasher::~Dasher()
 {
+	for (int i = 0; i < MAX_PLAYER_TYPES; ++i) {
+		delete mReachabilityTable[i];
+	}
 }
 
 //==============================================================================
@@ -381,6 +489,17 @@ double Dasher::AdjustPowerForDash(const PlayerState & player, Vector target, dou
 */
 int Dasher::CycleNeedToPoint(const PlayerState & player, Vector target, bool can_inverse, double *buf)
 {
+	if (buf == 0 && PlayerParam::instance().DasherTable() && !player.IsGoalie() && player.IsBodyDirValid()) {
+		int cycle;
+		if (LookupCycleNeedToPoint(GetReachabilityTable(player.GetPlayerType()), player, target, can_inverse, cycle)) {
+#ifdef _Debug
+			double exact_buf; //buf不为0时不查表
+			Assert(cycle == CycleNeedToPoint(player, target, can_inverse, &exact_buf));
+#endif
+			return cycle;
+		}
+	}
+
 	const Vector & pos = player.GetPos();
 	const Vector & vel = player.GetVel();
 
@@ -606,6 +725,171 @@ int Dasher::CycleNeedToPointWithCertainPosture(const PlayerState & player, Vecto
     }
 }
 
+void Dasher::BuildReachabilityTables()
+{
+	const int types = Min(PlayerParam::instance().playerTypes(), int(MAX_PLAYER_TYPES));
+	for (int type = 0; type < types; ++type) {
+		GetReachabilityTable(type);
+	}
+}
+
+int Dasher::GetReachabilityError(int type) const
+{
+	return mReachabilityTable[type]? mReachabilityTable[type]->mMaxError: -1;
+}
+
+/**
+ * 并行的planner可能同时查询，表生成完之后才对其他线程可见
+ */
+const Dasher::ReachabilityTable & Dasher::GetReachabilityTable(int type)
+{
+	if (mReachabilityTable[type] == 0) { //表生成后不再改变，已生成时不需要加锁
+		mReachabilityMutex.Lock();
+		if (mReachabilityTable[type] == 0) {
+			ReachabilityTable *table = new ReachabilityTable;
+			BuildReachabilityTable(type, *table);
+			MemoryFence();
+			mReachabilityTable[type] = table;
+		}
+		mReachabilityMutex.UnLock();
+	}
+	return *mReachabilityTable[type];
+}
+
+void Dasher::BuildReachabilityTable(int type, ReachabilityTable & table)
+{
+	PlayerState player;
+	player.UpdatePlayerType(type);
+	player.UpdatePos(Vector(0.0, 0.0));
+	player.UpdateBodyDir(0.0);
+	player.UpdateStamina(ServerParam::instance().staminaMax());
+	player.UpdateEffort(player.GetEffortMax());
+
+	table.mEffort = player.GetEffort();
+	table.mKickableArea = player.GetKickableArea();
+	table.mMaxError = 0;
+
+	for (int inverse = 0; inverse < 2; ++inverse) {
+		table.mFullCycle[inverse] = FullStaminaCycle(player.GetStamina(), player.GetStaminaIncMax(), inverse);
+		table.mReach[inverse].resize(REACH_ANGLE_NUM * REACH_SPEED_NUM * REACH_CYCLE_NUM);
+
+		for (int k = 0; k < REACH_SPEED_NUM; ++k) {
+			const double speed = k * REACH_SPEED_STEP;
+			player.UpdateVel(Vector(speed, 0.0));
+			player.UpdateMaxTurnAngle(GetMaxTurnAngle(type, speed));
+
+			for (int j = 0; j < REACH_ANGLE_NUM; ++j) {
+				const Vector dir = PseudoAngleDir(j * REACH_ANGLE_STEP);
+				float *reach = &table.mReach[inverse][ReachIndex(j, k)];
+
+				/** 周期数随距离单调不减，在每个变化处二分出边界 */
+				double dist = REACH_MIN_DIST;
+				int cycle = CycleNeedToPointWithCertainPosture(player, dir * dist, inverse);
+				for (int c = 0; c < cycle && c < REACH_CYCLE_NUM; ++c) {
+					reach[c] = dist;
+				}
+				while (cycle < REACH_CYCLE_NUM && dist < REACH_MAX_DIST) {
+					const double next = dist + REACH_DIST_STEP;
+					const int next_cycle = CycleNeedToPointWithCertainPosture(player, dir * next, inverse);
+					if (next_cycle > cycle) {
+						double low = dist, high = next;
+						while (high - low > REACH_DIST_PRECISION) {
+							const double mid = (low + high) * 0.5;
+							if (CycleNeedToPointWithCertainPosture(player, dir * mid, inverse) <= cycle) {
+								low = mid;
+							}
+							else {
+								high = mid;
+							}
+						}
+						for (int c = cycle; c < next_cycle && c < REACH_CYCLE_NUM; ++c) {
+							reach[c] = low;
+						}
+						cycle = next_cycle;
+					}
+					dist = next;
+				}
+				for (int c = cycle; c < REACH_CYCLE_NUM; ++c) {
+					reach[c] = dist; //超出表的距离范围，查询时不使用
+				}
+			}
+		}
+	}
+
+	/** 抽样估计查表误差，包括速度方向与身体方向不完全一致的情况；用自己的随机数序列，不影响drand48 */
+	unsigned short seed[3] = { 0x330e, (unsigned short)type, 0x1234 };
+	for (int n = 0; n < REACH_ERROR_SAMPLES; ++n) {
+		const double speed = erand48(seed) * (REACH_SPEED_NUM - 1) * REACH_SPEED_STEP;
+		const Vector vel = Vector(speed, (erand48(seed) * 2.0 - 1.0) * REACH_SIDE_SPEED);
+		const Vector target = Polar2Vector(REACH_MIN_DIST + erand48(seed) * (REACH_MAX_DIST - REACH_MIN_DIST), erand48(seed) * 360.0 - 180.0);
+		const bool can_inverse = fabs(target.Dir()) >= 90.0;
+		player.UpdateVel(vel);
+		player.UpdateMaxTurnAngle(GetMaxTurnAngle(type, vel.Mod()));
+
+		int cycle;
+		if (LookupCycleNeedToPoint(table, player, target, can_inverse, cycle)) {
+			int exact = CycleNeedToPointWithCertainPosture(player, target, false);
+			if (can_inverse) {
+				exact = Min(exact, CycleNeedToPointWithCertainPosture(player, target, true));
+			}
+			table.mMaxError = Max(table.mMaxError, abs(cycle - exact));
+		}
+	}
+}
+
+bool Dasher::LookupCycleNeedToPoint(const ReachabilityTable & table, const PlayerState & player, const Vector & target, bool can_inverse, int & cycle)
+{
+	if (player.GetEffort() != table.mEffort || player.GetKickableArea() != table.mKickableArea) return false;
+
+	/**
+	 * 转到身体坐标系下。同一球员通常连续查询多个点，缓存身体方向的三角函数值；
+	 * 并行的planner各自有一份缓存
+	 */
+	static THREAD_LOCAL double cached_body_dir = 0.0;
+	static THREAD_LOCAL double cached_sin = 0.0;
+	static THREAD_LOCAL double cached_cos = 1.0;
+	if (player.GetBodyDir() != cached_body_dir) {
+		cached_body_dir = player.GetBodyDir();
+		const SinCosT value = SinCos(-cached_body_dir);
+		cached_sin = Sin(value);
+		cached_cos = Cos(value);
+	}
+	const SinCosT body = std::make_pair(cached_sin, cached_cos);
+
+	const Vector vel = player.GetVel().Rotate(body);
+	if (fabs(vel.Y()) > REACH_SIDE_SPEED || vel.X() < 0.0) return false;
+
+	const Vector rel = (target - player.GetPos()).Rotate(body);
+	const float dist = rel.Mod();
+	if (dist <= REACH_MIN_DIST) return false;
+	const double fa = PseudoAngle(rel.X(), rel.Y()) / REACH_ANGLE_STEP;
+	const double fs = vel.X() / REACH_SPEED_STEP;
+	if (fs >= REACH_SPEED_NUM - 1) return false;
+	const int j = Min(int(fa), REACH_ANGLE_NUM - 2);
+	const int k = int(fs);
+
+	if (rel.X() > 0.0) {
+		can_inverse = false; //与CycleNeedToPoint一致，夹角小于90度时没有必要倒着跑
+	}
+
+	cycle = REACH_CYCLE_NUM;
+	for (int inverse = 0; inverse <= int(can_inverse); ++inverse) {
+		const float *r00 = &table.mReach[inverse][ReachIndex(j, k)];
+		const float *r10 = &table.mReach[inverse][ReachIndex(j + 1, k)];
+		const float *r01 = &table.mReach[inverse][ReachIndex(j, k + 1)];
+		const float *r11 = &table.mReach[inverse][ReachIndex(j + 1, k + 1)];
+		const int value = ReachCycle(r00, r10, r01, r11, fa - j, fs - k, dist);
+		if (value >= REACH_CYCLE_NUM || Max(Max(r00[value], r10[value]), Max(r01[value], r11[value])) >= REACH_MAX_DIST) return false;
+		if (!IsReachCycle(r00, value, dist) || !IsReachCycle(r10, value, dist) || !IsReachCycle(r01, value, dist) || !IsReachCycle(r11, value, dist)) return false;
+
+		const int full_cycle = Min(table.mFullCycle[inverse], FullStaminaCycle(player.GetStamina(), player.GetStaminaIncMax(), inverse));
+		if (value >= full_cycle) return false;
+
+		cycle = Min(cycle, value);
+	}
+	return true;
+}
+
 //=============================================================================
 /**
 * 将身体转向特定方向
@@ -35,6 +35,7 @@
 
 #include "Geometry.h"
 #include "Agent.h"
+#include "Thread.h"
 
 struct AtomicAction;
 class PlayerState;
@@ -137,6 +138,19 @@ public:
      */
     int CycleNeedToPointWithCertainPosture(const PlayerState & player, Vector target, const bool inverse, double *buf = 0);
 
+    /**
+     * 为所有异构球员类型生成CycleNeedToPoint的查表数据，在player_type信息全部收到后调用；
+     * 没有调用时第一次查询某个类型时生成
+     * Build the CycleNeedToPoint tables for all player types.
+     */
+    void BuildReachabilityTables();
+
+    /**
+     * 生成表时抽样得到的查表结果与精确计算的最大误差（周期），-1表示该类型的表还没有生成
+     * The max error in cycles of table lookups, sampled when the table is built.
+     */
+    int GetReachabilityError(int type) const;
+
     /**
      * player 以确定得姿势（指倒着跑和正跑），跑到 target 所需要的周期数, 返回实数周期
      * This function returns the minimum cycles for a player to go to a target position with 
@@ -253,6 +267,21 @@ public:
 
 public:
 	static double GETBALL_BUFFER; //拿球里面使用的判断是否可踢的buf，比worldstate里的大
+
+private:
+	struct ReachabilityTable;
+
+	const ReachabilityTable & GetReachabilityTable(int type);
+	void BuildReachabilityTable(int type, ReachabilityTable & table);
+
+	/**
+	 * 查表计算CycleNeedToPoint，player的状态超出表的适用范围或者查询点附近的表项不一致时返回false。
+	 * player必须不是守门员且身体方向可信
+	 */
+	bool LookupCycleNeedToPoint(const ReachabilityTable & table, const PlayerState & player, const Vector & target, bool can_inverse, int & cycle);
+
+	ReachabilityTable *mReachabilityTable[MAX_PLAYER_TYPES];
+	ThreadMutex mReachabilityMutex;
 };
 
 #endif
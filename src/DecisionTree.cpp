@@ -39,13 +39,21 @@
 #include "BehaviorIntercept.h"
 #include "Agent.h"
 #include "Strategy.h"
+#include "PositionInfo.h"
+#include "InfoState.h"
 #include "TimeTest.h"
+#include "PlayerParam.h"
+#include "Tracer.h"
+#include "Evaluation.h"
+#include "ServerParam.h"
 
 bool DecisionTree::Decision(Agent & agent)
 {
+	TRACE_SPAN(TS_Decision);
+
 	Assert(agent.GetSelf().IsAlive());
 
-	ActiveBehavior beh = Search(agent, 1);
+	ActiveBehavior beh = Search(agent, PlayerParam::instance().SearchDepth());
 
 	if (beh.GetType() != BT_None) {
 		agent.SetActiveBehaviorInAct(beh.GetType());
@@ -57,43 +65,196 @@ bool DecisionTree::Decision(Agent & agent)
 
 ActiveBehavior DecisionTree::Search(Agent & agent, int step)
 {
-	if (step == 1) {
-		if (agent.GetSelf().IsIdling()) {
-			return ActiveBehavior(agent, BT_None);
+	if (agent.GetSelf().IsIdling()) {
+		return ActiveBehavior(agent, BT_None);
+	}
+
+	ActiveBehaviorList active_behavior_list;
+	ActiveBehaviorList candidate_list;
+	ActiveBehaviorList * candidate = (step > 1)? & candidate_list: 0; //只有多步搜索时才需要全部候选行为
+
+	if (agent.GetSelf().IsGoalie()) {
+		MutexPlan<BehaviorPenaltyPlanner>(agent, active_behavior_list) ||
+		MutexPlan<BehaviorSetplayPlanner>(agent, active_behavior_list) ||
+		AttackPlan(agent, active_behavior_list, candidate) ||
+		MutexPlan<BehaviorGoaliePlanner>(agent, active_behavior_list);
+	}
+	else {
+		MutexPlan<BehaviorPenaltyPlanner>(agent, active_behavior_list) ||
+		MutexPlan<BehaviorSetplayPlanner>(agent, active_behavior_list) ||
+		AttackPlan(agent, active_behavior_list, candidate) ||
+		MutexPlan<BehaviorDefensePlanner>(agent, active_behavior_list);
+	}
+
+	if (active_behavior_list.empty()){
+		return ActiveBehavior(agent, BT_None);
+	}
+
+	if (!candidate_list.empty()) {
+		ActiveBehavior beh = DeepSearch(agent, step, candidate_list);
+		active_behavior_list.clear();
+		active_behavior_list.push_back(beh);
+	}
+
+	return GetBestActiveBehavior(agent, active_behavior_list);
+}
+
+bool DecisionTree::AttackPlan(Agent & agent, ActiveBehaviorList & active_behavior_list, ActiveBehaviorList * candidate_list)
+{
+	BehaviorAttackPlanner planner(agent);
+	planner.Plan(active_behavior_list);
+
+	if (candidate_list && !active_behavior_list.empty()) {
+		*candidate_list = planner.GetActiveBehaviorList();
+	}
+	return !active_behavior_list.empty();
+}
+
+ActiveBehavior DecisionTree::DeepSearch(Agent & agent, int step, const ActiveBehaviorList & candidate_list)
+{
+	ActiveBehavior best = candidate_list.front(); //一层搜索的结果，与step == 1时相同
+
+	for (int depth = 2; depth <= step; ++depth) {
+		ActiveBehavior depth_best = best;
+		bool finished = true;
+		int count = 0;
+
+		for (ActiveBehaviorList::const_iterator it = candidate_list.begin();
+				it != candidate_list.end() && count < PlayerParam::instance().SearchWidth(); ++it, ++count) {
+			if (IsTimeOut()) {
+				finished = false;
+				break;
+			}
+
+			ActiveBehavior beh = *it;
+			beh.mEvaluation = EvaluateBehavior(agent, *it, depth);
+
+			if (IsTimeOut()) { //EvaluateContinuation超时后提前返回，这个候选的评价不完整
+				finished = false;
+				break;
+			}
+
+			if (count == 0 || beh > depth_best) {
+				depth_best = beh;
+			}
 		}
 
-		std::list<ActiveBehavior> active_behavior_list;
+		if (!finished) break; //这一层没有搜完，用上一层的结果
+
+		best = depth_best;
+	}
+
+	return best;
+}
+
+/**
+ * 没有完整的前向模型，不能在传球后的状态下运行各个planner（它们还会提交线程池任务、提出视觉请求），
+ * 所以这里只预测传球后的简化状态：球到达传球目标点，接球队员在那里控球，对手在这段时间内向球跑动；
+ * 然后只考虑与传球同一尺度（EvaluatePosition）的后续进攻行为
+ */
+double DecisionTree::EvaluateBehavior(Agent & agent, const ActiveBehavior & beh, int step)
+{
+	if (beh.GetType() != BT_Pass) {
+		return beh.mEvaluation;
+	}
 
-		if (agent.GetSelf().IsGoalie()) {
-			MutexPlan<BehaviorPenaltyPlanner>(agent, active_behavior_list) ||
-			MutexPlan<BehaviorSetplayPlanner>(agent, active_behavior_list) ||
-			MutexPlan<BehaviorAttackPlanner>(agent, active_behavior_list) ||
-			MutexPlan<BehaviorGoaliePlanner>(agent, active_behavior_list);
+	/** 传球目标点是队员的预测位置，离目标点最近的队友就是接球队员 */
+	Unum receiver_unum = 0;
+	const std::vector<Unum> close_players = agent.Info().GetPositionInfo().GetClosePlayerToPoint(beh.mTarget, agent.GetSelfUnum());
+	for (std::vector<Unum>::const_iterator it = close_players.begin(); it != close_players.end(); ++it) {
+		if (*it > 0) {
+			receiver_unum = *it;
+			break;
 		}
-		else {
-			MutexPlan<BehaviorPenaltyPlanner>(agent, active_behavior_list) ||
-			MutexPlan<BehaviorSetplayPlanner>(agent, active_behavior_list) ||
-			MutexPlan<BehaviorAttackPlanner>(agent, active_behavior_list) ||
-			MutexPlan<BehaviorDefensePlanner>(agent, active_behavior_list);
+	}
+	if (receiver_unum == 0) {
+		return beh.mEvaluation;
+	}
+
+	const WorldState & world = agent.GetWorldState();
+	const double cycle = ServerParam::instance().GetBallCycle(beh.mKickSpeed, beh.mTarget.Dist(world.GetBall().GetPos()));
+
+	Array<Vector, TEAMSIZE + 1> opponents;
+	for (Unum i = 1; i <= TEAMSIZE; ++i) {
+		opponents[i] = world.GetOpponent(i).GetPos();
+	}
+	PredictOpponents(world, beh.mTarget, cycle, opponents);
+
+	return (beh.mEvaluation + EvaluateContinuation(world, receiver_unum, beh.mTarget, opponents, step - 1)) * 0.5;
+}
+
+void DecisionTree::PredictOpponents(const WorldState & world, const Vector & ball_pos, double cycle, Array<Vector, TEAMSIZE + 1> & opponents) const
+{
+	for (Unum i = 1; i <= TEAMSIZE; ++i) {
+		const PlayerState & opp = world.GetOpponent(i);
+		if (!opp.IsAlive()) continue;
+
+		const Vector to_ball = ball_pos - opponents[i];
+		const double dist = to_ball.Mod();
+		if (dist > FLOAT_EPS) {
+			opponents[i] += to_ball * (Min(dist, cycle * opp.GetEffectiveSpeedMax()) / dist);
 		}
+	}
+}
 
-		if (!active_behavior_list.empty()){
-			return GetBestActiveBehavior(agent, active_behavior_list);
+/**
+ * 控球队员在ball_pos时的后续进攻：原地控球，或者按BehaviorPassPlanner的规则（传球线路10度内没有更近的对手）
+ * 传给其他队友，传球再向下看step - 1层。评价都用EvaluatePosition，与进攻planner的传球、带球同一尺度。
+ * 每层约有10个队友可传，代价随step指数增长，所以每个队友都检查是否超时，超时后返回的结果由DeepSearch丢弃
+ */
+double DecisionTree::EvaluateContinuation(const WorldState & world, Unum holder, const Vector & ball_pos, const Array<Vector, TEAMSIZE + 1> & opponents, int step) const
+{
+	double best = Evaluation::instance().EvaluatePosition(ball_pos, true);
+	if (step <= 0) {
+		return best;
+	}
+
+	for (Unum i = 1; i <= TEAMSIZE; ++i) {
+		if (IsTimeOut()) break;
+
+		const PlayerState & tm = world.GetTeammate(i);
+		if (i == holder || !tm.IsAlive() || tm.IsGoalie()) continue;
+
+		const Vector target = tm.GetPos();
+		const Vector rel_target = target - ball_pos;
+		bool is_blocked = false;
+
+		for (Unum j = 1; j <= TEAMSIZE && !is_blocked; ++j) {
+			if (!world.GetOpponent(j).IsAlive()) continue;
+
+			const Vector rel_pos = opponents[j] - ball_pos;
+			is_blocked = rel_pos.Mod() <= rel_target.Mod() + 3.0 && GetAngleDegDiffer(rel_target.Dir(), rel_pos.Dir()) < 10.0;
 		}
-		else {
-			return ActiveBehavior(agent, BT_None);
+		if (is_blocked) continue;
+
+		double evaluation = Evaluation::instance().EvaluatePosition(target, true);
+		if (step > 1) {
+			const double speed = ServerParam::instance().GetBallSpeed(5, rel_target.Mod());
+			Array<Vector, TEAMSIZE + 1> next_opponents = opponents;
+			PredictOpponents(world, target, ServerParam::instance().GetBallCycle(speed, rel_target.Mod()), next_opponents);
+			evaluation = (evaluation + EvaluateContinuation(world, i, target, next_opponents, step - 1)) * 0.5;
 		}
+
+		best = Max(best, evaluation);
 	}
-	else {
-		return ActiveBehavior(agent, BT_None);
+
+	return best;
+}
+
+bool DecisionTree::IsTimeOut() const
+{
+	if (PlayerParam::instance().SearchDeadline() <= 0) {
+		return false;
 	}
+
+	return RealTime(GetRealTimeDecision()) - mCycleBeginTime >= PlayerParam::instance().SearchDeadline();
 }
 
-ActiveBehavior DecisionTree::GetBestActiveBehavior(Agent & agent, std::list<ActiveBehavior> & behavior_list)
+ActiveBehavior DecisionTree::GetBestActiveBehavior(Agent & agent, ActiveBehaviorList & behavior_list)
 {
 	agent.SaveActiveBehaviorList(behavior_list); //behavior_list里面存储了本周期所有behavior决策出的最优activebehavior，这里统一保存一下，供特定behavior下周期plan时用
 
-	behavior_list.sort(std::greater<ActiveBehavior>());
+	SelectTopBehaviors(behavior_list, 1);
 
 	return behavior_list.front();
 }
@@ -35,12 +35,14 @@
 
 #include <list>
 #include "BehaviorBase.h"
+#include "Utilities.h"
 
 class Agent;
+class WorldState;
 
 class DecisionTree {
 public:
-	DecisionTree() {}
+	DecisionTree(): mCycleBeginTime(GetRealTime()) {}
 	virtual ~DecisionTree() {}
 
 	/**
@@ -49,6 +51,12 @@ public:
 	 */
 	bool Decision(Agent & agent);
 
+	/**
+	 * 设置本周期开始（sense到达）的时间，多步搜索的时限从这个时间算起
+	 * @param time 由Observer记录
+	 */
+	void SetCycleBeginTime(const RealTime & time) { mCycleBeginTime = time; }
+
 private:
 	/**
 	* 搜索决策树，完成对（状态、动作）的评估
@@ -58,13 +66,49 @@ private:
 	*/
 	ActiveBehavior Search(Agent & agent, int step);
 
-	ActiveBehavior GetBestActiveBehavior(Agent & agent, std::list<ActiveBehavior> & behavior_list);
+	ActiveBehavior GetBestActiveBehavior(Agent & agent, ActiveBehaviorList & behavior_list);
+
+	/**
+	 * 逐层加深地评估进攻决策的候选行为，每完成一层更新一次最优行为，超时则返回已完成的最深一层的结果
+	 * @param agent 当前节点的局策主体
+	 * @param step 最大搜索深度
+	 * @param candidate_list 进攻决策的候选行为，按评价从高到低排列
+	 * @return
+	 */
+	ActiveBehavior DeepSearch(Agent & agent, int step, const ActiveBehaviorList & candidate_list);
+
+	/**
+	 * 评估一个候选行为向下step - 1层的结果，目前只对传球在传球后的预测状态下评估接球队员的后续进攻
+	 * @return 修正后的评价
+	 */
+	double EvaluateBehavior(Agent & agent, const ActiveBehavior & beh, int step);
+
+	/**
+	 * 预测cycle周期后对手的位置，都向ball_pos跑动
+	 * @param opponents 对手当前（预测）的位置，按号码索引
+	 */
+	void PredictOpponents(const WorldState & world, const Vector & ball_pos, double cycle, Array<Vector, TEAMSIZE + 1> & opponents) const;
+
+	/**
+	 * 队员holder在ball_pos控球、对手位于opponents时后续进攻的最好评价，不产生任何副作用
+	 */
+	double EvaluateContinuation(const WorldState & world, Unum holder, const Vector & ball_pos, const Array<Vector, TEAMSIZE + 1> & opponents, int step) const;
+
+	bool IsTimeOut() const;
+
+	/**
+	 * 与MutexPlan相同，candidate_list不为空时另外存下进攻决策的全部候选行为
+	 */
+	bool AttackPlan(Agent & agent, ActiveBehaviorList & active_behavior_list, ActiveBehaviorList * candidate_list);
 
 	template <typename BehaviorDerived>
-	bool MutexPlan(Agent & agent, std::list<ActiveBehavior> & active_behavior_list){
+	bool MutexPlan(Agent & agent, ActiveBehaviorList & active_behavior_list){
 		BehaviorDerived(agent).Plan(active_behavior_list);
 		return !active_behavior_list.empty();
 	}
+
+private:
+	RealTime mCycleBeginTime;
 };
 
 #endif /* DECISIONTREE_H_ */
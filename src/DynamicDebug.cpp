@@ -259,85 +259,15 @@ MessageType DynamicDebug::Run(char *msg)
 		{
 			std::string file_name;
 			std::cin >> file_name;
-			mpFile = fopen(file_name.c_str(), "rb");
-			if (mpFile == 0)
+			if (Load(file_name.c_str(), msg))
 			{
-				std::cerr << "Can't open dynamicdebug file, exit..." << std::endl;
-				continue;
-			}
-
-			char ch1( 0 ),ch2( 0 );
-
-			if ( fread( &ch1, sizeof( char ), 1, mpFile ) < 1 )
-			{
-				Assert( 0 );
-			}
-
-			if ( fread( &ch2, sizeof( char ), 1, mpFile ) < 1 )
-			{
-				Assert( 0 );
+				return MT_Parse;
 			}
-
-			if ( ch1 != 'D' || ch2 != 'D' )
+			else if (mpFile == 0)
 			{
-				std::cerr<<"Not a dynamicdebug logfile!"<<std::endl;
-				return MT_Null;
+				continue;
 			}
-
-			if (fread(&mFileHead, sizeof(mFileHead), 1, mpFile) < 1)
-            {
-                Assert(0);
-            }
-
-			long long size;
-
-			size = mFileHead.mIndexTableSize;
-			mpIndex = new MessageIndexTableUnit[size];
-			fseek(mpFile, mFileHead.mIndexTableOffset, SEEK_SET);
-			if (size > 0 && fread(mpIndex, size * sizeof(MessageIndexTableUnit), 1, mpFile) < 1)
-            {
-                Assert(0);
-            }
-
-			size = mFileHead.mParserTableSize;
-			mpParserTime = new timeval[size];
-			fseek(mpFile, mFileHead.mParserTableOffset, SEEK_SET);
-			if (size > 0 && fread(mpParserTime, size * sizeof(timeval), 1, mpFile) < 1)
-            {
-                Assert(0);
-            }
-
-			size = mFileHead.mDecisionTableSize;
-			mpDecisionTime = new timeval[size];
-			fseek(mpFile, mFileHead.mDecisionTableOffset, SEEK_SET);
-			if (size > 0 && fread(mpDecisionTime, size * sizeof(timeval), 1, mpFile) < 1)
-            {
-                Assert(0);
-            }
-
-			size = mFileHead.mCommandSendTableSize;
-			mpCommandSendTime = new timeval[size];
-			fseek(mpFile, mFileHead.mCommandSendTableOffset, SEEK_SET);
-			if (size > 0 && fread(mpCommandSendTime, size * sizeof(timeval), 1, mpFile) < 1)
-            {
-                Assert(0);
-            }
-
-			fseek(mpFile, sizeof(mFileHead) + 2 * sizeof( char ), SEEK_SET);
-			mpCurrentIndex = mpIndex; // load后，第一个为初始化信息，先进行初始化
-
-			std::cerr << "Load finished." << std::endl;
-			fseek(mpFile, mpCurrentIndex->mDataOffset, SEEK_SET);
-			if (fread(msg, 1, 1, mpFile) < 1)
-            {
-                Assert(0);
-            }
-            if (mpCurrentIndex->mDataSize > 0 && fread(msg, mpCurrentIndex->mDataSize, 1, mpFile) < 1)
-            {
-                Assert(0);
-            }
-			msg[mpCurrentIndex->mDataSize] = '\0';
-			return MT_Parse;
+			return MT_Null;
 		}
 		else if (read_msg == "step" || read_msg == "s")
 		{
@@ -441,6 +371,97 @@ MessageType DynamicDebug::Run(char *msg)
 }
 
 
+//==============================================================================
+bool DynamicDebug::Load(const char *file_name, char *msg)
+{
+	mpFile = fopen(file_name, "rb");
+	if (mpFile == 0)
+	{
+		std::cerr << "Can't open dynamicdebug file, exit..." << std::endl;
+		return false;
+	}
+
+	char ch1( 0 ),ch2( 0 );
+
+	if ( fread( &ch1, sizeof( char ), 1, mpFile ) < 1 )
+	{
+		Assert( 0 );
+	}
+
+	if ( fread( &ch2, sizeof( char ), 1, mpFile ) < 1 )
+	{
+		Assert( 0 );
+	}
+
+	if ( ch1 != 'D' || ch2 != 'D' )
+	{
+		std::cerr<<"Not a dynamicdebug logfile!"<<std::endl;
+		return false;
+	}
+
+	if (fread(&mFileHead, sizeof(mFileHead), 1, mpFile) < 1)
+	{
+		Assert(0);
+	}
+
+	long long size;
+
+	size = mFileHead.mIndexTableSize;
+	mpIndex = new MessageIndexTableUnit[size];
+	fseek(mpFile, mFileHead.mIndexTableOffset, SEEK_SET);
+	if (size > 0 && fread(mpIndex, size * sizeof(MessageIndexTableUnit), 1, mpFile) < 1)
+	{
+		Assert(0);
+	}
+
+	size = mFileHead.mParserTableSize;
+	mpParserTime = new timeval[size];
+	fseek(mpFile, mFileHead.mParserTableOffset, SEEK_SET);
+	if (size > 0 && fread(mpParserTime, size * sizeof(timeval), 1, mpFile) < 1)
+	{
+		Assert(0);
+	}
+
+	size = mFileHead.mDecisionTableSize;
+	mpDecisionTime = new timeval[size];
+	fseek(mpFile, mFileHead.mDecisionTableOffset, SEEK_SET);
+	if (size > 0 && fread(mpDecisionTime, size * sizeof(timeval), 1, mpFile) < 1)
+	{
+		Assert(0);
+	}
+
+	size = mFileHead.mCommandSendTableSize;
+	mpCommandSendTime = new timeval[size];
+	fseek(mpFile, mFileHead.mCommandSendTableOffset, SEEK_SET);
+	if (size > 0 && fread(mpCommandSendTime, size * sizeof(timeval), 1, mpFile) < 1)
+	{
+		Assert(0);
+	}
+
+	if (mFileHead.mIndexTableSize <= 0)
+	{
+		std::cerr << "Empty dynamicdebug logfile!" << std::endl;
+		return false;
+	}
+
+	fseek(mpFile, sizeof(mFileHead) + 2 * sizeof( char ), SEEK_SET);
+	mpCurrentIndex = mpIndex; // load后，第一个为初始化信息，先进行初始化
+
+	std::cerr << "Load finished." << std::endl;
+	fseek(mpFile, mpCurrentIndex->mDataOffset, SEEK_SET);
+	if (fread(msg, 1, 1, mpFile) < 1)
+	{
+		Assert(0);
+	}
+	if (mpCurrentIndex->mDataSize > 0 && fread(msg, mpCurrentIndex->mDataSize, 1, mpFile) < 1)
+	{
+		Assert(0);
+	}
+	msg[mpCurrentIndex->mDataSize] = '\0';
+	return true;
+}
+
+
 //==============================================================================
 MessageType DynamicDebug::GetMessage(char *msg)
 {
@@ -449,7 +470,8 @@ MessageType DynamicDebug::GetMessage(char *msg)
 		return MT_Null;
 	}
 
-	if (mpCurrentIndex->mServerTime >= mFileHead.mMaxCycle)
+	if (mpCurrentIndex->mServerTime >= mFileHead.mMaxCycle ||
+			mpCurrentIndex + 1 >= mpIndex + mFileHead.mIndexTableSize)
 	{
 		std::cerr << "End ..." << std::endl;
 		return MT_Null;
@@ -131,6 +131,7 @@ public:
      * 下面函数是动态调试时用到的接口
      */
     MessageType Run(char *msg);
+    bool Load(const char *file_name, char *msg); // 读入消息文件，msg中返回初始化信息
     MessageType GetMessage(char *msg);
     bool FindCycle(int cycle);
     timeval GetTimeParser();
@@ -39,9 +39,55 @@
 #include "WorldState.h"
 #include "InfoState.h"
 
-Evaluation::Evaluation()
+#include "PlayerParam.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const int MAX_BATCH_UNITS = 32; //批量计算支持的每层最大单元数，超过时退回Net::Run
+const int BATCH_SIZE = 16; //EvaluatePositions每次准备输入的点数
+
+/**
+ * 查表范围（网络输入空间），比球场稍大一些，以便覆盖场外的点
+ */
+const double GRID_MIN_X = -1.2;
+const double GRID_MAX_X = 1.2;
+const double GRID_MIN_Y = -1.0;
+const double GRID_MAX_Y = 1.4;
+
+inline double Sigmoid(double s)
+{
+	return 1.0/(1.0 + exp(-s)); //与Net::sigmoid一致
+}
+
+}
+
+Evaluation::Evaluation():
+	mGridSizeX(0),
+	mGridSizeY(0),
+	mGridStepX(0.0),
+	mGridStepY(0.0)
 {
 	mSensitivityNet = new Net("data/sensitivity.net");
+
+	const int layers = mSensitivityNet->GetLayers();
+	bool batch = layers >= 2;
+	for (int i = 0; i < layers; ++i) {
+		mUnits.push_back(mSensitivityNet->GetUnits(i));
+		batch = batch && mUnits[i] <= MAX_BATCH_UNITS;
+	}
+
+	if (batch) {
+		const double *weights = mSensitivityNet->GetWeightBuffer();
+		mWeights.assign(weights, weights + mSensitivityNet->GetWeightCount());
+	}
+
+	if (PlayerParam::instance().EvaluationGrid() > FLOAT_EPS) {
+		BuildGrid(PlayerParam::instance().EvaluationGrid());
+	}
 }
 
 Evaluation::~Evaluation()
@@ -57,16 +103,160 @@ Evaluation & Evaluation::instance()
 
 double Evaluation::EvaluatePosition(const Vector & pos, bool ourside)
 {
-	static double input[2];
-	static double output[1];
+	double output;
+	EvaluatePositions(&pos, 1, ourside, &output);
+    return output;
+}
+
+void Evaluation::EvaluatePositions(const Vector *pos, int n, bool ourside, double *evaluation)
+{
+	double input[2 * BATCH_SIZE];
 
-	input[0] = pos.X() / (ServerParam::instance().PITCH_LENGTH * 0.5);
-	input[1] = fabs(pos.Y()) / (ServerParam::instance().PITCH_WIDTH * 0.5) * 2.0 - 1.0;
-	if (!ourside){
-		input[0] *= -1.0;
+	for (int begin = 0; begin < n; begin += BATCH_SIZE) {
+		const int m = std::min(n - begin, BATCH_SIZE);
+
+		for (int i = 0; i < m; ++i) {
+			const Vector & p = pos[begin + i];
+			input[2 * i] = p.X() / (ServerParam::instance().PITCH_LENGTH * 0.5);
+			input[2 * i + 1] = fabs(p.Y()) / (ServerParam::instance().PITCH_WIDTH * 0.5) * 2.0 - 1.0;
+			if (!ourside){
+				input[2 * i] *= -1.0;
+			}
+		}
+
+		if (!mGrid.empty()) {
+			for (int i = 0; i < m; ++i) {
+				evaluation[begin + i] = LookupGrid(input[2 * i], input[2 * i + 1]);
+			}
+		}
+		else {
+			RunNet(input, m, evaluation + begin);
+		}
+	}
+}
+
+/**
+ * input中每个点依次存放mUnits[0]个输入，output中放每个点输出层第一个单元的值。
+ * SSE2下两个点一组同时计算，乘加的顺序和Net::FeedForward相同，结果逐位一致；
+ * sigmoid中的exp没有对应的SSE2指令，仍然逐个计算
+ */
+void Evaluation::RunNet(const double *input, int n, double *output)
+{
+	if (mUnits.size() < 2) {
+		for (int i = 0; i < n; ++i) {
+			output[i] = 0.0;
+		}
+		return;
 	}
-	mSensitivityNet->Run(input, output);
 
-    return output[0];
+	const int layers = mUnits.size();
+	const int in_units = mUnits[0];
+
+	if (mWeights.empty()) { //网络太大，逐个运行
+		std::vector<double> in(input, input + n * in_units);
+		std::vector<double> out(mUnits[layers - 1]);
+		mNetMutex.Lock();
+		for (int i = 0; i < n; ++i) {
+			mSensitivityNet->Run(&in[i * in_units], &out[0]);
+			output[i] = out[0];
+		}
+		mNetMutex.UnLock();
+		return;
+	}
+
+	int i = 0;
+
+#ifdef __SSE2__
+	__m128d act[MAX_BATCH_UNITS];
+	__m128d next[MAX_BATCH_UNITS];
+
+	for (; i + 1 < n; i += 2) {
+		const double *in0 = input + i * in_units;
+		const double *in1 = in0 + in_units;
+		for (int k = 0; k < in_units; ++k) {
+			act[k] = _mm_set_pd(in1[k], in0[k]);
+		}
+
+		const double *w = &mWeights[0];
+		for (int l = 1; l < layers; ++l) {
+			const int prev = mUnits[l - 1];
+			for (int j = 0; j < mUnits[l]; ++j, w += prev + 1) {
+				__m128d s = _mm_set1_pd(w[prev]); //bias
+				for (int k = 0; k < prev; ++k) {
+					s = _mm_add_pd(s, _mm_mul_pd(act[k], _mm_set1_pd(w[k])));
+				}
+				double lane[2];
+				_mm_storeu_pd(lane, s);
+				next[j] = _mm_set_pd(Sigmoid(lane[1]), Sigmoid(lane[0]));
+			}
+			std::copy(next, next + mUnits[l], act);
+		}
+
+		_mm_storel_pd(output + i, act[0]);
+		_mm_storeh_pd(output + i + 1, act[0]);
+	}
+#endif
+
+	double sact[MAX_BATCH_UNITS];
+	double snext[MAX_BATCH_UNITS];
+
+	for (; i < n; ++i) {
+		std::copy(input + i * in_units, input + (i + 1) * in_units, sact);
+
+		const double *w = &mWeights[0];
+		for (int l = 1; l < layers; ++l) {
+			const int prev = mUnits[l - 1];
+			for (int j = 0; j < mUnits[l]; ++j, w += prev + 1) {
+				double s = w[prev]; //bias
+				for (int k = 0; k < prev; ++k) {
+					s += sact[k] * w[k];
+				}
+				snext[j] = Sigmoid(s);
+			}
+			std::copy(snext, snext + mUnits[l], sact);
+		}
+
+		output[i] = sact[0];
+	}
+}
+
+/**
+ * 在网络输入空间上按step米的间隔计算格点值，x方向对应球场长度，y方向对应|y|
+ */
+void Evaluation::BuildGrid(double step)
+{
+	mGridStepX = step / (ServerParam::instance().PITCH_LENGTH * 0.5);
+	mGridStepY = step / (ServerParam::instance().PITCH_WIDTH * 0.5) * 2.0;
+	mGridSizeX = int(ceil((GRID_MAX_X - GRID_MIN_X) / mGridStepX)) + 1;
+	mGridSizeY = int(ceil((GRID_MAX_Y - GRID_MIN_Y) / mGridStepY)) + 1;
+	mGridStepX = (GRID_MAX_X - GRID_MIN_X) / (mGridSizeX - 1);
+	mGridStepY = (GRID_MAX_Y - GRID_MIN_Y) / (mGridSizeY - 1);
+
+	std::vector<double> grid(mGridSizeX * mGridSizeY);
+	std::vector<double> input(mGridSizeX * 2);
+
+	for (int j = 0; j < mGridSizeY; ++j) {
+		for (int i = 0; i < mGridSizeX; ++i) {
+			input[2 * i] = GRID_MIN_X + i * mGridStepX;
+			input[2 * i + 1] = GRID_MIN_Y + j * mGridStepY;
+		}
+		RunNet(&input[0], mGridSizeX, &grid[j * mGridSizeX]);
+	}
+
+	mGrid.swap(grid);
 }
 
+double Evaluation::LookupGrid(double x, double y) const
+{
+	const double fx = (MinMax(GRID_MIN_X, x, GRID_MAX_X) - GRID_MIN_X) / mGridStepX;
+	const double fy = (MinMax(GRID_MIN_Y, y, GRID_MAX_Y) - GRID_MIN_Y) / mGridStepY;
+	const int ix = std::min(int(fx), mGridSizeX - 2);
+	const int iy = std::min(int(fy), mGridSizeY - 2);
+	const double tx = fx - ix;
+	const double ty = fy - iy;
+
+	const double *row0 = &mGrid[iy * mGridSizeX + ix];
+	const double *row1 = row0 + mGridSizeX;
+
+	return (row0[0] * (1.0 - tx) + row0[1] * tx) * (1.0 - ty) + (row1[0] * (1.0 - tx) + row1[1] * tx) * ty;
+}
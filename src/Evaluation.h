@@ -34,6 +34,8 @@
 #define __Evaluation_H__
 
 #include "Geometry.h"
+#include "Thread.h"
+#include <vector>
 class Net;
 
 class Evaluation
@@ -47,8 +49,35 @@ public:
 
 	double EvaluatePosition(const Vector & pos, bool ourside);
 
+	/**
+	 * 一次评价n个点，结果依次放在evaluation中，与逐个调用EvaluatePosition的结果相同
+	 * Evaluate n positions in one call.
+	 */
+	void EvaluatePositions(const Vector *pos, int n, bool ourside, double *evaluation);
+
+private:
+	void RunNet(const double *input, int n, double *output);
+	void BuildGrid(double step);
+	double LookupGrid(double x, double y) const;
+
 private:
 	Net *mSensitivityNet;
+	ThreadMutex mNetMutex; // Net::Run使用网络内部的缓存，只在网络超过批量计算的规模时使用
+
+	/**
+	 * 网络权值的连续拷贝，每层按 [单元][输入..., 偏置] 依次存放，批量计算时只读，不需要加锁
+	 */
+	std::vector<double> mWeights;
+	std::vector<int> mUnits;
+
+	/**
+	 * 查表模式下网络输入空间上的格点值，为空表示不使用查表
+	 */
+	std::vector<double> mGrid;
+	int mGridSizeX;
+	int mGridSizeY;
+	double mGridStepX;
+	double mGridStepY;
 };
 
 #endif
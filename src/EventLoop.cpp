@@ -0,0 +1,146 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+
+#include "EventLoop.h"
+#include "Utilities.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+EventLoop::EventLoop():
+	mEpoll(-1),
+	mTimer(-1),
+	mSocket(-1),
+	mTimerExpired(false)
+{
+}
+
+EventLoop::~EventLoop()
+{
+#ifdef __linux__
+	if (mTimer >= 0) close(mTimer);
+	if (mEpoll >= 0) close(mEpoll);
+#endif
+}
+
+bool EventLoop::Initial(int socket)
+{
+#ifdef __linux__
+	mSocket = socket;
+	mEpoll = epoll_create(2);
+	mTimer = timerfd_create(CLOCK_MONOTONIC, 0);
+	if (mEpoll < 0 || mTimer < 0) {
+		PRINT_ERROR("create epoll or timerfd error");
+		return false;
+	}
+
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = mSocket;
+	if (epoll_ctl(mEpoll, EPOLL_CTL_ADD, mSocket, &event) < 0) {
+		PRINT_ERROR("add socket to epoll error");
+		return false;
+	}
+
+	event.data.fd = mTimer;
+	if (epoll_ctl(mEpoll, EPOLL_CTL_ADD, mTimer, &event) < 0) {
+		PRINT_ERROR("add timerfd to epoll error");
+		return false;
+	}
+	return true;
+#else
+	(void) socket;
+	PRINT_ERROR("event loop is only supported on linux");
+	return false;
+#endif
+}
+
+void EventLoop::SetTimer(int ms)
+{
+#ifdef __linux__
+	ms = Max(ms, 0);
+
+	itimerspec spec;
+	spec.it_interval.tv_sec = 0;
+	spec.it_interval.tv_nsec = 0;
+	spec.it_value.tv_sec = ms / 1000;
+	spec.it_value.tv_nsec = (ms % 1000) * 1000000 + (ms == 0? 1: 0); //全为0表示取消定时器
+	timerfd_settime(mTimer, 0, &spec, 0);
+
+	mTimerExpired = false; //之前到期的定时器作废
+#else
+	(void) ms;
+#endif
+}
+
+EventLoop::Event EventLoop::Wait()
+{
+#ifdef __linux__
+	while (true) {
+		epoll_event events[2];
+		int n = epoll_wait(mEpoll, events, 2, mTimerExpired? 0: -1); // 有未报告的到期时不阻塞
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			PRINT_ERROR("epoll_wait error");
+			return E_Error;
+		}
+
+		bool readable = false;
+		for (int i = 0; i < n; ++i) {
+			if (events[i].data.fd == mSocket) {
+				readable = true;
+			}
+			else if (events[i].data.fd == mTimer) {
+				unsigned long long expirations;
+				if (read(mTimer, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+					mTimerExpired = true;
+				}
+			}
+		}
+
+		if (readable) {
+			return E_Receive; // 先处理消息，定时器可能随后被重新设置
+		}
+		if (mTimerExpired) {
+			mTimerExpired = false;
+			return E_Timeout;
+		}
+	}
+#else
+	return E_Error;
+#endif
+}
@@ -0,0 +1,80 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+
+#ifndef __EventLoop_H__
+#define __EventLoop_H__
+
+/**
+ * 单线程运行时用的事件等待：同时等待server的udp消息和一个单次定时器（epoll + timerfd），
+ * 代替Parser线程和CommandSender线程之间基于ThreadCondition的唤醒，减少从收到视觉到发出命令之间的调度抖动。
+ * 只在Linux下可用，其他平台Initial返回false。
+ * Waits on the server socket and a one-shot timer in a single thread.
+ */
+class EventLoop
+{
+public:
+	enum Event
+	{
+		E_Receive, // socket上有消息可读
+		E_Timeout, // 定时器到期
+		E_Error
+	};
+
+	EventLoop();
+	~EventLoop();
+
+	/**
+	 * 创建epoll和timerfd，并开始监听socket
+	 * @param socket 用于接收server消息的socket
+	 */
+	bool Initial(int socket);
+
+	/**
+	 * 设置单次定时器，覆盖之前的设置
+	 * @param ms 从现在起的毫秒数，不大于0时立即到期
+	 */
+	void SetTimer(int ms);
+
+	/**
+	 * 阻塞直到socket可读或定时器到期；两者同时发生时先返回E_Receive，定时器下次再报告
+	 */
+	Event Wait();
+
+private:
+	int mEpoll;
+	int mTimer;
+	int mSocket;
+	bool mTimerExpired; // 定时器已到期但还没有报告
+};
+
+#endif
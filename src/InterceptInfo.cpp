@@ -50,14 +50,23 @@ void InterceptInfo::SortIntercerptInfo()
 {
 	mOIT.clear();
 
+	PlayerInterceptInfo *outdated[2 * TEAMSIZE];
+	int outdated_count = 0;
+
 	for (int i = -TEAMSIZE; i <= TEAMSIZE; i++){
 		if (i == 0) continue;
 
 		if (mpWorldState->GetPlayer(i).IsAlive()){
-			mOIT.push_back(OrderedIT(VerifyIntInfo(i), i, mpWorldState->GetPlayer(i).GetPosDelay()));
+			PlayerInterceptInfo *pInfo = GetPlayerInterceptInfo(i);
+			if (IsIntInfoOutdated(pInfo)) {
+				outdated[outdated_count++] = pInfo;
+			}
+			mOIT.push_back(OrderedIT(pInfo, i, mpWorldState->GetPlayer(i).GetPosDelay()));
 		}
 	}
 
+	CalcTightInterception(mpWorldState->GetBall(), outdated, outdated_count); //需要重新计算的一起求解
+
 	std::sort(mOIT.begin(), mOIT.end());
 
 	if (PlayerParam::instance().SaveTextLog()) {
@@ -79,19 +88,49 @@ void InterceptInfo::SortIntercerptInfo()
 	}
 }
 
-PlayerInterceptInfo *InterceptInfo::VerifyIntInfo(Unum unum)
+bool InterceptInfo::IsIntInfoOutdated(PlayerInterceptInfo *pInfo)
 {
-	PlayerInterceptInfo* pInfo = GetPlayerInterceptInfo(unum);
-	if (!pInfo) {
-		return 0;
+	if (pInfo->mTime == mpWorldState->CurrentTime()) {
+		return false;
 	}
+	pInfo->mTime = mpWorldState->CurrentTime();
+
+	Array<double, PlayerInterceptInfo::INPUT_SIZE, true> input;
+	GetInterceptInput(mpWorldState->GetBall(), *pInfo->mpPlayer, 1.0, pInfo->mpPlayer->GetKickableArea(), input);
 
-	if(pInfo->mTime != mpWorldState->CurrentTime()){
-		CalcTightInterception(mpWorldState->GetBall(), pInfo);
-		pInfo->mTime = mpWorldState->CurrentTime();
+	for (int i = 0; i < PlayerInterceptInfo::INPUT_SIZE; ++i) {
+		if (input[i] != pInfo->mInput[i]) {
+			return true;
+		}
 	}
+	return false;
+}
 
-	return pInfo;
+/**
+ * 截球求解用到的全部输入，mode区分求解方式：1为可倒跑的紧截球，2为不可倒跑的紧截球，3为松截球
+ */
+void InterceptInfo::GetInterceptInput(const BallState & ball, const PlayerState & player, double mode, double buffer, Array<double, PlayerInterceptInfo::INPUT_SIZE, true> & input)
+{
+	input[0] = mode;
+	input[1] = buffer;
+	input[2] = ball.GetPos().X();
+	input[3] = ball.GetPos().Y();
+	input[4] = ball.GetVel().X();
+	input[5] = ball.GetVel().Y();
+	input[6] = player.GetPos().X();
+	input[7] = player.GetPos().Y();
+	input[8] = player.GetVel().X();
+	input[9] = player.GetVel().Y();
+	input[10] = player.GetBodyDir();
+	input[11] = player.IsBodyDirValid();
+	input[12] = player.GetPosDelay();
+	input[13] = player.GetPlayerType();
+	input[14] = player.GetStamina();
+	input[15] = player.GetEffort();
+	input[16] = player.GetEffectiveSpeedMax();
+	input[17] = player.GetMaxTurnAngle();
+	input[18] = player.IsGoalie();
+	input[19] = player.GetIdleCycle();
 }
 
 void InterceptInfo::AnalyseInterceptSolution(const BallState & ball, PlayerInterceptInfo *pInfo)
@@ -116,6 +155,13 @@ void InterceptInfo::CalcIdealInterception(const BallState & ball, PlayerIntercep
 	//step 1. 求解简化截球模型
 	InterceptModel::instance().CalcInterception(ball.GetPredictedPos(idle_cycle), ball.GetPredictedVel(idle_cycle), buffer, pInfo->mpPlayer, &(pInfo->solution));
 
+	FixIdealInterception(ball, pInfo, buffer);
+}
+
+void InterceptInfo::FixIdealInterception(const BallState & ball, PlayerInterceptInfo *pInfo, const double & buffer)
+{
+	const int idle_cycle = pInfo->mpPlayer->GetIdleCycle();
+
 	//step 2. 修正截球区间
 	//	取整
 	if (pInfo->solution.interc == 1){
@@ -160,12 +206,51 @@ void InterceptInfo::CalcLooseInterception(const BallState & ball, PlayerIntercep
 {
 	CalcIdealInterception(ball, pInfo, buffer);
 	AnalyseInterceptSolution(ball, pInfo);
+
+	GetInterceptInput(ball, *pInfo->mpPlayer, 3.0, buffer, pInfo->mInput);
 }
 
 void InterceptInfo::CalcTightInterception(const BallState & ball, PlayerInterceptInfo *pInfo, bool can_inverse)
 {
 	CalcIdealInterception(ball, pInfo, pInfo->mpPlayer->GetKickableArea()); //TODO: 改成从外面传进来 buffer
+	FixTightInterception(ball, pInfo, can_inverse);
+}
 
+void InterceptInfo::CalcTightInterception(const BallState & ball, PlayerInterceptInfo **infos, int n, bool can_inverse)
+{
+	/** 没有idle周期的球员（绝大多数）从同一个球的状态出发，一起求解简化截球模型 */
+	std::vector<PlayerInterceptInfo *> batch;
+	std::vector<const PlayerState *> players;
+	std::vector<double> buffers;
+	std::vector<InterceptModel::InterceptSolution> solutions;
+
+	for (int i = 0; i < n; ++i) {
+		if (infos[i]->mpPlayer->GetIdleCycle() == 0) {
+			batch.push_back(infos[i]);
+			players.push_back(infos[i]->mpPlayer);
+			buffers.push_back(infos[i]->mpPlayer->GetKickableArea());
+		}
+		else {
+			CalcTightInterception(ball, infos[i], can_inverse);
+		}
+	}
+
+	if (batch.empty()) {
+		return;
+	}
+
+	solutions.resize(batch.size());
+	InterceptModel::instance().CalcInterception(ball.GetPredictedPos(0), ball.GetPredictedVel(0), & buffers[0], & players[0], batch.size(), & solutions[0]);
+
+	for (unsigned i = 0; i < batch.size(); ++i) {
+		batch[i]->solution = solutions[i];
+		FixIdealInterception(ball, batch[i], buffers[i]);
+		FixTightInterception(ball, batch[i], can_inverse);
+	}
+}
+
+void InterceptInfo::FixTightInterception(const BallState & ball, PlayerInterceptInfo *pInfo, bool can_inverse)
+{
 	const int idle_cycle = pInfo->mpPlayer->GetIdleCycle();
 
 	//根据go_to_point模型修正
@@ -224,6 +309,8 @@ void InterceptInfo::CalcTightInterception(const BallState & ball, PlayerIntercep
 	}
 
 	AnalyseInterceptSolution(ball, pInfo);
+
+	GetInterceptInput(ball, *pInfo->mpPlayer, can_inverse? 1.0: 2.0, pInfo->mpPlayer->GetKickableArea(), pInfo->mInput); //别处用模拟的球调用时也要记下，避免误用
 }
 
 PlayerInterceptInfo *InterceptInfo::GetPlayerInterceptInfo(Unum unum) const
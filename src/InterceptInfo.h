@@ -50,6 +50,9 @@ private:
 	InterceptModel::InterceptSolution solution;
 	friend class InterceptInfo;
 
+	enum { INPUT_SIZE = 20 };
+	Array<double, INPUT_SIZE, true> mInput; //上次求解时的全部输入（球、球员状态和求解方式），输入不变时直接复用结果
+
 public:
 	PlayerInterceptInfo():
 		mTime (Time(-3, 0)),
@@ -104,17 +107,21 @@ public:
     bool IsPlayerBallInterceptable(Unum unum) const { return GetPlayerInterceptInfo(unum)? GetPlayerInterceptInfo(unum)->mRes == IR_Success: false; } //可以在球出界前拦截到球
 
 	static void CalcTightInterception(const BallState & ball, PlayerInterceptInfo *pInfo, bool can_inverse = true); //求解可踢即可截`紧'截球区间 -- 考虑gotopoint修正
+	static void CalcTightInterception(const BallState & ball, PlayerInterceptInfo **infos, int n, bool can_inverse = true); //同上，对同一个球的状态批量求解，结果与逐个求解相同
 	static void CalcLooseInterception(const BallState & ball, PlayerInterceptInfo *pInfo, const double & buffer); //求解buffer可截的`松‘截球区间 -- 不考虑gotopoint修正
 
 private:
 	static void CalcIdealInterception(const BallState & ball, PlayerInterceptInfo *pInfo, const double & buffer);
+	static void FixIdealInterception(const BallState & ball, PlayerInterceptInfo *pInfo, const double & buffer); //把简化模型的解修正为截球区间
+	static void FixTightInterception(const BallState & ball, PlayerInterceptInfo *pInfo, bool can_inverse); //根据gotopoint模型修正
+	static void GetInterceptInput(const BallState & ball, const PlayerState & player, double mode, double buffer, Array<double, PlayerInterceptInfo::INPUT_SIZE, true> & input);
 	static void AnalyseInterceptSolution(const BallState & ball, PlayerInterceptInfo *pInfo);
 
 private:
 	void UpdateRoutine();
 
 	void SortIntercerptInfo();
-	PlayerInterceptInfo *VerifyIntInfo(Unum unum);
+	bool IsIntInfoOutdated(PlayerInterceptInfo *pInfo); //输入与上次求解时不同则需要重新求解
 
 private:
     PlayerArray<PlayerInterceptInfo> mTeammateInterceptInfo;
@@ -41,6 +41,10 @@
 #include "Plotter.h"
 #include "Logger.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 const double InterceptModel::IMPOSSIBLE_BALL_SPEED = 8.0;
 
 InterceptModel::InterceptModel()
@@ -61,9 +65,6 @@ InterceptModel &InterceptModel::instance()
 
 void InterceptModel::CalcInterception(const Vector & ball_pos, const Vector & ball_vel, const double buffer, const PlayerState *player, InterceptSolution *sol)
 {
-	const double & alpha = ServerParam::instance().ballDecay();
-	const double & ln_alpha = ServerParam::instance().logBallDecay();
-
 	Vector start_pt = (player->GetPos() - ball_pos).Rotate(-ball_vel.Dir());
 
 	//取得模型输入
@@ -75,14 +76,68 @@ void InterceptModel::CalcInterception(const Vector & ball_pos, const Vector & ba
     const double & kick_area = buffer;
 	const double cycle_delay = double(player->GetPosDelay());
 
-	const double max_x = ball_spd / (1.0 - alpha);
-
 //	if (Logger::instance().CurrentTime() == Time(205, 0) && player->GetUnum() == 4){
-//		PlotInterceptCurve(x0, y0, ball_spd, player_spd, kick_area, cycle_delay, max_x);
+//		PlotInterceptCurve(x0, y0, ball_spd, player_spd, kick_area, cycle_delay, ball_spd / (1.0 - ServerParam::instance().ballDecay()));
 //	}
 
+	SolveInterception(x0, y0, Sqrt(x0 * x0 + y0 * y0), ball_spd, player_spd, kick_area, cycle_delay, sol);
+}
+
+void InterceptModel::CalcInterception(const Vector & ball_pos, const Vector & ball_vel, const double *buffer, const PlayerState * const *players, int n, InterceptSolution *sol)
+{
+	enum { BATCH_SIZE = 2 * TEAMSIZE };
+
+	/** 球的方向和速度对所有球员只算一次 */
+	const SinCosT value = SinCos(-ball_vel.Dir());
+	const double ball_spd = ball_vel.Mod();
+
+	double rel_x[BATCH_SIZE], rel_y[BATCH_SIZE];
+	double x0[BATCH_SIZE], y0[BATCH_SIZE], s[BATCH_SIZE];
+
+	for (int begin = 0; begin < n; begin += BATCH_SIZE) {
+		const int size = Min(n - begin, int(BATCH_SIZE));
+
+		for (int i = 0; i < size; ++i) {
+			rel_x[i] = players[begin + i]->GetPos().X() - ball_pos.X();
+			rel_y[i] = players[begin + i]->GetPos().Y() - ball_pos.Y();
+		}
+
+		/** 转到球的坐标系，与Vector::Rotate的计算顺序相同 */
+		int i = 0;
+#ifdef __SSE2__
+		const __m128d sine = _mm_set1_pd(Sin(value));
+		const __m128d cosine = _mm_set1_pd(Cos(value));
+		for (; i + 1 < size; i += 2) {
+			__m128d x = _mm_loadu_pd(rel_x + i);
+			__m128d y = _mm_loadu_pd(rel_y + i);
+			__m128d rx = _mm_sub_pd(_mm_mul_pd(x, cosine), _mm_mul_pd(y, sine));
+			__m128d ry = _mm_add_pd(_mm_mul_pd(y, cosine), _mm_mul_pd(x, sine));
+			_mm_storeu_pd(x0 + i, rx);
+			_mm_storeu_pd(y0 + i, ry);
+			_mm_storeu_pd(s + i, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(rx, rx), _mm_mul_pd(ry, ry))));
+		}
+#endif
+		for (; i < size; ++i) {
+			x0[i] = rel_x[i] * Cos(value) - rel_y[i] * Sin(value);
+			y0[i] = rel_y[i] * Cos(value) + rel_x[i] * Sin(value);
+			s[i] = Sqrt(x0[i] * x0[i] + y0[i] * y0[i]);
+		}
+
+		for (i = 0; i < size; ++i) {
+			const PlayerState *player = players[begin + i];
+			SolveInterception(x0[i], y0[i], s[i], ball_spd, player->GetEffectiveSpeedMax(), buffer[begin + i], double(player->GetPosDelay()), sol + begin + i);
+		}
+	}
+}
+
+void InterceptModel::SolveInterception(double x0, double y0, double s, double ball_spd, double player_spd, double kick_area, double cycle_delay, InterceptSolution *sol)
+{
+	const double & alpha = ServerParam::instance().ballDecay();
+	const double & ln_alpha = ServerParam::instance().logBallDecay();
+
+	const double max_x = ball_spd / (1.0 - alpha);
+
 	//特殊情况处理
-	const double s = Sqrt(x0 * x0 + y0 * y0);
 	const double self_fix = kick_area + cycle_delay * player_spd;
 
 	if (s < self_fix){ //最好的情况已经可踢
@@ -72,6 +72,15 @@ public:
 	 * 下面的函数是用来求解理想截球模型
 	 */
 	void CalcInterception(const Vector & ball_pos, const Vector & ball_vel, const double buffer, const PlayerState * player, InterceptSolution * sol);
+
+	/**
+	 * 批量求解同一个球的状态下多个球员的理想截球模型，结果与逐个调用CalcInterception相同
+	 * Solve interceptions of n players against the same ball state in one pass.
+	 * \param buffer kickable buffer of each player.
+	 * \param players players to solve.
+	 * \param sol solutions, one for each player.
+	 */
+	void CalcInterception(const Vector & ball_pos, const Vector & ball_vel, const double *buffer, const PlayerState * const *players, int n, InterceptSolution *sol);
 	int CalcTangPoint(double x0, double y0, double vp, double ka, double cd, InterceptSolution * sol);
 	double CalcInterPoint(double x_init, double x0, double y0, double vb, double vp, double ka, double cd);
 
@@ -83,6 +92,11 @@ public:
     double CalcGoingThroughSpeed(const PlayerState & player, const Ray & ballcourse, const double & distance, const double fix = 1.5);
 
 private:
+	/**
+	 * 在球的坐标系下求解，x0和y0为球员相对于球的位置（x轴为球的运动方向），s为两者之间的距离
+	 */
+	void SolveInterception(double x0, double y0, double s, double ball_spd, double player_spd, double kick_area, double cycle_delay, InterceptSolution *sol);
+
 	/**
 	 * 画出理想截球曲线
 	 * @param x0
@@ -35,12 +35,221 @@
 #include "Kicker.h"
 #include "Logger.h"
 #include "Parser.h"
+#include "Thread.h"
 #include "Utilities.h"
 
+#include <cstdio>
 #include <cstring>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 using namespace std;
 
+namespace {
+
+/**
+ * kicker_value文件格式：KickerFileHeader后依次为各球员类型的表
+ * 旧格式文件没有文件头，只有0号类型的一张表
+ */
+const char KICKER_FILE_MAGIC[8] = { 'W', 'E', 'K', 'I', 'C', 'K', 'E', 'R' };
+const int KICKER_FILE_VERSION = 1;
+
+/** 计算某一球员类型的表所用到的参数，参数变化后表需要重新计算 */
+struct KickerParamKey
+{
+	double mKickPowerRate;
+	double mPlayerSize;
+	double mKickableMargin;
+	double mBallSize;
+	double mMaxPower;
+	double mBallDecay;
+	double mBallSpeedMax;
+	int mValid;
+	int mPadding;
+};
+
+struct KickerFileHeader
+{
+	char mMagic[8];
+	int mVersion;
+	int mAngles;
+	int mPoints;
+	int mTypes; /** 文件中表的个数 */
+	KickerParamKey mKey[MAX_PLAYER_TYPES];
+};
+
+KickerParamKey GetParamKey(int player_type)
+{
+	KickerParamKey key;
+	memset(&key, 0, sizeof(key));
+
+	key.mKickPowerRate  = PlayerParam::instance().HeteroPlayer(player_type).kickPowerRate();
+	key.mPlayerSize     = PlayerParam::instance().HeteroPlayer(player_type).playerSize();
+	key.mKickableMargin = PlayerParam::instance().HeteroPlayer(player_type).kickableMargin();
+	key.mBallSize       = ServerParam::instance().ballSize();
+	key.mMaxPower       = ServerParam::instance().maxPower();
+	key.mBallDecay      = ServerParam::instance().ballDecay();
+	key.mBallSpeedMax   = ServerParam::instance().ballSpeedMax();
+	key.mValid          = 1;
+
+	return key;
+}
+
+bool IsSameParamKey(const KickerParamKey & a, const KickerParamKey & b)
+{
+	return a.mValid && b.mValid
+			&& fabs(a.mKickPowerRate - b.mKickPowerRate) < FLOAT_EPS
+			&& fabs(a.mPlayerSize - b.mPlayerSize) < FLOAT_EPS
+			&& fabs(a.mKickableMargin - b.mKickableMargin) < FLOAT_EPS
+			&& fabs(a.mBallSize - b.mBallSize) < FLOAT_EPS
+			&& fabs(a.mMaxPower - b.mMaxPower) < FLOAT_EPS
+			&& fabs(a.mBallDecay - b.mBallDecay) < FLOAT_EPS
+			&& fabs(a.mBallSpeedMax - b.mBallSpeedMax) < FLOAT_EPS;
+}
+
+/**
+ * 在距离(x, y)小于max_accel（理论上可以踢到）的点中，求value的最大值
+ * Maximum of value[l] over points l reachable from (x, y) with acceleration max_accel.
+ */
+double MaxReachableValue(const double *px, const double *py, double x, double y, double max_accel, const float *value, int n)
+{
+	double max_value = 0.0;
+	int l = 0;
+
+#ifdef __SSE2__
+	const __m128d vx = _mm_set1_pd(x);
+	const __m128d vy = _mm_set1_pd(y);
+	const __m128d accel = _mm_set1_pd(max_accel);
+	__m128d best = _mm_setzero_pd();
+
+	for (; l + 1 < n; l += 2) {
+		__m128d dx = _mm_sub_pd(_mm_loadu_pd(px + l), vx);
+		__m128d dy = _mm_sub_pd(_mm_loadu_pd(py + l), vy);
+		__m128d dist = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+		__m128d v = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)(value + l))));
+		best = _mm_max_pd(best, _mm_and_pd(_mm_cmplt_pd(dist, accel), v)); // value都不小于0
+	}
+
+	double result[2];
+	_mm_storeu_pd(result, best);
+	max_value = Max(result[0], result[1]);
+#endif
+
+	for (; l < n; ++l) {
+		double dx = px[l] - x;
+		double dy = py[l] - y;
+		if (Sqrt(dx * dx + dy * dy) < max_accel) {
+			max_value = Max(max_value, (double)value[l]);
+		}
+	}
+
+	return max_value;
+}
+
+}
+
+/**
+ * 离线计算mKickerValue表的工作线程，从共享的任务计数中领取(球员类型, 踢球角度)任务
+ */
+class KickerWorker: public Thread
+{
+public:
+	KickerWorker(Kicker & kicker, std::vector<Kicker::KickerTable *> & tables, int *next_task):
+		mKicker(kicker),
+		mTables(tables),
+		mpNextTask(next_task)
+	{
+	}
+
+	virtual ~KickerWorker() {}
+
+private:
+	void StartRoutine()
+	{
+		const int task_count = mTables.size() * 36;
+
+		for (int task = AtomicAdd(mpNextTask, 1); task < task_count; task = AtomicAdd(mpNextTask, 1))
+		{
+			mKicker.ComputeUtilityTable(task / 36, task % 36, *mTables[task / 36]);
+		}
+	}
+
+	Kicker & mKicker;
+	std::vector<Kicker::KickerTable *> & mTables;
+	int *mpNextTask;
+};
+
+/**
+ * 文件里没有某个球员类型的表时的后备：只计算本进程实际用到的类型，算完后才对决策线程可见
+ */
+class KickerBuilder: public Thread
+{
+public:
+	KickerBuilder(Kicker & kicker):
+		mKicker(kicker)
+	{
+	}
+
+	virtual ~KickerBuilder() {}
+
+private:
+	void StartRoutine()
+	{
+		for (;;)
+		{
+			int set_count = mKicker.mBuildCondition.SetCount();
+			if (mKicker.mIsStopping)
+			{
+				return;
+			}
+
+			int type = 1;
+			while (type < MAX_PLAYER_TYPES && !(mKicker.mIsRequested[type] && mKicker.mUtilityTable[type] == 0))
+			{
+				++type;
+			}
+
+			if (type == MAX_PLAYER_TYPES)
+			{
+				mKicker.mBuildCondition.WaitSet(set_count, 1000);
+				continue;
+			}
+
+			const Kicker::KickerTable *table = mKicker.GetFileTable(type);
+			if (table == 0)
+			{
+				Kicker::KickerTable *computed = new Kicker::KickerTable;
+				for (int angle = 0; angle < 36; ++angle)
+				{
+					if (mKicker.mIsStopping)
+					{
+						delete computed;
+						return;
+					}
+					mKicker.ComputeUtilityTable(type, angle, *computed);
+				}
+				mKicker.mComputedValue[type] = computed;
+				table = computed;
+			}
+
+			MemoryFence();
+			mKicker.mUtilityTable[type] = table;
+		}
+	}
+
+	Kicker & mKicker;
+};
+
 /**
  * Constructor
  */
@@ -103,7 +312,11 @@ Kicker::Kicker()
 
 
 	/** 将要读取或计算mKickerValue表 */
-	memset(mKickerValue, 0, sizeof(mKickerValue));
+	mpKickerValue   = 0;
+	mpMappedFile    = 0;
+	mMappedSize     = 0;
+	mpBuilder       = 0;
+	mIsStopping     = false;
 
     if (PlayerParam::instance().KickerMode() == 0)
     {
@@ -117,6 +330,27 @@ Kicker::Kicker()
  */
 Kicker::~Kicker()
 {
+	if (mpBuilder != 0)
+	{
+		mIsStopping = true;
+		mBuildCondition.Set();
+		mpBuilder->Join();
+		delete mpBuilder;
+	}
+
+	for (int i = 0; i < MAX_PLAYER_TYPES; ++i)
+	{
+		delete mComputedValue[i];
+	}
+
+	if (mpMappedFile != 0)
+	{
+#ifndef WIN32
+		munmap(mpMappedFile, mMappedSize);
+#else
+		delete[] mpMappedFile;
+#endif
+	}
 }
 
 
@@ -432,88 +666,334 @@ void Kicker::Execute(Agent &agent, const ActionPlan &plan)
 }
 
 /**
- * 读取mKickerValue表
+ * 映射mKickerValue表文件。文件以只读方式共享映射，同一台机器上的各球员进程共用一份物理内存
  */
 void Kicker::ReadUtilityTable()
 {
-	std::ifstream in_file("data/kicker_value", std::ios::binary);
+	const char *file_name = "data/kicker_value";
+
+#ifndef WIN32
+	int fd = open(file_name, O_RDONLY);
+	if (fd < 0)
+	{
+		PRINT_ERROR("open file error");
+		return;
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) < 0 || file_stat.st_size <= 0)
+	{
+		PRINT_ERROR("stat file error");
+		close(fd);
+		return;
+	}
+
+	mMappedSize = file_stat.st_size;
+	void *addr = mmap(0, mMappedSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (addr == MAP_FAILED)
+	{
+		PRINT_ERROR("mmap file error");
+		mMappedSize = 0;
+		return;
+	}
+	mpMappedFile = (char *)addr;
+#else
+	std::ifstream in_file(file_name, std::ios::binary);
 	if (!in_file)
 	{
 		PRINT_ERROR("open file error");
 		return;
 	}
-	in_file.read((char *)mKickerValue, sizeof(mKickerValue));
+	in_file.seekg(0, std::ios::end);
+	mMappedSize = in_file.tellg();
+	in_file.seekg(0, std::ios::beg);
+	mpMappedFile = new char[mMappedSize];
+	in_file.read(mpMappedFile, mMappedSize);
 	in_file.close();
+#endif
+
+	if (mMappedSize == sizeof(KickerTable))
+	{
+		return; /** 旧格式，只有0号类型的表 */
+	}
+
+	const KickerFileHeader *header = (const KickerFileHeader *)mpMappedFile;
+	if (mMappedSize < sizeof(KickerFileHeader)
+			|| memcmp(header->mMagic, KICKER_FILE_MAGIC, sizeof(KICKER_FILE_MAGIC)) != 0
+			|| header->mVersion != KICKER_FILE_VERSION
+			|| header->mAngles != 36
+			|| header->mPoints != POINTS_NUM
+			|| header->mTypes < 0
+			|| header->mTypes > MAX_PLAYER_TYPES
+			|| mMappedSize < sizeof(KickerFileHeader) + header->mTypes * sizeof(KickerTable))
+	{
+		PRINT_ERROR("kicker_value version mismatch, run kicker_mode 1 to regenerate it");
+#ifndef WIN32
+		munmap(mpMappedFile, mMappedSize);
+#else
+		delete[] mpMappedFile;
+#endif
+		mpMappedFile = 0;
+		mMappedSize = 0;
+	}
 }
 
 
 /**
- * Compute kicker value table.
+ * 文件中的表只有在计算参数与当前参数一致时才使用
  */
-void Kicker::ComputeUtilityTable()
+const Kicker::KickerTable *Kicker::GetFileTable(int player_type) const
 {
-	Assert(Parser::IsPlayerTypesReady());
+	if (mpMappedFile == 0)
+	{
+		return 0;
+	}
+
+	if (mMappedSize == sizeof(KickerTable))
+	{
+		return player_type == 0? (const KickerTable *)mpMappedFile: 0;
+	}
+
+	const KickerFileHeader *header = (const KickerFileHeader *)mpMappedFile;
+	if (player_type < header->mTypes && IsSameParamKey(header->mKey[player_type], GetParamKey(player_type)))
+	{
+		return (const KickerTable *)(mpMappedFile + sizeof(KickerFileHeader) + player_type * sizeof(KickerTable));
+	}
+	return 0;
+}
 
-    mInput.mPlayerType = 0;//离线计算只考虑0号类型
-    for (int k = 0; k < POINTS_NUM; ++k)
-    {
-        mKickRate[k] = GetKickRate(mPoint[k], mInput.mPlayerType);
-        mMaxAccel[k] = ServerParam::instance().maxPower() * mKickRate[k];
-    }
 
-	AngleDeg kick_angle = 0.0;//踢球角度
+/**
+ * 没有收到异构球员参数时（如内置模拟器中）只有这张表。Parser线程和决策线程都可能第一次调用，
+ * 加锁保证只计算一次，算好后才发布指针
+ */
+const Kicker::KickerTable & Kicker::GetDefaultTable()
+{
+	if (mUtilityTable[0] == 0)
+	{
+		mDefaultMutex.Lock();
+		if (mUtilityTable[0] == 0)
+		{
+			const KickerTable *table = GetFileTable(0);
+			if (table == 0)
+			{
+				mComputedValue[0] = new KickerTable;
+				ComputeUtilityTable(0, *mComputedValue[0]);
+				table = mComputedValue[0];
+			}
+			MemoryFence();
+			mUtilityTable[0] = table;
+		}
+		mDefaultMutex.UnLock();
+	}
+
+	return *mUtilityTable[0];
+}
+
+
+/**
+ * 比赛开始前server发来异构球员参数时调用，0号类型的表在这里准备好，其他类型只从文件中取。
+ * 文件中没有的类型要用kicker_mode 1对着这个server重新生成，这里只给出警告，不在比赛中全部计算
+ */
+void Kicker::BuildUtilityTables()
+{
+	const int types = Min(PlayerParam::instance().playerTypes(), (int)MAX_PLAYER_TYPES);
+	int missing = 0;
+
+	GetDefaultTable();
+	for (int type = 1; type < types; ++type)
+	{
+		const KickerTable *table = GetFileTable(type);
+		if (table != 0)
+		{
+			MemoryFence();
+			mUtilityTable[type] = table;
+		}
+		else
+		{
+			++missing;
+		}
+	}
+
+	if (missing > 0)
+	{
+		PRINT_ERROR("kicker_value lacks " << missing << " of " << types << " player types, run kicker_mode 1 against this server to regenerate it");
+	}
+}
+
+
+/**
+ * Get kicker value table of a player type.
+ * 文件中没有这个类型的表时给出警告，请求后台线程只计算这一个类型，算好之前先用0号类型的表
+ */
+const Kicker::KickerTable & Kicker::GetUtilityTable(int player_type)
+{
+	Assert(player_type >= 0 && player_type < MAX_PLAYER_TYPES);
+
+	const KickerTable *table = mUtilityTable[player_type];
+	if (table != 0)
+	{
+		return *table;
+	}
+
+	if (player_type > 0 && !mIsRequested[player_type] && Parser::IsPlayerTypesReady())
+	{
+		PRINT_ERROR("no kicker_value table for player type " << player_type << ", computing it in background");
+		mIsRequested[player_type] = true;
+		if (mpBuilder == 0)
+		{
+			mpBuilder = new KickerBuilder(*this);
+			mpBuilder->Start();
+		}
+		mBuildCondition.Set();
+	}
+
+	return GetDefaultTable();
+}
+
+
+/**
+ * Compute kicker value table of a player type.
+ */
+void Kicker::ComputeUtilityTable(int player_type, KickerTable & table)
+{
+	for (int i = 0; i < 36; ++i)
+	{
+		ComputeUtilityTable(player_type, i, table);
+	}
+}
+
+
+/**
+ * Compute kicker value table of a player type for one kick angle.
+ * v[1]和v[2]只依赖同一角度下前一次迭代的结果
+ */
+void Kicker::ComputeUtilityTable(int player_type, int angle, KickerTable & table)
+{
+	double point_x[POINTS_NUM];
+	double point_y[POINTS_NUM];
+	double max_accel[POINTS_NUM];
+	for (int k = 0; k < POINTS_NUM; ++k)
+	{
+		point_x[k] = mPoint[k].X();
+		point_y[k] = mPoint[k].Y();
+		max_accel[k] = ServerParam::instance().maxPower() * GetKickRate(mPoint[k], player_type);
+	}
+
+	const AngleDeg kick_angle = STEP_KICK_ANGLE * angle;//踢球角度
 	Vector ball_vel     = Vector(0.0, 0.0);
 	Vector ball_next    = Vector(0.0, 0.0);
-	double max_speed    = 0.0;
 
 	for (int v = 0; v < 3; ++v)//3次迭代，分别算v[0], v[1], v[2]
 	{
-		for (int i = 0; i < 36; ++i)//踢球角度
+		for (int j = 0; j < POINTS_NUM; ++j)//初始位置，即第1脚kick前的位置
 		{
-			kick_angle = STEP_KICK_ANGLE * i;
-
-			for (int j = 0; j < POINTS_NUM; ++j)//初始位置，即第1脚kick前的位置
+			for (int k = 0; k < POINTS_NUM; ++k)//第1脚kick后的位置
 			{
-				for (int k = 0; k < POINTS_NUM; ++k)//第1脚kick后的位置
-				{
-					ball_vel = (mPoint[k] - mPoint[j]) * ServerParam::instance().ballDecay();
-
-					if (v == 0)//v[0]直接算即可
-					{
-						mKickerValue[v][i][j][k] = (float)GetOneKickMaxSpeed(ball_vel, kick_angle, mMaxAccel[k]);
-					}
-					else//v[1]和v[2]要迭代
-					{
-						max_speed   = 0.0;
-						ball_next   = mPoint[k] + ball_vel;
-
-						for (int l = 0; l < POINTS_NUM; ++l)//从j踢到k，再踢到l
-						{
-							if (mPoint[l].Dist(ball_next) < mMaxAccel[k])//保证理论上可以从k踢到l
-							{
-								max_speed = Max(max_speed, (double)mKickerValue[v - 1][i][k][l]);
-							}
-						}
+				ball_vel = (mPoint[k] - mPoint[j]) * ServerParam::instance().ballDecay();
 
-						mKickerValue[v][i][j][k] = (float)max_speed;
-					}
+				if (v == 0)//v[0]直接算即可
+				{
+					table.mValue[v][angle][j][k] = (float)GetOneKickMaxSpeed(ball_vel, kick_angle, max_accel[k]);
+				}
+				else//v[1]和v[2]要迭代，从j踢到k，再踢到l，要保证理论上可以从k踢到l
+				{
+					ball_next = mPoint[k] + ball_vel;
+					table.mValue[v][angle][j][k] = (float)MaxReachableValue(point_x, point_y, ball_next.X(), ball_next.Y(),
+							max_accel[k], table.mValue[v - 1][angle][k], POINTS_NUM);
 				}
 			}
 		}
 	}
+}
+
 
-	//写文件
-	std::ofstream out_file("kicker_value", std::ios::binary);
+/**
+ * Compute kicker value tables of all player types.
+ * 按(球员类型, 踢球角度)划分任务，由kicker_threads个线程并行计算
+ */
+bool Kicker::ComputeUtilityTable()
+{
+	Assert(Parser::IsPlayerTypesReady());
+
+	KickerFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.mMagic, KICKER_FILE_MAGIC, sizeof(KICKER_FILE_MAGIC));
+	header.mVersion = KICKER_FILE_VERSION;
+	header.mAngles  = 36;
+	header.mPoints  = POINTS_NUM;
+	header.mTypes   = Min(PlayerParam::instance().playerTypes(), (int)MAX_PLAYER_TYPES);
+
+	std::vector<KickerTable *> tables;
+	for (int type = 0; type < header.mTypes; ++type)
+	{
+		header.mKey[type] = GetParamKey(type);
+		tables.push_back(new KickerTable);
+	}
+
+	int thread_count = PlayerParam::instance().KickerThreads();
+#ifndef WIN32
+	if (thread_count <= 0)
+	{
+		thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+#endif
+	thread_count = Max(thread_count, 1);
+
+	int next_task = 0;
+	std::vector<KickerWorker *> workers;
+	for (int i = 0; i < thread_count; ++i)
+	{
+		workers.push_back(new KickerWorker(*this, tables, &next_task));
+		workers.back()->Start();
+	}
+	for (int i = 0; i < thread_count; ++i)
+	{
+		workers[i]->Join();
+		delete workers[i];
+	}
+
+	//先写临时文件再改名，不影响正在映射旧文件的球员进程
+	const char *file_name = "data/kicker_value";
+	const std::string temp_name = std::string(file_name) + ".tmp";
+	std::ofstream out_file(temp_name.c_str(), std::ios::binary);
 	if (!out_file)
 	{
 		PRINT_ERROR("open file error");
-		return;
 	}
-	out_file.write((char *)mKickerValue, sizeof(mKickerValue));
-	out_file.close();
+	else
+	{
+		out_file.write((char *)&header, sizeof(header));
+		for (int type = 0; type < header.mTypes; ++type)
+		{
+			out_file.write((char *)tables[type], sizeof(KickerTable));
+		}
+		out_file.close();
+	}
 
-    std::cerr << "compute kicker value over ..." << std::endl;
-	exit(0);
+	for (int type = 0; type < header.mTypes; ++type)
+	{
+		delete tables[type];
+	}
+
+	if (!out_file)
+	{
+		return false;
+	}
+
+#ifdef WIN32
+	remove(file_name);
+#endif
+	if (rename(temp_name.c_str(), file_name) != 0)
+	{
+		PRINT_ERROR("rename file error " << temp_name);
+		return false;
+	}
+
+    std::cerr << "compute kicker value over, " << header.mTypes << " player types, " << thread_count << " threads ..." << std::endl;
+	return true;
 }
 
 
@@ -567,6 +1047,8 @@ void Kicker::UpdateKickData(const Agent & agent)
 		}
 	}
 
+	mpKickerValue = & GetUtilityTable(mInput.mPlayerType); //这个类型的表可能刚由后台线程算好
+
 	/** initial */
 	for (int i = 0; i < POINTS_NUM; i++)
 	{
@@ -910,7 +1392,7 @@ ActionPlan Kicker::MultiCycleKick(const Agent & agent, int cycle)
 		for (int k = 0, v = cycle - 2, j = NearestPoint(mInput.mBallPos); k < POINTS_NUM; ++k)
 		{
 			int i = (int)(GetNormalizeAngleDeg((target-mPoint[k]).Dir(), -FLOAT_EPS) / STEP_KICK_ANGLE);
-			if (mPointEva[k] > 0.001 && (double)mKickerValue[v][i][j][k] > mKickSpeed - speed_buf) // 要大于期望的出球速度
+			if (mPointEva[k] > 0.001 && (double)mpKickerValue->mValue[v][i][j][k] > mKickSpeed - speed_buf) // 要大于期望的出球速度
 			{
 				//mPoint[k]+mInput.mPlayerVel是mPoint[k]在踢球的第一个周期的坐标系中的位置
 				Vector ball_vel = (mPoint[k]+mInput.mPlayerVel - mInput.mBallPos) * ServerParam::instance().ballDecay(); // 踢到k后的球速
@@ -936,7 +1418,7 @@ ActionPlan Kicker::MultiCycleKick(const Agent & agent, int cycle)
 							else if (cycle == 4) // 利用mKickerValue[1]的信息，没必要再前向了
 							{
 								int t = (int)(GetNormalizeAngleDeg((target-mPoint[l]).Dir(), -FLOAT_EPS) / STEP_KICK_ANGLE);
-								speed = Max(speed, (double)mKickerValue[1][t][k][l]);
+								speed = Max(speed, (double)mpKickerValue->mValue[1][t][k][l]);
 							}
 						}
 					}
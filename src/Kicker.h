@@ -34,6 +34,9 @@
 #define __Kicker_H__
 
 #include "Agent.h"
+#include "Thread.h"
+
+class KickerBuilder;
 
 enum KickMode
 {
@@ -52,10 +55,17 @@ public:
     static Kicker & instance();
 
     /**
-     * 计算mKickerValue表
-     * Compute kicker value table.
+     * 计算所有球员类型的mKickerValue表，写入带版本头的kicker_value文件
+     * Compute kicker value tables of all player types and write them to file "kicker_value".
+     * \return true if the file is written.
+     */
+    bool ComputeUtilityTable();
+
+    /**
+     * 收到异构球员参数后调用，准备0号类型的表并取出文件中各球员类型的表，文件中缺少的类型给出警告
+     * Prepare kicker value tables of all player types from file, warning about missing ones.
      */
-    void ComputeUtilityTable();
+    void BuildUtilityTables();
 
     /**
      * 通过kick的误差模型计算踢球后的max_rand
@@ -124,7 +134,7 @@ private:
 	    }
     }
 
-    /** 读取mKickerValue表 */
+    /** 映射mKickerValue表文件，各进程共享同一份只读内存 */
     void ReadUtilityTable();
 
     /** 更新kick的数据，里面有时间控制 */
@@ -174,6 +184,31 @@ private:
     	POINTS_NUM = 81 // Kicker类中搜索的总点数，POINTS_NUM = nlayer[0] + nlayer[1] + nlayer[2]
     };
 
+    struct KickerTable {
+    	float mValue[3][36][POINTS_NUM][POINTS_NUM]; /** 2,3,4脚踢球，36个角度，POINTS_NUM个点 */ // float即可，节省所占空间
+    };
+
+    /** 计算某一球员类型的mKickerValue表 */
+    void ComputeUtilityTable(int player_type, KickerTable & table);
+
+    /** 计算某一球员类型在某一踢球角度下的mKickerValue表，不同角度之间互不依赖，可以并行计算 */
+    void ComputeUtilityTable(int player_type, int angle, KickerTable & table);
+
+    friend class KickerWorker;
+    friend class KickerBuilder;
+
+    /**
+     * 得到某一球员类型的mKickerValue表。文件中没有时警告并在后台只计算这一个类型，算好之前返回0号类型的表
+     * Get kicker value table of a player type, falling back to type 0 until it is ready.
+     */
+    const KickerTable & GetUtilityTable(int player_type);
+
+    /** 文件中计算参数与当前一致的表，没有时返回0 */
+    const KickerTable *GetFileTable(int player_type) const;
+
+    /** 0号类型的表，文件中没有时现场计算，多个线程同时调用时只计算一次 */
+    const KickerTable & GetDefaultTable();
+
     AgentID     mAgentID;
 
     Array<int, 3>  mNlayer;         /** 每层的离散点数 */
@@ -182,7 +217,17 @@ private:
     Array<double, 3> mDlayer;    /** 每层的半径 */
     Array<Vector, POINTS_NUM> mPoint; /** 存储所有点 */
 
-    float mKickerValue[3][36][POINTS_NUM][POINTS_NUM]; /** 2,3,4脚踢球，36个角度，POINTS_NUM个点 */ // float即可，节省所占空间
+    const KickerTable *mpKickerValue;   /** 当前球员类型的mKickerValue表 */
+    Array<const KickerTable *, MAX_PLAYER_TYPES, true> mUtilityTable; /** 各类型已准备好的表，完整后才写入 */
+    Array<KickerTable *, MAX_PLAYER_TYPES, true> mComputedValue; /** 计算出的表 */
+    Array<bool, MAX_PLAYER_TYPES, true> mIsRequested; /** 文件中没有、已请求后台计算的类型 */
+    KickerBuilder *mpBuilder;            /** 计算文件中没有的表的后台线程，第一次请求时才启动 */
+    ThreadCondition mBuildCondition;     /** 唤醒后台线程 */
+    ThreadMutex mDefaultMutex;           /** 保护0号类型表的计算 */
+    volatile bool mIsStopping;
+
+    char        *mpMappedFile;          /** 映射的kicker_value文件 */
+    size_t      mMappedSize;
 
     ReciprocalCurve mOppCurve;      /** 对手的影响 */
     ReciprocalCurve mRandCurve;     /** 误差的影响 */
@@ -0,0 +1,246 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+
+#include "Localization.h"
+#include "PlayerParam.h"
+#include "Utilities.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const double Localization::ANGLE_EPS = 1.0;
+const double Localization::WIDEN_COST = 1.0;
+const double Localization::WIDEN_SCALE = 3.0;
+
+void Localization::AddMarker(const Vector & global_pos, double dist, AngleDeg global_dir)
+{
+	if (mMarkerCount >= MAX_MARKER_NUM)
+	{
+		PRINT_ERROR("too many markers " << mMarkerCount);
+		return;
+	}
+
+	const double d = PlayerParam::instance().ConvertMarkDist(dist);
+	const double e = PlayerParam::instance().GetEpsInMark(d);
+	const double min_dist = Max(d - e, 0.0);
+	const double max_dist = d + e;
+	const SinCosT dir = SinCos(global_dir);
+
+	const int i = mMarkerCount++;
+	mMarkerX[i] = global_pos.X();
+	mMarkerY[i] = global_pos.Y();
+	mDirX[i] = Cos(dir);
+	mDirY[i] = Sin(dir);
+	mDist[i] = d;
+	mDistEps[i] = e;
+	mMinDist2[i] = min_dist * min_dist;
+	mMaxDist2[i] = max_dist * max_dist;
+	mDist2Scale[i] = 1.0 / (2.0 * Max(d, e) * e); //距离平方的偏差约为2d倍的距离偏差
+	mSideEps[i] = Max(d * Sin(ANGLE_EPS), e);
+
+	if (mNearest < 0 || d < mDist[mNearest])
+	{
+		mNearest = i;
+	}
+}
+
+bool Localization::Estimate(Vector & pos, double & eps)
+{
+	if (mMarkerCount == 0)
+	{
+		return false;
+	}
+
+	const int n = mNearest;
+	const double d = mDist[n];
+	const double e = mDistEps[n];
+
+	//只有一个标志时就是扇环的中心，误差为扇环的外接圆半径
+	if (mMarkerCount == 1)
+	{
+		pos = Vector(mMarkerX[n] - mDirX[n] * d, mMarkerY[n] - mDirY[n] * d);
+		eps = Sqrt(d * d + (d + e) * (d + e) - 2.0 * d * (d + e) * Cos(ANGLE_EPS));
+		return true;
+	}
+
+	double scale = 1.0;
+	SampleParticles(scale);
+	EvaluateParticles();
+	double min_cost = MinParticleCost();
+
+	if (min_cost > WIDEN_COST)
+	{
+		scale = WIDEN_SCALE;
+		SampleParticles(scale);
+		EvaluateParticles();
+		min_cost = MinParticleCost();
+	}
+
+	//即使放大之后仍没有与所有标志都相容的粒子，也取其中最好的
+	double sum_weight = 0.0;
+	double sum_x = 0.0;
+	double sum_y = 0.0;
+	for (int k = 0; k < PARTICLE_NUM; ++k)
+	{
+		const double weight = exp(-0.5 * (mParticleCost[k] - min_cost));
+		sum_weight += weight;
+		sum_x += weight * mParticleX[k];
+		sum_y += weight * mParticleY[k];
+	}
+	pos = Vector(sum_x / sum_weight, sum_y / sum_weight);
+
+	double max_dist2 = 0.0;
+	for (int k = 0; k < PARTICLE_NUM; ++k)
+	{
+		if (mParticleCost[k] - min_cost <= 1.0)
+		{
+			max_dist2 = Max(max_dist2, pos.Dist2(Vector(mParticleX[k], mParticleY[k])));
+		}
+	}
+
+	//再加上半个粒子间隔；标志之间仍不相容时，按剩余的代价（以允许误差为单位）放大
+	const double radius_step = (d + e * scale - Max(d - e * scale, 0.0)) / RADIUS_SAMPLES;
+	const double side_step = d * Deg2Rad(2.0 * ANGLE_EPS * scale) / ANGLE_SAMPLES;
+	eps = Sqrt(max_dist2) + 0.5 * Sqrt(radius_step * radius_step + side_step * side_step);
+	if (min_cost > WIDEN_COST)
+	{
+		eps *= 1.0 + Sqrt(min_cost);
+	}
+	return true;
+}
+
+double Localization::MinParticleCost() const
+{
+	double min_cost = mParticleCost[0];
+	for (int k = 1; k < PARTICLE_NUM; ++k)
+	{
+		min_cost = Min(min_cost, mParticleCost[k]);
+	}
+	return min_cost;
+}
+
+/**
+ * 粒子均匀分布在最近标志的扇环内，误差在估计范围内时真实位置一定在这个扇环里
+ */
+void Localization::SampleParticles(double scale)
+{
+	const int n = mNearest;
+	const double angle_eps = ANGLE_EPS * scale;
+	const double min_dist = Max(mDist[n] - mDistEps[n] * scale, 0.0);
+	const double radius_step = (mDist[n] + mDistEps[n] * scale - min_dist) / RADIUS_SAMPLES;
+	const double angle_step = 2.0 * angle_eps / ANGLE_SAMPLES;
+
+	double offset_x[ANGLE_SAMPLES];
+	double offset_y[ANGLE_SAMPLES];
+	for (int a = 0; a < ANGLE_SAMPLES; ++a)
+	{
+		const SinCosT rotation = SinCos(-angle_eps + (a + 0.5) * angle_step);
+		offset_x[a] = mDirX[n] * Cos(rotation) - mDirY[n] * Sin(rotation);
+		offset_y[a] = mDirY[n] * Cos(rotation) + mDirX[n] * Sin(rotation);
+	}
+
+	for (int r = 0; r < RADIUS_SAMPLES; ++r)
+	{
+		const double radius = min_dist + (r + 0.5) * radius_step;
+		for (int a = 0; a < ANGLE_SAMPLES; ++a)
+		{
+			const int k = r * ANGLE_SAMPLES + a;
+			mParticleX[k] = mMarkerX[n] - radius * offset_x[a];
+			mParticleY[k] = mMarkerY[n] - radius * offset_y[a];
+		}
+	}
+}
+
+/**
+ * 粒子在每个标志下的代价为超出距离范围和方向范围的部分（以允许误差为单位）的平方和。
+ * 外层循环是标志，内层循环是粒子，没有分支；SSE2下两个粒子一组，运算顺序与标量版本相同，结果逐位一致
+ */
+void Localization::EvaluateParticles()
+{
+	for (int k = 0; k < PARTICLE_NUM; ++k)
+	{
+		mParticleCost[k] = 0.0;
+	}
+
+	for (int i = 0; i < mMarkerCount; ++i)
+	{
+		const double marker_x = mMarkerX[i];
+		const double marker_y = mMarkerY[i];
+		const double dir_x = mDirX[i];
+		const double dir_y = mDirY[i];
+		const double min_dist2 = mMinDist2[i];
+		const double max_dist2 = mMaxDist2[i];
+		const double dist2_scale = mDist2Scale[i];
+		const double side_eps = mSideEps[i];
+		const double side_scale = 1.0 / side_eps;
+
+		int k = 0;
+
+#ifdef __SSE2__
+		const __m128d vmarker_x = _mm_set1_pd(marker_x);
+		const __m128d vmarker_y = _mm_set1_pd(marker_y);
+		const __m128d vdir_x = _mm_set1_pd(dir_x);
+		const __m128d vdir_y = _mm_set1_pd(dir_y);
+		const __m128d vmin_dist2 = _mm_set1_pd(min_dist2);
+		const __m128d vmax_dist2 = _mm_set1_pd(max_dist2);
+		const __m128d vdist2_scale = _mm_set1_pd(dist2_scale);
+		const __m128d vside_eps = _mm_set1_pd(side_eps);
+		const __m128d vside_scale = _mm_set1_pd(side_scale);
+		const __m128d zero = _mm_setzero_pd();
+		const __m128d sign_mask = _mm_set1_pd(-0.0);
+
+		for (; k + 1 < PARTICLE_NUM; k += 2)
+		{
+			const __m128d dx = _mm_sub_pd(vmarker_x, _mm_loadu_pd(mParticleX + k));
+			const __m128d dy = _mm_sub_pd(vmarker_y, _mm_loadu_pd(mParticleY + k));
+			const __m128d dist2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+			const __m128d radial = _mm_mul_pd(_mm_max_pd(_mm_max_pd(_mm_sub_pd(vmin_dist2, dist2), _mm_sub_pd(dist2, vmax_dist2)), zero), vdist2_scale);
+			const __m128d cross = _mm_andnot_pd(sign_mask, _mm_sub_pd(_mm_mul_pd(vdir_x, dy), _mm_mul_pd(vdir_y, dx)));
+			const __m128d side = _mm_mul_pd(_mm_max_pd(_mm_sub_pd(cross, vside_eps), zero), vside_scale);
+			const __m128d cost = _mm_add_pd(_mm_mul_pd(radial, radial), _mm_mul_pd(side, side));
+			_mm_storeu_pd(mParticleCost + k, _mm_add_pd(_mm_loadu_pd(mParticleCost + k), cost));
+		}
+#endif
+
+		for (; k < PARTICLE_NUM; ++k)
+		{
+			const double dx = marker_x - mParticleX[k];
+			const double dy = marker_y - mParticleY[k];
+			const double dist2 = dx * dx + dy * dy;
+			const double radial = Max(Max(min_dist2 - dist2, dist2 - max_dist2), 0.0) * dist2_scale;
+			const double side = Max(fabs(dir_x * dy - dir_y * dx) - side_eps, 0.0) * side_scale;
+			mParticleCost[k] += radial * radial + side * side;
+		}
+	}
+}
@@ -0,0 +1,118 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+
+#ifndef __Localization_H__
+#define __Localization_H__
+
+#include "Geometry.h"
+
+/**
+ * 用一次视觉中看到的所有标志计算自己的位置。
+ * server发来的距离按对数量化，方向取整，所以每个标志都把自己限制在一个扇环内，误差模型用PlayerParam::GetEpsInMark。
+ * 在最近标志的扇环内均匀撒固定个数的粒子，用所有标志计算每个粒子的似然，加权平均得到位置，
+ * 与各标志都相容的粒子的范围就是误差；没有粒子与各标志相容时在放大的扇环内重新撒粒子，并相应放大误差。
+ * 粒子和标志按数组分开存放，SSE2下每次计算两个粒子的似然。
+ * Fixed-budget grid particle self localization fusing all seen markers.
+ */
+class Localization
+{
+public:
+	enum {
+		MAX_MARKER_NUM = 64,
+		RADIUS_SAMPLES = 16,
+		ANGLE_SAMPLES = 16,
+		PARTICLE_NUM = RADIUS_SAMPLES * ANGLE_SAMPLES
+	};
+
+	/**
+	 * 方向量化和脖子角度的误差之和（度），与原来只用最近标志时的估计一致
+	 */
+	static const double ANGLE_EPS;
+
+	/**
+	 * 最好的粒子代价超过WIDEN_COST时，说明真实位置可能不在最近标志的扇环内（如脖子角度误差较大），
+	 * 这时把扇环的角度和距离范围放大WIDEN_SCALE倍后重新撒粒子
+	 */
+	static const double WIDEN_COST;
+	static const double WIDEN_SCALE;
+
+	Localization(): mMarkerCount(0), mNearest(-1) {}
+
+	/**
+	 * 加入一个看到的标志
+	 * @param global_pos 标志的全局坐标
+	 * @param dist server发来的距离
+	 * @param global_dir 标志的全局方向，即脖子的全局角度加上server发来的方向
+	 */
+	void AddMarker(const Vector & global_pos, double dist, AngleDeg global_dir);
+
+	int MarkerCount() const { return mMarkerCount; }
+
+	/**
+	 * 计算自己的位置
+	 * @param pos 位置
+	 * @param eps 位置的误差
+	 * @return 没有看到标志时返回false
+	 */
+	bool Estimate(Vector & pos, double & eps);
+
+private:
+	/**
+	 * @param scale 扇环的角度和距离范围相对于最近标志误差的倍数
+	 */
+	void SampleParticles(double scale);
+	void EvaluateParticles();
+	double MinParticleCost() const;
+
+private:
+	int mMarkerCount;
+	int mNearest;
+
+	/** 每个标志的参数，粒子的似然只用到这些 */
+	double mMarkerX[MAX_MARKER_NUM];
+	double mMarkerY[MAX_MARKER_NUM];
+	double mDirX[MAX_MARKER_NUM];				///观察方向的单位向量
+	double mDirY[MAX_MARKER_NUM];
+	double mDist[MAX_MARKER_NUM];				///修正后的距离
+	double mDistEps[MAX_MARKER_NUM];
+	double mMinDist2[MAX_MARKER_NUM];			///距离平方的允许范围
+	double mMaxDist2[MAX_MARKER_NUM];
+	double mDist2Scale[MAX_MARKER_NUM];			///距离平方的偏差换算为误差的倍数
+	double mSideEps[MAX_MARKER_NUM];			///偏离观察方向的允许距离
+
+	double mParticleX[PARTICLE_NUM];
+	double mParticleY[PARTICLE_NUM];
+	double mParticleCost[PARTICLE_NUM];			///负对数似然，与所有标志相容时为0
+};
+
+#endif
@@ -30,7 +30,9 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
  ************************************************************************************/
 
+
 #include <cstdio>
+#include <cstring>
 #include <sstream>
 #include "Logger.h"
 #include "Observer.h"
@@ -38,34 +40,198 @@
 #include "PositionInfo.h"
 #include "InterceptInfo.h"
 
+namespace {
+
+enum LogRecordType {
+	LR_End, // 缓冲区满时的结束标记
+	LR_Show,
+	LR_Point,
+	LR_Line,
+	LR_Circle,
+	LR_TextString,
+	LR_TextChar,
+	LR_TextLong,
+	LR_TextUnsigned,
+	LR_TextDouble,
+	LR_TextTime,
+	LR_TextManip,
+	LR_TextIosManip,
+	LR_TextValue // 格式化函数指针，之后是复制的值
+};
+
+const int MAX_LOG_FRAMES = 8; // log线程跟不上时最多使用的缓冲区数，再多就继续写在当前缓冲区中
 
 /**
- * SightLogger's constructor
+ * 图形记录，点只用mX1, mY1，圆的半径放在mX2
  */
-SightLogger::SightLogger(Observer *observer, WorldState *world_state)
+struct DrawRecord
 {
-	Assert(observer && world_state);
+	int mTime;
+	int mColor;
+	double mX1, mY1;
+	double mX2, mY2;
+};
 
-	mpObserver = observer;
-	mpWorldState = world_state;
+struct TimeRecord
+{
+	int mT;
+	int mS;
+};
+
+typedef std::ostream& (*StreamManip)(std::ostream&);
+typedef std::ios_base& (*IosManip)(std::ios_base&);
+
+const int TEXT_VALUE_OFFSET = 8; // LR_TextValue中复制的值的位置，保持8字节对齐
+
+}
+
+/**
+ * 记录头，之后是定长部分和mTextSize字节的变长部分，总长mSize按8字节对齐
+ */
+struct LogRecord
+{
+	short mType;
+	short mLogger;
+	int mSize;
+	int mTextSize;
+	int mPad;
+
+	const char *Data() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+struct ObjectRecord
+{
+	double mPosX, mPosY;
+	double mVelX, mVelY;
+	int mPosDelay, mVelDelay;
+	double mPosConf, mVelConf;
+
+	void Set(const MobileState & state) {
+		mPosX = state.GetPos().X();
+		mPosY = state.GetPos().Y();
+		mVelX = state.GetVel().X();
+		mVelY = state.GetVel().Y();
+		mPosDelay = state.GetPosDelay();
+		mVelDelay = state.GetVelDelay();
+		mPosConf = state.GetPosConf();
+		mVelConf = state.GetVelConf();
+	}
+};
+
+struct PlayerRecord: public ObjectRecord
+{
+	int mPlayerType;
+	bool mIsAlive;
+	bool mIsGoalie;
+	double mBodyDir, mNeckDir;
+	double mViewAngle;
+	double mStamina, mEffort;
+	int mBodyDirDelay, mNeckDirDelay;
+	double mBodyDirConf, mNeckDirConf;
+
+	void Set(const PlayerState & player) {
+		ObjectRecord::Set(player);
+		mPlayerType = player.GetPlayerType();
+		mIsAlive = player.IsAlive();
+		mIsGoalie = player.IsGoalie();
+		mBodyDir = player.GetBodyDir();
+		mNeckDir = player.GetNeckDir();
+		mViewAngle = sight::ViewAngle(player.GetViewWidth());
+		mStamina = player.GetStamina();
+		mEffort = player.GetEffort();
+		mBodyDirDelay = player.GetBodyDirDelay();
+		mNeckDirDelay = player.GetNeckDirDelay();
+		mBodyDirConf = player.GetBodyDirConf();
+		mNeckDirConf = player.GetNeckDirConf();
+	}
+};
+
+/**
+ * 一个周期的世界状态快照，决策线程只做拷贝
+ */
+struct ShowRecord
+{
+	int mTime;
+	int mStopTime;
+	int mServerPlayMode;
+	int mLeftScore;
+	int mRightScore;
+	ObjectRecord mBall;
+	PlayerRecord mPlayers[2][TEAMSIZE];
+};
+
+/**
+ * Open a log file, piping it through gzip when log_compress is on.
+ */
+bool LogFile::Open(const char *file_name)
+{
+	Close();
+
+#ifndef WIN32
+	if (PlayerParam::instance().LogCompress()) {
+		std::string cmd = std::string("gzip -c > '") + file_name + ".gz'";
+		mpFile = popen(cmd.c_str(), "w");
+		mIsPipe = true;
+	}
+	else
+#endif
+	{
+		mpFile = fopen(file_name, "w");
+		mIsPipe = false;
+	}
+
+	return mpFile != 0;
+}
+
+void LogFile::Close()
+{
+	if (mpFile) {
+#ifndef WIN32
+		if (mIsPipe) {
+			pclose(mpFile);
+		}
+		else
+#endif
+		{
+			fclose(mpFile);
+		}
+		mpFile = 0;
+	}
+}
+
+void LogFile::Write(const std::string & text)
+{
+	if (mpFile && !text.empty()) {
+		fwrite(text.data(), 1, text.size(), mpFile);
+	}
+}
+
+void LogFile::Flush()
+{
+	if (mpFile) {
+		fflush(mpFile);
+	}
+}
+
+/**
+ * SightLogger's constructor
+ */
+SightLogger::SightLogger(Observer *observer)
+{
+	Assert(observer);
 
 	mHeader = "ULG4\n";
 	mHeaderReady = false;
 	mHeaderLogged = false;
 	mLoggedPlayerTypeCount = 0;
 
-	mServerPlayMode = SPM_Null;
-	mServerPlayMode_dirty = true;
-	mLeftScore = 0;
-	mRightScore = 0;
-	mLeftPenTaken = 0;
-	mRightPenTaken = 0;
-	mTeamState_dirty = true;
+	mServerPlayMode = -1;
+	mLeftScore = -1;
+	mRightScore = -1;
 
 	char file_name[256];
-	sprintf( file_name, "%s/%s-%d-sight.log", PlayerParam::instance().logDir().c_str(), PlayerParam::instance().teamName().c_str(), mpObserver->SelfUnum());
-	os.open(file_name);
-	if (!os.good()){
+	sprintf( file_name, "%s/%s-%d-sight.log", PlayerParam::instance().logDir().c_str(), PlayerParam::instance().teamName().c_str(), observer->SelfUnum());
+	if (!mFile.Open(file_name)){
 		PRINT_ERROR("open sight log file error");
 	}
 }
@@ -75,7 +241,8 @@ SightLogger::SightLogger(Observer *observer, WorldState *world_state)
  */
 SightLogger::~SightLogger()
 {
-	os.close();
+	Flush();
+	mFile.Close();
 }
 
 /**
@@ -106,216 +273,165 @@ void SightLogger::SetPlayerTypeMsg(const char *msg)
 	mLoggedPlayerTypeCount ++;
 
 	if (mLoggedPlayerTypeCount >= PlayerParam::instance().playerTypes()){
+		MemoryFence(); // 头部信息写完之后决策线程才能看到mHeaderReady
 		mHeaderReady = true;
 	}
 }
 
 /**
- * Flush sight log to file.
+ * Write the header and the placeholder shows before the first recorded cycle.
  */
-void SightLogger::Flush()
+void SightLogger::WriteHeader(const ShowRecord & show)
 {
 	static const double prec = 0.0001;
 
-	if (mHeaderReady && PlayerParam::instance().SaveSightLog())
-	{
-		if (!mHeaderLogged)
-		{
-			mHeaderLogged = true;
-			os << mHeader << mServerParamMsg << mPlayerParamMsg << mPlayerTypeMsg;
-
-			for (int i = 0; i < mTime.S(); ++i) {
-				os << "(show " << 0
-				<< " ((b)"
-				<< ' ' << Quantize( mpBall->GetPos().X(), prec )
-				<< ' ' << Quantize( mpBall->GetPos().Y(), prec )
-				<< ' ' << Quantize( mpBall->GetVel().X(), prec )
-				<< ' ' << Quantize( mpBall->GetVel().Y(), prec )
-				<< ')';
-
-				for (char side = 'l'; side <= 'r'; side += 'r'-'l'){
-					for (Unum i = 1; i <= TEAMSIZE; ++i){
-						os << " ((" << side << ' ' << i << ')'
-						<< ' ' << 0
-						<< ' ' << "0x0"
-						<< ' ' << i * 4.0 * (side == 'l'? -1: 1)
-						<< ' ' << -37.0
-						<< ' ' << 0
-						<< ' ' << 0
-						<< ' ' << 0
-						<< ' ' << 0
-						<< " (v h " <<  60 << ')'
-						<< " (s " << 0 << ' ' << 0 << ' ' << '1' << ')'
-						<< " (c 0 0 0 0 0 0 0 0 0 0 0))";
-						// end of player
-					}
-				}
-				os << ")\n";
-			}
-		}
-
-		mSightMutex.Lock();
-
-		if (mServerPlayMode_dirty)
-		{
-			mServerPlayMode_dirty = false;
-			os << "(playmode " << mTime.T() << ' ' << ServerPlayModeMap::instance().GetPlayModeString(mServerPlayMode) << ")\n";
-		}
-
-		if ( mTeamState_dirty )
-		{
-			mTeamState_dirty = false;
-			os << "(team " << mTime.T()
-			   << ' ' << ( mLeftName.empty() ? "null" : mLeftName.c_str() )
-			   << ' ' << ( mRightName.empty() ? "null" : mRightName.c_str() )
-			   << ' ' << mLeftScore
-			   << ' ' << mRightScore
-			   << ")\n";
-		}
-
-		os << "(show " << mTime.T()
-		   << " ((b)"
-		   << ' ' << Quantize( mpBall->GetPos().X(), prec )
-		   << ' ' << Quantize( mpBall->GetPos().Y(), prec )
-		   << ' ' << Quantize( mpBall->GetVel().X(), prec )
-		   << ' ' << Quantize( mpBall->GetVel().Y(), prec )
-		   << ')';
+	mHeaderLogged = true;
+	mBuffer << mHeader << mServerParamMsg << mPlayerParamMsg << mPlayerTypeMsg;
 
-		LogBallInfo(*mpBall);
+	for (int i = 0; i < show.mStopTime; ++i) {
+		mBuffer << "(show " << 0
+		<< " ((b)"
+		<< ' ' << Quantize( show.mBall.mPosX, prec )
+		<< ' ' << Quantize( show.mBall.mPosY, prec )
+		<< ' ' << Quantize( show.mBall.mVelX, prec )
+		<< ' ' << Quantize( show.mBall.mVelY, prec )
+		<< ')';
 
-		const PlayerState *p;
 		for (char side = 'l'; side <= 'r'; side += 'r'-'l'){
 			for (Unum i = 1; i <= TEAMSIZE; ++i){
-				p = (side == 'l') ? mpLeftTeam[i] : mpRightTeam[i];
-
-				if (p->IsAlive()){
-					LogPlayerInfo(*p);
-				}
-
-				os << " ((" << side << ' ' << i << ')'
-				   << ' ' << p->GetPlayerType()
-				   << ' ' << (p->IsAlive()? (p->IsGoalie()? "0x9": "0x1"): "0x0")
-				   << ' ' << (p->IsAlive()? Quantize( p->GetPos().X(), prec ): i * 4.0 * (side == 'l'? -1: 1))
-				   << ' ' << (p->IsAlive()? Quantize( p->GetPos().Y(), prec ): -37.0)
-				   << ' ' << Quantize( p->GetVel().X(), prec )
-				   << ' ' << Quantize( p->GetVel().Y(), prec )
-				   << ' ' << Quantize( p->GetBodyDir(), prec )
-				   << ' ' << Quantize( p->GetNeckDir(), prec )
-				   << " (v h " <<  sight::ViewAngle(p->GetViewWidth()) << ')'
-				   << " (s " << p->GetStamina() << ' ' << p->GetEffort() << ' ' << '1' << ')'
-				   << " (c 0 0 0 0 0 0 0 0 0 0 0))";
+				mBuffer << " ((" << side << ' ' << i << ')'
+				<< ' ' << 0
+				<< ' ' << "0x0"
+				<< ' ' << i * 4.0 * (side == 'l'? -1: 1)
+				<< ' ' << -37.0
+				<< ' ' << 0
+				<< ' ' << 0
+				<< ' ' << 0
+				<< ' ' << 0
+				<< " (v h " <<  60 << ')'
+				<< " (s " << 0 << ' ' << 0 << ' ' << '1' << ')'
+				<< " (c 0 0 0 0 0 0 0 0 0 0 0))";
 				// end of player
 			}
 		}
-
-		mSightMutex.UnLock();
-
-		os << ")\n";
-		os.flush();
-	}
-
-	if (PlayerParam::instance().SaveDecLog())
-	{
-		mDecMutex.Lock();
-		int time = mTime.S()<<16 | mTime.T();
-		if (!points.empty()) {
-			for (std::vector<PointShape>::iterator it = points.begin(); it != points.end(); it++)
-			{
-				os << "(draw " << time << ' '<< *it <<")\n";
-			}
-			points.clear();
-		}
-		if (!lines.empty()) {
-			for (std::vector<LineShape>::iterator it = lines.begin(); it != lines.end(); it++)
-			{
-				os << "(draw " << time << ' '<< *it <<")\n";
-			}
-			lines.clear();
-		}
-		if (!circles.empty()) {
-			for (std::vector<CircleShape>::iterator it = circles.begin(); it != circles.end(); it++)
-			{
-				os << "(draw " << time << ' '<< *it <<")\n";
-			}
-			circles.clear();
-		}
-		mDecMutex.UnLock();
-		os.flush();
+		mBuffer << ")\n";
 	}
 }
 
 /**
- * Log the player's sight state.
+ * Format one recorded cycle, plus the state confidence of every object when dec log is on.
  */
-void SightLogger::LogSight()
+void SightLogger::WriteShow(const ShowRecord & show)
 {
-	if (mHeaderReady)
+	static const double prec = 0.0001;
+
+	if (!mHeaderLogged)
 	{
-		mSightMutex.Lock();
+		WriteHeader(show);
+	}
 
-		if (mServerPlayMode != mpObserver->GetServerPlayMode())
-		{
-			mServerPlayMode = mpObserver->GetServerPlayMode();
-			mServerPlayMode_dirty = true;
-		}
+	if (mServerPlayMode != show.mServerPlayMode)
+	{
+		mServerPlayMode = show.mServerPlayMode;
+		mBuffer << "(playmode " << show.mTime << ' ' << ServerPlayModeMap::instance().GetPlayModeString(ServerPlayMode(show.mServerPlayMode)) << ")\n";
+	}
 
-		mTime = mpWorldState->CurrentTime();
+	if ( mLeftScore != show.mLeftScore
+			|| mRightScore != show.mRightScore
+			|| mLeftName != PlayerParam::instance().teamName()
+			|| mRightName != PlayerParam::instance().opponentTeamName()
+	)
+	{
+		mLeftName = PlayerParam::instance().teamName();
+		mRightName = PlayerParam::instance().opponentTeamName();
+		mLeftScore = show.mLeftScore;
+		mRightScore = show.mRightScore;
+		mBuffer << "(team " << show.mTime
+		   << ' ' << ( mLeftName.empty() ? "null" : mLeftName.c_str() )
+		   << ' ' << ( mRightName.empty() ? "null" : mRightName.c_str() )
+		   << ' ' << mLeftScore
+		   << ' ' << mRightScore
+		   << ")\n";
+	}
 
-		if ( mLeftScore != mpWorldState->GetTeammateScore()
-				|| mRightScore != mpWorldState->GetOpponentScore()
-				|| mLeftName != PlayerParam::instance().teamName()
-				|| mRightName != PlayerParam::instance().opponentTeamName()
-		)
-		{
-			mLeftName = PlayerParam::instance().teamName();
-			mRightName = PlayerParam::instance().opponentTeamName();
-			mLeftScore = mpWorldState->GetTeammateScore();
-			mRightScore = mpWorldState->GetOpponentScore();
-			mTeamState_dirty = true;
+	mBuffer << "(show " << show.mTime
+	   << " ((b)"
+	   << ' ' << Quantize( show.mBall.mPosX, prec )
+	   << ' ' << Quantize( show.mBall.mPosY, prec )
+	   << ' ' << Quantize( show.mBall.mVelX, prec )
+	   << ' ' << Quantize( show.mBall.mVelY, prec )
+	   << ')';
+
+	for (int s = 0; s < 2; ++s){
+		const char side = s == 0? 'l': 'r';
+		for (Unum i = 1; i <= TEAMSIZE; ++i){
+			const PlayerRecord & p = show.mPlayers[s][i - 1];
+
+			mBuffer << " ((" << side << ' ' << i << ')'
+			   << ' ' << p.mPlayerType
+			   << ' ' << (p.mIsAlive? (p.mIsGoalie? "0x9": "0x1"): "0x0")
+			   << ' ' << (p.mIsAlive? Quantize( p.mPosX, prec ): i * 4.0 * (side == 'l'? -1: 1))
+			   << ' ' << (p.mIsAlive? Quantize( p.mPosY, prec ): -37.0)
+			   << ' ' << Quantize( p.mVelX, prec )
+			   << ' ' << Quantize( p.mVelY, prec )
+			   << ' ' << Quantize( p.mBodyDir, prec )
+			   << ' ' << Quantize( p.mNeckDir, prec )
+			   << " (v h " <<  p.mViewAngle << ')'
+			   << " (s " << p.mStamina << ' ' << p.mEffort << ' ' << '1' << ')'
+			   << " (c 0 0 0 0 0 0 0 0 0 0 0))";
+			// end of player
 		}
+	}
+	mBuffer << ")\n";
 
-		mpBall = & (mpWorldState->Ball());
+	if (PlayerParam::instance().SaveDecLog())
+	{
+		const int time = show.mStopTime << 16 | show.mTime;
 
-		for (Unum i = 1; i <= TEAMSIZE; ++i)
-		{
-			mpLeftTeam[i] = & (mpWorldState->Teammate(i));
-			mpRightTeam[i] = & (mpWorldState->Opponent(i));
-		}
+		std::stringstream ss;
+		ss << "pos [" << show.mBall.mPosDelay << ", " << show.mBall.mPosConf << "]" << '#'
+		<< "vel [" << show.mBall.mVelDelay << ", " << show.mBall.mVelConf << "]" << '#';
+		WritePoint(time, Vector(show.mBall.mPosX, show.mBall.mPosY), White, ss.str().c_str());
 
-		mSightMutex.UnLock();
+		for (int s = 0; s < 2; ++s){
+			for (Unum i = 1; i <= TEAMSIZE; ++i){
+				const PlayerRecord & p = show.mPlayers[s][i - 1];
+				if (!p.mIsAlive) continue;
+
+				ss.str("");
+				ss << "pos [" << p.mPosDelay << ", " << p.mPosConf << "]" << '#'
+				   << "vel [" << p.mVelDelay << ", " << p.mVelConf << "]" << '#'
+				   << "dir [" << p.mBodyDirDelay << ", " << p.mBodyDirConf << "]" << '#'
+				   << "neck [" << p.mNeckDirDelay << ", " << p.mNeckDirConf << "]";
+				WritePoint(time, Vector(p.mPosX, p.mPosY), White, ss.str().c_str());
+			}
+		}
 	}
 }
 
-void SightLogger::LogPlayerInfo(const PlayerState & player)
+void SightLogger::WritePoint(int time, const Vector & point, Color color, const char *comment)
 {
-	if (PlayerParam::instance().SaveDecLog()){
-		DecLock();
-		LogDec();
-
-		std::stringstream ss;
-		ss << "pos [" << player.GetPosDelay() << ", " << player.GetPosConf() << "]" << '#'
-		   << "vel [" << player.GetVelDelay() << ", " << player.GetVelConf() << "]" << '#'
-		   << "dir [" << player.GetBodyDirDelay() << ", " << player.GetBodyDirConf() << "]" << '#'
-		   << "neck [" << player.GetNeckDirDelay() << ", " << player.GetNeckDirConf() << "]";
-		AddPoint(player.GetPos(), ss.str().c_str(), White);
-
-		DecUnLock();
-	}
+	mBuffer << "(draw " << time << ' '<< PointShape(point, color, comment) <<")\n";
 }
 
-void SightLogger::LogBallInfo(const BallState & ball)
+void SightLogger::WriteLine(int time, const Vector & origin, const Vector & target, Color color)
 {
-	if (PlayerParam::instance().SaveDecLog()){
-		DecLock();
-		LogDec();
+	mBuffer << "(draw " << time << ' '<< LineShape(origin, target, color) <<")\n";
+}
 
-		std::stringstream ss;
-		ss << "pos [" << ball.GetPosDelay() << ", " << ball.GetPosConf() << "]" << '#'
-		<< "vel [" << ball.GetVelDelay() << ", " << ball.GetVelConf() << "]" << '#';
-		AddPoint(ball.GetPos(), ss.str().c_str(), White);
+void SightLogger::WriteCircle(int time, const Vector & origin, double radius, Color color)
+{
+	mBuffer << "(draw " << time << ' '<< CircleShape(origin, radius, color) <<")\n";
+}
 
-		DecUnLock();
-	}
+/**
+ * Flush sight log to file.
+ */
+void SightLogger::Flush()
+{
+	mFile.Write(mBuffer.str());
+	mFile.Flush();
+	mBuffer.str("");
 }
 
 /**
@@ -323,8 +439,9 @@ void SightLogger::LogBallInfo(const BallState & ball)
  * The name of the log file will be "team_name-unum-log_name.log".
  * \param observer for getting player's unum
  * \param log_name
+ * \param id index in Logger's list, stored in every record
  */
-TextLogger::TextLogger(Observer* observer, const char* log_name)
+TextLogger::TextLogger(Observer* observer, const char* log_name, int id): mId(id)
 {
 	char file_name[256];
 
@@ -332,8 +449,7 @@ TextLogger::TextLogger(Observer* observer, const char* log_name)
 	Assert(std::string(log_name) != std::string("sight"));
 
 	sprintf( file_name, "Logfiles/%s-%d-%s.log", PlayerParam::instance().teamName().c_str(), observer->SelfUnum(), log_name);
-	os.open(file_name);
-	if (!os.good()){
+	if (!mFile.Open(file_name)){
 		PRINT_ERROR("open log file error");
 	}
 }
@@ -342,7 +458,7 @@ TextLogger::TextLogger(Observer* observer, const char* log_name)
  * TextLogger's constructor
  * Construct a null logger.
  */
-TextLogger::TextLogger()
+TextLogger::TextLogger(): mId(-1)
 {
 }
 
@@ -351,36 +467,174 @@ TextLogger::TextLogger()
  */
 TextLogger::~TextLogger()
 {
-	os.flush();
-	os.close();
+	Flush();
+	mFile.Close();
+}
+
+void TextLogger::AppendString(const char *value, int size)
+{
+	Logger::instance().Append(LR_TextString, mId, 0, 0, value, size);
+}
+
+void TextLogger::AppendValue(const void *value, int size, ValueCopier copy, ValueFormatter format)
+{
+	LogFrame *frame;
+	char *data = Logger::instance().Reserve(LR_TextValue, mId, TEXT_VALUE_OFFSET + size, frame);
+	if (data != 0) {
+		memcpy(data, &format, sizeof(format));
+		copy(data + TEXT_VALUE_OFFSET, value);
+	}
+	Logger::instance().Commit(frame);
+}
+
+TextLogger& TextLogger::operator<<(const char *value)
+{
+	if (mId >= 0 && PlayerParam::instance().SaveTextLog())
+	{
+		AppendString(value, strlen(value));
+	}
+	return *this;
+}
+
+TextLogger& TextLogger::operator<<(const std::string & value)
+{
+	if (mId >= 0 && PlayerParam::instance().SaveTextLog())
+	{
+		AppendString(value.c_str(), value.size());
+	}
+	return *this;
+}
+
+TextLogger& TextLogger::operator<<(char value)
+{
+	if (mId >= 0 && PlayerParam::instance().SaveTextLog())
+	{
+		Logger::instance().Append(LR_TextChar, mId, &value, sizeof(value));
+	}
+	return *this;
+}
+
+TextLogger& TextLogger::operator<<(int value)
+{
+	return operator<<(long(value));
+}
+
+TextLogger& TextLogger::operator<<(long value)
+{
+	if (mId >= 0 && PlayerParam::instance().SaveTextLog())
+	{
+		Logger::instance().Append(LR_TextLong, mId, &value, sizeof(value));
+	}
+	return *this;
+}
+
+TextLogger& TextLogger::operator<<(unsigned value)
+{
+	return operator<<((unsigned long)(value));
+}
+
+TextLogger& TextLogger::operator<<(unsigned long value)
+{
+	if (mId >= 0 && PlayerParam::instance().SaveTextLog())
+	{
+		Logger::instance().Append(LR_TextUnsigned, mId, &value, sizeof(value));
+	}
+	return *this;
+}
+
+TextLogger& TextLogger::operator<<(double value)
+{
+	if (mId >= 0 && PlayerParam::instance().SaveTextLog())
+	{
+		Logger::instance().Append(LR_TextDouble, mId, &value, sizeof(value));
+	}
+	return *this;
+}
+
+TextLogger& TextLogger::operator<<(const Time & value)
+{
+	if (mId >= 0 && PlayerParam::instance().SaveTextLog())
+	{
+		TimeRecord time = { value.T(), value.S() };
+		Logger::instance().Append(LR_TextTime, mId, &time, sizeof(time));
+	}
+	return *this;
 }
 
 /**
- * Flush log to file
+ * Copied from Mersad-5.9.5-RC2005. I dont know what these two specials
+ * are for. Will cause "undefined reference ..." if removed.
  */
-void TextLogger::Flush()
+TextLogger& TextLogger::operator<<(std::ostream& (*man)(std::ostream&))
 {
-	if (PlayerParam::instance().SaveTextLog())
+	if (mId >= 0 && PlayerParam::instance().SaveTextLog())
 	{
-		os << mBuffer.str();
-		os.flush();
+		Logger::instance().Append(LR_TextManip, mId, &man, sizeof(man));
 	}
-	mBuffer.str("");
+	return *this;
+}
+
+TextLogger& TextLogger::operator<<(std::ios_base& (*man)(std::ios_base&))
+{
+	if (mId >= 0 && PlayerParam::instance().SaveTextLog())
+	{
+		Logger::instance().Append(LR_TextIosManip, mId, &man, sizeof(man));
+	}
+	return *this;
 }
 
 /**
- * Operator <<
- * Usage is the same as ostream.
+ * Format one recorded value into the buffer, in the log thread.
  */
-//template<typename T>
-//TextLogger& operator<<(TextLogger& logger, const T &value)
-//{
-//	if (PlayerParam::instance().SaveTextLog())
-//	{
-//		logger.mBuffer << value;
-//	}
-//	return logger;
-//}
+void TextLogger::Format(const LogRecord & record)
+{
+	const char *data = record.Data();
+
+	switch (record.mType) {
+	case LR_TextString: mFormat.write(data, record.mTextSize); break;
+	case LR_TextChar: mFormat << *data; break;
+	case LR_TextLong: mFormat << *reinterpret_cast<const long*>(data); break;
+	case LR_TextUnsigned: mFormat << *reinterpret_cast<const unsigned long*>(data); break;
+	case LR_TextDouble: mFormat << *reinterpret_cast<const double*>(data); break;
+	case LR_TextTime: {
+		const TimeRecord & time = *reinterpret_cast<const TimeRecord*>(data);
+		mFormat << Time(time.mT, time.mS);
+		break;
+	}
+	case LR_TextManip: {
+		StreamManip man;
+		memcpy(&man, data, sizeof(man));
+		mFormat << man;
+		break;
+	}
+	case LR_TextIosManip: {
+		IosManip man;
+		memcpy(&man, data, sizeof(man));
+		mFormat << man;
+		break;
+	}
+	case LR_TextValue: {
+		ValueFormatter format;
+		memcpy(&format, data, sizeof(format));
+		format(mFormat, const_cast<char*>(data) + TEXT_VALUE_OFFSET);
+		break;
+	}
+	default: break;
+	}
+}
+
+/**
+ * Flush log to file
+ */
+void TextLogger::Flush()
+{
+	if (mId >= 0)
+	{
+		mFile.Write(mFormat.str());
+		mFile.Flush();
+	}
+	mFormat.str("");
+}
 
 /**
  * Return an static instance of Logger
@@ -401,6 +655,13 @@ void Logger::Initial(Observer *observer, WorldState *world_state)
 {
 	mpObserver = observer;
 	mpWorldState = world_state;
+
+	if (PlayerParam::instance().SaveSightLog() || PlayerParam::instance().SaveDecLog() || PlayerParam::instance().SaveTextLog())
+	{
+		mFreeFrames.Push(new LogFrame); // 双缓冲，log线程跟不上时再增加
+		mpCurrentFrame = new LogFrame;
+		mFrameCount = 2;
+	}
 }
 
 /**
@@ -408,11 +669,24 @@ void Logger::Initial(Observer *observer, WorldState *world_state)
  */
 Logger::~Logger()
 {
+	Flush();
+
+	if (mDroppedRecords > 0)
+	{
+		PRINT_ERROR("log buffer full, " << mDroppedRecords << " records dropped");
+	}
+
 	delete mpSightLogger;
 	for (std::map<std::string, TextLogger*>::iterator i = mTextLoggers.begin(); i != mTextLoggers.end(); ++i)
 	{
 		delete i->second;
 	}
+
+	delete mpCurrentFrame;
+	while (LogFrame *frame = mFreeFrames.Pop())
+	{
+		delete frame;
+	}
 }
 
 TextLogger Logger::mTextLoggerNull;
@@ -424,9 +698,9 @@ void Logger::StartRoutine()
 {
 	while (!mCondFlush.Wait(PlayerParam::instance().WaitTimeOut() * 1000))
 	{
-		Flush();
+		Drain();
 	}
-	Flush();
+	Drain();
 }
 
 /**
@@ -438,7 +712,12 @@ SightLogger* Logger::GetSightLogger()
 {
 	if (!mpSightLogger)
 	{
-		mpSightLogger = new SightLogger(mpObserver, mpWorldState);
+		mTextLoggerMutex.Lock();
+		if (!mpSightLogger)
+		{
+			mpSightLogger = new SightLogger(mpObserver);
+		}
+		mTextLoggerMutex.UnLock();
 	}
 	return mpSightLogger;
 }
@@ -453,11 +732,23 @@ TextLogger& Logger::GetTextLogger(const char* log_name)
 {
 	if (PlayerParam::instance().SaveTextLog())
 	{
+		mTextLoggerMutex.Lock();
 		std::map<std::string, TextLogger*>::iterator logger=mTextLoggers.find(log_name);
 		if (logger == mTextLoggers.end())
 		{
-			logger = mTextLoggers.insert(std::make_pair(log_name, new TextLogger(mpObserver, log_name))).first;
+			if (mTextLoggerCount >= MAX_TEXT_LOGGERS)
+			{
+				mTextLoggerMutex.UnLock();
+				return mTextLoggerNull;
+			}
+
+			TextLogger *text_logger = new TextLogger(mpObserver, log_name, mTextLoggerCount);
+			logger = mTextLoggers.insert(std::make_pair(log_name, text_logger)).first;
+			mTextLoggerList[mTextLoggerCount] = text_logger;
+			MemoryFence();
+			mTextLoggerCount = mTextLoggerCount + 1;
 		}
+		mTextLoggerMutex.UnLock();
 		return *(logger->second);
 	}
 	else
@@ -466,29 +757,171 @@ TextLogger& Logger::GetTextLogger(const char* log_name)
 	}
 }
 
+void Logger::Append(int type, int logger, const void *data, int size, const char *text, int text_size)
+{
+	LogFrame *frame;
+	char *record = Reserve(type, logger, size + text_size, frame);
+	if (record != 0) {
+		memcpy(record, data, size);
+		memcpy(record + size, text, text_size);
+		reinterpret_cast<LogRecord*>(record)[-1].mTextSize = text_size;
+	}
+	Commit(frame);
+}
+
 /**
- * flush logs
+ * 先登记为写入者再确认缓冲区没有被换掉，这样log线程在写入者为0之后读到的内容就是完整的
  */
-void Logger::Flush()
+char *Logger::Reserve(int type, int logger, int size, LogFrame *& frame)
 {
+	const int total = (sizeof(LogRecord) + size + 7) & ~7;
+
+	for (;;) {
+		frame = mpCurrentFrame;
+		if (frame == 0) return 0;
+
+		AtomicAdd(&frame->mWriters, 1);
+		if (frame == mpCurrentFrame) break;
+		AtomicAdd(&frame->mWriters, -1);
+	}
+
+	const int offset = AtomicAdd(&frame->mUsed, total);
+	if (offset + total <= LogFrame::CAPACITY) {
+		LogRecord *record = reinterpret_cast<LogRecord*>(frame->mData + offset);
+		record->mType = type;
+		record->mLogger = logger;
+		record->mSize = total;
+		record->mTextSize = 0;
+		return reinterpret_cast<char*>(record + 1);
+	}
+
+	if (offset + int(sizeof(LogRecord)) <= LogFrame::CAPACITY) { //第一个放不下的记录负责写结束标记
+		reinterpret_cast<LogRecord*>(frame->mData + offset)->mType = LR_End;
+	}
+	AtomicAdd(&mDroppedRecords, 1);
+	return 0;
+}
+
+void Logger::Commit(LogFrame *frame)
+{
+	if (frame != 0) {
+		AtomicAdd(&frame->mWriters, -1);
+	}
+}
+
+/**
+ * 换上一块空的缓冲区，把当前缓冲区交给log线程；没有空闲缓冲区时不交出，下个周期的记录接着写
+ */
+void Logger::Publish()
+{
+	if (mpCurrentFrame == 0) return;
+
+	mPublishMutex.Lock();
+
+	LogFrame *frame = mFreeFrames.Pop();
+	if (frame == 0 && mFrameCount < MAX_LOG_FRAMES) {
+		frame = new LogFrame;
+		++mFrameCount;
+	}
+
+	if (frame != 0) {
+		frame->mUsed = 0;
+		MemoryFence();
+
+		LogFrame *full = mpCurrentFrame;
+		mpCurrentFrame = frame;
+		MemoryFence();
+		mFullFrames.Push(full);
+	}
+
+	mPublishMutex.UnLock();
+}
+
+/**
+ * 写入所有已交出的缓冲区，并还给决策线程
+ */
+void Logger::Drain()
+{
+	mDrainMutex.Lock();
+	while (LogFrame *frame = mFullFrames.Pop())
+	{
+		WriteFrame(*frame);
+		mFreeFrames.Push(frame);
+	}
+	mDrainMutex.UnLock();
+}
+
+void Logger::WriteFrame(LogFrame & frame)
+{
+	while (frame.mWriters > 0) { //换下缓冲区之前开始的追加还没有完成
+		WaitFor(0);
+	}
+	MemoryFence();
+
+	const int used = Min(int(frame.mUsed), int(LogFrame::CAPACITY));
+	int offset = 0;
+	while (offset + int(sizeof(LogRecord)) <= used)
+	{
+		const LogRecord & record = *reinterpret_cast<const LogRecord*>(frame.mData + offset);
+		if (record.mType == LR_End) break;
+
+		const DrawRecord & draw = *reinterpret_cast<const DrawRecord*>(record.Data());
+		const SightLogger::Color color = SightLogger::Color(draw.mColor);
+
+		switch (record.mType) {
+		case LR_Show:
+			GetSightLogger()->WriteShow(*reinterpret_cast<const ShowRecord*>(record.Data()));
+			break;
+		case LR_Point:
+			GetSightLogger()->WritePoint(draw.mTime, Vector(draw.mX1, draw.mY1), color, record.mTextSize > 0? record.Data() + sizeof(DrawRecord): "");
+			break;
+		case LR_Line:
+			GetSightLogger()->WriteLine(draw.mTime, Vector(draw.mX1, draw.mY1), Vector(draw.mX2, draw.mY2), color);
+			break;
+		case LR_Circle:
+			GetSightLogger()->WriteCircle(draw.mTime, Vector(draw.mX1, draw.mY1), draw.mX2, color);
+			break;
+		default:
+			if (record.mLogger >= 0 && record.mLogger < mTextLoggerCount)
+			{
+				mTextLoggerList[record.mLogger]->Format(record);
+			}
+			break;
+		}
+
+		offset += record.mSize;
+	}
+
 	if (mpSightLogger)
 	{
 		mpSightLogger->Flush();
 	}
 
-	for (std::map<std::string, TextLogger*>::iterator i = mTextLoggers.begin(); i != mTextLoggers.end(); ++i)
+	for (int i = 0; i < mTextLoggerCount; ++i)
 	{
-		i->second->Flush();
+		mTextLoggerList[i]->Flush();
 	}
 }
 
+/**
+ * flush logs
+ */
+void Logger::Flush()
+{
+	Publish();
+	Drain();
+}
+
 /**
  * set mCondFlush to let LoggerLoop flush logs.
  */
 void Logger::SetFlushCond()
 {
 	if (PlayerParam::instance().SaveSightLog() || PlayerParam::instance().SaveDecLog() || PlayerParam::instance().SaveTextLog())
+	{
+		Publish();
 		mCondFlush.Set();
+	}
 }
 
 /**
@@ -513,36 +946,43 @@ void Logger::InitSightLogger(ServerMsgType msg_type, const char* msg)
 
 /**
  * Log the player's sight state
+ * 只拷贝一份快照，格式化在log线程中进行
  */
 void Logger::LogSight()
 {
-	if (PlayerParam::instance().SaveSightLog())
+	if (PlayerParam::instance().SaveSightLog() && GetSightLogger()->IsHeaderReady())
 	{
-		GetSightLogger()->LogSight();
+		ShowRecord show;
+		show.mTime = mpWorldState->CurrentTime().T();
+		show.mStopTime = mpWorldState->CurrentTime().S();
+		show.mServerPlayMode = mpObserver->GetServerPlayMode();
+		show.mLeftScore = mpWorldState->GetTeammateScore();
+		show.mRightScore = mpWorldState->GetOpponentScore();
+		show.mBall.Set(mpWorldState->GetBall());
+
+		for (Unum i = 1; i <= TEAMSIZE; ++i)
+		{
+			show.mPlayers[0][i - 1].Set(mpWorldState->GetTeammate(i));
+			show.mPlayers[1][i - 1].Set(mpWorldState->GetOpponent(i));
+		}
+
+		Append(LR_Show, 0, &show, sizeof(show));
 	}
 }
 
 void Logger::LogPoint(const Vector & target, SightLogger::Color color, const char* comment)
 {
 	if (PlayerParam::instance().SaveDecLog()){
-		SightLogger *pSightLogger = GetSightLogger();
-		pSightLogger->DecLock();
-		pSightLogger->LogDec();
-		pSightLogger->AddPoint(target, comment, color);
-		pSightLogger->DecUnLock();
+		AddPoint(target, comment, color);
 	}
 }
 
 void Logger::LogGoToPoint(const Vector & start, const Vector & target, const char* comment)
 {
 	if (PlayerParam::instance().SaveDecLog()){
-		SightLogger *pSightLogger = GetSightLogger();
-		pSightLogger->DecLock();
-		pSightLogger->LogDec();
-		pSightLogger->AddPoint(target, comment, SightLogger::Red);
-		pSightLogger->AddCircle(target, 0.2, SightLogger::Red);
-		pSightLogger->AddLine(start, target, SightLogger::Red);
-		pSightLogger->DecUnLock();
+		AddPoint(target, comment, SightLogger::Red);
+		AddCircle(target, 0.2, SightLogger::Red);
+		AddLine(start, target, SightLogger::Red);
 	}
 }
 
@@ -550,12 +990,8 @@ void Logger::LogShoot(const Vector & start, const Vector & target, const char* c
 {
     if (PlayerParam::instance().SaveDecLog())
     {
-        SightLogger *pSightLogger = GetSightLogger();
-        pSightLogger->DecLock();
-        pSightLogger->LogDec();
-        pSightLogger->AddPoint(target, comment, SightLogger::Purple);
-        pSightLogger->AddLine(start, target, SightLogger::Purple);
-        pSightLogger->DecUnLock();
+        AddPoint(target, comment, SightLogger::Purple);
+        AddLine(start, target, SightLogger::Purple);
     }
 }
 
@@ -563,51 +999,33 @@ void Logger::LogIntercept(const Vector & interpt, const char* comment)
 {
 	if (PlayerParam::instance().SaveDecLog())
 	{
-		SightLogger *pSightLogger = GetSightLogger();
-		pSightLogger->DecLock();
-		pSightLogger->LogDec();
-		pSightLogger->AddPoint(interpt, comment, SightLogger::Cyan);
-		pSightLogger->AddCircle(interpt, 0.1, SightLogger::Cyan);
-		pSightLogger->DecUnLock();
+		AddPoint(interpt, comment, SightLogger::Cyan);
+		AddCircle(interpt, 0.1, SightLogger::Cyan);
 	}
 }
 
 void Logger::LogLine(const Vector & begin, const Vector & end, SightLogger::Color color, const char* comment)
 {
 	if (PlayerParam::instance().SaveDecLog()){
-		SightLogger *pSightLogger = GetSightLogger();
-		pSightLogger->DecLock();
-		pSightLogger->LogDec();
-		pSightLogger->AddPoint(end, comment, color);
-		pSightLogger->AddLine(begin, end, color);
-		pSightLogger->DecUnLock();
+		AddPoint(end, comment, color);
+		AddLine(begin, end, color);
 	}
 }
 
 void Logger::LogCircle(const Vector & o, const double & r, SightLogger::Color color)
 {
 	if (PlayerParam::instance().SaveDecLog()){
-		SightLogger *pSightLogger = GetSightLogger();
-		pSightLogger->DecLock();
-		pSightLogger->LogDec();
-		pSightLogger->AddCircle(o, r, color);
-		pSightLogger->DecUnLock();
+		AddCircle(o, r, color);
 	}
 }
 
 void Logger::LogRectangular(const Rectangular & rect, SightLogger::Color color)
 {
 	if (PlayerParam::instance().SaveDecLog()){
-		SightLogger *pSightLogger = GetSightLogger();
-		pSightLogger->DecLock();
-		pSightLogger->LogDec();
-
-		pSightLogger->AddLine(rect.TopLeftCorner(), rect.TopRightCorner(), color);
-		pSightLogger->AddLine(rect.TopLeftCorner(), rect.BottomLeftCorner(), color);
-		pSightLogger->AddLine(rect.BottomLeftCorner(), rect.BottomRightCorner(), color);
-		pSightLogger->AddLine(rect.BottomRightCorner(), rect.TopRightCorner(), color);
-
-		pSightLogger->DecUnLock();
+		AddLine(rect.TopLeftCorner(), rect.TopRightCorner(), color);
+		AddLine(rect.TopLeftCorner(), rect.BottomLeftCorner(), color);
+		AddLine(rect.BottomLeftCorner(), rect.BottomRightCorner(), color);
+		AddLine(rect.BottomRightCorner(), rect.TopRightCorner(), color);
 	}
 }
 
@@ -616,17 +1034,11 @@ void Logger::LogDribble(const Vector & start, const Vector & target, const char
 {
 	if (PlayerParam::instance().SaveDecLog())
     {
-		SightLogger *pSightLogger = GetSightLogger();
-		pSightLogger->DecLock();
-		pSightLogger->LogDec();
-
-        pSightLogger->AddPoint(target, comment, SightLogger::Blue);
+        AddPoint(target, comment, SightLogger::Blue);
         if (is_execute)
         {
-            pSightLogger->AddLine(start, target, SightLogger::Blue);
+            AddLine(start, target, SightLogger::Blue);
         }
-
-		pSightLogger->DecUnLock();
 	}
 }
 
@@ -635,17 +1047,11 @@ void Logger::LogPass(const bool reverse, const Vector & start, const Vector & ta
 {
     if (PlayerParam::instance().SaveDecLog())
     {
-        SightLogger *pSightLogger = GetSightLogger();
-        pSightLogger->DecLock();
-        pSightLogger->LogDec();
-
-        pSightLogger->AddPoint(reverse? target.Rotate(180.0): target, comment, SightLogger::Red);
+        AddPoint(reverse? target.Rotate(180.0): target, comment, SightLogger::Red);
         if (is_execute)
         {
-            pSightLogger->AddLine(reverse? start.Rotate(180.0): start, reverse? target.Rotate(180.0): target, SightLogger::Red);
+            AddLine(reverse? start.Rotate(180.0): start, reverse? target.Rotate(180.0): target, SightLogger::Red);
         }
-
-        pSightLogger->DecUnLock();
     }
 }
 
@@ -653,3 +1059,24 @@ const Time & Logger::CurrentTime()
 {
 	return mpWorldState->CurrentTime();
 }
+
+void Logger::AddPoint(const Vector & point, const char* comment, SightLogger::Color color)
+{
+	const Time & time = CurrentTime();
+	DrawRecord draw = { time.S() << 16 | time.T(), color, point.X(), point.Y(), 0.0, 0.0 };
+	Append(LR_Point, 0, &draw, sizeof(draw), comment, comment? strlen(comment) + 1: 0);
+}
+
+void Logger::AddLine(const Vector & origin, const Vector & target, SightLogger::Color color)
+{
+	const Time & time = CurrentTime();
+	DrawRecord draw = { time.S() << 16 | time.T(), color, origin.X(), origin.Y(), target.X(), target.Y() };
+	Append(LR_Line, 0, &draw, sizeof(draw));
+}
+
+void Logger::AddCircle(const Vector & origin, const double & radius, SightLogger::Color color)
+{
+	const Time & time = CurrentTime();
+	DrawRecord draw = { time.S() << 16 | time.T(), color, origin.X(), origin.Y(), radius, 0.0 };
+	Append(LR_Circle, 0, &draw, sizeof(draw));
+}
@@ -30,15 +30,18 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
  ************************************************************************************/
 
+
 #ifndef __Logger_H__
 #define __Logger_H__
 
 #include <string>
-#include <fstream>
+#include <cstdio>
 #include <sstream>
+#include <fstream>
 #include <iostream>
 #include <vector>
 #include <map>
+#include <new>
 #include "Types.h"
 #include "Geometry.h"
 #include "Thread.h"
@@ -48,9 +51,34 @@ class Observer;
 class BallState;
 class PlayerState;
 class InfoState;
+struct LogRecord;
+struct LogFrame;
+struct ShowRecord;
+
+/**
+ * log文件，打开压缩时通过gzip管道写入.gz文件
+ * Log output file, optionally piped through gzip.
+ */
+class LogFile
+{
+public:
+	LogFile(): mpFile(0), mIsPipe(false) {}
+	~LogFile() { Close(); }
+
+	bool Open(const char *file_name);
+	void Close();
+
+	void Write(const std::string & text);
+	void Flush();
+
+private:
+	FILE *mpFile;
+	bool mIsPipe;
+};
 
 /**
  * Sight log class
+ * 在log线程中把决策线程记录的快照和图形格式化为rcg格式
  */
 class SightLogger
 {
@@ -70,62 +98,43 @@ public:
 	};
 
 	/** Constructor & destructor */
-	SightLogger(Observer *observer, WorldState *world_state);
+	SightLogger(Observer *observer);
 	~SightLogger();
 
 	/** Header tools */
 	void SetServerParamMsg(const char *msg);
 	void SetPlayerParamMsg(const char *msg);
 	void SetPlayerTypeMsg(const char *msg);
+	bool IsHeaderReady() const { return mHeaderReady; }
 
-	/** Log sight */
-	void LogSight();
+	/** 以下只在log线程中调用 */
+	void WriteShow(const ShowRecord & show);
+	void WritePoint(int time, const Vector & point, Color color, const char *comment);
+	void WriteLine(int time, const Vector & origin, const Vector & target, Color color);
+	void WriteCircle(int time, const Vector & origin, double radius, Color color);
 
 	/** flush */
 	void Flush();
 
-	/** Basic drawing tools */
-	void DecLock()   { mDecMutex.Lock(); }
-	void DecUnLock() { mDecMutex.UnLock(); }
-	void LogDec() { mTime = mpWorldState->CurrentTime(); }
-
-	void AddPoint(const Vector & point, const char* comment = 0, Color color = Red) { points.push_back(PointShape(point, color, comment)); }
-	void AddLine(const Vector & origin, const Vector & target, Color color = Yellow) { lines.push_back(LineShape(origin, target, color)); }
-	void AddCircle(const Vector & origin, const double & radius, Color color = White) { circles.push_back(CircleShape(origin, radius, color)); }
-
-	/** Integrated drawing tools */
-    void LogPlayerInfo(const PlayerState & player);
-    void LogBallInfo(const BallState & ball);
-
 private:
-	std::ofstream os;
-	ThreadMutex mSightMutex;
-	ThreadMutex mDecMutex;
+	void WriteHeader(const ShowRecord & show);
 
-	Observer   *mpObserver;
-	WorldState *mpWorldState;
+private:
+	LogFile mFile;
+	std::ostringstream mBuffer; // 一次Flush之间格式化好的内容
 
 	std::string mHeader;
 	std::string mServerParamMsg;
 	std::string mPlayerParamMsg;
 	std::string mPlayerTypeMsg;
 	int mLoggedPlayerTypeCount;
-	bool mHeaderReady; //是否可以记录视觉信息（要先记录好server_param等）
+	volatile bool mHeaderReady; //是否可以记录视觉信息（要先记录好server_param等）
 	bool mHeaderLogged;
-	ServerPlayMode mServerPlayMode;
-	bool mServerPlayMode_dirty;
-	Time mTime;
+	int mServerPlayMode; // 上一次写入的比赛模式和比分，变化时再写入
 	int mLeftScore; //自己总是左边的
 	int mRightScore;
-	int mLeftPenTaken;
-	int mRightPenTaken;
 	std::string mLeftName;
 	std::string mRightName;
-	bool mTeamState_dirty;
-
-	BallState *mpBall;
-	PlayerArray<PlayerState*> mpLeftTeam;
-	PlayerArray<PlayerState*> mpRightTeam;
 
 	struct ItemShape {
 		Color line_color;
@@ -154,18 +163,15 @@ private:
 
 	struct PointShape: public ItemShape {
 		double x, y;
-		std::string comment;
+		const char *comment;
 
-		PointShape (const Vector & point, Color color, const char* cmt = 0): ItemShape(color){
+		PointShape (const Vector & point, Color color, const char* cmt): ItemShape(color){
 			x = point.X();
 			y = point.Y();
-			if (cmt)
-			{
-				comment.assign(cmt);
-			}
+			comment = cmt;
 		};
 
-		friend std::ostream& operator<<(std::ostream &os, PointShape &point) {
+		friend std::ostream& operator<<(std::ostream &os, const PointShape &point) {
 			return os << "(point " << point.x << ' ' << point.y << ' ' << "\"" << point.color() << "\" "<<point.comment<<")";
 		}
 	};
@@ -173,7 +179,6 @@ private:
 	struct LineShape: public ItemShape {
 		double x1, y1;
 		double x2, y2;
-		int width;
 
 		LineShape (const Vector & from, const Vector & to, Color color): ItemShape(color){
 			x1 = from.X();
@@ -197,71 +202,136 @@ private:
 			radius = r;
 		};
 
-		friend std::ostream& operator<<(std::ostream &os, CircleShape &circle) {
+		friend std::ostream& operator<<(std::ostream &os, const CircleShape &circle) {
 			return os << "(circle " << circle.x << ' ' << circle.y << ' ' << circle.radius << " \"" << circle.color() << "\")";
 		}
 	};
-
-	std::vector<PointShape> points;
-	std::vector<LineShape> lines;
-	std::vector<CircleShape> circles;
-
 };
 
 /**
  * Text log class
+ * <<只把值以二进制记录追加到当前周期的缓冲区，格式化和写文件都在log线程中进行
  */
 class TextLogger
 {
-	std::ofstream     os;
-	std::stringstream mBuffer;
-
 public:
-	TextLogger(Observer* observer, const char* log_name);
+	TextLogger(Observer* observer, const char* log_name, int id);
 	TextLogger();
 	~TextLogger();
-	void Flush();
 
 	/**
 	 * Operator <<
 	 * Usage is the same as ostream.
+	 * 常用类型直接记录二进制值，其他类型把值复制到记录中，也在log线程中格式化
 	 */
 	template<typename T>
 	TextLogger& operator<<(const T& value)
 	{
-		if (PlayerParam::instance().SaveTextLog())
+		if (mId >= 0 && PlayerParam::instance().SaveTextLog())
 		{
-			mBuffer << value;
+			AppendValue(&value, sizeof(T), &CopyValue<T>, &FormatValue<T>);
 		}
 		return *this;
 	}
 
+	TextLogger& operator<<(const char *value);
+	TextLogger& operator<<(const std::string & value);
+	TextLogger& operator<<(char value);
+	TextLogger& operator<<(int value);
+	TextLogger& operator<<(long value);
+	TextLogger& operator<<(unsigned value);
+	TextLogger& operator<<(unsigned long value);
+	TextLogger& operator<<(double value);
+	TextLogger& operator<<(const Time & value);
+
 	/**
-	 * Copied from Mersad-5.9.5-RC2005. I dont know what these two specials
-	 * are for. Will cause "undefined reference ..." if removed.
+	 * 操纵符也记录下来，在log线程中作用在这个logger的格式化流上
 	 */
-	TextLogger& operator<<(std::ostream& (*man)(std::ostream&))
-	{
-		if (PlayerParam::instance().SaveTextLog())
-		{
-			mBuffer << man;
-		}
-		return *this;
+	TextLogger& operator<<(std::ostream& (*man)(std::ostream&));
+	TextLogger& operator<<(std::ios_base& (*man)(std::ios_base&));
+
+	/** 以下只在log线程中调用 */
+	void Format(const LogRecord & record);
+	void Flush();
+
+private:
+	/**
+	 * 复制到记录中的值：ValueCopier在调用线程中把值构造在记录里，ValueFormatter在log线程中格式化后析构
+	 */
+	typedef void (*ValueCopier)(void *dest, const void *src);
+	typedef void (*ValueFormatter)(std::ostream & os, void *value);
+
+	template<typename T>
+	static void CopyValue(void *dest, const void *src) { new (dest) T(*static_cast<const T*>(src)); }
+
+	template<typename T>
+	static void FormatValue(std::ostream & os, void *value) { T *p = static_cast<T*>(value); os << *p; p->~T(); }
+
+	void AppendString(const char *value, int size);
+	void AppendValue(const void *value, int size, ValueCopier copy, ValueFormatter format);
+
+	int mId;
+	LogFile mFile;
+	std::ostringstream mFormat; // 格式化用的流，保留操纵符设置的格式
+};
+
+/**
+ * 一个周期的log记录缓冲区。任何线程都可以用原子操作预留空间后追加记录，不需要加锁；
+ * 周期结束时整块交给log线程，同时换上另一块空的缓冲区
+ */
+struct LogFrame
+{
+	enum {
+		CAPACITY = 1 << 20
+	};
+
+	char *mData;
+	volatile int mUsed; // 已预留的字节数，可能超过CAPACITY，超出的记录被丢弃
+	volatile int mWriters; // 正在追加记录的线程数，为0时log线程才能读取
+
+	LogFrame(): mData(new char[CAPACITY]), mUsed(0), mWriters(0) {}
+	~LogFrame() { delete[] mData; }
+};
+
+/**
+ * 单生产者单消费者的无锁环形队列，用于在决策线程和log线程之间传递LogFrame
+ */
+class LogFrameQueue
+{
+public:
+	LogFrameQueue(): mHead(0), mTail(0) {}
+
+	bool Push(LogFrame *frame) {
+		if (mTail - mHead >= QUEUE_SIZE) return false;
+		mFrames[mTail & (QUEUE_SIZE - 1)] = frame;
+		MemoryFence();
+		mTail = mTail + 1;
+		return true;
 	}
-	TextLogger& operator<<(std::ios_base& (*man)(std::ios_base&))
-	{
-		if (PlayerParam::instance().SaveTextLog())
-		{
-			mBuffer << man;
-		}
-		return *this;
+
+	LogFrame *Pop() {
+		if (mHead == mTail) return 0;
+		MemoryFence();
+		LogFrame *frame = mFrames[mHead & (QUEUE_SIZE - 1)];
+		MemoryFence();
+		mHead = mHead + 1;
+		return frame;
 	}
 
-};
+private:
+	enum {
+		QUEUE_SIZE = 64
+	};
 
+	LogFrame *mFrames[QUEUE_SIZE];
+	volatile unsigned mHead;
+	volatile unsigned mTail;
+};
 
 /**
  * Logger
+ * 决策线程只把快照、图形和文本记录成二进制追加到当前LogFrame中，每周期结束时（SetFlushCond）
+ * 通过无锁队列交给log线程；log线程负责全部格式化和写文件，再把LogFrame还回来重复使用。
  */
 class Logger: public Thread
 {
@@ -271,10 +341,25 @@ class Logger: public Thread
 	SightLogger *mpSightLogger;
 	std::map<std::string, TextLogger*> mTextLoggers;
 	static TextLogger mTextLoggerNull;
+	ThreadMutex mTextLoggerMutex; // 只在查找和创建text logger时使用
+
+	enum {
+		MAX_TEXT_LOGGERS = 64
+	};
+	TextLogger *mTextLoggerList[MAX_TEXT_LOGGERS]; // 按编号，log线程只读
+	volatile int mTextLoggerCount;
+
+	LogFrame * volatile mpCurrentFrame;
+	LogFrameQueue mFullFrames; // 决策线程 -> log线程
+	LogFrameQueue mFreeFrames; // log线程 -> 决策线程
+	ThreadMutex mPublishMutex; // 正常只有决策线程提交，信号处理时可能有其他线程
+	ThreadMutex mDrainMutex; // log线程与同步Flush之间互斥，决策线程不使用
+	volatile int mDroppedRecords;
+	int mFrameCount; // 已分配的LogFrame数
 
 	ThreadCondition mCondFlush;
 
-	Logger(): mpObserver(0), mpWorldState(0), mpSightLogger(0) {}
+	Logger(): mpObserver(0), mpWorldState(0), mpSightLogger(0), mTextLoggerCount(0), mpCurrentFrame(0), mDroppedRecords(0), mFrameCount(0) {}
 
 public:
 	static Logger& instance();
@@ -293,11 +378,13 @@ public:
     void StartRoutine();
 
     /**
+     * 交出当前周期的记录并在调用线程中立即写入文件，用于没有log线程的模式
      * flush logs
      */
     void Flush();
 
     /**
+     * 交出当前周期的记录，唤醒log线程写入文件
      * set mCondFlush to let LoggerLoop flush logs.
      */
     void SetFlushCond();
@@ -310,6 +397,20 @@ public:
     SightLogger* GetSightLogger();
     TextLogger& GetTextLogger(const char* logger_name);
 
+    /**
+     * 追加一条记录，可以在任何线程中调用
+     * @param data 定长部分
+     * @param text 记录末尾的变长部分
+     */
+    void Append(int type, int logger, const void *data, int size, const char *text = 0, int text_size = 0);
+
+    /**
+     * 预留一条size字节的记录，返回记录内容的地址，缓冲区放不下时返回0；
+     * 无论是否成功都要用得到的frame调用Commit
+     */
+    char *Reserve(int type, int logger, int size, LogFrame *& frame);
+    void Commit(LogFrame *frame);
+
     /**
      * utilitis - sight log & dec log
      */
@@ -324,6 +425,15 @@ public:
     void LogIntercept(const Vector & interpt, const char* comment =0);
     void LogDribble(const Vector & start, const Vector & target, const char * comment = 0, bool is_execute = false);
     void LogPass(const bool reverse, const Vector & start, const Vector & target, const char * comment = 0, bool is_execute = false);
+
+private:
+    void AddPoint(const Vector & point, const char* comment, SightLogger::Color color);
+    void AddLine(const Vector & origin, const Vector & target, SightLogger::Color color);
+    void AddCircle(const Vector & origin, const double & radius, SightLogger::Color color);
+
+    void Publish();
+    void Drain();
+    void WriteFrame(LogFrame & frame);
 };
 
 #endif
@@ -35,11 +35,11 @@
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
+#include <vector>
 #include "Net.h"
 #include "Types.h"
 #include "Utilities.h"
-
-#define BINARY
+#include "ThreadPool.h"
 
 #define SCAN_PARAMS(p, i, d) if (fscanf(fp, "%d %d %d", &p, &i, &d) < 1) { Assert(0); }
 #define SCAN_TRAIN(patterns, input_size, desire_size, input, desire) \
@@ -52,10 +52,71 @@
 		} \
 	}
 
+namespace {
+
+const int NET_FILE_MAGIC = 0x4e4e4557; //"WENN"
+const int NET_FILE_VERSION = 1;
+const int CACHE_LINE_REALS = 64 / sizeof(real);
+const int MAX_NET_LAYERS = 16;
+const int MAX_NET_UNITS = 4096;
+
+/** 从文件中读出的层数和单元数不合理时说明文件已损坏，不能据此分配内存 */
+bool IsValidShape(int layers, const int *units)
+{
+	if (layers < 2 || layers > MAX_NET_LAYERS)
+		return false;
+	for (int i = 0; i < layers; ++i){
+		if (units[i] <= 0 || units[i] > MAX_NET_UNITS)
+			return false;
+	}
+	return true;
+}
+
+}
+
+/**
+ * 计算一个mini-batch中一段样本的梯度，各任务的梯度分开存放，最后按顺序累加，保证结果与线程数无关
+ */
+class NetGradientTask: public ThreadTask
+{
+public:
+	NetGradientTask(const Net & net, real **input, real **desire, int begin, int end):
+		mNet(net),
+		mInput(input),
+		mDesire(desire),
+		mBegin(begin),
+		mEnd(end),
+		mGradient(net.mWeightCount),
+		mError(0.0)
+	{
+	}
+
+	virtual ~NetGradientTask() {}
+
+	void Run()
+	{
+		mError = mNet.AccumulateGradient(mInput, mDesire, mBegin, mEnd, &mGradient[0]);
+	}
+
+	const std::vector<real> & Gradient() const { return mGradient; }
+	real Error() const { return mError; }
+
+private:
+	const Net & mNet;
+	real **mInput;
+	real **mDesire;
+	int mBegin;
+	int mEnd;
+	std::vector<real> mGradient;
+	real mError;
+};
+
 Net::Net(int layers, int *units)
 {
 	mUnits = 0;
 	mLogName = 0;
+	mBatchSize = 1;
+	mThreads = 1;
 	Construct(layers, units);
 }
 
@@ -63,6 +124,10 @@ Net::Net(const char *fname)
 {
 	mUnits = 0;
 	mLogName = 0;
+	mBatchSize = 1;
+	mThreads = 1;
+	mDesiredError = 0.01;
+	mMaxEpochs = 1000;
 	Construct(fname);
 }
 
@@ -88,14 +153,27 @@ void Net::Construct(int layers, int *units)
 }
 
 void Net::Memaloc(){
+	mWeightCount = 0;
+	for (int i = 1; i < mLayers; ++i){
+		mWeightCount += mUnits[i] * (mUnits[i-1] + 1); //one bias
+	}
+
+	/** 两块权值各自按cache line对齐，中间补齐 */
+	const int stride = (mWeightCount + CACHE_LINE_REALS - 1) / CACHE_LINE_REALS * CACHE_LINE_REALS;
+	mWeightMemory = new real[stride * 2 + CACHE_LINE_REALS];
+	mWeightBuffer = reinterpret_cast<real *>((reinterpret_cast<size_t>(mWeightMemory) + 63) & ~size_t(63));
+	mDeltaWeightBuffer = mWeightBuffer + stride;
+
 	mWeight = new real**[mLayers];
 	mDeltaWeight = new real**[mLayers];
+	int offset = 0;
 	for (int i = 1; i < mLayers; ++i){
 		mWeight[i] = new real*[mUnits[i]];
 		mDeltaWeight[i] = new real*[mUnits[i]];
 		for (int j = 0; j < mUnits[i]; ++j){
-			mWeight[i][j] = new real[mUnits[i-1] + 1]; //one bias
-			mDeltaWeight[i][j] = new real[mUnits[i-1] + 1]; //one bias
+			mWeight[i][j] = mWeightBuffer + offset;
+			mDeltaWeight[i][j] = mDeltaWeightBuffer + offset;
+			offset += mUnits[i-1] + 1;
 		}
 	}
 
@@ -124,15 +202,12 @@ void Net::Destroy()
 	if (mUnits == 0)
 		return;
 	for (int i = 1; i < mLayers; ++i){
-		for (int j = 0; j < mUnits[i]; ++j){
-			delete[] mWeight[i][j];
-			delete[] mDeltaWeight[i][j];
-		}
 		delete[] mWeight[i];
 		delete[] mDeltaWeight[i];
 	}
 	delete[] mWeight;
 	delete[] mDeltaWeight;
+	delete[] mWeightMemory;
 
 	for (int i = 1; i < mLayers; ++i){
 		delete[] mOutput[i];
@@ -146,104 +221,166 @@ void Net::Destroy()
 		delete[] mLogName;
 }
 
-void Net::Save(const char *fname)
+void Net::Save(const char *fname, bool binary)
 {
 	if (mUnits == 0)
 		return;
 	FILE *fp;
-	if ((fp = fopen(fname, "w")) == 0){
+	if ((fp = fopen(fname, binary? "wb": "w")) == 0){
 		perror("BPN::Save(char *fname)");
 		exit(1);
 	}
-#ifdef BINARY
-	fwrite(&mLayers, sizeof(mLayers), 1, fp);
-	fwrite(mUnits, sizeof(*mUnits), mLayers, fp);
-	fwrite(&mEta, sizeof(mEta), 1, fp);
-	fwrite(&mAlpha, sizeof(mAlpha), 1, fp);
-	for (int i = 1; i < mLayers; ++i){
-		for (int j = 0; j < mUnits[i]; ++j){
-			fwrite(mWeight[i][j], sizeof(*mWeight[i][j]), mUnits[i-1]+1, fp);
-		}
+	if (binary){
+		fwrite(&NET_FILE_MAGIC, sizeof(NET_FILE_MAGIC), 1, fp);
+		fwrite(&NET_FILE_VERSION, sizeof(NET_FILE_VERSION), 1, fp);
+		fwrite(&mLayers, sizeof(mLayers), 1, fp);
+		fwrite(mUnits, sizeof(*mUnits), mLayers, fp);
+		fwrite(&mEta, sizeof(mEta), 1, fp);
+		fwrite(&mAlpha, sizeof(mAlpha), 1, fp);
+		fwrite(&mWeightCount, sizeof(mWeightCount), 1, fp);
+		fwrite(mWeightBuffer, sizeof(*mWeightBuffer), mWeightCount, fp);
 	}
-#else
-	fprintf(fp, "#mLayers\n%d\n#mUnits\n", mLayers);
-	for (int i = 0; i < mLayers; ++i){
-		fprintf(fp, "%d ", mUnits[i]);
-	}
-	fprintf(fp, "\n#mEta\n%lf\n#mAlpha\n%lf\n#mWeight\n", mEta, mAlpha);
-	for (int i = 1; i < mLayers; ++i){
-		fprintf(fp, "#Layer %d\n", i);
-		for (int j = 0; j < mUnits[i]; ++j){
-			for (int k = 0; k < mUnits[i-1]+1; ++k){
-				fprintf(fp, "%lf ", mWeight[i][j][k]);
+	else {
+		fprintf(fp, "#mLayers\n%d\n#mUnits\n", mLayers);
+		for (int i = 0; i < mLayers; ++i){
+			fprintf(fp, "%d ", mUnits[i]);
+		}
+		fprintf(fp, "\n#mEta\n%lf\n#mAlpha\n%lf\n#mWeight\n", mEta, mAlpha);
+		for (int i = 1; i < mLayers; ++i){
+			fprintf(fp, "#Layer %d\n", i);
+			for (int j = 0; j < mUnits[i]; ++j){
+				for (int k = 0; k < mUnits[i-1]+1; ++k){
+					fprintf(fp, "%.17g ", mWeight[i][j][k]);
+				}
+				fprintf(fp, "\n");
 			}
 			fprintf(fp, "\n");
 		}
-		fprintf(fp, "\n");
 	}
-#endif
 	fclose(fp);
 }
 
+/**
+ * 根据文件头自动识别格式：带NET_FILE_MAGIC的二进制格式、以#mLayers开头的文本格式，
+ * 或者没有文件头的旧二进制格式（data/sensitivity.net）
+ */
 void Net::Construct(const char *fname)
 {
 	FILE *fp;
-	if ((fp = fopen(fname, "r")) == 0){
+	if ((fp = fopen(fname, "rb")) == 0){
 		perror("BPN::Construct(char *fname)");
 		exit(1);
 	}
-#ifdef BINARY
-	if (fread(&mLayers, sizeof(mLayers), 1, fp) < 1)
-    {
-        Assert(0);
-    }
+
+	char head[8];
+	const size_t head_size = fread(head, 1, sizeof(head), fp);
+	rewind(fp);
+
+	int magic = 0;
+	if (head_size >= sizeof(magic)){
+		memcpy(&magic, head, sizeof(magic));
+	}
+
+	bool ok;
+	if (magic == NET_FILE_MAGIC){
+		ok = ConstructBinary(fp);
+	}
+	else if (head_size == sizeof(head) && strncmp(head, "#mLayers", sizeof(head)) == 0){
+		ok = ConstructText(fp);
+	}
+	else {
+		ok = ConstructLegacyBinary(fp);
+	}
+	fclose(fp);
+
+	if (!ok){
+		/** 权值只读了一部分，这样的网络不能再被使用 */
+		PRINT_ERROR("bad net file " << fname);
+		exit(1);
+	}
+}
+
+bool Net::ConstructBinary(FILE *fp)
+{
+	int magic;
+	int version;
+	if (fread(&magic, sizeof(magic), 1, fp) < 1 || fread(&version, sizeof(version), 1, fp) < 1 || version != NET_FILE_VERSION){
+		return false;
+	}
+	if (fread(&mLayers, sizeof(mLayers), 1, fp) < 1 || mLayers < 2 || mLayers > MAX_NET_LAYERS){
+		return false;
+	}
 	mUnits = new int[mLayers];
-	if (fread(mUnits, sizeof(*mUnits), mLayers, fp) < 1)
-    {
-        Assert(0);
-    }
-    if (fread(&mEta, sizeof(mEta), 1, fp) < 1)
-    {
-        Assert(0);
-    }
-    if (fread(&mAlpha, sizeof(mAlpha), 1, fp) < 1)
-    {
-        Assert(0);
-    }
+	if (fread(mUnits, sizeof(*mUnits), mLayers, fp) < (size_t)mLayers ||
+			!IsValidShape(mLayers, mUnits) ||
+			fread(&mEta, sizeof(mEta), 1, fp) < 1 ||
+			fread(&mAlpha, sizeof(mAlpha), 1, fp) < 1){
+		delete[] mUnits;
+		mUnits = 0;
+		return false;
+	}
 	Memaloc();
 	InitWeight();
 
-	for (int i = 1; i < mLayers; ++i){
-		for (int j = 0; j < mUnits[i]; ++j){
-			if (fread(mWeight[i][j], sizeof(*mWeight[i][j]), mUnits[i-1]+1, fp) < 1)
-            {
-                Assert(0);
-            }
-		}
+	int count;
+	if (fread(&count, sizeof(count), 1, fp) < 1 || count != mWeightCount){
+		return false;
+	}
+	return fread(mWeightBuffer, sizeof(*mWeightBuffer), mWeightCount, fp) == (size_t)mWeightCount;
+}
+
+bool Net::ConstructLegacyBinary(FILE *fp)
+{
+	if (fread(&mLayers, sizeof(mLayers), 1, fp) < 1 || mLayers < 2 || mLayers > MAX_NET_LAYERS){
+		return false;
+	}
+	mUnits = new int[mLayers];
+	if (fread(mUnits, sizeof(*mUnits), mLayers, fp) < (size_t)mLayers ||
+			!IsValidShape(mLayers, mUnits) ||
+			fread(&mEta, sizeof(mEta), 1, fp) < 1 ||
+			fread(&mAlpha, sizeof(mAlpha), 1, fp) < 1){
+		delete[] mUnits;
+		mUnits = 0;
+		return false;
+	}
+	Memaloc();
+	InitWeight();
+
+	/** 旧格式中的权值也是按层、单元依次存放的，和mWeightBuffer的布局相同 */
+	return fread(mWeightBuffer, sizeof(*mWeightBuffer), mWeightCount, fp) == (size_t)mWeightCount;
+}
+
+bool Net::ConstructText(FILE *fp)
+{
+	if (fscanf(fp, "#mLayers\n%d\n#mUnits\n", &mLayers) < 1 || mLayers < 2 || mLayers > MAX_NET_LAYERS){
+		return false;
 	}
-#else
-	fscanf(fp, "#mLayers\n%d\n#mUnits\n", &mLayers);
 	mUnits = new int[mLayers];
 	for (int i = 0; i < mLayers; ++i){
-		fscanf(fp, "%d ", &mUnits[i]);
+		if (fscanf(fp, "%d ", &mUnits[i]) < 1) {
+			delete[] mUnits;
+			mUnits = 0;
+			return false;
+		}
+	}
+	if (!IsValidShape(mLayers, mUnits) || fscanf(fp, "\n#mEta\n%lf\n#mAlpha\n%lf\n#mWeight\n", &mEta, &mAlpha) < 2) {
+		delete[] mUnits;
+		mUnits = 0;
+		return false;
 	}
-	fscanf(fp, "\n#mEta\n%lf\n#mAlpha\n%lf\n#mWeight\n", &mEta, &mAlpha);
 	int tmp;
 	Memaloc();
 	InitWeight();
 
 	for (int i = 1; i < mLayers; ++i){
-		fscanf(fp, "#Layer %d\n", &tmp);
+		if (fscanf(fp, "#Layer %d\n", &tmp) < 1) return false;
 		for (int j = 0; j < mUnits[i]; ++j){
 			for (int k = 0; k < mUnits[i-1]+1; ++k){
-				fscanf(fp, "%lf ", &mWeight[i][j][k]);
+				if (fscanf(fp, "%lf ", &mWeight[i][j][k]) < 1) return false;
 			}
-			fscanf(fp, "\n");
 		}
-		fscanf(fp, "\n");
 	}
-#endif
-	fclose(fp);
+	return true;
 }
 
 inline real Net::sigmoid(real s)
@@ -336,6 +473,20 @@ void Net::SetMaxEpochs(int m)
 	mMaxEpochs = m;
 }
 
+void Net::SetBatchSize(int b)
+{
+	mBatchSize = Max(b, 1);
+}
+
+/**
+ * 梯度计算使用ThreadPool，除调用线程外再启动threads-1个工作线程
+ */
+void Net::SetThreads(int threads)
+{
+	mThreads = Max(threads, 1);
+	ThreadPool::instance().Start(mThreads - 1);
+}
+
 void Net::SetDefaultValue()
 {
 	SetLearningRate(0.7);
@@ -380,6 +531,118 @@ real Net::Train(real *input, real *desire)
 	return Error();
 }
 
+/**
+ * 对样本[begin, end)累加误差对各权值的梯度（与UpdateWeight中的符号相同），返回误差平方和。
+ * 只读mWeight，输出和delta使用局部的缓存，可以在多个线程中同时调用
+ */
+real Net::AccumulateGradient(real **input, real **desire, int begin, int end, real *gradient) const
+{
+	std::vector<int> offset(mLayers + 1, 0);
+	for (int i = 0; i < mLayers; ++i){
+		offset[i+1] = offset[i] + mUnits[i];
+	}
+	std::vector<real> output(offset[mLayers]);
+	std::vector<real> delta(offset[mLayers]);
+
+	for (int i = 0; i < mWeightCount; ++i){
+		gradient[i] = 0.0;
+	}
+
+	real error = 0.0;
+	for (int p = begin; p < end; ++p){
+		for (int k = 0; k < mUnits[0]; ++k){
+			output[k] = input[p][k];
+		}
+
+		for (int i = 1; i < mLayers; ++i){
+			const real *prev = &output[offset[i-1]];
+			for (int j = 0; j < mUnits[i]; ++j){
+				const real *w = mWeight[i][j];
+				real s = w[mUnits[i-1]]; //bias
+				for (int k = 0; k < mUnits[i-1]; ++k){
+					s += prev[k] * w[k];
+				}
+				output[offset[i] + j] = 1.0/(1.0 + exp(-s));
+			}
+		}
+
+		const int last = mLayers - 1;
+		for (int j = 0; j < mUnits[last]; ++j){
+			const real o = output[offset[last] + j];
+			const real e = desire[p][j] - o;
+			error += e * e;
+			delta[offset[last] + j] = e * o * (1.0 - o);
+		}
+
+		for (int i = last - 1; i >= 1; --i){
+			for (int j = 0; j < mUnits[i]; ++j){
+				real d = 0.0;
+				for (int k = 0; k < mUnits[i+1]; ++k){
+					d += delta[offset[i+1] + k] * mWeight[i+1][k][j];
+				}
+				const real o = output[offset[i] + j];
+				delta[offset[i] + j] = d * o * (1.0 - o);
+			}
+		}
+
+		for (int i = 1; i < mLayers; ++i){
+			const real *prev = &output[offset[i-1]];
+			for (int j = 0; j < mUnits[i]; ++j){
+				real *g = gradient + (mWeight[i][j] - mWeightBuffer);
+				const real d = delta[offset[i] + j];
+				for (int k = 0; k < mUnits[i-1]; ++k){
+					g[k] += d * prev[k];
+				}
+				g[mUnits[i-1]] += d;
+			}
+		}
+	}
+
+	return error;
+}
+
+/**
+ * 每mBatchSize个样本更新一次权值，梯度取平均。每个mini-batch按mThreads分段并行计算梯度
+ */
+real Net::TrainBatch(real **input, real **desire, int patterns)
+{
+	if (mUnits == 0)
+		return -1.0;
+
+	real error = 0.0;
+	std::vector<NetGradientTask *> tasks;
+
+	for (int begin = 0; begin < patterns; begin += mBatchSize){
+		const int end = Min(begin + mBatchSize, patterns);
+		const int slices = Min(mThreads, end - begin);
+
+		for (int t = 0; t < slices; ++t){
+			tasks.push_back(new NetGradientTask(*this, input, desire,
+					begin + (end - begin) * t / slices, begin + (end - begin) * (t + 1) / slices));
+			ThreadPool::instance().Submit(tasks.back());
+		}
+		ThreadPool::instance().Wait();
+
+		const real rate = mEta / (end - begin);
+		for (int i = 0; i < mWeightCount; ++i){
+			real g = 0.0;
+			for (int t = 0; t < slices; ++t){
+				g += tasks[t]->Gradient()[i];
+			}
+			mDeltaWeightBuffer[i] = rate * g + mAlpha * mDeltaWeightBuffer[i];
+			mWeightBuffer[i] += mDeltaWeightBuffer[i];
+		}
+
+		for (int t = 0; t < slices; ++t){
+			error += tasks[t]->Error();
+			delete tasks[t];
+		}
+		tasks.clear();
+	}
+
+	return error;
+}
+
 void Net::TrainOnFile(const char *fname)
 {
 	if (mUnits == 0)
@@ -419,8 +682,13 @@ void Net::TrainOnFile(const char *fname)
 	while(epochs <= mMaxEpochs){
 		++epochs;
 		real error = 0.0;
-		for (int p = 0; p < patterns; ++p){
-			error += Train(input[p], desire[p]);
+		if (mBatchSize > 1){
+			error = TrainBatch(input, desire, patterns);
+		}
+		else {
+			for (int p = 0; p < patterns; ++p){
+				error += Train(input[p], desire[p]);
+			}
 		}
 		if (mLogName){
 			fprintf(log_file, "%d %f\n", epochs, error);
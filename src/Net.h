@@ -33,14 +33,20 @@
 #ifndef BPN_H_
 #define BPN_H_
 
+#include <cstdio>
+
 typedef double real;
 
 class Net {
 	int mLayers;                   ///number of layers(including input layer)
 	int  *mUnits;                  ///the number of units of each layer
 
-	real ***mWeight;               ///weight of each conjuction between units
-	real ***mDeltaWeight;          ///delta weight of each conjuction between units
+	real ***mWeight;               ///weight of each conjuction between units, pointing into mWeightBuffer
+	real ***mDeltaWeight;          ///delta weight of each conjuction between units, pointing into mDeltaWeightBuffer
+	real *mWeightMemory;           ///raw memory holding both weight buffers
+	real *mWeightBuffer;           ///all weights stored contiguously as [layer][unit][input..., bias], cache line aligned
+	real *mDeltaWeightBuffer;      ///same layout as mWeightBuffer
+	int mWeightCount;              ///number of reals in mWeightBuffer
 	real **mDelta;                 ///delta value of each unit
 	real **mOutput;                ///output value of each unit
 	real *mDesire;                 ///desired output value of output layer
@@ -49,6 +55,8 @@ class Net {
 	real mAlpha;
 	real mDesiredError;
 	int mMaxEpochs;
+	int mBatchSize;                ///samples per weight update in TrainOnFile, 1 means online training
+	int mThreads;                  ///threads computing the gradient of a mini-batch
 
 	char *mLogName;
 public:
@@ -59,10 +67,11 @@ public:
 	void Construct(int layers, int *units);
 	void Construct(const char *fname);
 	void Destroy();
-	void Save(const char *fname);
+	void Save(const char *fname, bool binary = true); ///binary: header + flat weights, otherwise text
 
 	void Run(real *input, real *output);               ///calc outout of input and return sum of square error
 	real Train(real *input, real *desire);             ///train network with sample <Input, Desire>
+	real TrainBatch(real **input, real **desire, int patterns); ///one epoch of mini-batch training, return sum of square error
 	void TrainOnFile(const char *fname);
 	real TestOnFile(const char *fname);
 	real Error();
@@ -72,9 +81,22 @@ public:
 	void SetDesiredError(real d);
 	void SetLogName(const char *);
 	void SetMaxEpochs(int );
+	void SetBatchSize(int );
+	void SetThreads(int );
+
+	int GetLayers() const { return mLayers; }
+	int GetUnits(int layer) const { return mUnits[layer]; }
+	const real *GetWeightBuffer() const { return mWeightBuffer; } ///[layer][unit][input..., bias]
+	int GetWeightCount() const { return mWeightCount; }
 private:
+	friend class NetGradientTask;
+
 	Net(const Net &);
 	void Memaloc();
+	bool ConstructBinary(FILE *fp);
+	bool ConstructLegacyBinary(FILE *fp);
+	bool ConstructText(FILE *fp);
+	real AccumulateGradient(real **input, real **desire, int begin, int end, real *gradient) const;
 	void SetDefaultValue();
 
 	void SetInput(real *input);
@@ -342,6 +342,8 @@ NetworkTest::NetworkTest()
     CMDExecute.Tackles = 0;
     CMDExecute.Pointtos = 0;
     CMDExecute.Attentiontos = 0;
+
+    mIsWakeupPending = false;
 }
 
 NetworkTest::~NetworkTest()
@@ -627,6 +629,31 @@ void NetworkTest::AddCommandSendEnd(Time current_time)
 }
 
 
+//==============================================================================
+void NetworkTest::AddWakeupBegin()
+{
+    if (PlayerParam::instance().NetworkTest())
+    {
+        mWakeupRecord.mBeginTime = GetRealTime();
+        mIsWakeupPending = true;
+    }
+}
+
+
+//==============================================================================
+void NetworkTest::AddWakeupEnd(Time current_time)
+{
+    if (PlayerParam::instance().NetworkTest() && mIsWakeupPending)
+    {
+        mIsWakeupPending = false;
+        mWakeupRecord.mEndTime  = GetRealTime();
+        mWakeupRecord.mCostTime = mWakeupRecord.mEndTime.Sub(mWakeupRecord.mBeginTime);
+        mWakeupRecord.mTime     = current_time;
+        mWakeupList.push_back(mWakeupRecord);
+    }
+}
+
+
 //==============================================================================
 void NetworkTest::WriteRealTimeRecord()
 {
@@ -685,6 +712,24 @@ void NetworkTest::WriteRealTimeRecord()
             }
             out_commandsend.close();
         }
+
+        if (mWakeupList.size() > 0)
+        {
+            char wakeup_file[128];
+	        sprintf(wakeup_file,"Test/RealTime-Wakeup-%d.txt", mUnum);
+            std::ofstream out_wakeup(wakeup_file);
+            if (out_wakeup.good() == true)
+            {
+                for (unsigned i = 0; i < mWakeupList.size(); ++i)
+                {
+                    out_wakeup << mWakeupList[i].mCostTime << " us" <<
+                        "\t" << mWakeupList[i].mBeginTime <<
+                        "\t" << mWakeupList[i].mEndTime <<
+                        "\t" << mWakeupList[i].mTime << std::endl;
+                }
+            }
+            out_wakeup.close();
+        }
     }
 }
 
@@ -219,16 +219,25 @@ public:
     void AddCommandSendBegin();
     void AddCommandSendEnd(Time current_time);
 
+    /**
+     * 从可以决策的消息（sight或think）解析完到本周期命令发出的间隔（微秒），衡量线程唤醒的抖动
+     */
+    void AddWakeupBegin();
+    void AddWakeupEnd(Time current_time);
+
     void WriteRealTimeRecord();
 
 private:
     std::vector<RealTimeRecord> mParserList;
     std::vector<RealTimeRecord> mDecisionList;
     std::vector<RealTimeRecord> mCommandSendList;
+    std::vector<RealTimeRecord> mWakeupList;
 
     RealTimeRecord  mParserRecord;
     RealTimeRecord  mDecisionRecord;
     RealTimeRecord  mCommandSendRecord;
+    RealTimeRecord  mWakeupRecord;
+    bool            mIsWakeupPending; // 本周期已经有wakeup开始时间
 };
 
 
@@ -34,6 +34,7 @@
 #include "Observer.h"
 #include "PlayerParam.h"
 #include "Logger.h"
+#include "NetworkTest.h"
 
 Observer::Observer()
 {
@@ -722,6 +723,34 @@ bool Observer::WaitForCoachNewHear()
 	return true;
 }
 
+//==============================================================================
+bool Observer::CheckNewSense()
+{
+	if (mIsBeginDecision == false) {
+		mIsBeginDecision = true; // 与WaitForNewSense一致，第一次决策前到达的sense不算
+		mSenseArrived = false;
+		return false;
+	}
+
+	bool ret = mSenseArrived;
+	mSenseArrived = false;
+	return ret;
+}
+
+bool Observer::CheckNewSight()
+{
+	bool ret = mSightArrived;
+	mSightArrived = false;
+	return ret;
+}
+
+bool Observer::CheckNewThink()
+{
+	bool ret = mThinkArrived;
+	mThinkArrived = false;
+	return ret;
+}
+
 //==============================================================================
 void Observer::SetNewSense()
 {
@@ -738,6 +767,7 @@ void Observer::SetNewThink()
 	mIsNewThink = true;
 	mSightArrived = true;
 	mThinkArrived = true;
+	NetworkTest::instance().AddWakeupBegin();
 	mCondNewThink.Set();
 }
 
@@ -747,6 +777,7 @@ void Observer::SetNewSight()
 	mIsNewSight = true;
 	mSightArrived = true;
 	mThinkArrived = false;
+	NetworkTest::instance().AddWakeupBegin();
 	mCondNewSight.Set();
 }
 
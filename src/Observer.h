@@ -751,6 +751,13 @@ public:
 	bool WaitForNewThink();
 	bool WaitForCommandSend();
 	bool WaitForCoachNewHear(); // coach用来等待hear信息
+
+	/*
+	 * 单线程事件循环中使用，不阻塞：新信息已经到达时清除标记并返回true
+	 */
+	bool CheckNewSense();
+	bool CheckNewSight();
+	bool CheckNewThink();
 	void SetNewSense();
 	void SetNewSight();
 	void SetNewThink();
@@ -41,6 +41,9 @@
 #include "Logger.h"
 #include "Thread.h"
 #include "NetworkTest.h"
+#include "Dasher.h"
+#include "Kicker.h"
+#include "Tracer.h"
 
 char Parser::mBuf[MAX_MESSAGE];
 bool Parser::mIsPlayerTypesReady = false;
@@ -52,6 +55,73 @@ const double Parser::INVALID_VALUE = std::numeric_limits<double>::max();
 #define PARSE_ERROR(x)
 #endif
 
+namespace {
+/**
+ * 视觉信息中球门和标志的名字，顺序与MarkerType一致
+ */
+const char *MARKER_NAMES[FLAG_MAX] = {
+	"g l", "g r",
+	"f c", "f c t", "f c b", "f l t", "f l b", "f r t", "f r b",
+	"f p l t", "f p l c", "f p l b", "f p r t", "f p r c", "f p r b",
+	"f g l t", "f g l b", "f g r t", "f g r b",
+	"f t l 50", "f t l 40", "f t l 30", "f t l 20", "f t l 10", "f t 0",
+	"f t r 10", "f t r 20", "f t r 30", "f t r 40", "f t r 50",
+	"f b l 50", "f b l 40", "f b l 30", "f b l 20", "f b l 10", "f b 0",
+	"f b r 10", "f b r 20", "f b r 30", "f b r 40", "f b r 50",
+	"f l t 30", "f l t 20", "f l t 10", "f l 0", "f l b 10", "f l b 20", "f l b 30",
+	"f r t 30", "f r t 20", "f r t 10", "f r 0", "f r b 10", "f r b 20", "f r b 30"
+};
+
+/**
+ * 标志名到MarkerType的完美散列表，代替逐字符的判断树。
+ * 名字以')'结尾，在这个乘数和表大小下55个名字没有冲突。
+ */
+class MarkerNameMap {
+public:
+	static MarkerNameMap & instance() {
+		static MarkerNameMap marker_name_map;
+		return marker_name_map;
+	}
+
+	MarkerType GetMarker(const char *name) const {
+		MarkerType marker = mHashTable[HashSlot(name)];
+		if (marker != FLAG_NONE &&
+				!strncmp(name, MARKER_NAMES[marker], mNameLength[marker]) && name[mNameLength[marker]] == ')') {
+			return marker;
+		}
+		return FLAG_NONE;
+	}
+
+private:
+	MarkerNameMap() {
+		for (int i = 0; i < HASH_TABLE_SIZE; ++i) {
+			mHashTable[i] = FLAG_NONE;
+		}
+
+		for (int i = 0; i < FLAG_MAX; ++i) {
+			unsigned slot = parser::hash_name(MARKER_NAMES[i], HASH_MULTIPLIER) & (HASH_TABLE_SIZE - 1);
+			if (mHashTable[slot] != FLAG_NONE) {
+				PRINT_ERROR("marker name hash collision: " << MARKER_NAMES[i] << " and " << MARKER_NAMES[mHashTable[slot]]);
+			}
+			mHashTable[slot] = MarkerType(i);
+			mNameLength[i] = strlen(MARKER_NAMES[i]);
+		}
+	}
+
+	static unsigned HashSlot(const char *name) {
+		return parser::hash_name(name, HASH_MULTIPLIER, ')') & (HASH_TABLE_SIZE - 1);
+	}
+
+	enum {
+		HASH_MULTIPLIER = 45,
+		HASH_TABLE_SIZE = 512
+	};
+
+	MarkerType mHashTable[HASH_TABLE_SIZE];
+	size_t mNameLength[FLAG_MAX];
+};
+}
+
 
 Parser::Parser(Observer *p_observer)
 {
@@ -95,6 +165,8 @@ Parser::~Parser()
 
 void Parser::StartRoutine()
 {
+	Tracer::instance().SetThreadName("Parser");
+
 	ConnectToServer();
 
 	while( true )
@@ -123,16 +195,24 @@ void Parser::ConnectToServer()
 	SendInitialLizeMsg();
 	do {
 		UDPSocket::instance().Receive(mBuf);
-	} while (!ParseInitializeMsg(mBuf));
+	} while (!ParseConnectMsg(mBuf));
+
+	//Logger::instance().GetTextLogger("msg-text") << mBuf << std::endl;
+}
+
+bool Parser::ParseConnectMsg(const char *msg)
+{
+	if (!ParseInitializeMsg(msg)) {
+		return false;
+	}
 
 	mOkMutex.Lock();
 	mConnectServerOk = true;
 	mOkMutex.UnLock();
 
 	DynamicDebug::instance().Initial(mpObserver); // 动态调试的初始化，知道自己是哪边了才能初始化，位置不能动
-	DynamicDebug::instance().AddMessage(mBuf, MT_Parse); // 动态调试记录Parse信息
-
-	//Logger::instance().GetTextLogger("msg-text") << mBuf << std::endl;
+	DynamicDebug::instance().AddMessage(msg, MT_Parse); // 动态调试记录Parse信息
+	return true;
 }
 
 void Parser::SendInitialLizeMsg(){
@@ -216,12 +296,15 @@ bool Parser::ParseInitializeMsg(const char *msg)
 
 	TimeTest::instance().SetUnum(my_unum); // TimeTest的记录文件名会用到
 	NetworkTest::instance().SetUnum(my_unum);
+	Tracer::instance().SetUnum(my_unum);
 
 	return true;
 }
 
 void Parser::Parse(char *msg)
 {
+	TRACE_SPAN(TS_Parse);
+
 	ServerMsgType msg_type = None_Msg;
 
 	switch ( msg[1] ) {
@@ -514,6 +597,8 @@ void Parser::ParseTime(char *msg, char **end_ptr, bool is_new_cycle)
 			PRINT_ERROR("Player " << mpObserver->SelfUnum() << " miss a sense at " << mpObserver->CurrentTime());
 		}
 	}
+
+	Tracer::instance().SetCycle(mpObserver->CurrentTime().T());
 }
 
 void Parser::ParsePlayerParam(char *msg)
@@ -548,6 +633,14 @@ void Parser::ParsePlayerType(char *msg)
 
 	if (type >= PlayerParam::instance().playerTypes() - 1) {
 		mIsPlayerTypesReady = true;
+
+		if (PlayerParam::instance().DasherTable()) {
+			Dasher::instance().BuildReachabilityTables(); //比赛开始前生成，避免在决策中第一次查询时生成
+		}
+
+		if (PlayerParam::instance().KickerMode() == 0 && !PlayerParam::instance().isCoach() && !PlayerParam::instance().isTrainer()) {
+			Kicker::instance().BuildUtilityTables(); //同上，文件中缺少的类型给出警告
+		}
 	}
 }
 
@@ -574,8 +667,8 @@ void Parser::ParseSight(char *msg)
 	while ( msg != 0 ){ // 直到没有object为止
 		msg += 2; // 跳过 ((
 		ObjType obj = ParseObjType(msg); // 获得object的类型
-		msg = strchr(msg,')');
-		ObjProperty prop = ParseObjProperty(msg + 1);  // 获得object的属性
+		msg = strchr(msg,')') + 1;
+		ObjProperty prop = ParseObjProperty(&msg);  // 获得object的属性，msg停在object末尾的')'处
 
 		switch ( obj.type ) {
 		case OBJ_Marker:
@@ -662,7 +755,6 @@ Parser::ObjType Parser::ParseObjType(char *msg)
 	switch( *msg ) {
 	case 'g':
 	case 'G':
-		return ParseGoal(msg);
 	case 'f':
 	case 'F':
 		return ParseMarker(msg);
@@ -683,175 +775,23 @@ Parser::ObjType Parser::ParseObjType(char *msg)
 	return result;
 }
 
-Parser::ObjType Parser::ParseGoal(char *msg)
+Parser::ObjType Parser::ParseMarker(char *msg)
 {
 	ObjType result;
-	if ( *msg == 'g' ) { // goal
+	if ( *msg == 'g' || *msg == 'f' ) { // goal or flag
 		result.type = OBJ_Marker;
-		msg += 2; // 'g '
-		if ( *msg == 'r' ) { result.marker = Goal_R; } else
-			if ( *msg == 'l' ) { result.marker = Goal_L; }
-			else { PARSE_ERROR("goal ?"); }
+		result.marker = MarkerNameMap::instance().GetMarker(msg);
+		if ( result.marker == FLAG_NONE ) {
+			PARSE_ERROR("marker ?");
+		}
 	}
-	else if ( *msg =='G' ){ // goal behind
+	else if ( *msg == 'G' || *msg == 'F' ) { // goal or flag behind
 		result.type = OBJ_Marker_Behind;
-		//result.marker = _pMem->ClosestGoal(); TODO: how to process?
+		//result.marker = _pMem->ClosestFlagTo(); /*TODO:  could be No_Marker */
 	}
 	return result;
 }
 
-Parser::ObjType Parser::ParseMarker(char *msg)
-{
-	ObjType result;
-	if ( *msg == 'f' ){	// flag
-		result.type = OBJ_Marker;
-		msg += 2;     // 'f '
-		if ( *msg == 'r' ){
-			msg += 2; // 'r'
-			if ( *msg == '0' ) { result.marker = Flag_R0; }
-			else if ( *msg == 'b' ){
-				msg += 1;
-				if ( *msg== ')' ) { result.marker = Flag_RB; }
-				else { // flag r b
-					msg += 1; // skip space
-					if ( *msg == '1' ) { result.marker = Flag_RB10; } else
-						if ( *msg == '2' ) { result.marker = Flag_RB20; } else
-							if ( *msg == '3' ) { result.marker = Flag_RB30; }
-							else { PARSE_ERROR("flag r b ?"); }
-				}
-			} else
-				if ( *msg == 't' ) {
-					msg += 1;
-					if ( *msg == ')' ) { result.marker = Flag_RT;}
-					else {   // flag r t
-						msg += 1;
-						if ( *msg == '1' ) { result.marker = Flag_RT10; } else
-							if ( *msg == '2' ) { result.marker = Flag_RT20; } else
-								if ( *msg == '3' ) { result.marker = Flag_RT30; }
-								else { PARSE_ERROR("flag r t ?"); }
-					}
-				} else { PARSE_ERROR("flag r ?"); }
-		} else
-			if ( *msg == 'l' ) { // flag l
-				msg += 2; // 'l '
-				if ( *msg == '0' ) { result.marker = Flag_L0; }  else
-					if ( *msg == 'b' ) { // flag l b
-						msg += 1;
-						if ( *msg == ')' ) { result.marker = Flag_LB; }
-						else {
-							msg += 1;
-							if ( *msg == '1' ) { result.marker = Flag_LB10; } else
-								if ( *msg == '2' ) { result.marker = Flag_LB20; } else
-									if ( *msg == '3' ) { result.marker = Flag_LB30; }
-									else { PARSE_ERROR("flag l b ?"); }
-						}
-					}else
-						if ( *msg == 't' ){	 // flag l t
-							msg += 1;
-							if ( *msg == ')' ) { result.marker = Flag_LT; }
-							else{
-								msg += 1;
-								if ( *msg == '1' ) { result.marker = Flag_LT10; } else
-									if ( *msg == '2' ) { result.marker = Flag_LT20; } else
-										if ( *msg == '3' ) { result.marker = Flag_LT30; }
-										else { PARSE_ERROR("flag l t ?"); }
-							}
-						} else { PARSE_ERROR("flag l ?"); }
-			} else
-				if ( *msg == 't' ){ // flag t
-					msg += 2;
-					if ( *msg == '0' ) { result.marker = Flag_T0; }  else
-						if ( *msg == 'l' ){
-							msg += 2;
-							if ( *msg == '1' ) { result.marker = Flag_TL10; } else
-								if ( *msg == '2' ) { result.marker = Flag_TL20; } else
-									if ( *msg == '3' ) { result.marker = Flag_TL30; } else
-										if ( *msg == '4' ) { result.marker = Flag_TL40; } else
-											if ( *msg == '5' ) { result.marker = Flag_TL50; }
-											else { PARSE_ERROR("flag t l ?"); }
-						} else
-							if ( *msg=='r' ){
-								msg += 2;
-								if ( *msg == '1' ) { result.marker = Flag_TR10; } else
-									if ( *msg == '2' ) { result.marker = Flag_TR20; } else
-										if ( *msg == '3' ) { result.marker = Flag_TR30; } else
-											if ( *msg == '4' ) { result.marker = Flag_TR40; } else
-												if ( *msg == '5' ) { result.marker = Flag_TR50; }
-												else { PARSE_ERROR("flag t r ?"); }
-							} else { PARSE_ERROR("flag t ?"); }
-				} else
-					if ( *msg == 'b' ){
-						msg += 2;
-						if ( *msg == '0' ) { result.marker = Flag_B0; } else
-							if ( *msg == 'l' ) {
-								msg += 2;
-								if ( *msg == '1' ) { result.marker = Flag_BL10; } else
-									if ( *msg == '2' ) { result.marker = Flag_BL20; } else
-										if ( *msg == '3' ) { result.marker = Flag_BL30; } else
-											if ( *msg == '4' ) { result.marker = Flag_BL40; } else
-												if ( *msg == '5' ) { result.marker = Flag_BL50; }
-												else { PARSE_ERROR("flag b l ?"); }
-							} else
-								if ( *msg == 'r' ) {
-									msg += 2;
-									if ( *msg == '1' ) { result.marker = Flag_BR10; } else
-										if ( *msg == '2' ) { result.marker = Flag_BR20; } else
-											if ( *msg == '3' ) { result.marker = Flag_BR30; } else
-												if ( *msg == '4' ) { result.marker = Flag_BR40; } else
-													if ( *msg == '5' ) { result.marker = Flag_BR50; }
-													else { PARSE_ERROR("flag b r ?"); }
-								} else { PARSE_ERROR("flag b ?"); }
-					} else
-						if ( *msg == 'c' ){
-							msg+=1;
-							if ( *msg == ')' ) { result.marker = Flag_C; }
-							else {
-								msg += 1;
-								if ( *msg == 'b' ) { result.marker = Flag_CB; } else
-									if ( *msg == 't' ) { result.marker = Flag_CT; }
-									else { PARSE_ERROR("flag c ?"); }
-							}
-						} else
-							if ( *msg == 'p' ){
-								msg += 2;
-								if ( *msg == 'r' ) {
-									msg += 2;
-									if ( *msg == 't') { result.marker = Flag_PRT; } else
-										if ( *msg == 'c') { result.marker = Flag_PRC; } else
-											if ( *msg == 'b') { result.marker = Flag_PRB; }
-											else { PARSE_ERROR("flag p r ?"); }
-								} else
-									if ( *msg == 'l' ) {
-										msg += 2;
-										if ( *msg == 't') { result.marker = Flag_PLT; } else
-											if ( *msg == 'c') { result.marker = Flag_PLC; } else
-												if ( *msg == 'b') { result.marker = Flag_PLB; }
-												else { PARSE_ERROR("flag p l ?"); }
-									} else { PARSE_ERROR("flag p ?"); }
-							} else
-								if ( *msg == 'g' ){
-									msg+=2;
-									if ( *msg == 'l' ) {
-										msg += 2;
-										if ( *msg == 't' ) { result.marker = Flag_GLT; } else
-											if ( *msg == 'b' ) { result.marker = Flag_GLB; }
-											else { PARSE_ERROR("flag g l ?"); }
-									} else
-										if ( *msg == 'r' ){
-											msg += 2;
-											if ( *msg == 't' ) { result.marker = Flag_GRT; } else
-												if ( *msg == 'b' ) { result.marker = Flag_GRB; }
-												else { PARSE_ERROR("flag g r ?"); }
-										} else { PARSE_ERROR("flag g ?"); }
-								} else { PARSE_ERROR("flag ?"); }
-	} else
-		if ( *msg == 'F' ){ // Flag behind
-			result.type = OBJ_Marker_Behind;
-			//result.marker = _pMem->ClosestFlagTo(); /*TODO:  could be No_Marker */
-		}
-	return result;
-}
-
 Parser::ObjType Parser::ParseLine(char *msg)
 {
 	ObjType result;
@@ -948,9 +888,10 @@ Parser::ObjType Parser::ParseBall(char* msg)
 	return result;
 }
 
-Parser::ObjProperty Parser::ParseObjProperty(char* msg)
+Parser::ObjProperty Parser::ParseObjProperty(char **str_ptr)
 {
 	ObjProperty result;
+	char *msg = *str_ptr;
 
 	/* 'high' quality only */
 	result.dist = parser::get_double(&msg);/* 'high' quality     */
@@ -1062,6 +1003,7 @@ Parser::ObjProperty Parser::ParseObjProperty(char* msg)
 	Assert(result.card_type == CR_None); //TODO: server 不会发card_type和foul_charged
 	Assert(result.lying == false);
 
+	*str_ptr = msg;
 	return result;
 }
 
@@ -1404,11 +1346,10 @@ void Parser::ParseSound(char *msg)
 		parser::get_next_word(&msg);
 		end = msg;
 		while (*end != ')') end++;
-		n = end - msg;
-		strncpy(buffer, msg, n * sizeof(char));
-		buffer[n] = '\0';
+		*end = '\0'; // 就地截断，不必拷贝
 
-		ParseRefereeMsg(buffer);
+		ParseRefereeMsg(msg);
+		*end = ')';
 	}
 	else if (msg[0] == 's') // self
 	{
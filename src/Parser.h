@@ -172,9 +172,14 @@ public:
 	void Parse(char *msg);
 	bool ParseInitializeMsg(const char *msg);
 
+    /**
+     * 单线程运行时连接server用的接口，由Client代替Parser线程接收消息
+     */
+	void SendInitialLizeMsg();
+	bool ParseConnectMsg(const char *msg);
+
 private:
 	void ConnectToServer();
-	void SendInitialLizeMsg();
 	void ParseServerParam(char *msg);
 	void ParsePlayerParam(char *msg);
 	void ParsePlayerType(char *msg);
@@ -282,7 +287,6 @@ private:
     };
 
 	ObjType ParseObjType(char *msg);
-	ObjType ParseGoal(char *msg);
 	ObjType ParseMarker(char *msg);
 	ObjType ParseLine(char *msg);
 	ObjType ParsePlayer(char *msg);
@@ -290,7 +294,7 @@ private:
   ObjType ParseObjType_Fullstate(char *msg);
   ObjType ParsePlayer_Fullstate(char *msg);
 
-	ObjProperty ParseObjProperty(char* msg);
+	ObjProperty ParseObjProperty(char **str_ptr);
 	ObjProperty_Coach ParseObjProperty_Coach(char* msg);
   ObjProperty_Fullstate ParseObjProperty_Fullstate(char* msg);
 
@@ -37,6 +37,8 @@
 #include "CommandSender.h"
 #include "Parser.h"
 #include "Thread.h"
+#include "ThreadPool.h"
+#include "PlayerParam.h"
 #include "UDPSocket.h"
 #include "WorldModel.h"
 #include "Agent.h"
@@ -45,10 +47,13 @@
 #include "CommunicateSystem.h"
 #include "TimeTest.h"
 #include "Dasher.h"
+#include "BehaviorBase.h"
+#include "Tracer.h"
 
 Player::Player():
 	mpDecisionTree( new DecisionTree )
 {
+	ThreadPool::instance().Start(PlayerParam::instance().PlannerThreads()); // 为0时不启动，planner在决策线程中顺序运行
 }
 
 Player::~Player()
@@ -62,30 +67,31 @@ void Player::SendOptionToServer()
 	{
 		mpAgent->CheckCommands(mpObserver);
 		mpAgent->Clang(7, 8);
-		mpObserver->SetCommandSend();
-		WaitFor(200);
+		WaitForServer(200);
 	}
 
 	while (!mpParser->IsSyncOk())
 	{
 		mpAgent->CheckCommands(mpObserver);
 		mpAgent->SynchSee();
-		mpObserver->SetCommandSend();
-		WaitFor(200);
+		WaitForServer(200);
 	}
 
 	mpAgent->CheckCommands(mpObserver);
 	mpAgent->EarOff(false);
-	mpObserver->SetCommandSend();
-	WaitFor(200);
+	WaitForServer(200);
 }
 
 void Player::Run()
 {
+	TRACE_SPAN(TS_Run);
+
     //TIMETEST("Run");
 
 	static Time last_time = Time(-100, 0);
 
+	RealTime update_begin = GetRealTime();
+
 	mpObserver->Lock();
 
 	/** 下面几个更新顺序不能变 */
@@ -93,6 +99,7 @@ void Player::Run()
 	CommunicateSystem::instance().Update(); //在这里解析hear信息，必须首先更新
 	mpAgent->CheckCommands(mpObserver);
 	mpWorldModel->Update(mpObserver);
+	mpDecisionTree->SetCycleBeginTime(mpObserver->GetLastCycleBeginRealTime());
 
 	mpObserver->UnLock();
 
@@ -110,17 +117,23 @@ void Player::Run()
 
 	Formation::instance.UpdateOpponentRole(); //TODO: 暂时放在这里，教练未发来对手阵型信息时自己先计算
 
+	RealTime decision_begin = GetRealTime();
+	mUpdateCost = decision_begin.Sub(update_begin);
+
 	VisualSystem::instance().ResetVisualRequest();
 	mpDecisionTree->Decision(*mpAgent);
 
 	VisualSystem::instance().Decision();
 	CommunicateSystem::instance().Decision();
 
+	mDecisionCost = RealTime(GetRealTime()).Sub(decision_begin);
+
 	if (ServerParam::instance().synchMode()) {
 		mpAgent->Done();
 	}
 
 	mpAgent->SetHistoryActiveBehaviors();
+	BehaviorArena::instance().Reset(); //本周期的行为候选都已经不再使用
 
 	Logger::instance().LogSight();
 }
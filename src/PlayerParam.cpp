@@ -92,6 +92,7 @@ const int PlayerParam::SHOOT_MAX_SEARCH_COUNT = 128;
 const double PlayerParam::SHOOT_DIR_SEARCH_STEP = 0.6;
 
 const bool PlayerParam::DYNAMIC_DEBUG_MODE = false;
+const char PlayerParam::DYNAMIC_DEBUG_BENCHMARK[] = "";
 const bool PlayerParam::SAVE_SERVER_MESSAGE = false;
 const bool PlayerParam::SAVE_SIGHT_LOG = false;
 const bool PlayerParam::SAVE_DEC_LOG = false;
@@ -100,6 +101,9 @@ const bool PlayerParam::USE_PLOTTER = false;
 const bool PlayerParam::USE_TEAM_GRAPHIC = true;
 const bool PlayerParam::TIME_TEST = false;
 const bool PlayerParam::NETWORK_TEST = false;
+const bool PlayerParam::SIMULATOR_MODE = false;
+const int PlayerParam::SIMULATOR_UNUM = 10;
+const int PlayerParam::SIMULATOR_SEED = 0;
 const int PlayerParam::WAIT_SIGHT_BUFFER = 40; // 每周期最多等视觉40毫秒
 const int PlayerParam::WAIT_HEAR_BUFFER = 40; // 每周期最多等听觉40毫秒
 const int PlayerParam::WAIT_TIME_OUT = 10; // 每场比赛最多等server10秒
@@ -110,6 +114,25 @@ const double PlayerParam::OPP_TACKLE_THRESHOLD_BACK = 0.85;
 const double PlayerParam::TIRED_BUFFER = 10.0;
 const double PlayerParam::AT_POINT_BUFFER = 1.0;
 const int PlayerParam::KICKER_MODE = 0;
+const char PlayerParam::KICKER_PARAM_FILE[] = "";
+const int PlayerParam::KICKER_THREADS = 0;
+const int PlayerParam::PLANNER_THREADS = 0;
+const int PlayerParam::SEARCH_DEPTH = 1;
+const int PlayerParam::SEARCH_WIDTH = 5;
+const int PlayerParam::SEARCH_DEADLINE = 80;
+const double PlayerParam::EVALUATION_GRID = 0.0;
+const bool PlayerParam::DASHER_TABLE = false;
+const int PlayerParam::ROLLOUT_COUNT = 0;
+const int PlayerParam::ROLLOUT_BUDGET = 10;
+const bool PlayerParam::TRACE = false;
+const bool PlayerParam::LOG_COMPRESS = false;
+const bool PlayerParam::EVENT_LOOP = false;
+const char PlayerParam::TRAIN_PORTS[] = "";
+const int PlayerParam::TRAIN_EPISODES = 0;
+const char PlayerParam::NET_FILE[] = "data/sensitivity.net";
+const char PlayerParam::NET_TRAIN_FILE[] = "";
+const int PlayerParam::NET_BATCH_SIZE = 1;
+const int PlayerParam::NET_THREADS = 1;
 const int PlayerParam::MARKOV_DRIBBLER_MODE = 0;
 const int PlayerParam::MARKOV_DRIBBLER_HORIZON = 3;
 const int PlayerParam::MARKOV_DRIBBLER_METHOD = 1;
@@ -253,6 +276,7 @@ void PlayerParam::AddParams()
 	AddParam( "hetero_test_model", & M_hetero_test_model, std::string(HETERO_TEST_MODEL));
 
 	AddParam( "dynamic_debug_mode", & mDynamicDebugMode, DYNAMIC_DEBUG_MODE );
+	AddParam( "dynamic_debug_benchmark", & mDynamicDebugBenchmark, std::string(DYNAMIC_DEBUG_BENCHMARK) );
 	AddParam( "save_server_message", & mSaveServerMessage, SAVE_SERVER_MESSAGE );
 	AddParam( "save_sight_log", & mSaveSightLog, SAVE_SIGHT_LOG );
 	AddParam( "save_dec_log", & mSaveDecLog, SAVE_DEC_LOG );
@@ -261,6 +285,9 @@ void PlayerParam::AddParams()
     AddParam( "use_team_graphic", & mUseTeamGraphic, USE_TEAM_GRAPHIC );
     AddParam( "time_test", & mTimeTest, TIME_TEST );
     AddParam( "network_test", & mNetworkTest, NETWORK_TEST );
+    AddParam( "simulator_mode", & mSimulatorMode, SIMULATOR_MODE );
+    AddParam( "simulator_unum", & mSimulatorUnum, SIMULATOR_UNUM );
+    AddParam( "simulator_seed", & mSimulatorSeed, SIMULATOR_SEED );
 	AddParam( "wait_sight_buffer", & mWaitSightBuffer, WAIT_SIGHT_BUFFER );
     AddParam( "wait_hear_buffer", & mWaitHearBuffer, WAIT_HEAR_BUFFER );
 	AddParam( "wait_time_out", & mWaitTimeOut, WAIT_TIME_OUT );
@@ -268,6 +295,25 @@ void PlayerParam::AddParams()
     AddParam( "tired_buffer", & mTiredBuffer, TIRED_BUFFER );
     AddParam( "at_point_buffer", & mAtPointBuffer, AT_POINT_BUFFER );
     AddParam( "kicker_mode", & mKickerMode, KICKER_MODE );
+    AddParam( "kicker_param_file", & mKickerParamFile, std::string(KICKER_PARAM_FILE) );
+    AddParam( "kicker_threads", & mKickerThreads, KICKER_THREADS );
+    AddParam( "planner_threads", & mPlannerThreads, PLANNER_THREADS );
+    AddParam( "search_depth", & mSearchDepth, SEARCH_DEPTH );
+    AddParam( "search_width", & mSearchWidth, SEARCH_WIDTH );
+    AddParam( "search_deadline", & mSearchDeadline, SEARCH_DEADLINE );
+    AddParam( "evaluation_grid", & mEvaluationGrid, EVALUATION_GRID );
+    AddParam( "dasher_table", & mDasherTable, DASHER_TABLE );
+    AddParam( "rollout_count", & mRolloutCount, ROLLOUT_COUNT );
+    AddParam( "rollout_budget", & mRolloutBudget, ROLLOUT_BUDGET );
+    AddParam( "trace", & mTrace, TRACE );
+    AddParam( "log_compress", & mLogCompress, LOG_COMPRESS );
+    AddParam( "event_loop", & mEventLoop, EVENT_LOOP );
+    AddParam( "train_ports", & mTrainPorts, std::string(TRAIN_PORTS) );
+    AddParam( "train_episodes", & mTrainEpisodes, TRAIN_EPISODES );
+    AddParam( "net_file", & mNetFile, std::string(NET_FILE) );
+    AddParam( "net_train_file", & mNetTrainFile, std::string(NET_TRAIN_FILE) );
+    AddParam( "net_batch_size", & mNetBatchSize, NET_BATCH_SIZE );
+    AddParam( "net_threads", & mNetThreads, NET_THREADS );
 
     AddParam( "our_goalie_unum", & M_our_goalie_unum, 1 );
 	AddParam( "goalie", & M_is_goalie, false );
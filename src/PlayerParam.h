@@ -569,6 +569,7 @@ public:
 
 private:
 	static const bool DYNAMIC_DEBUG_MODE;
+	static const char DYNAMIC_DEBUG_BENCHMARK[];
 	static const bool SAVE_SERVER_MESSAGE;
 	static const bool SAVE_SIGHT_LOG;
 	static const bool SAVE_DEC_LOG;
@@ -578,6 +579,9 @@ private:
     static const bool USE_TEAM_GRAPHIC;
 	static const bool TIME_TEST;
 	static const bool NETWORK_TEST;
+	static const bool SIMULATOR_MODE;
+	static const int SIMULATOR_UNUM;
+	static const int SIMULATOR_SEED;
 	static const int WAIT_SIGHT_BUFFER;
 	static const int WAIT_HEAR_BUFFER;
 	static const int WAIT_TIME_OUT;
@@ -588,6 +592,25 @@ private:
     static const double TIRED_BUFFER;
     static const double AT_POINT_BUFFER;
     static const int KICKER_MODE;
+    static const char KICKER_PARAM_FILE[];
+    static const int KICKER_THREADS;
+    static const int PLANNER_THREADS;
+    static const int SEARCH_DEPTH;
+    static const int SEARCH_WIDTH;
+    static const int SEARCH_DEADLINE;
+    static const double EVALUATION_GRID;
+    static const bool DASHER_TABLE;
+    static const int ROLLOUT_COUNT;
+    static const int ROLLOUT_BUDGET;
+    static const bool TRACE;
+    static const bool LOG_COMPRESS;
+    static const bool EVENT_LOOP;
+    static const char TRAIN_PORTS[];
+    static const int TRAIN_EPISODES;
+    static const char NET_FILE[];
+    static const char NET_TRAIN_FILE[];
+    static const int NET_BATCH_SIZE;
+    static const int NET_THREADS;
     static const int MARKOV_DRIBBLER_MODE;
     static const int MARKOV_DRIBBLER_HORIZON;
     static const int MARKOV_DRIBBLER_METHOD;
@@ -604,6 +627,7 @@ private:
 	static const int SETPLAY_REINFORCE_PLAYERS;
 
 	bool mDynamicDebugMode; // DynamicDebug模式
+	std::string mDynamicDebugBenchmark; // 回放测速用的消息文件，为空时进入交互的动态调试
 	bool mForcePenaltyMode; //利用trainer强制进入penalty模式
 	bool mSaveServerMessage; // 是否保存server的信息，用于动态调试
 	bool mSaveSightLog; // 是否保存sight_log
@@ -613,6 +637,9 @@ private:
     bool mUseTeamGraphic;
 	bool mTimeTest;
 	bool mNetworkTest;
+	bool mSimulatorMode; // 离线比赛模拟模式，不需要server
+	int mSimulatorUnum; // 离线比赛模拟时被测球员的号码
+	int mSimulatorSeed; // 离线比赛模拟的随机数种子，0表示使用当前时间
 	int mWaitSightBuffer; // 等待视觉到来的最大buffer
 	int mWaitHearBuffer; // 等待听觉到来的最大buffer
 	int mWaitTimeOut; // 等待server的最大时间
@@ -632,6 +659,73 @@ private:
      */
     int mKickerMode;
 
+    /**
+     * 离线计算值函数时读取server_param/player_param/player_type的文件（如rcg日志），
+     * 为空时连接server获取；mKickerThreads为计算线程数，0表示按cpu个数
+     */
+    std::string mKickerParamFile;
+    int mKickerThreads;
+
+    /**
+     * 进攻决策时并行运行各子planner的工作线程数，0表示在决策线程中顺序运行
+     */
+    int mPlannerThreads;
+
+    /**
+     * 决策树的搜索层数，1表示只做当前一层的决策；大于1时对进攻决策的前mSearchWidth个候选行为向下搜索，
+     * 超过mSearchDeadline时停止并使用已经完成的最深一层的结果。
+     * mSearchDeadline为从本周期开始（sense到达）算起的毫秒数，0表示不限时。
+     * 搜索在每个后续传球处检查是否超时，但mSearchDeadline为0时代价约为10^(mSearchDepth-2)次评价，
+     * 不要不限时地用大的层数；模拟比赛中2、3层的进球并不比1层多
+     */
+    int mSearchDepth;
+    int mSearchWidth;
+    int mSearchDeadline;
+
+    /**
+     * 大于0时Evaluation预先按这个间隔（米）在整个球场上计算出评价网络的值，之后用双线性插值查表，
+     * 0表示每次都直接运行网络
+     */
+    double mEvaluationGrid;
+
+    /**
+     * 是否用预先生成的表计算Dasher::CycleNeedToPoint。只有插值的4个格点给出相同的周期数、并且目标离周期边界
+     * 足够远时才使用查表结果，其余情况（包括表不适用的情况）仍然精确计算。这是经验规则而不是保证：
+     * 模拟比赛第2、3号种子中6906次查表的结果都与精确计算相同，建表时抽样2000个查询记录最大误差，
+     * debug版本中每次查表都与精确计算比较
+     */
+    bool mDasherTable;
+
+    /**
+     * 大于0时对进攻决策中评价最高的几个传球、带球、射门各做这么多次蒙特卡洛模拟，评价乘以成功概率；
+     * mRolloutBudget为这些模拟总的时间预算（毫秒），0表示不限时
+     */
+    int mRolloutCount;
+    int mRolloutBudget;
+
+    /**
+     * 是否用Tracer记录各线程每周期的耗时，退出时导出到log目录下的json文件
+     */
+    bool mTrace;
+    bool mLogCompress;
+    bool mEventLoop;
+
+    /**
+     * 批量训练时各个server的offline coach端口，用逗号分隔，为空时只训练一个server；
+     * mTrainEpisodes为每个server的训练次数，达到后结束比赛，0表示不限
+     */
+    std::string mTrainPorts;
+    int mTrainEpisodes;
+
+    /**
+     * net_train_file不为空时不连接server，用其中的样本离线训练mNetFile中的网络，训练后以二进制格式存回；
+     * mNetBatchSize为每次更新权值的样本数，1表示逐个样本训练；mNetThreads为计算梯度的线程数
+     */
+    std::string mNetFile;
+    std::string mNetTrainFile;
+    int mNetBatchSize;
+    int mNetThreads;
+
     /**
      * 如果视觉部分导致超时严重，就调大这个变量，最大为1
      */
@@ -641,6 +735,7 @@ private:
 
 public:
 	const bool & DynamicDebugMode() const { return mDynamicDebugMode; }
+	const std::string & DynamicDebugBenchmark() const { return mDynamicDebugBenchmark; }
 	const bool & ForcePenaltyMode() const { return mForcePenaltyMode; }
 	const bool & SaveServerMessage() const { return mSaveServerMessage; }
 	const bool & SaveSightLog() const { return mSaveSightLog; }
@@ -648,6 +743,9 @@ public:
 	const bool & SaveTextLog() const { return mSaveTextLog; }
 	const bool & TimeTest() const { return mTimeTest; }
 	const bool & NetworkTest() const { return mNetworkTest; }
+	const bool & SimulatorMode() const { return mSimulatorMode; }
+	const int & SimulatorUnum() const { return mSimulatorUnum; }
+	const int & SimulatorSeed() const { return mSimulatorSeed; }
 	const bool & UsePlotter() const { return mUsePlotter; }
     const bool & UseTeamGraphic() const { return mUseTeamGraphic; }
 	const int & WaitSightBuffer() const { return mWaitSightBuffer; }
@@ -660,6 +758,25 @@ public:
     const double & MinStamina() const { return mMinStamina; }
     const double & AtPointBuffer() const { return mAtPointBuffer; }
     const int & KickerMode() const { return mKickerMode; }
+    const std::string & KickerParamFile() const { return mKickerParamFile; }
+    const int & KickerThreads() const { return mKickerThreads; }
+    const int & PlannerThreads() const { return mPlannerThreads; }
+    const int & SearchDepth() const { return mSearchDepth; }
+    const int & SearchWidth() const { return mSearchWidth; }
+    const int & SearchDeadline() const { return mSearchDeadline; }
+    const double & EvaluationGrid() const { return mEvaluationGrid; }
+    const bool & DasherTable() const { return mDasherTable; }
+    const int & RolloutCount() const { return mRolloutCount; }
+    const int & RolloutBudget() const { return mRolloutBudget; }
+    const bool & Trace() const { return mTrace; }
+    const bool & LogCompress() const { return mLogCompress; }
+    const bool & EventLoop() const { return mEventLoop; }
+    const std::string & TrainPorts() const { return mTrainPorts; }
+    const int & TrainEpisodes() const { return mTrainEpisodes; }
+    const std::string & NetFile() const { return mNetFile; }
+    const std::string & NetTrainFile() const { return mNetTrainFile; }
+    const int & NetBatchSize() const { return mNetBatchSize; }
+    const int & NetThreads() const { return mNetThreads; }
 
 	const double & LowStaminaPointThr() const { return mLowStaminaPointThr; }
 };
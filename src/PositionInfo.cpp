@@ -36,21 +36,31 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 using namespace std;
 
 PositionInfo::PositionInfo(WorldState *pWorldState, InfoState *pInfoState):
 	InfoStateBase(pWorldState, pInfoState),
+	mIsAnyDirty(true),
+	mIsTableReady(false),
 	mPlayerWithBallList_UpdateTime(Time(-3, 0))
 {
 }
 
 void PositionInfo::UpdateRoutine()
 {
+	UpdatePositionTable();
 	UpdateDistMatrix();
 	UpdateOffsideLine();
     UpdateOppGoalInfo();
 
-	/** 每个周期clear一次 */
+	if (!mIsAnyDirty) {
+		return; // 位置都没有变化，上次的列表仍然有效
+	}
+
+	/** 有位置变化时clear一次 */
 	mPlayer2BallList.clear();
 	mTeammate2BallList.clear();
 	mOpponent2BallList.clear();
@@ -65,55 +75,127 @@ void PositionInfo::UpdateRoutine()
 	mXSortOpponentList.clear();
 }
 
-void PositionInfo::UpdateDistMatrix()
+namespace {
+
+/**
+ * 计算点(x, y)到快照中第[begin, end)个对象的距离，不在场上的对象距离记为-1
+ * Distances from (x, y) to objects [begin, end) of the snapshot, -1 for objects not alive.
+ */
+void DistRow(double x, double y, const double *xs, const double *ys, const double *alive, double *out, int begin, int end)
+{
+	int j = begin;
+
+#ifdef __SSE2__
+	const __m128d px = _mm_set1_pd(x);
+	const __m128d py = _mm_set1_pd(y);
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d invalid = _mm_set1_pd(-1.0);
+
+	for (; j + 1 < end; j += 2) {
+		__m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + j), px);
+		__m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + j), py);
+		__m128d dist = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+		__m128d mask = _mm_cmpgt_pd(_mm_loadu_pd(alive + j), zero);
+		_mm_storeu_pd(out + j, _mm_or_pd(_mm_and_pd(mask, dist), _mm_andnot_pd(mask, invalid)));
+	}
+#endif
+
+	for (; j < end; ++j) {
+		double dx = xs[j] - x;
+		double dy = ys[j] - y;
+		out[j] = alive[j] > 0.0? Sqrt(dx * dx + dy * dy): -1.0;
+	}
+}
+
+}
+
+void PositionInfo::UpdatePositionTable()
 {
-	for (int i = 0; i < 1 + 2 * TEAMSIZE; ++i){
-		for (int j = 0; j < 1 + 2 * TEAMSIZE; ++j){
-			mDistMatrix[i][j] = -1.0;
+	const BallState & ball = mpWorldState->GetBall();
+
+	mIsAnyDirty = false;
+
+	for (int i = 0; i <= 2 * TEAMSIZE; ++i) {
+		double x, y, alive;
+		bool valid;
+
+		if (i == 0) {
+			x = ball.GetPos().X();
+			y = ball.GetPos().Y();
+			alive = 0.0;
+			valid = false;
+		}
+		else {
+			const PlayerState & player = mpWorldState->GetPlayer(Index2Unum(i));
+			x = player.GetPos().X();
+			y = player.GetPos().Y();
+			alive = player.IsAlive()? 1.0: 0.0;
+			valid = player.IsAlive() && player.GetPosConf() > FLOAT_EPS;
 		}
+
+		mIsDirty[i] = !mIsTableReady || x != mPosX[i] || y != mPosY[i] || alive != mAliveMask[i] || valid != mIsValid[i];
+		mIsAnyDirty = mIsAnyDirty || mIsDirty[i];
+
+		mPosX[i] = x;
+		mPosY[i] = y;
+		mAliveMask[i] = alive;
+		mIsValid[i] = valid;
 	}
 
-    for (int i = 0; i < TEAMSIZE; ++i)
-    {
-        mTeammateDir2Ball[i] = 0.0;
-        mOpponentDir2Ball[i] = 0.0;
-    }
+	mIsTableReady = true;
+}
 
-	const vector<PlayerState*> & player_list = mpWorldState->GetPlayerList();
+void PositionInfo::UpdateDistMatrix()
+{
+	if (!mIsAnyDirty) {
+		return;
+	}
 
-	for (vector<PlayerState*>::const_iterator it = player_list.begin(); it != player_list.end(); ++it){
-		if ((*it)->IsAlive()){
-			int index = Unum2Index((*it)->GetUnum());
-            Vector rel_pos = (*it)->GetPos() - mpWorldState->GetBall().GetPos();
-            mDistMatrix[0][index] = rel_pos.Mod();
-			mDistMatrix[index][index] = 0.0;
+	const int size = 1 + 2 * TEAMSIZE;
 
-            // 更新球员相对于球的角度
-            if ((*it)->GetUnum() > 0)
-            {
-                mTeammateDir2Ball[(*it)->GetUnum() - 1] = rel_pos.Dir();
-            }
-            else
-            {
-                mOpponentDir2Ball[-(*it)->GetUnum() - 1] = rel_pos.Dir();
-            }
+	/** 第0行为球到各球员的距离，第0列（球员到球）不填 */
+	mDistMatrix[0][0] = -1.0;
+	DistRow(mPosX[0], mPosY[0], mPosX, mPosY, mAliveMask, & mDistMatrix[0][0], 1, size);
+
+	/** 只重算有变化的球员所在的行，其他行中对应的列由对称性得到 */
+	for (int i = 1; i < size; ++i) {
+		if (!mIsDirty[i]) {
+			continue;
+		}
+
+		mDistMatrix[i][0] = -1.0;
+
+		if (mAliveMask[i] > 0.0) {
+			DistRow(mPosX[i], mPosY[i], mPosX, mPosY, mAliveMask, & mDistMatrix[i][0], 1, size);
+		}
+		else {
+			for (int j = 1; j < size; ++j) {
+				mDistMatrix[i][j] = -1.0;
+			}
 		}
 	}
 
-	const uint player_list_size = player_list.size();
-	for (unsigned int i = 0; i < player_list_size; ++i){
-		const PlayerState *pi = player_list[i];
-		if (pi->IsAlive()){
-			for (unsigned int j = i + 1; j < player_list_size; ++j){
-				const PlayerState *pj = player_list[j];
-				if (pj->IsAlive()){
-					int index1 = Unum2Index(pi->GetUnum());
-					int index2 = Unum2Index(pj->GetUnum());
-					mDistMatrix[index1][index2] = mDistMatrix[index2][index1] = pi->GetPos().Dist(pj->GetPos());
-				}
+	for (int i = 1; i < size; ++i) {
+		if (mIsDirty[i]) {
+			continue;
+		}
+
+		for (int j = 1; j < size; ++j) {
+			if (mIsDirty[j]) {
+				mDistMatrix[i][j] = mDistMatrix[j][i];
 			}
 		}
 	}
+
+	// 更新球员相对于球的角度
+	for (int i = 1; i <= TEAMSIZE; ++i) {
+		if (mIsDirty[0] || mIsDirty[i]) {
+			mTeammateDir2Ball[i - 1] = mAliveMask[i] > 0.0? ATan2(mPosY[i] - mPosY[0], mPosX[i] - mPosX[0]): 0.0;
+		}
+		if (mIsDirty[0] || mIsDirty[TEAMSIZE + i]) {
+			mOpponentDir2Ball[i - 1] = mAliveMask[TEAMSIZE + i] > 0.0? ATan2(mPosY[TEAMSIZE + i] - mPosY[0], mPosX[TEAMSIZE + i] - mPosX[0]): 0.0;
+		}
+	}
 }
 
 const double & PositionInfo::GetBallDistToPlayer(Unum unum) const
@@ -344,10 +426,18 @@ AngleDeg PositionInfo::GetShootAngle(AngleDeg left,AngleDeg right, const PlayerS
 vector<Unum> PositionInfo::GetClosePlayerToPoint(const Vector & bp, const Unum & exclude_unum) const
 {
 	vector< pair<Unum, double> > tmp;
-
-	for (vector<PlayerState*>::const_iterator it = mpWorldState->GetPlayerList().begin(); it != mpWorldState->GetPlayerList().end(); ++it){
-        if ((*it)->IsAlive() && (*it)->GetPosConf() > FLOAT_EPS && (*it)->GetUnum() != exclude_unum){ // 算距离自己的球员时把自己排除掉
-			tmp.push_back(pair<Unum, double>((*it)->GetUnum(), (*it)->GetPos().Dist2(bp)));
+	tmp.reserve(2 * TEAMSIZE);
+
+	/** 与WorldState::GetPlayerList()的顺序一致：队友和对手交替 */
+	for (int i = 1; i <= TEAMSIZE; ++i) {
+		for (int k = 0; k < 2; ++k) {
+			int index = i + k * TEAMSIZE;
+			Unum unum = Index2Unum(index);
+			if (mIsValid[index] && unum != exclude_unum){ // 算距离自己的球员时把自己排除掉
+				double dx = mPosX[index] - bp.X();
+				double dy = mPosY[index] - bp.Y();
+				tmp.push_back(pair<Unum, double>(unum, dx * dx + dy * dy));
+			}
 		}
 	}
 
@@ -445,6 +535,24 @@ const vector<Unum> & PositionInfo::GetCloseOpponentToPlayer(Unum i)
 	return mOpponent2PlayerList[index];
 }
 
+void PositionInfo::PrecomputeLists()
+{
+	GetXSortTeammate();
+	GetXSortOpponent();
+
+	GetCloseTeammateToBall();
+	GetCloseOpponentToBall();
+
+	for (int i = 1; i <= TEAMSIZE; ++i) {
+		GetCloseTeammateToPlayer(i);
+		GetCloseOpponentToPlayer(i);
+		GetCloseTeammateToPlayer(-i);
+		GetCloseOpponentToPlayer(-i);
+	}
+
+	GetPlayerWithBallList();
+}
+
 //距离球最近按距离且可踢（F）
 const vector<Unum> & PositionInfo::GetPlayerWithBallList()
 {
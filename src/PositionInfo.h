@@ -133,6 +133,12 @@ public:
 
 	Unum GetOpponentWithBall();
 
+	/**
+	 * 把按需计算的各个列表一次算好，之后本周期内的Get函数不再修改数据，可以被多个线程同时调用
+	 * Fill all lazily computed lists, so that the getters are read-only for the rest of the cycle.
+	 */
+	void PrecomputeLists();
+
     /**
      * Get closest opponent in a cycle which radius = buffer;
      * If buffer is larger than 2 then the result will be calculated as buffer = 2;
@@ -154,6 +160,7 @@ private:
 		return index <= TEAMSIZE? index: TEAMSIZE - index;
 	}
 
+	void UpdatePositionTable();
 	void UpdateDistMatrix();
 	void UpdateOffsideLine();
     void UpdateOppGoalInfo(); /** 暂时这样命名，以后有需要再改 */
@@ -161,6 +168,23 @@ private:
 private:
 	Array<Array<double, 1 + 2 * TEAMSIZE>, 1 + 2 * TEAMSIZE > mDistMatrix; // 22名球员和球相互之间的距离，0为球，1-11为队友，12到22为对手
 
+	/**
+	 * 每周期构建一次的位置快照，按数组结构（SoA）存放，下标同mDistMatrix，便于向量化计算距离
+	 * Per-cycle structure-of-arrays snapshot, indexed as mDistMatrix.
+	 */
+	double mPosX[1 + 2 * TEAMSIZE];
+	double mPosY[1 + 2 * TEAMSIZE];
+	double mAliveMask[1 + 2 * TEAMSIZE]; // 1.0表示IsAlive，否则为0.0
+	bool mIsValid[1 + 2 * TEAMSIZE]; // IsAlive且位置置信度大于FLOAT_EPS
+
+	/**
+	 * 与上次更新相比快照有变化的对象，只重新计算这些对象相关的距离和列表；
+	 * 未被看到且静止的球员在相邻周期（包括定位球时的子周期）中一般不变
+	 */
+	bool mIsDirty[1 + 2 * TEAMSIZE];
+	bool mIsAnyDirty;
+	bool mIsTableReady; // 是否已经构建过快照
+
     std::list<KeyPlayerInfo> mXSortTeammateList;
     std::list<KeyPlayerInfo> mXSortOpponentList;
 
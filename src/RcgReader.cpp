@@ -0,0 +1,523 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+
+#include "RcgReader.h"
+#include "Utilities.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * 二进制rcg（ULG3）的记录类型，与rcssserver一致
+ */
+enum BinaryMode
+{
+	BM_NoInfo = 0,
+	BM_Show = 1,
+	BM_Msg = 2,
+	BM_Draw = 3,
+	BM_Blank = 4,
+	BM_PlayMode = 5,
+	BM_Team = 6,
+	BM_PlayerType = 7,
+	BM_Param = 8,
+	BM_PlayerParam = 9
+};
+
+const double BINARY_SCALE = 65536.0;
+
+const size_t BINARY_BALL_SIZE = 16; // 4个Int32
+const size_t BINARY_PLAYER_SIZE = 64; // 按server写出时的对齐
+const size_t BINARY_SHOW_SIZE = 1428; // ball + 22个player + Int16 time，对齐到4字节
+const size_t BINARY_TEAM_SIZE = 36; // 2 * (char name[16] + Int16 score)
+const size_t BINARY_DRAW_SIZE = 74; // Int16 mode + 最大的lineinfo_t
+
+const int INDEX_VERSION = 1;
+const char INDEX_MAGIC[8] = { 'W', 'E', 'R', 'C', 'G', 'I', 'D', 'X' };
+
+struct IndexHeader
+{
+	char mMagic[8];
+	int mVersion;
+	int mCount;
+	long long mSize;
+	long long mModifyTime;
+};
+
+inline int ReadInt16(const char *p)
+{
+	const unsigned char *u = reinterpret_cast<const unsigned char*>(p);
+	return short((u[0] << 8) | u[1]);
+}
+
+inline int ReadInt32(const char *p)
+{
+	const unsigned char *u = reinterpret_cast<const unsigned char*>(p);
+	return int((unsigned(u[0]) << 24) | (unsigned(u[1]) << 16) | (unsigned(u[2]) << 8) | unsigned(u[3]));
+}
+
+inline double ReadScaled(const char *p)
+{
+	return ReadInt32(p) / BINARY_SCALE;
+}
+
+}
+
+RcgReader::RcgReader():
+	mpData(0),
+	mSize(0),
+	mModifyTime(0),
+	mIsBinary(false),
+#ifndef WIN32
+	mFile(-1),
+#endif
+	mCursor(-1)
+{
+}
+
+RcgReader::~RcgReader()
+{
+	Close();
+}
+
+bool RcgReader::Open(const char *file_name)
+{
+	Close();
+
+#ifdef WIN32
+	std::ifstream fin(file_name, std::ios::binary);
+	if (!fin) {
+		PRINT_ERROR("open rcg file error " << file_name);
+		return false;
+	}
+	mBuffer.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+	mpData = mBuffer.empty()? 0: & mBuffer[0];
+	mSize = mBuffer.size();
+#else
+	mFile = open(file_name, O_RDONLY);
+	if (mFile < 0) {
+		PRINT_ERROR("open rcg file error " << file_name);
+		return false;
+	}
+
+	struct stat file_stat;
+	if (fstat(mFile, &file_stat) < 0 || file_stat.st_size < 4) {
+		PRINT_ERROR("empty rcg file " << file_name);
+		Close();
+		return false;
+	}
+
+	mSize = file_stat.st_size;
+	mModifyTime = file_stat.st_mtime;
+
+	void *data = mmap(0, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (data == MAP_FAILED) {
+		PRINT_ERROR("mmap rcg file error " << file_name);
+		Close();
+		return false;
+	}
+	mpData = static_cast<const char*>(data);
+#endif
+
+	if (mSize < 4 || strncmp(mpData, "ULG", 3) != 0) {
+		PRINT_ERROR("unknown rcg format " << file_name);
+		Close();
+		return false;
+	}
+
+	if (mpData[3] == 3) {
+		mIsBinary = true;
+	}
+	else if (mpData[3] == '4' || mpData[3] == '5') {
+		mIsBinary = false;
+	}
+	else {
+		PRINT_ERROR("unsupported rcg version " << file_name);
+		Close();
+		return false;
+	}
+
+	const std::string index_file = std::string(file_name) + ".idx";
+	if (!LoadIndex(index_file)) {
+		if (!(mIsBinary? BuildBinaryIndex(): BuildTextIndex())) {
+			PRINT_ERROR("no show in rcg file " << file_name);
+			Close();
+			return false;
+		}
+		SaveIndex(index_file);
+	}
+
+	return true;
+}
+
+void RcgReader::Close()
+{
+#ifdef WIN32
+	mBuffer.clear();
+#else
+	if (mpData != 0) {
+		munmap(const_cast<char*>(mpData), mSize);
+	}
+	if (mFile >= 0) {
+		close(mFile);
+		mFile = -1;
+	}
+#endif
+
+	mpData = 0;
+	mSize = 0;
+	mIndex.clear();
+	mCursor = -1;
+}
+
+int RcgReader::Find(int time) const
+{
+	int low = 0, high = mIndex.size(); // 周期在rcg中不减
+	while (low < high) {
+		int mid = (low + high) / 2;
+		if (mIndex[mid].mTime < time) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+	return low < int(mIndex.size())? low: -1;
+}
+
+bool RcgReader::ReadFrame(int i, RcgFrame & frame) const
+{
+	if (i < 0 || i >= GetFrameCount()) {
+		return false;
+	}
+
+	frame.mPlayers.clear();
+	frame.mTime = mIndex[i].mTime;
+	frame.mServerPlayMode = ServerPlayMode(mIndex[i].mServerPlayMode);
+	return mIsBinary? ReadBinaryFrame(mIndex[i], frame): ReadTextFrame(mIndex[i], frame);
+}
+
+bool RcgReader::BuildTextIndex()
+{
+	ServerPlayMode server_playmode = SPM_Null;
+
+	const char *end = mpData + mSize;
+	for (const char *line = mpData; line < end; ) {
+		const char *eol = static_cast<const char*>(memchr(line, '\n', end - line));
+		if (eol == 0) {
+			eol = end;
+		}
+
+		if (eol - line > 6 && strncmp(line, "(show ", 6) == 0) {
+			IndexEntry entry;
+			entry.mTime = strtol(line + 6, 0, 10);
+			entry.mServerPlayMode = server_playmode;
+			entry.mOffset = line - mpData;
+			mIndex.push_back(entry);
+		}
+		else if (eol - line > 10 && strncmp(line, "(playmode ", 10) == 0) {
+			char buf[64];
+			const int length = Min(int(eol - line), int(sizeof(buf)) - 1);
+			memcpy(buf, line, length);
+			buf[length] = '\0';
+
+			int time = 0;
+			char pm_string[32];
+			if (sscanf(buf, " (playmode %d %31[^)] ) ", &time, pm_string) == 2) {
+				server_playmode = ServerPlayModeMap::instance().GetServerPlayMode(pm_string);
+			}
+			else {
+				PRINT_ERROR("illegal playmode line " << buf);
+			}
+		}
+
+		line = eol + 1;
+	}
+
+	return !mIndex.empty();
+}
+
+bool RcgReader::BuildBinaryIndex()
+{
+	int server_playmode = SPM_Null;
+
+	size_t offset = 4;
+	while (offset + 2 <= mSize) {
+		const int mode = ReadInt16(mpData + offset);
+
+		if (mode == BM_Show && IsBinaryShow(offset)) {
+			IndexEntry entry;
+			entry.mTime = ReadInt16(mpData + offset + 2 + BINARY_BALL_SIZE + BINARY_PLAYER_SIZE * TEAMSIZE * 2);
+			entry.mServerPlayMode = server_playmode;
+			entry.mOffset = offset;
+			mIndex.push_back(entry);
+		}
+		else if (mode == BM_PlayMode && offset + 3 <= mSize) {
+			server_playmode = Min(int(static_cast<unsigned char>(mpData[offset + 2])), int(SPM_MAX) - 1);
+		}
+
+		const size_t size = BinaryRecordSize(offset);
+		if (size > 0) {
+			offset += size;
+			continue;
+		}
+
+		// 参数和异构类型记录的长度随server版本变化，向后找到下一串能接上show的记录
+		do {
+			++offset;
+		} while (offset + 2 + BINARY_SHOW_SIZE <= mSize && !IsBinaryRecordChain(offset));
+
+		if (offset + 2 + BINARY_SHOW_SIZE > mSize) {
+			break;
+		}
+	}
+
+	return !mIndex.empty();
+}
+
+size_t RcgReader::BinaryRecordSize(size_t offset) const
+{
+	size_t size = 0;
+	switch (ReadInt16(mpData + offset)) {
+	case BM_NoInfo:
+	case BM_Blank: size = 2; break;
+	case BM_Show: size = 2 + BINARY_SHOW_SIZE; break;
+	case BM_PlayMode: size = 3; break;
+	case BM_Team: size = 2 + BINARY_TEAM_SIZE; break;
+	case BM_Draw: size = 2 + BINARY_DRAW_SIZE; break;
+	case BM_Msg:
+		if (offset + 6 <= mSize) {
+			const int length = ReadInt16(mpData + offset + 4);
+			size = length >= 0? 6 + length: 0;
+		}
+		break;
+	default: return 0;
+	}
+
+	return offset + size <= mSize? size: 0;
+}
+
+bool RcgReader::IsBinaryRecordChain(size_t offset) const
+{
+	for (int i = 0; i < 8; ++i) { // 中间的比赛模式、队名等记录不多
+		const int mode = ReadInt16(mpData + offset);
+		if (mode == BM_Show) {
+			return IsBinaryShow(offset);
+		}
+		if (mode == BM_NoInfo || (mode == BM_PlayMode && static_cast<unsigned char>(mpData[offset + 2]) >= SPM_MAX)) {
+			return false;
+		}
+
+		const size_t size = BinaryRecordSize(offset);
+		if (size == 0 || offset + size + 2 > mSize) {
+			return false;
+		}
+		offset += size;
+	}
+	return false;
+}
+
+bool RcgReader::IsBinaryShow(size_t offset) const
+{
+	if (offset + 2 + BINARY_SHOW_SIZE > mSize || ReadInt16(mpData + offset) != BM_Show) {
+		return false;
+	}
+
+	const char *show = mpData + offset + 2;
+	if (ReadInt16(show + BINARY_BALL_SIZE + BINARY_PLAYER_SIZE * TEAMSIZE * 2) < 0) {
+		return false;
+	}
+
+	const double max_coord = 80.0;
+	if (fabs(ReadScaled(show)) > max_coord || fabs(ReadScaled(show + 4)) > max_coord) {
+		return false;
+	}
+
+	for (int i = 0; i < TEAMSIZE * 2; ++i) {
+		const char *player = show + BINARY_BALL_SIZE + BINARY_PLAYER_SIZE * i;
+		const int state = ReadInt16(player);
+		const int type = ReadInt16(player + 2);
+		if (state < 0 || type < 0 || type >= 64) {
+			return false;
+		}
+		if (fabs(ReadScaled(player + 4)) > max_coord || fabs(ReadScaled(player + 8)) > max_coord) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool RcgReader::ReadTextFrame(const IndexEntry & entry, RcgFrame & frame) const
+{
+	const char *begin = mpData + entry.mOffset;
+	const char *eol = static_cast<const char*>(memchr(begin, '\n', mSize - entry.mOffset));
+	const std::string line(begin, eol? eol: mpData + mSize);
+
+	const char *buf = line.c_str();
+	int time = 0, n_read = 0;
+	if (sscanf(buf, "(show %d %n", &time, &n_read) != 1) {
+		PRINT_ERROR("error time info:" << line);
+		return false;
+	}
+	buf += n_read;
+
+	float bx, by, bvx, bvy;
+	if (sscanf(buf, " ((b) %f %f %f %f) %n", &bx, &by, &bvx, &bvy, &n_read) != 4) {
+		PRINT_ERROR("error ball info:" << line);
+		return false;
+	}
+	buf += n_read;
+	frame.mBallPos = Vector(bx, by);
+	frame.mBallVel = Vector(bvx, bvy);
+
+	RcgFrame::Player player;
+	float x, y, vx, vy, body, neck;
+	for (int i = 0; i < TEAMSIZE * 2; ++i) {
+		if (*buf == '\0' || *buf == ')') break;
+
+		short unum, type;
+		if (sscanf(buf, " ((%c %hd) %hd %x %f %f %f %f %f %f %n",
+				&player.mSide, &unum, &type, &player.mState,
+				&x, &y, &vx, &vy, &body, &neck, &n_read) != 10) {
+			PRINT_ERROR("error player info:" << buf);
+			return false;
+		}
+		buf += n_read;
+
+		if (unum < 1 || unum > TEAMSIZE || (player.mSide != 'l' && player.mSide != 'r')) {
+			PRINT_ERROR("error player info:" << buf);
+			return false;
+		}
+
+		player.mUnum = unum;
+		player.mPlayerType = type;
+		player.mPos = Vector(x, y);
+		player.mVel = Vector(vx, vy);
+		player.mBodyDir = body;
+		player.mNeckDir = neck;
+		frame.mPlayers.push_back(player);
+
+		while (strncmp(buf, "((", 2)) { // 跳过视角、体力等
+			if (*buf == '\0') break;
+			buf++;
+		}
+	}
+
+	return true;
+}
+
+bool RcgReader::ReadBinaryFrame(const IndexEntry & entry, RcgFrame & frame) const
+{
+	const char *show = mpData + entry.mOffset + 2;
+
+	frame.mBallPos = Vector(ReadScaled(show), ReadScaled(show + 4));
+	frame.mBallVel = Vector(ReadScaled(show + 8), ReadScaled(show + 12));
+
+	RcgFrame::Player player;
+	for (int i = 0; i < TEAMSIZE * 2; ++i) {
+		const char *p = show + BINARY_BALL_SIZE + BINARY_PLAYER_SIZE * i;
+
+		player.mSide = i < TEAMSIZE? 'l': 'r';
+		player.mUnum = i % TEAMSIZE + 1;
+		player.mState = ReadInt16(p);
+		player.mPlayerType = ReadInt16(p + 2);
+		player.mPos = Vector(ReadScaled(p + 4), ReadScaled(p + 8));
+		player.mVel = Vector(ReadScaled(p + 12), ReadScaled(p + 16));
+		player.mBodyDir = Rad2Deg(ReadScaled(p + 20));
+		player.mNeckDir = Rad2Deg(ReadScaled(p + 24));
+		frame.mPlayers.push_back(player);
+	}
+
+	return true;
+}
+
+bool RcgReader::LoadIndex(const std::string & index_file)
+{
+	std::ifstream fin(index_file.c_str(), std::ios::binary);
+	if (!fin) {
+		return false;
+	}
+
+	IndexHeader header;
+	if (!fin.read(reinterpret_cast<char*>(&header), sizeof(header))
+			|| memcmp(header.mMagic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0
+			|| header.mVersion != INDEX_VERSION
+			|| header.mSize != (long long)(mSize)
+			|| header.mModifyTime != mModifyTime
+			|| header.mCount <= 0) {
+		return false; // rcg已经改变，重新建立索引
+	}
+
+	mIndex.resize(header.mCount);
+	if (!fin.read(reinterpret_cast<char*>(&mIndex[0]), sizeof(IndexEntry) * header.mCount)) {
+		mIndex.clear();
+		return false;
+	}
+
+	for (unsigned i = 0; i < mIndex.size(); ++i) {
+		if (mIndex[i].mOffset < 0 || mIndex[i].mOffset >= (long long)(mSize)) {
+			mIndex.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+void RcgReader::SaveIndex(const std::string & index_file) const
+{
+	std::ofstream fout(index_file.c_str(), std::ios::binary);
+	if (!fout) {
+		return; // rcg所在目录不可写时每次重新建立
+	}
+
+	IndexHeader header;
+	memcpy(header.mMagic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	header.mVersion = INDEX_VERSION;
+	header.mCount = mIndex.size();
+	header.mSize = mSize;
+	header.mModifyTime = mModifyTime;
+
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	fout.write(reinterpret_cast<const char*>(&mIndex[0]), sizeof(IndexEntry) * mIndex.size());
+}
@@ -0,0 +1,150 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+
+#ifndef __RcgReader_H__
+#define __RcgReader_H__
+
+#include "Geometry.h"
+#include "Types.h"
+#include <string>
+#include <vector>
+
+/**
+ * rcg中一个周期的show信息
+ */
+struct RcgFrame
+{
+	struct Player
+	{
+		char mSide; // 'l'或'r'
+		Unum mUnum;
+		int mPlayerType;
+		unsigned mState; // 0表示不在场上
+		Vector mPos;
+		Vector mVel;
+		AngleDeg mBodyDir;
+		AngleDeg mNeckDir;
+	};
+
+	int mTime;
+	ServerPlayMode mServerPlayMode; // 这个周期生效的比赛模式
+	Vector mBallPos;
+	Vector mBallVel;
+	std::vector<Player> mPlayers; // 按rcg中的顺序，左边在前；不在场上的球员mState为0
+};
+
+/**
+ * rcg读取，支持文本格式（ULG4、ULG5）和二进制格式（ULG3）。
+ * 打开时把整个文件映射到内存，建立周期到文件偏移的索引，并缓存在"文件名.idx"中，
+ * 之后打开同一个未修改的文件时直接读取索引；每个周期的show信息在读取时才解析。
+ * Memory-mapped rcg reader with a cached cycle->offset index and lazy frame decoding.
+ */
+class RcgReader
+{
+public:
+	RcgReader();
+	~RcgReader();
+
+	/**
+	 * 打开rcg文件并准备好索引
+	 */
+	bool Open(const char *file_name);
+	void Close();
+
+	int GetFrameCount() const { return mIndex.size(); }
+	int GetFrameTime(int i) const { return mIndex[i].mTime; }
+
+	/**
+	 * 第一个周期不小于time的show的序号，没有时返回-1
+	 */
+	int Find(int time) const;
+
+	/**
+	 * 解析第i个show
+	 */
+	bool ReadFrame(int i, RcgFrame & frame) const;
+
+	/**
+	 * 顺序读取：Seek到第一个周期不小于time的show，之后每次Next读出一个周期
+	 */
+	bool Seek(int time) { mCursor = Find(time); return mCursor >= 0; }
+	bool Next(RcgFrame & frame) { return mCursor >= 0 && mCursor < GetFrameCount() && ReadFrame(mCursor++, frame); }
+
+private:
+	struct IndexEntry
+	{
+		int mTime;
+		int mServerPlayMode;
+		long long mOffset; // show记录在文件中的位置
+	};
+
+	bool BuildTextIndex();
+	bool BuildBinaryIndex();
+	bool LoadIndex(const std::string & index_file);
+	void SaveIndex(const std::string & index_file) const;
+
+	bool ReadTextFrame(const IndexEntry & entry, RcgFrame & frame) const;
+	bool ReadBinaryFrame(const IndexEntry & entry, RcgFrame & frame) const;
+
+	/**
+	 * 二进制格式中offset处是否是一个完整的show记录
+	 */
+	bool IsBinaryShow(size_t offset) const;
+
+	/**
+	 * 从offset开始是否是几个已知记录并接上一个show，用于跳过各版本server长度不同的参数记录
+	 */
+	bool IsBinaryRecordChain(size_t offset) const;
+
+	/**
+	 * 二进制格式中offset处记录的长度（包括开头的mode），未知的记录返回0
+	 */
+	size_t BinaryRecordSize(size_t offset) const;
+
+private:
+	const char *mpData;
+	size_t mSize;
+	long long mModifyTime;
+	bool mIsBinary;
+
+#ifdef WIN32
+	std::vector<char> mBuffer;
+#else
+	int mFile;
+#endif
+
+	std::vector<IndexEntry> mIndex;
+	int mCursor;
+};
+
+#endif
@@ -0,0 +1,345 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+#include "Rollout.h"
+#include "Agent.h"
+#include "WorldState.h"
+#include "ThreadPool.h"
+#include "Utilities.h"
+#include "Tracer.h"
+#include <cstdlib>
+
+namespace {
+
+const int ROLLOUT_CHUNK = 16; // 每个任务的模拟次数，任务的划分与线程数无关，不限时的时候结果可以重现
+const int ROLLOUT_KICK_CYCLES = 30; // 球被踢出后最多模拟的周期数
+const int ROLLOUT_CARRY_CYCLES = 10; // 普通带球最多模拟的周期数
+const double ROLLOUT_PLAYER_RADIUS = 15.0; // 离球路线超过这个距离的球员不参与模拟
+const double ROLLOUT_POS_ERROR = 3.0; // 置信度为0的球员初始位置误差的最大值
+const double ROLLOUT_TURN_ANGLE = 15.0; // 追球时身体方向偏离超过这个角度就先转身
+const unsigned short ROLLOUT_SEED = 0x330e;
+
+/**
+ * 点到线段的距离
+ */
+double DistToSegment(const Vector & point, const Vector & begin, const Vector & end)
+{
+	const Vector segment = end - begin;
+	const double length2 = segment.Mod2();
+	if (length2 < FLOAT_EPS) return point.Dist(begin);
+
+	const Vector rel = point - begin;
+	const double t = MinMax(0.0, (rel.X() * segment.X() + rel.Y() * segment.Y()) / length2, 1.0);
+	return point.Dist(begin + segment * t);
+}
+
+/**
+ * 简单的追球策略：跑向按当前距离估计的球的到达位置，方向偏差大时先转身
+ */
+void Chase(Simulator::Player & player, const Simulator::Ball & ball)
+{
+	const double speed = PlayerParam::instance().HeteroPlayer(player.mPlayerType).effectiveSpeedMax();
+	const double decay = ServerParam::instance().ballDecay();
+	const double cycles = player.mPos.Dist(ball.mPos) / speed;
+	const Vector target = ball.mPos + ball.mVel * ((1.0 - pow(decay, cycles)) / (1.0 - decay));
+
+	const AngleDeg differ = GetNormalizeAngleDeg((target - player.mPos).Dir() - player.mBodyDir);
+	if (fabs(differ) > ROLLOUT_TURN_ANGLE) {
+		player.Turn(GetTurnMoment(differ, player.mPlayerType, player.mVel.Mod()));
+	}
+	else {
+		player.Dash(ServerParam::instance().maxDashPower(), 0);
+	}
+}
+
+/**
+ * 沿固定方向跑，用于普通带球的自己
+ */
+void Run(Simulator::Player & player, AngleDeg dir)
+{
+	const AngleDeg differ = GetNormalizeAngleDeg(dir - player.mBodyDir);
+	if (fabs(differ) > ROLLOUT_TURN_ANGLE) {
+		player.Turn(GetTurnMoment(differ, player.mPlayerType, player.mVel.Mod()));
+	}
+	else {
+		player.Dash(ServerParam::instance().maxDashPower(), 0);
+	}
+}
+
+bool IsGoal(const Vector & ball_pos)
+{
+	return ball_pos.X() > ServerParam::instance().PITCH_LENGTH * 0.5 && fabs(ball_pos.Y()) < ServerParam::instance().goalWidth() * 0.5;
+}
+
+}
+
+/**
+ * 在线程池中运行一段连续的模拟，使用自己的随机数序列
+ */
+class Rollout::Task: public ThreadTask
+{
+public:
+	Task(): mpScenario(0), mIndex(0), mCount(0), mHasDeadline(false), mDone(0), mSuccess(0) {}
+
+	void Init(const Scenario & scenario, int index, int count, int seed, bool has_deadline, const RealTime & deadline) {
+		mpScenario = &scenario;
+		mIndex = index;
+		mCount = count;
+		mHasDeadline = has_deadline;
+		mDeadline = deadline;
+
+		mSeed[0] = ROLLOUT_SEED;
+		mSeed[1] = (unsigned short)seed;
+		mSeed[2] = (unsigned short)index;
+	}
+
+	void Run() {
+		std::vector<Simulator::Player> players;
+		players.reserve(mpScenario->mPlayers.size());
+
+		for (int i = 0; i < mCount; ++i) {
+			if (mHasDeadline && (mIndex > 0 || i > 0) && RealTime(GetRealTime()) > mDeadline) break; //至少完成一次
+			if (RunOnce(*mpScenario, mSeed, players)) {
+				++mSuccess;
+			}
+			++mDone;
+		}
+	}
+
+	int Done() const { return mDone; }
+	int Success() const { return mSuccess; }
+
+private:
+	const Scenario *mpScenario;
+	int mIndex;
+	int mCount;
+	bool mHasDeadline;
+	RealTime mDeadline;
+	unsigned short mSeed[3];
+
+	int mDone;
+	int mSuccess;
+};
+
+Rollout::Rollout()
+{
+}
+
+Rollout::~Rollout()
+{
+}
+
+Rollout & Rollout::instance()
+{
+	static Rollout rollout;
+	return rollout;
+}
+
+bool Rollout::IsSupported(const ActiveBehavior & behavior)
+{
+	return behavior.GetType() == BT_Pass || behavior.GetType() == BT_Shoot || behavior.GetType() == BT_Dribble || behavior.GetType() == BT_Hold;
+}
+
+/**
+ * 各任务共享同一个Scenario，都在Wait()返回前完成，因此不能在ThreadPool的任务中调用
+ */
+RolloutResult Rollout::Evaluate(const ActiveBehavior & behavior, int count, int budget)
+{
+	TRACE_SPAN(TS_Rollout);
+
+	RolloutResult result;
+	if (count <= 0 || !IsSupported(behavior)) return result;
+
+	Scenario scenario;
+	BuildScenario(behavior, scenario);
+
+	const bool has_deadline = budget > 0 && !PlayerParam::instance().DynamicDebugMode();
+	const RealTime deadline = RealTime(GetRealTime()) + budget;
+	const int seed = behavior.GetAgent().GetWorldState().CurrentTime().T();
+
+	std::vector<Task> tasks((count + ROLLOUT_CHUNK - 1) / ROLLOUT_CHUNK);
+	for (uint i = 0; i < tasks.size(); ++i) {
+		tasks[i].Init(scenario, i, Min(ROLLOUT_CHUNK, count - int(i) * ROLLOUT_CHUNK), seed, has_deadline, deadline);
+		ThreadPool::instance().Submit(&tasks[i]);
+	}
+	ThreadPool::instance().Wait();
+
+	int success = 0;
+	for (uint i = 0; i < tasks.size(); ++i) {
+		result.mCount += tasks[i].Done();
+		success += tasks[i].Success();
+	}
+
+	if (result.mCount > 0) {
+		result.mSuccess = double(success) / result.mCount;
+		if (result.mCount > 1) {
+			result.mVariance = result.mSuccess * (1.0 - result.mSuccess) * result.mCount / (result.mCount - 1);
+		}
+	}
+	return result;
+}
+
+void Rollout::BuildScenario(const ActiveBehavior & behavior, Scenario & scenario)
+{
+	const Agent & agent = behavior.GetAgent();
+	const WorldState & world_state = agent.GetWorldState();
+	const PlayerState & self = agent.GetSelf();
+	const Vector & ball_pos = world_state.GetBall().GetPos();
+
+	scenario.mType = behavior.GetType();
+	scenario.mCarry = (behavior.GetType() == BT_Dribble && behavior.mDetailType == BDT_Dribble_Normal) || behavior.GetType() == BT_Hold;
+	scenario.mCarryDir = behavior.GetType() == BT_Hold? (ball_pos - self.GetPos()).Dir(): behavior.mAngle;
+	scenario.mBallPos = ball_pos;
+	scenario.mBallVel = Vector(0.0, 0.0);
+
+	switch (behavior.GetType()) {
+	case BT_Pass:
+		scenario.mBallVel = Polar2Vector(behavior.mDetailType == BDT_Pass_Clear? ServerParam::instance().ballSpeedMax(): behavior.mKickSpeed, (behavior.mTarget - ball_pos).Dir());
+		break;
+	case BT_Shoot:
+		scenario.mBallVel = Polar2Vector(ServerParam::instance().ballSpeedMax(), (behavior.mTarget - ball_pos).Dir());
+		break;
+	case BT_Dribble:
+		if (!scenario.mCarry) {
+			scenario.mBallVel = Polar2Vector(behavior.mKickSpeed, behavior.mAngle);
+		}
+		break;
+	default:
+		break;
+	}
+
+	/** 球的大致路线，只有离它足够近的球员才可能影响结果 */
+	Vector path_end;
+	if (scenario.mCarry) {
+		scenario.mMaxCycles = ROLLOUT_CARRY_CYCLES;
+		path_end = self.GetPos();
+		if (scenario.mType != BT_Hold) {
+			path_end += Polar2Vector(self.GetEffectiveSpeedMax() * ROLLOUT_CARRY_CYCLES, scenario.mCarryDir);
+		}
+	}
+	else {
+		scenario.mMaxCycles = ROLLOUT_KICK_CYCLES;
+		const double decay = ServerParam::instance().ballDecay();
+		path_end = ball_pos + scenario.mBallVel * ((1.0 - pow(decay, ROLLOUT_KICK_CYCLES)) / (1.0 - decay));
+	}
+
+	const std::vector<PlayerState *> & players = world_state.GetPlayerList();
+	for (uint i = 0; i < players.size(); ++i) {
+		const PlayerState & player = *players[i];
+		if (!player.IsAlive()) continue;
+
+		const bool is_self = &player == &self;
+		if (!is_self && DistToSegment(player.GetPos(), ball_pos, path_end) > ROLLOUT_PLAYER_RADIUS) continue;
+
+		const bool is_opponent = player.GetUnum() < 0;
+		scenario.mPlayers.push_back(RolloutPlayer(player, is_opponent, is_self, is_opponent? (1.0 - player.GetPosConf()) * ROLLOUT_POS_ERROR: 0.0));
+	}
+}
+
+/**
+ * 每周期先由各球员按简单策略行动（速度带噪声），再移动球，然后判断控球：
+ * 1. 对手先控到球或者球出界为失败，射门进球为成功；
+ * 2. 传球和射门不考虑自己再次控球，射门也不考虑队友；快速带球从踢出后第2周期开始考虑自己；
+ * 3. 普通带球时球始终在自己身前，控球时自己不动、球在身边，模拟结束时球还在自己脚下为成功；
+ * 4. 踢出的球在模拟结束时仍没有人控到，离球最近的是队友（或自己）为成功。
+ */
+bool Rollout::RunOnce(const Scenario & scenario, unsigned short seed[3], std::vector<Simulator::Player> & players)
+{
+	players.clear();
+	for (uint i = 0; i < scenario.mPlayers.size(); ++i) {
+		players.push_back(scenario.mPlayers[i].mBody);
+		if (scenario.mPlayers[i].mPosError > 0.0) {
+			players.back().mPos += Polar2Vector(erand48(seed) * scenario.mPlayers[i].mPosError, erand48(seed) * 360.0 - 180.0);
+		}
+	}
+
+	Simulator::Ball ball(scenario.mBallPos, scenario.mBallVel);
+
+	for (int cycle = 1; cycle <= scenario.mMaxCycles; ++cycle) {
+		int self = -1;
+		for (uint i = 0; i < players.size(); ++i) {
+			Simulator::Player & player = players[i];
+			player.mVel += Polar2Vector(erand48(seed) * ServerParam::instance().playerRand() * player.mVel.Mod(), erand48(seed) * 360.0 - 180.0);
+
+			if (scenario.mPlayers[i].mIsSelf) {
+				self = i;
+				if (scenario.mCarry) {
+					if (scenario.mType != BT_Hold) {
+						Run(player, scenario.mCarryDir);
+					}
+					continue;
+				}
+			}
+			Chase(player, ball);
+		}
+
+		if (scenario.mCarry && self >= 0) {
+			const Simulator::Player & carrier = players[self];
+			ball.mPos = carrier.mPos + Polar2Vector(PlayerParam::instance().HeteroPlayer(carrier.mPlayerType).kickableArea() * 0.5, scenario.mCarryDir);
+			ball.mVel = carrier.mVel;
+		}
+		else {
+			ball.RandomizedStep(seed);
+		}
+
+		if (scenario.mType == BT_Shoot && IsGoal(ball.mPos)) return true;
+		if (!IsPointInBounds(ball.mPos)) return false;
+
+		bool our_control = false;
+		for (uint i = 0; i < players.size(); ++i) {
+			const RolloutPlayer & info = scenario.mPlayers[i];
+			if (info.mIsSelf && (scenario.mCarry || scenario.mType != BT_Dribble || cycle < 2)) continue;
+			if (!info.mIsOpponent && !info.mIsSelf && scenario.mType == BT_Shoot) continue;
+
+			const double prob = players[i].GetControlBallProb(ball.mPos, *info.mpState);
+			if (prob >= 1.0 || (prob > 0.0 && erand48(seed) < prob)) {
+				if (info.mIsOpponent) return false;
+				our_control = true;
+			}
+		}
+		if (our_control) return true;
+	}
+
+	if (scenario.mCarry) return true;
+	if (scenario.mType == BT_Shoot) return false;
+
+	int closest = -1;
+	double min_dist = HUGE_VALUE;
+	for (uint i = 0; i < players.size(); ++i) {
+		const double dist = players[i].mPos.Dist(ball.mPos);
+		if (dist < min_dist) {
+			min_dist = dist;
+			closest = i;
+		}
+	}
+	return closest >= 0 && !scenario.mPlayers[closest].mIsOpponent;
+}
@@ -0,0 +1,122 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+#ifndef __Rollout_H__
+#define __Rollout_H__
+
+#include "Simulator.h"
+#include "BehaviorBase.h"
+#include <vector>
+
+/**
+ * 一个行为的多次模拟结果
+ */
+struct RolloutResult
+{
+	int mCount; // 实际完成的模拟次数，时间不够时可能少于要求的次数
+	double mSuccess; // 成功的比例，作为成功概率的估计
+	double mVariance; // 单次结果的样本方差，成功概率估计的方差为mVariance / mCount
+
+	RolloutResult(): mCount(0), mSuccess(0.0), mVariance(0.0) {}
+};
+
+/**
+ * 基于Simulator::Ball和Simulator::Player的蒙特卡洛评价：从当前世界状态出发，
+ * 对传球、带球、射门和控球多次模拟球和附近球员的短期运动（带噪声），统计我方控球（或进球）的比例。
+ * 附近的球员都使用简单的追球策略，对手位置按其置信度加入随机误差。
+ * 模拟分成若干任务在ThreadPool中并行运行，每个任务有自己的随机数序列，不影响drand48。
+ * Monte Carlo rollouts of a kick behavior over Simulator's ball and player models.
+ */
+class Rollout
+{
+	Rollout();
+
+public:
+	~Rollout();
+
+	static Rollout & instance();
+
+	/**
+	 * 模拟一个行为，不支持的行为类型返回mCount为0的结果
+	 * @param behavior 传球、带球、射门或控球
+	 * @param count 模拟次数
+	 * @param budget 时间预算（毫秒），超时后各任务不再开始新的模拟；0表示不限时。动态调试时不限时，以便结果可以重现
+	 */
+	RolloutResult Evaluate(const ActiveBehavior & behavior, int count, int budget);
+
+	/** 是否可以模拟这个行为 */
+	static bool IsSupported(const ActiveBehavior & behavior);
+
+private:
+	class Task;
+	friend class Task;
+
+	/**
+	 * 参与模拟的球员，由决策线程从世界状态中取出，各任务只读
+	 */
+	struct RolloutPlayer
+	{
+		Simulator::Player mBody;
+		const PlayerState *mpState;
+		bool mIsOpponent;
+		bool mIsSelf;
+		double mPosError; // 初始位置随机误差的最大值
+
+		RolloutPlayer(const PlayerState & state, bool is_opponent, bool is_self, double pos_error):
+			mBody(state), mpState(&state), mIsOpponent(is_opponent), mIsSelf(is_self), mPosError(pos_error) {}
+	};
+
+	/**
+	 * 模拟的初始状态
+	 */
+	struct Scenario
+	{
+		BehaviorType mType;
+		bool mCarry; // 普通带球和控球：球始终在自己身边的mCarryDir方向，带球时自己沿mCarryDir跑
+		AngleDeg mCarryDir;
+		Vector mBallPos;
+		Vector mBallVel; // 踢出后的球速
+		int mMaxCycles;
+		std::vector<RolloutPlayer> mPlayers;
+	};
+
+	void BuildScenario(const ActiveBehavior & behavior, Scenario & scenario);
+
+	/**
+	 * 模拟一次，返回是否成功
+	 * @param seed 本次模拟使用的随机数序列
+	 * @param players 临时空间，避免每次模拟分配内存
+	 */
+	static bool RunOnce(const Scenario & scenario, unsigned short seed[3], std::vector<Simulator::Player> & players);
+};
+
+#endif
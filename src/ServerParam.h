@@ -526,6 +526,7 @@ public:
     int playerPort() const { return M_port; }
     const std::string & serverHost() const { return M_host; }
     int offlineCoachPort() const { return M_coach_port; }
+    void setOfflineCoachPort(int port) { M_coach_port = port; } //批量训练时每个训练进程连接不同的server
     int onlineCoachPort() const { return M_olcoach_port; }
 
     unsigned int freeformCountMax() const { return (unsigned int)M_say_cnt_max; }
@@ -33,6 +33,9 @@
 #include "Simulator.h"
 #include "ActionEffector.h"
 #include "Dasher.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 Simulator::Simulator() {
 }
@@ -86,3 +89,987 @@ void Simulator::Player::Act(const AtomicAction & act)
 	default: Assert(0); break;
 	}
 }
+
+namespace {
+const char *SIMULATED_TEAM_NAME = "Simulated";
+
+const int BEFORE_KICK_OFF_WAIT = 2; // before_kick_off持续的决策次数，时间停止
+const int AFTER_GOAL_WAIT = 50;
+const int GOALIE_HOLD_CYCLES = 5; // 内置守门员扑住球后持球的周期数
+const double TEAM_TOO_FAR_LENGTH = 60.0;
+const double DIST_EPS = 1.0e-10;
+
+/** 左边球队的4-3-3阵型位置，右边取镜像 */
+const double HOME_POSITIONS[TEAMSIZE + 1][2] = {
+		{   0.0,   0.0 },
+		{ -50.0,   0.0 },
+		{ -36.0, -15.0 }, { -38.0,  -5.0 }, { -38.0,   5.0 }, { -36.0,  15.0 },
+		{ -20.0, -12.0 }, { -22.0,   0.0 }, { -20.0,  12.0 },
+		{  -5.0, -20.0 }, {  -3.0,   0.0 }, {  -5.0,  20.0 }
+};
+
+/**
+ * 当前比赛模式下可以踢球的一方，'?'表示双方都可以，0表示都不可以
+ */
+char KickableSide(ServerPlayMode spm)
+{
+	switch (spm) {
+	case SPM_PlayOn: return '?';
+	case SPM_KickOff_Left:
+	case SPM_KickIn_Left:
+	case SPM_FreeKick_Left:
+	case SPM_CornerKick_Left:
+	case SPM_GoalKick_Left: return 'l';
+	case SPM_KickOff_Right:
+	case SPM_KickIn_Right:
+	case SPM_FreeKick_Right:
+	case SPM_CornerKick_Right:
+	case SPM_GoalKick_Right: return 'r';
+	default: return 0;
+	}
+}
+
+int NearestDashDirIdx(AngleDeg dir)
+{
+	int best = 0;
+	for (int i = 1; i < 8; ++i) {
+		if (GetAngleDegDiffer(dir, Dasher::DASH_DIR[i]) < GetAngleDegDiffer(dir, Dasher::DASH_DIR[best])) {
+			best = i;
+		}
+	}
+	return best;
+}
+
+const char *ViewWidthName(ViewWidth view_width)
+{
+	switch (view_width) {
+	case VW_Narrow: return "narrow";
+	case VW_Wide: return "wide";
+	default: return "normal";
+	}
+}
+}
+
+Simulator::Match::MatchPlayer::MatchPlayer():
+	mBody(Vector(0.0, 0.0), Vector(0.0, 0.0), 0.0, 0),
+	mSide('l'),
+	mUnum(0),
+	mIsGoalie(false),
+	mNeckDir(0.0),
+	mViewWidth(VW_Normal),
+	mTackleExpires(0),
+	mCollideWithBall(false),
+	mCollideWithPlayer(false),
+	mBodyCmd(CT_None),
+	mCmdPower(0.0),
+	mCmdAngle(0.0),
+	mCmdFoul(false),
+	mCmdTurnNeck(0.0),
+	mHasTurnNeck(false),
+	mKicks(0), mDashes(0), mTurns(0), mSays(0), mTurnNecks(0), mCatches(0), mMoves(0), mChangeViews(0), mTackles(0), mPoints(0), mFocuses(0)
+{
+}
+
+Simulator::Match::Match(const Unum & self_unum):
+	mSelfUnum(self_unum),
+	mBall(Vector(0.0, 0.0), Vector(0.0, 0.0)),
+	mpBallHolder(0),
+	mTime(0),
+	mServerPlayMode(SPM_BeforeKickOff),
+	mModeCycles(0),
+	mLastKickerSide('?'),
+	mBallKicked(false),
+	mKickOffSide('l'),
+	mLastSightTime(-1)
+{
+	Assert(mSelfUnum >= 1 && mSelfUnum <= TEAMSIZE);
+
+	mScore[0] = mScore[1] = 0;
+
+	for (int s = 0; s < 2; ++s) {
+		const Unum goalie = (s == 0) ? PlayerParam::instance().ourGoalieUnum() : 1;
+
+		for (Unum i = 1; i <= TEAMSIZE; ++i) {
+			MatchPlayer & player = mPlayers[s][i];
+
+			// 守门员总是使用1号的阵型位置
+			const Unum role = (i == goalie) ? 1 : ((i == 1) ? goalie : i);
+
+			player.mSide = (s == 0) ? 'l' : 'r';
+			player.mUnum = i;
+			player.mIsGoalie = (i == goalie);
+			player.mHomePos = Vector(HOME_POSITIONS[role][0], HOME_POSITIONS[role][1]);
+			player.mBody.mBodyDir = (s == 0) ? 0.0 : 180.0;
+		}
+	}
+
+	// 和server一样，刚连上的球员在场外
+	Self().mBody.mPos = Vector(-3.0 * mSelfUnum, -ServerParam::instance().PITCH_WIDTH * 0.5 - 3.0);
+
+	InitializeMarkers();
+	ResetForKickOff();
+}
+
+void Simulator::Match::InitializeMarkers()
+{
+	const double pitch_length = ServerParam::instance().PITCH_LENGTH;
+	const double pitch_width  = ServerParam::instance().PITCH_WIDTH;
+	const double pitch_margin = ServerParam::instance().PITCH_MARGIN;
+	const double goal_width   = ServerParam::instance().goalWidth();
+	const double penalty_area_length = ServerParam::instance().PENALTY_AREA_LENGTH;
+	const double penalty_area_width  = ServerParam::instance().PENALTY_AREA_WIDTH;
+
+	const double half_length = pitch_length / 2.0;
+	const double half_width = pitch_width / 2.0;
+
+	struct {
+		const char *name;
+		double x, y;
+	} markers[] = {
+			{ "g l", -half_length, 0.0 },
+			{ "g r", half_length, 0.0 },
+			{ "f c", 0.0, 0.0 },
+			{ "f c t", 0.0, -half_width },
+			{ "f c b", 0.0, half_width },
+			{ "f l t", -half_length, -half_width },
+			{ "f l b", -half_length, half_width },
+			{ "f r t", half_length, -half_width },
+			{ "f r b", half_length, half_width },
+			{ "f p l t", -half_length + penalty_area_length, -penalty_area_width / 2.0 },
+			{ "f p l c", -half_length + penalty_area_length, 0.0 },
+			{ "f p l b", -half_length + penalty_area_length, penalty_area_width / 2.0 },
+			{ "f p r t", half_length - penalty_area_length, -penalty_area_width / 2.0 },
+			{ "f p r c", half_length - penalty_area_length, 0.0 },
+			{ "f p r b", half_length - penalty_area_length, penalty_area_width / 2.0 },
+			{ "f g l t", -half_length, -goal_width / 2.0 },
+			{ "f g l b", -half_length, goal_width / 2.0 },
+			{ "f g r t", half_length, -goal_width / 2.0 },
+			{ "f g r b", half_length, goal_width / 2.0 },
+			{ "f t 0", 0.0, -half_width - pitch_margin },
+			{ "f b 0", 0.0, half_width + pitch_margin },
+			{ "f l 0", -half_length - pitch_margin, 0.0 },
+			{ "f r 0", half_length + pitch_margin, 0.0 }
+	};
+
+	mMarkers.clear();
+	for (unsigned i = 0; i < sizeof(markers) / sizeof(markers[0]); ++i) {
+		Marker marker;
+		marker.mName = markers[i].name;
+		marker.mPos = Vector(markers[i].x, markers[i].y);
+		mMarkers.push_back(marker);
+	}
+
+	char name[16];
+	for (int x = 10; x <= 50; x += 10) {
+		for (int s = -1; s <= 1; s += 2) {
+			sprintf(name, "f t %c %d", s < 0 ? 'l' : 'r', x);
+			Marker top = { name, Vector(s * x, -half_width - pitch_margin) };
+			mMarkers.push_back(top);
+
+			sprintf(name, "f b %c %d", s < 0 ? 'l' : 'r', x);
+			Marker bottom = { name, Vector(s * x, half_width + pitch_margin) };
+			mMarkers.push_back(bottom);
+		}
+	}
+	for (int y = 10; y <= 30; y += 10) {
+		for (int s = -1; s <= 1; s += 2) {
+			sprintf(name, "f l %c %d", s < 0 ? 't' : 'b', y);
+			Marker left = { name, Vector(-half_length - pitch_margin, s * y) };
+			mMarkers.push_back(left);
+
+			sprintf(name, "f r %c %d", s < 0 ? 't' : 'b', y);
+			Marker right = { name, Vector(half_length + pitch_margin, s * y) };
+			mMarkers.push_back(right);
+		}
+	}
+}
+
+void Simulator::Match::ResetForKickOff()
+{
+	mBall = Ball(Vector(0.0, 0.0), Vector(0.0, 0.0));
+	mpBallHolder = 0;
+
+	for (int s = 0; s < 2; ++s) {
+		const double sign = (s == 0) ? 1.0 : -1.0;
+
+		for (Unum i = 1; i <= TEAMSIZE; ++i) {
+			MatchPlayer & player = mPlayers[s][i];
+
+			if (&player == &Self()) { // 被测球员自己move，只有在对方半场时才被server移回来
+				if (player.mBody.mPos.X() > 0.0) {
+					player.mBody.mPos.SetX(-player.mBody.mPos.X());
+				}
+				continue;
+			}
+
+			player.mBody.mPos = Vector(Min(player.mHomePos.X(), -2.0) * sign, player.mHomePos.Y() * sign);
+			player.mBody.mVel = Vector(0.0, 0.0);
+			player.mBody.mBodyDir = (s == 0) ? 0.0 : 180.0;
+			player.mNeckDir = 0.0;
+			player.mTackleExpires = 0;
+		}
+	}
+}
+
+void Simulator::Match::ChangePlayMode(ServerPlayMode spm, const char *name)
+{
+	mServerPlayMode = spm;
+	mModeCycles = 0;
+
+	if (spm != SPM_GoalieCatchBall_Left && spm != SPM_GoalieCatchBall_Right &&
+			spm != SPM_FreeKick_Left && spm != SPM_FreeKick_Right) {
+		mpBallHolder = 0;
+	}
+
+	mRefereeMsgs.push_back(name ? name : ServerPlayModeMap::instance().GetPlayModeString(spm));
+}
+
+void Simulator::Match::GetInitMsg(char *msg) const
+{
+	sprintf(msg, "(init l %d before_kick_off)", mSelfUnum);
+}
+
+void Simulator::Match::GetSenseMsg(char *msg) const
+{
+	const MatchPlayer & self = Self();
+	const Vector & vel = self.mBody.mVel;
+
+	const char *collision = "none";
+	if (self.mCollideWithBall && self.mCollideWithPlayer) {
+		collision = "(ball) (player)";
+	}
+	else if (self.mCollideWithBall) {
+		collision = "(ball)";
+	}
+	else if (self.mCollideWithPlayer) {
+		collision = "(player)";
+	}
+
+	sprintf(msg, "(sense_body %d (view_mode high %s) (stamina %d %g %g) (speed %.2f %.0f) (head_angle %.0f) "
+			"(kick %d) (dash %d) (turn %d) (say %d) (turn_neck %d) (catch %d) (move %d) (change_view %d) "
+			"(arm (movable 0) (expires 0) (target 0 0) (count %d)) (focus (target none) (count %d)) "
+			"(tackle (expires %d) (count %d)) (collision %s) (foul (charged 0) (card none)))",
+			mTime, ViewWidthName(self.mViewWidth),
+			self.mBody.mStamina, self.mBody.mEffort, ServerParam::instance().staminaCapacity(),
+			Quantize(vel.Mod(), 0.01), Rint(GetNormalizeAngleDeg(vel.Dir() - self.NeckGlobalDir())), Rint(self.mNeckDir),
+			self.mKicks, self.mDashes, self.mTurns, self.mSays, self.mTurnNecks, self.mCatches, self.mMoves, self.mChangeViews,
+			self.mPoints, self.mFocuses,
+			self.mTackleExpires, self.mTackles, collision);
+}
+
+bool Simulator::Match::GetHearMsg(char *msg)
+{
+	if (mRefereeMsgs.empty()) {
+		return false;
+	}
+
+	sprintf(msg, "(hear %d referee %s)", mTime, mRefereeMsgs.front().c_str());
+	mRefereeMsgs.erase(mRefereeMsgs.begin());
+	return true;
+}
+
+char * Simulator::Match::AppendObject(char *msg, const char *name, const Vector & pos, const double & quantize_step, const Vector *vel, const MatchPlayer *player) const
+{
+	const MatchPlayer & self = Self();
+
+	const Vector rpos = pos - self.mBody.mPos;
+	const double dist = rpos.Mod();
+	const double quantized_dist = Quantize(exp(Quantize(log(dist + DIST_EPS), quantize_step)), 0.1);
+	const AngleDeg neck = self.NeckGlobalDir();
+
+	msg += sprintf(msg, " ((%s) %.1f %.0f", name, quantized_dist, Rint(GetNormalizeAngleDeg(rpos.Dir() - neck)));
+
+	if (vel) {
+		double dist_chg = 0.0;
+		double dir_chg = 0.0;
+
+		if (dist > DIST_EPS) {
+			const Vector unit = rpos / dist;
+			const Vector rvel = *vel - self.mBody.mVel;
+
+			dist_chg = Quantize(quantized_dist * (rvel.X() * unit.X() + rvel.Y() * unit.Y()) / dist, 0.02);
+			dir_chg = Quantize(Rad2Deg(rvel.Y() * unit.X() - rvel.X() * unit.Y()) / dist, 0.1);
+		}
+
+		msg += sprintf(msg, " %.2f %.1f", dist_chg, dir_chg);
+
+		if (player) {
+			msg += sprintf(msg, " %.0f %.0f",
+					Rint(GetNormalizeAngleDeg(player->mBody.mBodyDir - neck)),
+					Rint(GetNormalizeAngleDeg(player->NeckGlobalDir() - neck)));
+		}
+	}
+
+	msg += sprintf(msg, ")");
+	return msg;
+}
+
+bool Simulator::Match::GetSightMsg(char *msg)
+{
+	const MatchPlayer & self = Self();
+
+	if (mLastSightTime >= 0 && mTime - mLastSightTime < sight::SightDelay(self.mViewWidth)) {
+		return false;
+	}
+	mLastSightTime = mTime;
+
+	const Vector & self_pos = self.mBody.mPos;
+	const AngleDeg neck = self.NeckGlobalDir();
+	const double half_view_angle = sight::ViewAngle(self.mViewWidth) * 0.5;
+	const double landmark_step = ServerParam::instance().landmarkQuantizeStep();
+	const double object_step = ServerParam::instance().quantizeStep();
+
+	char *end = msg + sprintf(msg, "(see %d", mTime);
+
+	for (std::vector<Marker>::const_iterator it = mMarkers.begin(); it != mMarkers.end(); ++it) {
+		if (fabs(GetNormalizeAngleDeg((it->mPos - self_pos).Dir() - neck)) <= half_view_angle) {
+			end = AppendObject(end, it->mName.c_str(), it->mPos, landmark_step);
+		}
+	}
+
+	// 视线与边线相交时看到边线，在场外时视线会先从外侧穿过最近的边线
+	const double half_length = ServerParam::instance().PITCH_LENGTH * 0.5;
+	const double half_width = ServerParam::instance().PITCH_WIDTH * 0.5;
+	const char *line_names[SL_MAX] = { "l l", "l r", "l t", "l b" };
+	const AngleDeg line_dirs[SL_MAX] = { 180.0, 0.0, -90.0, 90.0 };
+	const double inside_dists[SL_MAX] = {
+			self_pos.X() + half_length, half_length - self_pos.X(), self_pos.Y() + half_width, half_width - self_pos.Y() };
+
+	for (int i = 0; i < SL_MAX; ++i) {
+		const double cos_rel = Cos(line_dirs[i] - neck);
+		if (fabs(cos_rel) < FLOAT_EPS || inside_dists[i] / cos_rel <= 0.0) {
+			continue;
+		}
+
+		const Vector cross = self_pos + Polar2Vector(inside_dists[i] / cos_rel, neck);
+		if ((i < SL_Top && fabs(cross.Y()) > half_width) || (i >= SL_Top && fabs(cross.X()) > half_length)) {
+			continue;
+		}
+
+		const AngleDeg rel = GetNormalizeAngleDeg((inside_dists[i] > 0.0 ? line_dirs[i] : line_dirs[i] + 180.0) - neck);
+		const double dist = Quantize(exp(Quantize(log(fabs(inside_dists[i]) + DIST_EPS), landmark_step)), 0.1);
+		end += sprintf(end, " ((%s) %.1f %.0f)", line_names[i], dist, Rint(rel >= 0.0 ? rel - 90.0 : rel + 90.0));
+	}
+
+	const double ball_dist = mBall.mPos.Dist(self_pos);
+	if (fabs(GetNormalizeAngleDeg((mBall.mPos - self_pos).Dir() - neck)) <= half_view_angle) {
+		end = AppendObject(end, "b", mBall.mPos, object_step, &mBall.mVel);
+	}
+	else if (ball_dist <= ServerParam::instance().visibleDistance()) {
+		end = AppendObject(end, "B", mBall.mPos, object_step);
+	}
+
+	// server先发左边球员，再发右边球员
+	char name[64];
+	for (int s = 0; s < 2; ++s) {
+		const char *team_name = (s == 0) ? PlayerParam::instance().teamName().c_str() : SIMULATED_TEAM_NAME;
+
+		for (Unum i = 1; i <= TEAMSIZE; ++i) {
+			const MatchPlayer & player = mPlayers[s][i];
+			if (&player == &self) {
+				continue;
+			}
+
+			const Vector & pos = player.mBody.mPos;
+			const double dist = pos.Dist(self_pos);
+
+			if (fabs(GetNormalizeAngleDeg((pos - self_pos).Dir() - neck)) > half_view_angle) {
+				if (dist <= ServerParam::instance().visibleDistance()) {
+					end = AppendObject(end, "P", pos, object_step);
+				}
+			}
+			else if (dist <= ServerParam::instance().unumFarLength()) {
+				sprintf(name, "p \"%s\" %d%s", team_name, i, player.mIsGoalie ? " goalie" : "");
+				end = AppendObject(end, name, pos, object_step, &player.mBody.mVel, &player);
+			}
+			else if (dist <= ServerParam::instance().unumTooFarLength()) {
+				sprintf(name, "p \"%s\" %d%s", team_name, i, player.mIsGoalie ? " goalie" : "");
+				end = AppendObject(end, name, pos, object_step);
+			}
+			else if (dist <= TEAM_TOO_FAR_LENGTH) {
+				sprintf(name, "p \"%s\"", team_name);
+				end = AppendObject(end, name, pos, object_step);
+			}
+			else {
+				end = AppendObject(end, "p", pos, object_step);
+			}
+		}
+	}
+
+	sprintf(end, ")");
+	return true;
+}
+
+void Simulator::Match::ExecuteCommands(const char *msg)
+{
+	MatchPlayer & self = Self();
+	self.ClearCommands();
+
+	const char *p = msg;
+	while ((p = strchr(p, '(')) != 0) {
+		++p;
+
+		char name[32];
+		int n = 0;
+		while (*p && *p != ' ' && *p != ')' && n < 31) {
+			name[n++] = *p++;
+		}
+		name[n] = '\0';
+
+		double x = 0.0, y = 0.0;
+		char word[32] = "";
+
+		if (!strcmp(name, "turn")) {
+			self.mBodyCmd = CT_Turn;
+			self.mCmdAngle = strtod(p, 0);
+		}
+		else if (!strcmp(name, "dash")) {
+			self.mBodyCmd = CT_Dash;
+			sscanf(p, "%lf %lf", &x, &y);
+			self.mCmdPower = x;
+			self.mCmdAngle = y;
+		}
+		else if (!strcmp(name, "kick")) {
+			self.mBodyCmd = CT_Kick;
+			sscanf(p, "%lf %lf", &x, &y);
+			self.mCmdPower = x;
+			self.mCmdAngle = y;
+		}
+		else if (!strcmp(name, "tackle")) {
+			self.mBodyCmd = CT_Tackle;
+			sscanf(p, "%lf %31[a-z]", &x, word);
+			self.mCmdAngle = x;
+			self.mCmdFoul = !strcmp(word, "true") || !strcmp(word, "on");
+		}
+		else if (!strcmp(name, "catch")) {
+			self.mBodyCmd = CT_Catch;
+			self.mCmdAngle = strtod(p, 0);
+		}
+		else if (!strcmp(name, "move")) {
+			self.mBodyCmd = CT_Move;
+			sscanf(p, "%lf %lf", &x, &y);
+			self.mCmdPos = Vector(x, y);
+		}
+		else if (!strcmp(name, "turn_neck")) {
+			self.mHasTurnNeck = true;
+			self.mCmdTurnNeck = strtod(p, 0);
+		}
+		else if (!strcmp(name, "change_view")) {
+			sscanf(p, "%31s", word);
+			self.mViewWidth = (word[0] == 'n' && word[1] == 'a') ? VW_Narrow : ((word[0] == 'w') ? VW_Wide : VW_Normal);
+			++self.mChangeViews;
+		}
+		else if (!strcmp(name, "say")) {
+			++self.mSays;
+		}
+		else if (!strcmp(name, "pointto")) {
+			++self.mPoints;
+		}
+		else if (!strcmp(name, "attentionto")) {
+			++self.mFocuses;
+		}
+
+		// 跳到本条命令结束，say的内容在引号中
+		while (*p && *p != ')') {
+			if (*p == '"') {
+				do {
+					++p;
+				} while (*p && *p != '"');
+				if (!*p) break;
+			}
+			++p;
+		}
+	}
+}
+
+bool Simulator::Match::CanKick(const MatchPlayer & player) const
+{
+	const char side = KickableSide(mServerPlayMode);
+	return side == '?' || side == player.mSide;
+}
+
+void Simulator::Match::FaceBall(MatchPlayer & player)
+{
+	const AngleDeg angle = GetNormalizeAngleDeg((mBall.mPos - player.mBody.mPos).Dir() - player.mBody.mBodyDir);
+	if (fabs(angle) > 20.0) {
+		player.mBodyCmd = CT_Turn;
+		player.mCmdAngle = GetTurnMoment(angle, player.mBody.mPlayerType, player.mBody.mVel.Mod());
+	}
+}
+
+void Simulator::Match::GoTo(MatchPlayer & player, const Vector & target, double buffer)
+{
+	const Vector to_target = target - player.mBody.mPos;
+	if (to_target.Mod() < buffer) {
+		FaceBall(player);
+		return;
+	}
+
+	const AngleDeg angle = GetNormalizeAngleDeg(to_target.Dir() - player.mBody.mBodyDir);
+	if (fabs(angle) > 15.0) {
+		player.mBodyCmd = CT_Turn;
+		player.mCmdAngle = GetTurnMoment(angle, player.mBody.mPlayerType, player.mBody.mVel.Mod());
+	}
+	else {
+		player.mBodyCmd = CT_Dash;
+		player.mCmdPower = (player.mBody.mStamina > ServerParam::instance().staminaMax() * 0.4) ? ServerParam::instance().maxDashPower() : 50.0;
+		player.mCmdAngle = 0.0;
+	}
+}
+
+void Simulator::Match::KickTo(MatchPlayer & player, const Vector & target, double speed)
+{
+	const Vector accel = Polar2Vector(speed, (target - mBall.mPos).Dir()) - mBall.mVel;
+	const double kick_rate = GetKickRate((mBall.mPos - player.mBody.mPos).Rotate(-player.mBody.mBodyDir), player.mBody.mPlayerType);
+
+	if (kick_rate <= 0.0) {
+		return;
+	}
+
+	player.mBodyCmd = CT_Kick;
+	player.mCmdPower = Min(accel.Mod() / kick_rate, ServerParam::instance().maxPower());
+	player.mCmdAngle = GetNormalizeAngleDeg(accel.Dir() - player.mBody.mBodyDir);
+}
+
+void Simulator::Match::ChooseKick(MatchPlayer & player)
+{
+	const double sign = (player.mSide == 'l') ? 1.0 : -1.0;
+	const int s = (player.mSide == 'l') ? 0 : 1;
+	const Vector goal(sign * ServerParam::instance().PITCH_LENGTH * 0.5, 0.0);
+	const Vector & pos = player.mBody.mPos;
+
+	if (pos.Dist(goal) < 25.0) {
+		KickTo(player, goal + Vector(0.0, drand(-6.0, 6.0)), ServerParam::instance().ballSpeedMax());
+		return;
+	}
+
+	// 向前传给附近没有对手的队友
+	const MatchPlayer *receiver = 0;
+	for (Unum i = 1; i <= TEAMSIZE; ++i) {
+		const MatchPlayer & mate = mPlayers[s][i];
+		const double dist = mate.mBody.mPos.Dist(pos);
+
+		if (&mate == &player || mate.mIsGoalie || dist < 5.0 || dist > 30.0 ||
+				(mate.mBody.mPos.X() - pos.X()) * sign < 3.0) {
+			continue;
+		}
+
+		bool free = true;
+		for (Unum j = 1; j <= TEAMSIZE && free; ++j) {
+			free = mPlayers[1 - s][j].mBody.mPos.Dist(mate.mBody.mPos) > 4.0;
+		}
+
+		if (free && (!receiver || (mate.mBody.mPos.X() - receiver->mBody.mPos.X()) * sign > 0.0)) {
+			receiver = &mate;
+		}
+	}
+
+	if (receiver && drand48() < 0.5) {
+		const double dist = receiver->mBody.mPos.Dist(mBall.mPos);
+		KickTo(player, receiver->mBody.mPos, Min(ServerParam::instance().ballSpeedMax(), (dist + 3.0) * (1.0 - ServerParam::instance().ballDecay())));
+	}
+	else {
+		KickTo(player, pos + Polar2Vector(6.0, (goal - pos).Dir() + drand(-20.0, 20.0)), 0.7);
+	}
+}
+
+void Simulator::Match::DecideSimulatedPlayer(MatchPlayer & player, const MatchPlayer *chaser)
+{
+	if (player.mTackleExpires > 0) {
+		return;
+	}
+
+	if (KickableSide(mServerPlayMode) == 0) {
+		FaceBall(player);
+		return;
+	}
+
+	const double sign = (player.mSide == 'l') ? 1.0 : -1.0;
+	const Vector & pos = player.mBody.mPos;
+	const Vector & ball = mBall.mPos;
+	const bool kickable = pos.Dist(ball) < PlayerParam::instance().HeteroPlayer(player.mBody.mPlayerType).kickableArea();
+
+	if (player.mIsGoalie) {
+		const Vector goal(-sign * ServerParam::instance().PITCH_LENGTH * 0.5, 0.0);
+
+		if (mpBallHolder == &player) {
+			if (mModeCycles >= GOALIE_HOLD_CYCLES) {
+				KickTo(player, Vector(sign * 10.0, drand(-25.0, 25.0)), ServerParam::instance().ballSpeedMax());
+			}
+			else {
+				FaceBall(player);
+			}
+			return;
+		}
+
+		const bool in_penalty_area = (ball.X() * sign < -ServerParam::instance().PITCH_LENGTH * 0.5 + ServerParam::instance().PENALTY_AREA_LENGTH) &&
+				fabs(ball.Y()) < ServerParam::instance().PENALTY_AREA_WIDTH * 0.5;
+
+		if (in_penalty_area && CanKick(player)) {
+			if (kickable) {
+				KickTo(player, Vector(sign * 10.0, ball.Y() > 0.0 ? 25.0 : -25.0), ServerParam::instance().ballSpeedMax());
+				return;
+			}
+			if (mServerPlayMode == SPM_PlayOn && pos.Dist(ball) < ServerParam::instance().catchAreaLength()) {
+				player.mBodyCmd = CT_Catch;
+				player.mCmdAngle = GetNormalizeAngleDeg((ball - pos).Dir() - player.mBody.mBodyDir);
+				return;
+			}
+			if (chaser == &player) {
+				GoTo(player, ball, 0.5);
+				return;
+			}
+		}
+
+		GoTo(player, goal + (ball - goal).SetLength(Min(3.0, ball.Dist(goal))), 1.0);
+		return;
+	}
+
+	if (chaser == &player && CanKick(player)) {
+		if (kickable) {
+			ChooseKick(player);
+		}
+		else {
+			const double decay = ServerParam::instance().ballDecay();
+			const double cycles = Min(pos.Dist(ball) / PlayerParam::instance().HeteroPlayer(player.mBody.mPlayerType).effectiveSpeedMax(), 20.0);
+			GoTo(player, ball + mBall.mVel * ((1.0 - pow(decay, cycles)) / (1.0 - decay)), 0.5);
+		}
+		return;
+	}
+
+	Vector target = player.mHomePos * sign + Vector(ball.X() * 0.5, ball.Y() * 0.2);
+	target = Vector(MinMax(-50.0, target.X(), 50.0), MinMax(-32.0, target.Y(), 32.0));
+
+	if (!CanKick(player) && target.Dist(ball) < ServerParam::instance().CENTER_CIRCLE_R + 1.0) {
+		target = ball + (target - ball).SetLength(ServerParam::instance().CENTER_CIRCLE_R + 1.0);
+	}
+
+	GoTo(player, target, 2.0);
+}
+
+void Simulator::Match::ExecuteBodyCommand(MatchPlayer & player)
+{
+	Player & body = player.mBody;
+
+	// 铲球后的若干周期内不能执行身体命令
+	const bool frozen = player.mTackleExpires > 0;
+	if (frozen) {
+		--player.mTackleExpires;
+	}
+
+	const Vector ball_2_player = (mBall.mPos - body.mPos).Rotate(-body.mBodyDir);
+
+	switch (frozen ? CT_None : player.mBodyCmd) {
+	case CT_Turn:
+		body.Turn(player.mCmdAngle);
+		break;
+	case CT_Dash: {
+		AngleDeg dir = GetNormalizeAngleDeg(player.mCmdAngle);
+		if (ServerParam::instance().dashAngleStep() > FLOAT_EPS) {
+			dir = ServerParam::instance().dashAngleStep() * Rint(dir / ServerParam::instance().dashAngleStep());
+		}
+		body.Dash(player.mCmdPower, NearestDashDirIdx(dir));
+		break;
+	}
+	case CT_Kick:
+		if (CanKick(player) && ball_2_player.Mod() < PlayerParam::instance().HeteroPlayer(body.mPlayerType).kickableArea()) {
+			const double power = GetNormalizeKickPower(player.mCmdPower);
+			Vector accel = Polar2Vector(power * GetKickRate(ball_2_player, body.mPlayerType), body.mBodyDir + GetNormalizeMoment(player.mCmdAngle));
+			if (accel.Mod() > ServerParam::instance().ballAccelMax()) {
+				accel = accel.SetLength(ServerParam::instance().ballAccelMax());
+			}
+			accel += Polar2Vector(drand(0.0, GetMaxKickRand(ball_2_player, mBall.mVel, body.mPlayerType, power)), drand(-180.0, 180.0));
+
+			mBall.mVel += accel;
+			if (mBall.mVel.Mod() > ServerParam::instance().ballSpeedMax()) {
+				mBall.mVel = mBall.mVel.SetLength(ServerParam::instance().ballSpeedMax());
+			}
+
+			mBallKicked = true;
+			mLastKickerSide = player.mSide;
+			mpBallHolder = 0;
+		}
+		body.Step();
+		break;
+	case CT_Tackle:
+		if (CanKick(player) && drand48() < GetTackleProb(ball_2_player, player.mCmdFoul)) {
+			const AngleDeg dir = GetNormalizeMoment(player.mCmdAngle);
+			const double power = ServerParam::instance().maxBackTacklePower() +
+					(ServerParam::instance().maxTacklePower() - ServerParam::instance().maxBackTacklePower()) * (1.0 - fabs(dir) / 180.0);
+
+			Vector accel = Polar2Vector(power * ServerParam::instance().tacklePowerRate(), body.mBodyDir + dir);
+			if (accel.Mod() > ServerParam::instance().ballAccelMax()) {
+				accel = accel.SetLength(ServerParam::instance().ballAccelMax());
+			}
+
+			mBall.mVel += accel;
+			if (mBall.mVel.Mod() > ServerParam::instance().ballSpeedMax()) {
+				mBall.mVel = mBall.mVel.SetLength(ServerParam::instance().ballSpeedMax());
+			}
+
+			mBallKicked = true;
+			mLastKickerSide = player.mSide;
+			mpBallHolder = 0;
+		}
+		player.mTackleExpires = ServerParam::instance().tackleCycles();
+		body.Step();
+		break;
+	case CT_Catch: {
+		const double sign = (player.mSide == 'l') ? 1.0 : -1.0;
+		const Vector ball_2_catcher = (mBall.mPos - body.mPos).Rotate(-(body.mBodyDir + GetNormalizeMoment(player.mCmdAngle)));
+		const bool in_penalty_area = (mBall.mPos.X() * sign < -ServerParam::instance().PITCH_LENGTH * 0.5 + ServerParam::instance().PENALTY_AREA_LENGTH) &&
+				fabs(mBall.mPos.Y()) < ServerParam::instance().PENALTY_AREA_WIDTH * 0.5;
+
+		if (player.mIsGoalie && mServerPlayMode == SPM_PlayOn && in_penalty_area &&
+				ball_2_catcher.X() >= 0.0 && ball_2_catcher.X() <= ServerParam::instance().catchAreaLength() &&
+				fabs(ball_2_catcher.Y()) <= ServerParam::instance().catchAreaWidth() * 0.5 &&
+				drand48() < ServerParam::instance().catchProb()) {
+			mBall.mVel = Vector(0.0, 0.0);
+			mLastKickerSide = player.mSide;
+			ChangePlayMode(player.mSide == 'l' ? SPM_GoalieCatchBall_Left : SPM_GoalieCatchBall_Right);
+			ChangePlayMode(player.mSide == 'l' ? SPM_FreeKick_Left : SPM_FreeKick_Right);
+			mpBallHolder = &player;
+		}
+		body.Step();
+		break;
+	}
+	case CT_Move:
+		if (KickableSide(mServerPlayMode) == 0 || mpBallHolder == &player) {
+			body.mPos = player.mCmdPos;
+			body.mVel = Vector(0.0, 0.0);
+		}
+		break;
+	default:
+		body.Step();
+		break;
+	}
+
+	if (player.mHasTurnNeck) {
+		player.mNeckDir = MinMax(ServerParam::instance().minNeckAngle(),
+				player.mNeckDir + GetNormalizeNeckMoment(player.mCmdTurnNeck),
+				ServerParam::instance().maxNeckAngle());
+	}
+
+	if (&player == &Self()) {
+		switch (frozen ? CT_None : player.mBodyCmd) {
+		case CT_Turn: ++player.mTurns; break;
+		case CT_Dash: ++player.mDashes; break;
+		case CT_Kick: ++player.mKicks; break;
+		case CT_Tackle: ++player.mTackles; break;
+		case CT_Catch: ++player.mCatches; break;
+		case CT_Move: ++player.mMoves; break;
+		default: break;
+		}
+		if (player.mHasTurnNeck) {
+			++player.mTurnNecks;
+		}
+	}
+}
+
+void Simulator::Match::CheckCollisions()
+{
+	MatchPlayer *players[2 * TEAMSIZE];
+	int num = 0;
+	for (int s = 0; s < 2; ++s) {
+		for (Unum i = 1; i <= TEAMSIZE; ++i) {
+			players[num] = &mPlayers[s][i];
+			players[num]->mCollideWithBall = false;
+			players[num]->mCollideWithPlayer = false;
+			++num;
+		}
+	}
+
+	for (int i = 0; i < num; ++i) {
+		Player & body = players[i]->mBody;
+		const double player_size = PlayerParam::instance().HeteroPlayer(body.mPlayerType).playerSize();
+
+		if (mServerPlayMode == SPM_PlayOn && mpBallHolder == 0) {
+			const Vector diff = mBall.mPos - body.mPos;
+			const double min_dist = player_size + ServerParam::instance().ballSize();
+			if (diff.Mod() < min_dist) {
+				mBall.mPos = body.mPos + diff.SetLength(min_dist);
+				mBall.mVel *= -0.1;
+				players[i]->mCollideWithBall = true;
+			}
+		}
+
+		for (int j = i + 1; j < num; ++j) {
+			Player & other = players[j]->mBody;
+			const Vector diff = other.mPos - body.mPos;
+			const double min_dist = player_size + PlayerParam::instance().HeteroPlayer(other.mPlayerType).playerSize();
+			const double dist = diff.Mod();
+
+			if (dist < min_dist) {
+				const Vector push = (dist > DIST_EPS ? diff : Vector(1.0, 0.0)).SetLength((min_dist - dist) * 0.5);
+				other.mPos += push;
+				body.mPos -= push;
+				other.mVel *= -0.1;
+				body.mVel *= -0.1;
+				players[i]->mCollideWithPlayer = true;
+				players[j]->mCollideWithPlayer = true;
+			}
+		}
+	}
+}
+
+void Simulator::Match::CheckBallOut()
+{
+	const double half_length = ServerParam::instance().PITCH_LENGTH * 0.5;
+	const double half_width = ServerParam::instance().PITCH_WIDTH * 0.5;
+	const Vector & ball = mBall.mPos;
+	const double y_sign = (ball.Y() > 0.0) ? 1.0 : -1.0;
+
+	if (fabs(ball.X()) > half_length + ServerParam::instance().ballSize()) {
+		const bool right_goal_line = ball.X() > 0.0;
+		const char defender = right_goal_line ? 'r' : 'l';
+		const double x_sign = right_goal_line ? 1.0 : -1.0;
+
+		if (fabs(ball.Y()) < ServerParam::instance().goalWidth() * 0.5) {
+			const int scorer = right_goal_line ? 0 : 1;
+			char name[32];
+
+			++mScore[scorer];
+			sprintf(name, "goal_%c_%d", right_goal_line ? 'l' : 'r', mScore[scorer]);
+
+			mBall.mVel = Vector(0.0, 0.0);
+			mKickOffSide = defender;
+			ChangePlayMode(right_goal_line ? SPM_AfterGoal_Left : SPM_AfterGoal_Right, name);
+		}
+		else if (mLastKickerSide == defender) {
+			const double margin = ServerParam::instance().cornerKickMargin();
+			mBall = Ball(Vector(x_sign * (half_length - margin), y_sign * (half_width - margin)), Vector(0.0, 0.0));
+			ChangePlayMode(right_goal_line ? SPM_CornerKick_Left : SPM_CornerKick_Right);
+		}
+		else {
+			mBall = Ball(Vector(x_sign * (half_length - ServerParam::instance().GOAL_AREA_LENGTH),
+					y_sign * ServerParam::instance().GOAL_AREA_WIDTH * 0.5), Vector(0.0, 0.0));
+			ChangePlayMode(right_goal_line ? SPM_GoalKick_Right : SPM_GoalKick_Left);
+		}
+	}
+	else if (fabs(ball.Y()) > half_width + ServerParam::instance().ballSize()) {
+		mBall = Ball(Vector(ball.X(), y_sign * half_width), Vector(0.0, 0.0));
+		ChangePlayMode(mLastKickerSide == 'l' ? SPM_KickIn_Right : SPM_KickIn_Left);
+	}
+}
+
+void Simulator::Match::Referee()
+{
+	++mModeCycles;
+
+	switch (mServerPlayMode) {
+	case SPM_BeforeKickOff:
+		if (mModeCycles >= BEFORE_KICK_OFF_WAIT) {
+			ChangePlayMode(mKickOffSide == 'l' ? SPM_KickOff_Left : SPM_KickOff_Right);
+		}
+		return; // before_kick_off时时间停止
+	case SPM_AfterGoal_Left:
+	case SPM_AfterGoal_Right:
+		if (mModeCycles >= AFTER_GOAL_WAIT) {
+			ResetForKickOff();
+			ChangePlayMode(SPM_BeforeKickOff);
+		}
+		break;
+	case SPM_PlayOn:
+		CheckBallOut();
+		break;
+	default: // 定位球
+		if (mBallKicked) {
+			ChangePlayMode(SPM_PlayOn);
+		}
+		else if (mModeCycles >= ServerParam::instance().dropTime()) {
+			ChangePlayMode(SPM_Drop_Ball);
+			ChangePlayMode(SPM_PlayOn);
+		}
+		break;
+	}
+
+	++mTime;
+
+	const int half_time = ServerParam::instance().halfTime();
+	if (mTime >= half_time * ServerParam::instance().nrNormalHalfs()) {
+		ChangePlayMode(SPM_TimeOver);
+	}
+	else if (half_time > 0 && mTime % half_time == 0) {
+		ChangePlayMode(SPM_HalfTime);
+
+		for (int s = 0; s < 2; ++s) {
+			for (Unum i = 1; i <= TEAMSIZE; ++i) {
+				mPlayers[s][i].mBody.RecoverAll();
+			}
+		}
+
+		mKickOffSide = ((mTime / half_time) % 2 == 0) ? 'l' : 'r';
+		ResetForKickOff();
+		ChangePlayMode(SPM_BeforeKickOff);
+	}
+}
+
+void Simulator::Match::Step()
+{
+	if (IsOver()) {
+		return;
+	}
+
+	// 每队离球最近的球员去抢球，被测球员也算在内
+	const MatchPlayer *chaser[2] = { 0, 0 };
+	for (int s = 0; s < 2; ++s) {
+		double min_dist = HUGE_VALUE;
+		for (Unum i = 1; i <= TEAMSIZE; ++i) {
+			const MatchPlayer & player = mPlayers[s][i];
+			const double dist = player.mBody.mPos.Dist(mBall.mPos);
+			if (player.mIsGoalie && &player != mpBallHolder && dist > ServerParam::instance().PENALTY_AREA_LENGTH) {
+				continue;
+			}
+			if (dist < min_dist) {
+				min_dist = dist;
+				chaser[s] = &player;
+			}
+		}
+	}
+
+	for (int s = 0; s < 2; ++s) {
+		for (Unum i = 1; i <= TEAMSIZE; ++i) {
+			MatchPlayer & player = mPlayers[s][i];
+			if (&player != &Self()) {
+				player.ClearCommands();
+				DecideSimulatedPlayer(player, chaser[s]);
+			}
+		}
+	}
+
+	mBallKicked = false;
+
+	// 先执行和球有关的命令，两队的先后顺序随机
+	const int first = (drand48() < 0.5) ? 0 : 1;
+	for (int k = 0; k < 2; ++k) {
+		for (Unum i = 1; i <= TEAMSIZE; ++i) {
+			MatchPlayer & player = mPlayers[(first + k) % 2][i];
+			if (player.mBodyCmd == CT_Kick || player.mBodyCmd == CT_Tackle || player.mBodyCmd == CT_Catch) {
+				ExecuteBodyCommand(player);
+			}
+		}
+	}
+	for (int s = 0; s < 2; ++s) {
+		for (Unum i = 1; i <= TEAMSIZE; ++i) {
+			MatchPlayer & player = mPlayers[s][i];
+			if (player.mBodyCmd != CT_Kick && player.mBodyCmd != CT_Tackle && player.mBodyCmd != CT_Catch) {
+				ExecuteBodyCommand(player);
+			}
+		}
+	}
+
+	if (mpBallHolder) {
+		mBall.mPos = mpBallHolder->mBody.mPos + Polar2Vector(
+				PlayerParam::instance().HeteroPlayer(mpBallHolder->mBody.mPlayerType).playerSize() + ServerParam::instance().ballSize(),
+				mpBallHolder->mBody.mBodyDir);
+		mBall.mVel = Vector(0.0, 0.0);
+	}
+	else {
+		mBall.RandomizedStep();
+	}
+
+	CheckCollisions();
+	Referee();
+
+	Self().ClearCommands();
+}
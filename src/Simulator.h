@@ -39,6 +39,7 @@
 #include "PlayerState.h"
 #include "ActionEffector.h"
 #include <vector>
+#include <string>
 
 struct AtomicAction;
 
@@ -72,6 +73,19 @@ public:
 			mPos += mVel;
 			mVel *= ServerParam::instance().ballDecay();
 		}
+
+		/**
+		 * 使用调用者自己的随机数序列（erand48），可以在多个线程中同时使用
+		 */
+		Vector noise(unsigned short seed[3]) {
+			return Polar2Vector( erand48(seed) * ServerParam::instance().ballRand() * mVel.Mod(), erand48(seed) * 360.0 - 180.0 );
+		}
+
+		void RandomizedStep(unsigned short seed[3]) {
+			mVel += noise(seed);
+			mPos += mVel;
+			mVel *= ServerParam::instance().ballDecay();
+		}
 	};
 
 	struct Player {
@@ -188,6 +202,132 @@ public:
 			}
 		}
 	};
+
+	/**
+	 * 离线比赛模拟器：在进程内推进球和22名球员，不需要rcssserver，以CPU允许的最快速度运行整场比赛。
+	 * 被测球员固定在左边，由WrightEagle决策；其余21名球员使用简单的内置策略。
+	 * 模拟器为被测球员生成server格式的sense_body/see/hear信息，交给Parser::Parse，
+	 * 并执行ActionEffector::SendCommands输出的命令。
+	 * Headless in-process match stepper. The agent under test always plays on the left side,
+	 * the other 21 players run built-in policies. Offside and fouls are not simulated.
+	 */
+	class Match {
+	public:
+		Match(const Unum & self_unum);
+
+		/**
+		 * 生成初始化信息，如 (init l 10 before_kick_off)
+		 */
+		void GetInitMsg(char *msg) const;
+
+		/**
+		 * 生成本周期的sense_body信息
+		 */
+		void GetSenseMsg(char *msg) const;
+
+		/**
+		 * 生成本周期的裁判信息，没有新的信息时返回false，可以多次调用直到返回false
+		 */
+		bool GetHearMsg(char *msg);
+
+		/**
+		 * 按照视角宽度决定的视觉周期生成see信息，本周期没有视觉时返回false
+		 */
+		bool GetSightMsg(char *msg);
+
+		/**
+		 * 解析被测球员本周期发出的命令串，Step时执行
+		 */
+		void ExecuteCommands(const char *msg);
+
+		/**
+		 * 推进一个周期：内置球员决策、执行动作、运动模型、碰撞和裁判
+		 */
+		void Step();
+
+		bool IsOver() const { return mServerPlayMode == SPM_TimeOver; }
+		int CurrentTime() const { return mTime; }
+		int OurScore() const { return mScore[0]; }
+		int OppScore() const { return mScore[1]; }
+
+	private:
+		struct MatchPlayer {
+			Player mBody;
+
+			char mSide;
+			Unum mUnum;
+			bool mIsGoalie;
+			Vector mHomePos; // 阵型位置，以左边为正方向
+
+			AngleDeg mNeckDir; // 相对于身体
+			ViewWidth mViewWidth;
+			int mTackleExpires;
+			bool mCollideWithBall;
+			bool mCollideWithPlayer;
+
+			/** 本周期待执行的命令 */
+			CommandType mBodyCmd;
+			double mCmdPower;
+			AngleDeg mCmdAngle;
+			Vector mCmdPos;
+			bool mCmdFoul;
+			AngleDeg mCmdTurnNeck;
+			bool mHasTurnNeck;
+
+			/** server执行命令的计数，只对被测球员有意义 */
+			int mKicks, mDashes, mTurns, mSays, mTurnNecks, mCatches, mMoves, mChangeViews, mTackles, mPoints, mFocuses;
+
+			MatchPlayer();
+
+			AngleDeg NeckGlobalDir() const { return GetNormalizeAngleDeg(mBody.mBodyDir + mNeckDir); }
+			void ClearCommands() { mBodyCmd = CT_None; mHasTurnNeck = false; mCmdFoul = false; }
+		};
+
+		MatchPlayer & Self() { return mPlayers[0][mSelfUnum]; }
+		const MatchPlayer & Self() const { return mPlayers[0][mSelfUnum]; }
+
+		void InitializeMarkers();
+		void ResetForKickOff();
+		void ChangePlayMode(ServerPlayMode spm, const char *name = 0);
+
+		void DecideSimulatedPlayer(MatchPlayer & player, const MatchPlayer * chaser);
+		void GoTo(MatchPlayer & player, const Vector & target, double buffer);
+		void FaceBall(MatchPlayer & player);
+		void ChooseKick(MatchPlayer & player);
+		void KickTo(MatchPlayer & player, const Vector & target, double speed);
+		bool CanKick(const MatchPlayer & player) const;
+
+		void ExecuteBodyCommand(MatchPlayer & player);
+		void CheckCollisions();
+		void CheckBallOut();
+		void Referee();
+
+		char * AppendObject(char *msg, const char *name, const Vector & pos, const double & quantize_step, const Vector *vel = 0, const MatchPlayer *player = 0) const;
+
+	private:
+		Unum mSelfUnum;
+
+		Ball mBall;
+		MatchPlayer mPlayers[2][TEAMSIZE + 1]; // [0]为左边（被测球员所在的队），[1]为右边
+		MatchPlayer *mpBallHolder; // 守门员扑住球后持球
+
+		int mTime;
+		ServerPlayMode mServerPlayMode;
+		int mModeCycles;
+		char mLastKickerSide;
+		bool mBallKicked;
+		int mScore[2];
+		char mKickOffSide;
+
+		int mLastSightTime;
+		std::vector<std::string> mRefereeMsgs;
+
+		struct Marker {
+			std::string mName;
+			Vector mPos;
+		};
+		std::vector<Marker> mMarkers;
+	};
 };
 
 #endif /* SIMULATOR_H_ */
@@ -37,7 +37,8 @@
 #ifdef WIN32
 
 #include <windows.h>
-ThreadCondition::ThreadCondition()
+ThreadCondition::ThreadCondition():
+	mSetCount(0)
 {
 	mEvent = CreateEvent(0, false, false, 0);
 }
@@ -60,9 +61,34 @@ bool ThreadCondition::Wait(int ms)
 
 void ThreadCondition::Set()
 {
+	InterlockedIncrement(&mSetCount);
 	SetEvent(mEvent);
 }
 
+int ThreadCondition::SetCount()
+{
+	return InterlockedCompareExchange(&mSetCount, 0, 0);
+}
+
+/**
+ * 不重置事件，SetCount()之后的Set()会使等待立即返回
+ */
+bool ThreadCondition::WaitSet(int count, int ms)
+{
+	if (ms == 0)
+	{
+		ms = INFINITE;
+	}
+
+	if (SetCount() != count)
+	{
+		return false;
+	}
+
+	DWORD ret = WaitForSingleObject(mEvent, ms);
+	return (ret == WAIT_TIMEOUT);
+}
+
 ThreadMutex::ThreadMutex()
 {
 	mEvent = CreateMutex(0, false, 0);
@@ -84,7 +110,8 @@ void ThreadMutex::UnLock()
 
 #else
 
-ThreadCondition::ThreadCondition()
+ThreadCondition::ThreadCondition():
+	mSetCount(0)
 {
 	pthread_mutex_init(&mMutex, 0);
 	pthread_cond_init(&mCond, 0);
@@ -130,6 +157,7 @@ void ThreadCondition::Set()
 	while(pthread_mutex_lock(&mMutex))
 	{
 	}
+	mSetCount++;
 	while(pthread_cond_signal(&mCond))
 	{
 	}
@@ -138,6 +166,52 @@ void ThreadCondition::Set()
 	}
 }
 
+int ThreadCondition::SetCount()
+{
+	while (pthread_mutex_lock(&mMutex))
+	{
+	}
+	int count = mSetCount;
+	while (pthread_mutex_unlock(&mMutex))
+	{
+	}
+	return count;
+}
+
+bool ThreadCondition::WaitSet(int count, int ms)
+{
+	while (pthread_mutex_lock(&mMutex))
+	{
+	}
+
+	timespec timeout;
+	if (ms > 0)
+	{
+		RealTime outtime = GetRealTime();
+		outtime = outtime + ms;
+		timeout.tv_sec = outtime.GetSec();
+		timeout.tv_nsec = outtime.GetUsec() * 1000;
+	}
+
+	int ret = 0;
+	while (mSetCount == count && ret != ETIMEDOUT)
+	{
+		if (ms > 0)
+		{
+			ret = pthread_cond_timedwait(&mCond, &mMutex, &timeout);
+		}
+		else
+		{
+			ret = pthread_cond_wait(&mCond, &mMutex);
+		}
+	}
+
+	while (pthread_mutex_unlock(&mMutex))
+	{
+	}
+	return (ret == ETIMEDOUT);
+}
+
 ThreadMutex::ThreadMutex()
 {
 	pthread_mutex_init (&mMutex,0);
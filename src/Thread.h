@@ -42,6 +42,33 @@ inline void WaitFor(int ms)
     Sleep(ms);
 }
 
+/**
+ * 原子加，返回加之前的值
+ */
+inline int AtomicAdd(volatile int *value, int delta)
+{
+	return InterlockedExchangeAdd((volatile LONG *)value, delta);
+}
+
+inline std::size_t AtomicAdd(volatile std::size_t *value, std::size_t delta)
+{
+#ifdef _WIN64
+	return InterlockedExchangeAdd64((volatile LONGLONG *)value, delta);
+#else
+	return InterlockedExchangeAdd((volatile LONG *)value, delta);
+#endif
+}
+
+/**
+ * 内存屏障，之前的读写对其他线程可见之后才执行之后的读写
+ */
+inline void MemoryFence()
+{
+	MemoryBarrier();
+}
+
+#define THREAD_LOCAL __declspec(thread)
+
 class ThreadCondition
 {
 public:
@@ -57,8 +84,16 @@ public:
     bool Wait(int ms);
     void Set();
 
+    /**
+     * 等待某个条件时，先取Set()的次数再检查条件，条件不满足再用WaitSet()等待；
+     * 检查条件之后发生的Set()不会丢失
+     */
+    int SetCount();
+    bool WaitSet(int count, int ms);
+
 private:
     HANDLE mEvent;
+    volatile LONG mSetCount;
 };
 
 class ThreadMutex
@@ -93,6 +128,29 @@ inline void WaitFor(int ms)
 	usleep(ms * 1000);
 }
 
+/**
+ * 原子加，返回加之前的值
+ */
+inline int AtomicAdd(volatile int *value, int delta)
+{
+	return __sync_fetch_and_add(value, delta);
+}
+
+inline std::size_t AtomicAdd(volatile std::size_t *value, std::size_t delta)
+{
+	return __sync_fetch_and_add(value, delta);
+}
+
+/**
+ * 内存屏障，之前的读写对其他线程可见之后才执行之后的读写
+ */
+inline void MemoryFence()
+{
+	__sync_synchronize();
+}
+
+#define THREAD_LOCAL __thread
+
 class ThreadCondition
 {
 public:
@@ -108,9 +166,17 @@ public:
     bool Wait(int ms);
     void Set();
 
+    /**
+     * 等待某个条件时，先取Set()的次数再检查条件，条件不满足再用WaitSet()等待；
+     * 检查条件之后发生的Set()不会丢失
+     */
+    int SetCount();
+    bool WaitSet(int count, int ms);
+
 private:
     pthread_cond_t mCond;
     pthread_mutex_t mMutex;
+    int mSetCount;
 };
 
 class ThreadMutex
@@ -0,0 +1,170 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+
+#include "ThreadPool.h"
+#include "Tracer.h"
+
+class ThreadPool::Worker: public Thread
+{
+public:
+	Worker(ThreadPool & pool, int queue): mPool(pool), mQueue(queue) {}
+	virtual ~Worker() {}
+
+private:
+	void StartRoutine() { mPool.WorkerRoutine(mQueue); }
+
+	ThreadPool & mPool;
+	int mQueue;
+};
+
+ThreadPool::ThreadPool():
+	mNextQueue(0),
+	mPendingCount(0),
+	mIsStopping(false)
+{
+	mQueues.push_back(new TaskQueue); // 调用Wait()的线程使用0号队列
+}
+
+ThreadPool::~ThreadPool()
+{
+	mIsStopping = true;
+
+	for (uint i = 0; i < mWorkers.size(); ++i) {
+		mCondNewTask.Set();
+	}
+	for (uint i = 0; i < mWorkers.size(); ++i) {
+		mWorkers[i]->Join();
+		delete mWorkers[i];
+	}
+	for (uint i = 0; i < mQueues.size(); ++i) {
+		delete mQueues[i];
+	}
+}
+
+ThreadPool & ThreadPool::instance()
+{
+	static ThreadPool thread_pool;
+	return thread_pool;
+}
+
+void ThreadPool::Start(int thread_count)
+{
+	if (!mWorkers.empty() || thread_count <= 0) return;
+
+	/** 队列要在工作线程启动前全部建好，之后mQueues不再改变 */
+	for (int i = 0; i < thread_count; ++i) {
+		mQueues.push_back(new TaskQueue);
+	}
+	for (int i = 0; i < thread_count; ++i) {
+		mWorkers.push_back(new Worker(*this, i + 1));
+		mWorkers.back()->Start();
+	}
+}
+
+/**
+ * 只由一个线程（决策线程）提交任务，所以mNextQueue不需要同步
+ */
+void ThreadPool::Submit(ThreadTask *task)
+{
+	AtomicAdd(&mPendingCount, 1);
+
+	TaskQueue *queue = mQueues[mNextQueue];
+	mNextQueue = (mNextQueue + 1) % mQueues.size();
+
+	queue->mMutex.Lock();
+	queue->mTasks.push_back(task);
+	queue->mMutex.UnLock();
+
+	if (IsRunning()) {
+		mCondNewTask.Set();
+	}
+}
+
+/**
+ * 只有决策线程提交任务，队列都空了之后不会再有新任务，剩下的都在工作线程中执行，
+ * 阻塞等待最后一个任务完成时的通知，不占用其他进程需要的CPU
+ */
+void ThreadPool::Wait()
+{
+	while (RunTask(0)) {
+	}
+
+	for (;;) {
+		const int count = mCondTaskDone.SetCount();
+		if (AtomicAdd(&mPendingCount, 0) == 0) break;
+		mCondTaskDone.WaitSet(count, 0);
+	}
+	mNextQueue = 0;
+}
+
+bool ThreadPool::RunTask(int queue)
+{
+	ThreadTask *task = 0;
+
+	for (uint i = 0; i < mQueues.size() && task == 0; ++i) {
+		TaskQueue *q = mQueues[(queue + i) % mQueues.size()];
+
+		q->mMutex.Lock();
+		if (!q->mTasks.empty()) {
+			if (i == 0) {
+				task = q->mTasks.front();
+				q->mTasks.pop_front();
+			}
+			else {
+				task = q->mTasks.back();
+				q->mTasks.pop_back();
+			}
+		}
+		q->mMutex.UnLock();
+	}
+
+	if (task == 0) return false;
+
+	task->Run();
+	if (AtomicAdd(&mPendingCount, -1) == 1) { // 带内存屏障，Wait()返回后任务的结果对调用线程可见
+		mCondTaskDone.Set();
+	}
+	return true;
+}
+
+void ThreadPool::WorkerRoutine(int queue)
+{
+	Tracer::instance().SetThreadName("Worker");
+
+	while (!mIsStopping) {
+		const int count = mCondNewTask.SetCount();
+		if (!RunTask(queue) && !mIsStopping) {
+			mCondNewTask.WaitSet(count, 0); // 取任务之后提交的任务会使等待立即返回
+		}
+	}
+}
@@ -0,0 +1,116 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+
+#ifndef __ThreadPool_H__
+#define __ThreadPool_H__
+
+#include "Thread.h"
+#include <deque>
+#include <vector>
+
+/**
+ * 线程池中执行的任务，由提交者负责创建和销毁
+ * A task run by ThreadPool, owned by whoever submits it.
+ */
+class ThreadTask
+{
+public:
+	virtual ~ThreadTask() {}
+
+	virtual void Run() = 0;
+};
+
+/**
+ * 进程内的工作窃取线程池。每个线程有自己的任务队列，自己的队列空了就从别的队列尾部窃取；
+ * 调用Wait()的线程也参与执行任务，因此即使工作线程没有被及时唤醒也不会阻塞。
+ * Per-process work-stealing thread pool. The thread calling Wait() runs tasks too.
+ */
+class ThreadPool
+{
+	ThreadPool();
+
+public:
+	~ThreadPool();
+
+	static ThreadPool & instance();
+
+	/**
+	 * 启动工作线程，只在第一次调用时有效
+	 * @param thread_count 工作线程数，不包括调用Wait()的线程
+	 */
+	void Start(int thread_count);
+
+	/** 是否有工作线程可用，没有时Submit的任务全部在Wait()中顺序执行 */
+	bool IsRunning() const { return !mWorkers.empty(); }
+
+	/**
+	 * 提交一个任务，任务按提交顺序轮流分配到各个队列
+	 */
+	void Submit(ThreadTask *task);
+
+	/**
+	 * 参与执行任务，直到之前提交的任务全部完成
+	 */
+	void Wait();
+
+private:
+	class Worker;
+	friend class Worker;
+
+	struct TaskQueue
+	{
+		ThreadMutex mMutex;
+		std::deque<ThreadTask*> mTasks;
+	};
+
+	/**
+	 * 先从自己的队列头部取任务，再依次从其他队列尾部窃取，取到则执行
+	 * @param queue 自己的队列下标，0为调用Wait()的线程
+	 * @return 是否执行了任务
+	 */
+	bool RunTask(int queue);
+
+	void WorkerRoutine(int queue);
+
+private:
+	std::vector<TaskQueue*> mQueues;
+	std::vector<Worker*> mWorkers;
+
+	ThreadCondition mCondNewTask;
+	ThreadCondition mCondTaskDone; // mPendingCount减到0时通知Wait()
+	int mNextQueue;
+	volatile int mPendingCount; // 已提交未完成的任务数
+	volatile bool mIsStopping;
+};
+
+#endif
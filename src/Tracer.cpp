@@ -0,0 +1,195 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+#include "Tracer.h"
+#include "PlayerParam.h"
+#include "Utilities.h"
+#include <cstdio>
+
+namespace {
+
+const unsigned long TRACE_BUFFER_SIZE = 1 << 17; // 每个线程最多保留的记录数，必须是2的幂
+
+const char *SPAN_NAME[TS_Max] = {
+		"Parse",
+		"Run",
+		"WorldUpdate",
+		"Decision",
+		"AttackPlanner",
+		"InterceptPlanner",
+		"ShootPlanner",
+		"PassPlanner",
+		"DribblePlanner",
+		"PositionPlanner",
+		"HoldPlanner",
+		"DefensePlanner",
+		"BlockPlanner",
+		"MarkPlanner",
+		"FormationPlanner",
+		"SetplayPlanner",
+		"GoaliePlanner",
+		"PenaltyPlanner",
+		"Rollout",
+		"VisualDecision",
+		"CommunicateDecision",
+		"CommandSend"
+};
+
+}
+
+bool Tracer::mIsEnabled = false;
+
+/**
+ * 每个线程自己的缓冲区，第一次记录时注册
+ */
+static THREAD_LOCAL void *tls_trace_buffer = 0;
+
+Tracer::Tracer():
+	mCycle(0),
+	mUnum(0)
+{
+	mIsEnabled = PlayerParam::instance().Trace();
+}
+
+Tracer::~Tracer()
+{
+	if (mIsEnabled && !mBuffers.empty()) {
+		char file_name[256];
+		sprintf(file_name, "%s/%s-%d-trace.json", PlayerParam::instance().logDir().c_str(), PlayerParam::instance().teamName().c_str(), mUnum);
+		Export(file_name);
+	}
+
+	mIsEnabled = false; // 其他线程可能还在运行，之后不再记录，缓冲区也不释放
+}
+
+Tracer & Tracer::instance()
+{
+	static Tracer tracer;
+	return tracer;
+}
+
+long long Tracer::Now()
+{
+	timeval time_val = GetRealTime();
+	return (long long)time_val.tv_sec * 1000000 + time_val.tv_usec;
+}
+
+Tracer::TraceBuffer *Tracer::GetBuffer()
+{
+	if (tls_trace_buffer == 0) {
+		TraceBuffer *buffer = new TraceBuffer;
+		buffer->mEvents = new TraceEvent[TRACE_BUFFER_SIZE];
+		buffer->mHead = 0;
+
+		mBufferMutex.Lock();
+		buffer->mThreadId = mBuffers.size() + 1;
+		buffer->mName = "Thread";
+		mBuffers.push_back(buffer);
+		mBufferMutex.UnLock();
+
+		tls_trace_buffer = buffer;
+	}
+	return static_cast<TraceBuffer*>(tls_trace_buffer);
+}
+
+void Tracer::Record(TraceSpan span, long long begin, long long end)
+{
+	TraceBuffer *buffer = GetBuffer();
+	const unsigned long head = buffer->mHead;
+
+	TraceEvent & event = buffer->mEvents[head & (TRACE_BUFFER_SIZE - 1)];
+	event.mBegin = begin;
+	event.mDuration = end - begin;
+	event.mSpan = span;
+	event.mCycle = mCycle;
+
+	MemoryFence(); // 记录写完之后导出线程才能看到
+	buffer->mHead = head + 1;
+}
+
+void Tracer::SetThreadName(const char *name)
+{
+	if (!mIsEnabled) return;
+
+	TraceBuffer *buffer = GetBuffer();
+	mBufferMutex.Lock();
+	buffer->mName = name;
+	mBufferMutex.UnLock();
+}
+
+/**
+ * 导出时所属线程可能还在写：先读mHead再复制，复制完再读一次mHead，
+ * 期间可能被覆盖的记录丢弃，包括第二次读到的mHead所指的、可能正在写的那一条
+ */
+bool Tracer::Export(const char *file_name)
+{
+	FILE *file = fopen(file_name, "w");
+	if (file == 0) {
+		PRINT_ERROR("open file error " << file_name);
+		return false;
+	}
+
+	mBufferMutex.Lock();
+	std::vector<TraceBuffer*> buffers = mBuffers;
+	std::vector<std::string> names;
+	for (unsigned i = 0; i < buffers.size(); ++i) {
+		names.push_back(buffers[i]->mName);
+	}
+	mBufferMutex.UnLock();
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s %d\"}}", mUnum, PlayerParam::instance().teamName().c_str(), mUnum);
+
+	std::vector<TraceEvent> events;
+	for (unsigned i = 0; i < buffers.size(); ++i) {
+		const TraceBuffer & buffer = *buffers[i];
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", mUnum, buffer.mThreadId, names[i].c_str());
+
+		const unsigned long head = buffer.mHead;
+		MemoryFence();
+		const unsigned long begin = head > TRACE_BUFFER_SIZE? head - TRACE_BUFFER_SIZE: 0;
+		events.assign(buffer.mEvents, buffer.mEvents + TRACE_BUFFER_SIZE);
+		MemoryFence();
+		const unsigned long new_head = buffer.mHead;
+		const unsigned long valid = new_head + 1 > TRACE_BUFFER_SIZE? Max(begin, new_head + 1 - TRACE_BUFFER_SIZE): begin;
+
+		for (unsigned long k = valid; k < head; ++k) {
+			const TraceEvent & event = events[k & (TRACE_BUFFER_SIZE - 1)];
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"WE\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%d,\"pid\":%d,\"tid\":%d,\"args\":{\"cycle\":%d}}",
+					SPAN_NAME[event.mSpan], event.mBegin, event.mDuration, mUnum, buffer.mThreadId, event.mCycle);
+		}
+	}
+
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(file);
+	return true;
+}
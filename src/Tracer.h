@@ -0,0 +1,168 @@
+/************************************************************************************
+ * WrightEagle (Soccer Simulation League 2D)                                        *
+ * BASE SOURCE CODE RELEASE 2016                                                    *
+ * Copyright (c) 1998-2016 WrightEagle 2D Soccer Simulation Team,                   *
+ *                         Multi-Agent Systems Lab.,                                *
+ *                         School of Computer Science and Technology,               *
+ *                         University of Science and Technology of China            *
+ * All rights reserved.                                                             *
+ *                                                                                  *
+ * Redistribution and use in source and binary forms, with or without               *
+ * modification, are permitted provided that the following conditions are met:      *
+ *     * Redistributions of source code must retain the above copyright             *
+ *       notice, this list of conditions and the following disclaimer.              *
+ *     * Redistributions in binary form must reproduce the above copyright          *
+ *       notice, this list of conditions and the following disclaimer in the        *
+ *       documentation and/or other materials provided with the distribution.       *
+ *     * Neither the name of the WrightEagle 2D Soccer Simulation Team nor the      *
+ *       names of its contributors may be used to endorse or promote products       *
+ *       derived from this software without specific prior written permission.      *
+ *                                                                                  *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND  *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED    *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE           *
+ * DISCLAIMED. IN NO EVENT SHALL WrightEagle 2D Soccer Simulation Team BE LIABLE    *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL       *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR       *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER       *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,    *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                *
+ ************************************************************************************/
+
+#ifndef __Tracer_H__
+#define __Tracer_H__
+
+#include "Thread.h"
+#include <string>
+#include <vector>
+
+/**
+ * 记录一段代码的耗时，离开作用域时写入本线程的缓冲区；tracing关闭时只有一次判断的开销
+ * Record the scope as a trace span.
+ */
+#define TRACE_SPAN(span) TraceScope trace_scope(span);
+
+/**
+ * 所有可以记录的代码段，名字在Tracer.cpp中，与这里的顺序一致
+ */
+enum TraceSpan
+{
+	TS_Parse,
+	TS_Run,
+	TS_WorldUpdate,
+	TS_Decision,
+	TS_AttackPlanner,
+	TS_InterceptPlanner,
+	TS_ShootPlanner,
+	TS_PassPlanner,
+	TS_DribblePlanner,
+	TS_PositionPlanner,
+	TS_HoldPlanner,
+	TS_DefensePlanner,
+	TS_BlockPlanner,
+	TS_MarkPlanner,
+	TS_FormationPlanner,
+	TS_SetplayPlanner,
+	TS_GoaliePlanner,
+	TS_PenaltyPlanner,
+	TS_Rollout,
+	TS_VisualDecision,
+	TS_CommunicateDecision,
+	TS_CommandSend,
+
+	TS_Max
+};
+
+/**
+ * 低开销的逐周期耗时记录。每个线程有自己的环形缓冲区，只由这个线程写入，不需要加锁；
+ * 缓冲区满了之后覆盖最早的记录。程序退出时（或调用Export时）导出为Chrome trace-event格式的json文件，
+ * 可以用chrome://tracing或Perfetto打开，每个代码段带有所在的周期。
+ * Per-thread lock-free span recorder with a Chrome trace-event exporter.
+ */
+class Tracer
+{
+	Tracer();
+
+public:
+	~Tracer();
+
+	static Tracer & instance();
+
+	static bool IsEnabled() { return mIsEnabled; }
+
+	/**
+	 * 当前时间（微秒）
+	 */
+	static long long Now();
+
+	/**
+	 * 记录一段代码，只能由执行这段代码的线程调用
+	 */
+	void Record(TraceSpan span, long long begin, long long end);
+
+	/**
+	 * 设置当前线程在导出文件中的名字
+	 */
+	void SetThreadName(const char *name);
+
+	/** 新的周期开始时调用，之后的记录都属于这个周期 */
+	void SetCycle(int cycle) { mCycle = cycle; }
+
+	/** 设置自己的号码，用于文件名的赋值 */
+	void SetUnum(int unum) { mUnum = unum; }
+
+	/**
+	 * 导出目前记录的所有代码段，可以在其他线程仍在记录时调用
+	 */
+	bool Export(const char *file_name);
+
+private:
+	struct TraceEvent
+	{
+		long long mBegin;
+		int mDuration;
+		short mSpan;
+		int mCycle;
+	};
+
+	struct TraceBuffer
+	{
+		int mThreadId;
+		std::string mName;
+		TraceEvent *mEvents;
+		volatile unsigned long mHead; // 已写入的记录总数，只由所属线程增加
+	};
+
+	TraceBuffer *GetBuffer();
+
+private:
+	static bool mIsEnabled;
+
+	ThreadMutex mBufferMutex; // 只在线程第一次记录时注册缓冲区用
+	std::vector<TraceBuffer*> mBuffers;
+
+	volatile int mCycle;
+	int mUnum;
+};
+
+/**
+ * TRACE_SPAN使用的作用域对象
+ */
+class TraceScope
+{
+public:
+	explicit TraceScope(TraceSpan span): mSpan(span), mBegin(Tracer::IsEnabled()? Tracer::Now(): -1) {}
+
+	~TraceScope() {
+		if (mBegin >= 0) {
+			Tracer::instance().Record(mSpan, mBegin, Tracer::Now());
+		}
+	}
+
+private:
+	TraceSpan mSpan;
+	long long mBegin;
+};
+
+#endif
@@ -42,12 +42,22 @@
 #include "Logger.h"
 #include "PlayerParam.h"
 #include "Utilities.h"
+#include "RcgReader.h"
 
 
 #include <iostream>
+#include <algorithm>
+
+#ifndef WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 using namespace std;
 
+int Trainer::mBatchIndex = 0;
+int Trainer::mBatchPipe = -1;
+
 Trainer::PlayerState::PlayerState(Unum num, Vector pos, Vector vel, AngleDeg dir, int type)
 {
 	mUnum = num;
@@ -64,8 +74,9 @@ Trainer::Trainer()
 	mInitialized = false;
 	mConverse = false;
 	mPrepared = false;
+	mFinished = false;
 	mHaveRcg = 0;
-	mpEndCondition = new Trainer::Condition(this, ET_Null, 0, 0, 0x0, mConverse);
+	mpEndCondition = new Trainer::Condition(ET_Null, 0, 0, 0x0, mConverse);
 	mLastStopTime = 0;
 	mpObserver->SetSelfUnum( TRAINER_UNUM );
 	mInitialTime = 0;
@@ -89,14 +100,14 @@ void Trainer::SendOptionToServer()
 	while (!mpParser->IsEyeOnOk())
 	{
 		UDPSocket::instance().Send("(eye on)");
-		WaitFor(200);
+		WaitForServer(200, false);
 	}
 
 	while (!mpParser->IsEarOnOk())
 	{
 		cout << "Send (ear on)" << endl;
 		UDPSocket::instance().Send("(ear on)");
-		WaitFor(200);
+		WaitForServer(200, false);
 	}
 }
 
@@ -155,16 +166,27 @@ void Trainer::DoDecisionMaking()
 		mpAgent->World().GetTeammateScore() < mpAgent->World().GetOpponentScore()? Score(true) : Score(false);
 	}
 	else if(CheckOpponent()){
+		if(mFinished)
+		{
+			return;
+		}
 		if(!mInitialized)
 		{
 			InitializeStadium();
 		}
-		if(mpEndCondition->CheckState(mpAgent->World()) || mpAgent->World().GetPlayMode() == PM_Before_Kick_Off)
+		if(CheckEndCondition(mpAgent->World()) || mpAgent->World().GetPlayMode() == PM_Before_Kick_Off)
 		{
 			mPrepared = false;
 		}
 		if(!mPrepared && mInitialized)
 		{
+			if(PlayerParam::instance().TrainEpisodes() > 0 && mTrainCount >= (unsigned int)PlayerParam::instance().TrainEpisodes())
+			{
+				std::cerr << "#" << PlayerParam::instance().teamName() << " Trainer: " << mTrainCount << " episodes finished @ " << mpAgent->World().CurrentTime() << std::endl;
+				ChangePlayMode(PM_Time_Over); //结束比赛，球员和训练进程随之退出
+				mFinished = true;
+				return;
+			}
 			PrepareForTrain();
 		}
 	}
@@ -361,136 +383,138 @@ void Trainer::ChangePlayerType(Unum num, int player_type)
 	}
 }
 
-bool Trainer::Condition::CheckState(const WorldState & state)
+bool Trainer::CheckEndCondition(const WorldState & state)
 {
-	//检测当前状态的条件
+	//顺序执行编译后的终止条件，result为累加器
 	bool result = false;
-	switch (mType){
-	case ET_ANDComplex:
-		if(!mSubCondition.empty())
-		{
-			for(std::vector<Trainer::Condition>::iterator it = mSubCondition.begin();
-					it != mSubCondition.end(); it++)
+	const int time = state.CurrentTime().T();
+	const int intervalCycle = time - mLastStopTime;
+	const Vector & ball = state.GetBall().GetPos();
+
+	unsigned int pc = 0;
+	while(pc < mEndProgram.size())
+	{
+		const Trainer::ConditionInstruction & ins = mEndProgram[pc++];
+
+		switch (ins.mOpCode){
+		case ConditionInstruction::OP_False:
+			result = false;
+			continue;
+		case ConditionInstruction::OP_JumpIfTrue:
+			if(result) pc = ins.mTarget;
+			continue;
+		case ConditionInstruction::OP_JumpIfFalse:
+			if(!result) pc = ins.mTarget;
+			continue;
+		case ConditionInstruction::OP_Check:
+			break;
+		}
+
+		const double ball_x = ins.mConverse ? -ball.X() : ball.X(); //对调训练时场景是对称过去的
+		const double ball_y = ins.mConverse ? -ball.Y() : ball.Y();
+
+		result = false;
+		switch (ins.mType){
+		case ET_Time://过x个周期自然终止
+			if(intervalCycle >= ins.mArg1)
 			{
-				if(!it->CheckState(state))
-				{
-					return false;//有一个不满足就不满足
+				std::cout << "Trigger time longer than " << ins.mArg1 << std::endl;
+				result = true;
+			}
+			break;
+		case ET_BallXbt://球的x坐标大于某值停止
+			if(ball_x > ins.mArg1)
+			{
+				std::cout << "Trigger Ball's X larger than " << ins.mArg1 << std::endl;
+				result = true;
+			}
+			break;
+		case ET_BallXlt://球的x坐标小于某值停止
+			if(ball_x < ins.mArg1)
+			{
+				std::cout << "Trigger Ball's X less than " << ins.mArg1 << std::endl;
+				result = true;
+			}
+			break;
+		case ET_BallYbt://球的y坐标。。
+			if(ball_y > ins.mArg1)
+			{
+				std::cout << "Trigger Ball's Y larger than " << ins.mArg1 << std::endl;
+				result = true;
+			}
+			break;
+		case ET_BallYlt://。。
+			if(ball_y < ins.mArg1)
+			{
+				std::cout << "Trigger Ball's Y less than " << ins.mArg1 << std::endl;
+				result = true;
+			}
+			break;
+		case ET_Ball2Playerbt://球到某人的距离大于某值
+			if(!ins.mArg2)
+			{
+				for(int i = 1; i <= TEAMSIZE; i++){
+					if(state.GetOpponent(i).IsAlive())
+						if(state.GetOpponent(i).GetPos().Dist(ball) > ins.mArg1)
+						{
+							std::cout << "Trigger Ball to #" << i << "Player's distance longer than " << ins.mArg1 << std::endl;
+							result = true;
+							break;
+						}
 				}
+				break;
 			}
-		}
-		break;
-	case ET_ORComplex:
-		if(!mSubCondition.empty())
-		{
-			for(std::vector<Trainer::Condition>::iterator it = mSubCondition.begin();
-					it != mSubCondition.end(); it++)
+			if(ball.Dist(state.GetPlayer(ins.mArg2).GetPos()) > ins.mArg1)
 			{
-				if(it->CheckState(state))
-				{
-					return true;//有一个满足就满足
+				std::cout << "Trigger Ball to #" << ins.mArg2 << "Player's distance longer than " << ins.mArg1 << std::endl;
+				result = true;
+			}
+			break;
+		case ET_Ball2Playerlt://球到某人的距离小于某值
+			if(!ins.mArg2)
+			{
+				for(int i = 1; i <= TEAMSIZE; i++){
+					if(state.GetOpponent(i).IsAlive())
+						if(state.GetOpponent(i).GetPos().Dist(ball) < ins.mArg1)
+						{
+							std::cout << "Trigger Ball to #" << i << "Player's distance less than " << ins.mArg1 << std::endl;
+							result = true;
+							break;
+						}
 				}
+				break;
 			}
-		}
-		break;
-	case ET_Time://过x个周期自然终止
-		if(state.CurrentTime().T() - mpTrainer->GetLastStopTime() >= mArg1)
-		{
-			std::cout << "Trigger time longer than " << mArg1 << std::endl;
-			result = true;
-		}
-		break;
-	case ET_BallXbt://球的x坐标大于某值停止
-		if((state.GetBall().GetPos().X() > mArg1 && !mConverse) || (!state.GetBall().GetPos().X() > mArg1 && mConverse))
-		{
-			std::cout << "Trigger Ball's X larger than " << mArg1 << std::endl;
-			result = true;
-		}
-		break;
-	case ET_BallXlt://球的x坐标小于某值停止
-		if((state.GetBall().GetPos().X() < mArg1 && !mConverse) || (!state.GetBall().GetPos().X() < mArg1 && mConverse))
-		{
-			std::cout << "Trigger Ball's X less than " << mArg1 << std::endl;
-			result = true;
-		}
-		break;
-	case ET_BallYbt://球的y坐标。。
-		if((state.GetBall().GetPos().Y() > mArg1 && !mConverse) || (!state.GetBall().GetPos().Y() > mArg1 && mConverse))
-		{
-			std::cout << "Trigger Ball's Y larger than " << mArg1 << std::endl;
-			result = true;
-		}
-		break;
-	case ET_BallYlt://。。
-		if((state.GetBall().GetPos().Y() < mArg1 && !mConverse) || (!state.GetBall().GetPos().Y() < mArg1 && mConverse))
-		{
-			std::cout << "Trigger Ball's Y less than " << mArg1 << std::endl;
-			result = true;
-		}
-		break;
-	case ET_Ball2Playerbt://球到某人的距离大于某值
-		if(!mArg2)
-		{
-			for(int i = 1; i <= TEAMSIZE; i++){
-				if(state.GetOpponent(i).IsAlive())
-					if(state.GetOpponent(i).GetPos().Dist(state.GetBall().GetPos()) > mArg1)
-					{
-						std::cout << "Trigger Ball to #" << i << "Player's distance longer than " << mArg1 << std::endl;
-						result = true;
-						break;
-					}
+			if(ball.Dist(state.GetPlayer(ins.mArg2).GetPos()) < ins.mArg1)
+			{
+				std::cout << "Trigger Ball to #" << ins.mArg2 << "Player's distance less than " << ins.mArg1 << std::endl;
+				result = true;
 			}
 			break;
-		}
-		if(state.GetBall().GetPos().Dist(state.GetPlayer(mArg2).GetPos()) > mArg1)
-		{
-			std::cout << "Trigger Ball to #" << mArg2 << "Player's distance longer than " << mArg1 << std::endl;
-			result = true;
-		}
-		break;
-	case ET_Ball2Playerlt://球到某人的距离小于某值
-		if(!mArg2)
-		{
-			for(int i = 1; i <= TEAMSIZE; i++){
-				if(state.GetOpponent(i).IsAlive())
-					if(state.GetOpponent(i).GetPos().Dist(state.GetBall().GetPos()) < mArg1)
-					{
-						std::cout << "Trigger Ball to #" << i << "Player's distance less than " << mArg1 << std::endl;
-						result = true;
-						break;
-					}
+		case ET_NonPlayOn:
+			if(state.GetPlayMode() != PM_Play_On)
+			{
+				result = true;
+				std::cout << "Trigger NonPlayOn" << std::endl;
 			}
 			break;
+		default: break;
 		}
-		if(state.GetBall().GetPos().Dist(state.GetPlayer(mArg2).GetPos()) < mArg1)
-		{
-			std::cout << "Trigger Ball to #" << mArg2 << "Player's distance less than " << mArg1 << std::endl;
-			result = true;
-		}
-		break;
-	case ET_NonPlayOn:
-		if(state.GetPlayMode() != PM_Play_On)
-		{
-			result = true;
-			std::cout << "Trigger NonPlayOn" << std::endl;
-		}
-		break;
-	case ET_Null: break;
-	}
 
-	if(result) //满足终止条件了
-	{
-		int intervalCycle = state.CurrentTime().T() - mpTrainer->GetLastStopTime();
-		if(intervalCycle > mMaxInterval)
-		{
-			mMaxInterval = intervalCycle;
-			mMaxTime = state.CurrentTime().T();
-		}
-		if(intervalCycle < mMinInterval)
+		if(result) //满足终止条件了
 		{
-			mMinInterval = intervalCycle;
-			mMinTime = state.CurrentTime().T();
+			TrainStatistic & statistic = mEndStatistics[ins.mTarget];
+			if(intervalCycle > statistic.mMaxInterval)
+			{
+				statistic.mMaxInterval = intervalCycle;
+				statistic.mMaxTime = time;
+			}
+			if(intervalCycle < statistic.mMinInterval)
+			{
+				statistic.mMinInterval = intervalCycle;
+				statistic.mMinTime = time;
+			}
+			statistic.mCount ++;
 		}
-		mCount ++;
 	}
 
 	return result;
@@ -533,135 +557,42 @@ void Trainer::ReadConfigFile()
 
 bool Trainer::ReadRcgFile()
 {
-	//TODO 读取之前的PlayMode
-	string line;
-	const char * buf = 0;
-	ifstream fin( mTrainRcg );
-	int time = 0, n_read = 0;
+	RcgReader reader;
+	if (!reader.Open(mTrainRcg)) {
+		return false;
+	}
 
 	const int begin_time = mTrainTime - mInitialTime;
 	const int end_time = mTrainTime;
 
-	ServerPlayMode server_playmode = SPM_PlayOn;
+	if (!reader.Seek(begin_time)) { //没有找到对应周期
+		return false;
+	}
 
-	while (1) {
+	RcgFrame frame;
+	while (reader.Next(frame)) {
 		vector<PlayerState> ps;
 		pair<Vector, Vector> bs;
 
-		bool read = false;
+		bs.first = frame.mBallPos;
+		bs.second = frame.mBallVel;
+		bs.second /= 0.94;
+		bs.first -= bs.second; //这是因为Server接到后会模拟一周期
 
-		while (getline(fin, line))
-		{
-			read = true;
-			if(!line.compare(0, 5, "(show"))
-			{
-				if(sscanf( line.c_str(), "(show %d %n",&time, &n_read ) != 1)
-				{
-					PRINT_ERROR("error time info:" << line);
-					return false;
-				}
-
-				if(time >= begin_time) {
-					buf = line.c_str();
-					buf += n_read;
-					break;
-				}
-			}
-			else if ( line.compare( 0, 10, "(playmode " ) == 0 )
-			{
-				int time = 0;
-				char pm_string[32];
-
-				if ( std::sscanf( line.c_str(),
-						" (playmode %d %31[^)] ) ",
-						&time, pm_string ) != 2 )
-				{
-					std::cerr << "error: "
-							<< "Illegal playmode line. \"" << line << "\"" << std::endl;
-					return false;
-				}
-
-				server_playmode = ServerPlayModeMap::instance().GetServerPlayMode(pm_string);
-			}
-		}
-
-		if (!read) {
-			break;
-		}
-
-		mServerPlayModeList.push_back(server_playmode);
-
-		float bx,by,bvx,bvy;
-
-		if( buf == 0 ) //没有找到对应周期
-		{
-			return false;
-		}
-
-		{
-			if ( sscanf( buf, " ((b) %f %f %f %f) %n",
-					&bx, &by, &bvx, &bvy,
-					&n_read ) != 4 )
-			{
-				PRINT_ERROR( "error ball info:" << line);
-				return false;
-			}
-			buf += n_read;
-			bs.first= Vector (bx, by);
-			bs.second = Vector (bvx, bvy);
-			bs.second /= 0.94;
-			bs.first -= bs.second; //这是因为Server接到后会模拟一周期
-		}
-
-		// players
-		char side;
-		short unum;
-		short type;
-		int state;
-		float x, y, vx, vy, body, neck;
-		for ( int i = 0; i < ServerParam::TEAM_SIZE * 2; ++i )
-		{
-			if ( *buf == '\0' || *buf == ')' ) break;
-
-			if ( sscanf( buf,
-					" ((%c %hd) %hd %x %f %f %f %f %f %f %n",
-					&side, &unum,
-					&type, &state,
-					&x, &y, &vx, &vy, &body, &neck,
-					&n_read ) != 10 )
-			{
-				PRINT_ERROR( "error player info:" << buf);
-				return false;
-			}
-			buf += n_read;
-
-			int idx = unum - 1;
-			if ( side == 'r' ) idx += ServerParam::TEAM_SIZE;
-			if ( idx < 0 || ServerParam::TEAM_SIZE * 2 <= idx )
-			{
-				PRINT_ERROR( "error player info:" << buf);
-				return false;
-			}
-
-			if(side == 'r')
-				unum = -unum;
+		for (vector<RcgFrame::Player>::const_iterator it = frame.mPlayers.begin(); it != frame.mPlayers.end(); ++it) {
+			Unum unum = it->mSide == 'r'? -it->mUnum: it->mUnum;
 
 			//对球员的微调安排在开场前，而不是建立前，因为牵涉到Server发来的异构
-			ps.push_back(Trainer::PlayerState(unum, Vector(x,y) , Vector(vx, vy), body, type));
-
-			while(strncmp(buf, "((", 2))
-			{
-				buf++;
-				if ( *buf == '\0' ) break;
-			}
+			ps.push_back(Trainer::PlayerState(unum, it->mPos, it->mVel, it->mBodyDir, it->mPlayerType));
 		}
 
 		if (ps.size() == 22) {
 			mPlayerStatesList.push_back(ps);
 			mBallStateList.push_back(bs);
+			mServerPlayModeList.push_back(frame.mServerPlayMode);
 		}
 
-		if (time >= end_time) {
+		if (frame.mTime >= end_time) {
 			break;
 		}
 	}
@@ -709,8 +640,22 @@ void Trainer::Parse(const string & section, const vector<string> & content)
 	int playerType;
 	if (section == "Scene")
 	{
-		sscanf( content.at(0).c_str(), "%d %s", &mTrainTime, mTrainRcg);
-		mHaveRcg = ReadRcgFile();
+		for(vector<string>::const_iterator it = content.begin(); it != content.end(); it++)
+		{
+			unsigned int time;
+			char rcg[128];
+			if(sscanf( it->c_str(), "%u %127s", &time, rcg) == 2)
+			{
+				mSceneList.push_back(pair<unsigned int, string>(time, rcg));
+			}
+		}
+		if(!mSceneList.empty())
+		{
+			const pair<unsigned int, string> & scene = mSceneList[mBatchIndex % mSceneList.size()];
+			mTrainTime = scene.first;
+			strncpy(mTrainRcg, scene.second.c_str(), sizeof(mTrainRcg) - 1);
+			mHaveRcg = ReadRcgFile();
+		}
 	}
 	else if ( section == "NeedOpponent")
 	{
@@ -784,7 +729,7 @@ void Trainer::ParseCondition(const std::string & content)
 		switch(*it)
 		{
 		case '(':
-			nowCondition = nowCondition->AddSubCondition(Condition(this, ET_Null, 0, 0, nowCondition, mConverse));
+			nowCondition = nowCondition->AddSubCondition(Condition(ET_Null, 0, 0, nowCondition, mConverse));
 			break;
 		case ')':
 			buffer[n] = 0;
@@ -799,7 +744,7 @@ void Trainer::ParseCondition(const std::string & content)
 			if(nowCondition->GetConditionType() == ET_ORComplex)
 			{
 				Trainer::Condition * tmp;
-				nowCondition->SetSuperCondition(new Trainer::Condition(this, ET_ANDComplex,0,0,0, mConverse));
+				nowCondition->SetSuperCondition(new Trainer::Condition(ET_ANDComplex,0,0,0, mConverse));
 				tmp = nowCondition->GetSuperCondition();
 				if(nowCondition == mpEndCondition)
 				{
@@ -822,7 +767,7 @@ void Trainer::ParseCondition(const std::string & content)
 			if(nowCondition->GetConditionType() == ET_ANDComplex) //如果发生冲突，降一级
 			{
 				Trainer::Condition * tmp;
-				nowCondition->SetSuperCondition(new Trainer::Condition(this, ET_ANDComplex,0,0,0, mConverse));
+				nowCondition->SetSuperCondition(new Trainer::Condition(ET_ANDComplex,0,0,0, mConverse));
 				tmp = nowCondition->GetSuperCondition();
 				if(nowCondition == mpEndCondition)
 				{
@@ -865,6 +810,10 @@ void Trainer::ParseCondition(const std::string & content)
 		AddCondition(nowCondition, name, buffer);
 	}
 	mpEndCondition->OptimizeConditionTree();
+
+	mEndProgram.clear();
+	mEndStatistics.clear();
+	mpEndCondition->Compile(mEndProgram, mEndStatistics);
 }
 
 void Trainer::AddCondition(Trainer::Condition * superCondition, const char* name, const char* buffer)
@@ -922,9 +871,9 @@ void Trainer::AddCondition(Trainer::Condition * superCondition, const char* name
 	if(type != ET_Null)
 	{
 		if(type == ET_Ball2Playerbt || type == ET_Ball2Playerlt)
-			superCondition->AddSubCondition(Trainer::Condition(this, type, arg, keyPlayer, superCondition, mConverse));
+			superCondition->AddSubCondition(Trainer::Condition(type, arg, keyPlayer, superCondition, mConverse));
 		else
-			superCondition->AddSubCondition(Trainer::Condition(this, type, arg, 0, superCondition, mConverse));
+			superCondition->AddSubCondition(Trainer::Condition(type, arg, 0, superCondition, mConverse));
 	}
 	else if(strcmp(name, "KeyPlayer"))
 	{
@@ -932,18 +881,47 @@ void Trainer::AddCondition(Trainer::Condition * superCondition, const char* name
 	}
 }
 
-void Trainer::Condition::Report(ofstream  & os) const
+void Trainer::Condition::Compile(std::vector<Trainer::ConditionInstruction> & program, std::vector<TrainStatistic> & statistics) const
 {
-	char name[32];
+	Trainer::ConditionInstruction ins;
+	ins.mType = mType;
+	ins.mArg1 = mArg1;
+	ins.mArg2 = mArg2;
+	ins.mConverse = mConverse;
+	ins.mTarget = 0;
+
+	char name[64];
 	switch (mType){
 	case ET_ANDComplex:
-	case ET_ORComplex://复合条件仅记录子条件
-		for(vector<Trainer::Condition>::const_iterator it = mSubCondition.begin(); it != mSubCondition.end(); it++)
+	case ET_ORComplex://复合条件：依次检测子条件，结果确定后跳到最后
+		if(mSubCondition.empty())
 		{
-			it->Report(os);
+			ins.mOpCode = ConditionInstruction::OP_False;
+			program.push_back(ins);
 		}
-		break;
-	case ET_Null: return;
+		else
+		{
+			std::vector<int> jumps;
+			for(vector<Trainer::Condition>::const_iterator it = mSubCondition.begin(); it != mSubCondition.end(); it++)
+			{
+				if(it != mSubCondition.begin())
+				{
+					ins.mOpCode = mType == ET_ANDComplex ? ConditionInstruction::OP_JumpIfFalse : ConditionInstruction::OP_JumpIfTrue;
+					jumps.push_back(program.size());
+					program.push_back(ins);
+				}
+				it->Compile(program, statistics);
+			}
+			for(vector<int>::const_iterator it = jumps.begin(); it != jumps.end(); it++)
+			{
+				program[*it].mTarget = program.size();
+			}
+		}
+		return;
+	case ET_Null:
+		ins.mOpCode = ConditionInstruction::OP_False;
+		program.push_back(ins);
+		return;
 	case ET_Time://过x个周期自然终止
 		sprintf(name,"After %4.0f Cycle Stop", mArg1);
 		break;
@@ -969,22 +947,212 @@ void Trainer::Condition::Report(ofstream  & os) const
 		sprintf(name,"NonPlayOn");
 		break;
 	}
-	os << name << endl;
-	os << "Count:" << mCount << endl;
-	os << "MaxIntervalCycle:" << mMaxInterval << "\t Time:" << mMaxTime << endl;
-	os << "MinIntervalCycle:" << mMinInterval << "\t Time:" << mMinTime << endl;
+
+	ins.mOpCode = ConditionInstruction::OP_Check;
+	ins.mTarget = statistics.size();
+	program.push_back(ins);
+
+	TrainStatistic statistic;
+	statistic.mName = name;
+	statistic.mCount = 0;
+	statistic.mMaxInterval = 0;
+	statistic.mMaxTime = 0;
+	statistic.mMinInterval = 6000;
+	statistic.mMinTime = 0;
+	statistics.push_back(statistic);
+}
+
+void TrainStatistic::Merge(const TrainStatistic & other)
+{
+	mCount += other.mCount;
+	if(other.mMaxInterval > mMaxInterval)
+	{
+		mMaxInterval = other.mMaxInterval;
+		mMaxTime = other.mMaxTime;
+	}
+	if(other.mMinInterval < mMinInterval)
+	{
+		mMinInterval = other.mMinInterval;
+		mMinTime = other.mMinTime;
+	}
+}
+
+void Trainer::WriteReport(ofstream & os, const std::vector<TrainStatistic> & statistics)
+{
+	for(vector<TrainStatistic>::const_iterator it = statistics.begin(); it != statistics.end(); it++)
+	{
+		os << it->mName << endl;
+		os << "Count:" << it->mCount << endl;
+		os << "MaxIntervalCycle:" << it->mMaxInterval << "\t Time:" << it->mMaxTime << endl;
+		os << "MinIntervalCycle:" << it->mMinInterval << "\t Time:" << it->mMinTime << endl;
+	}
 }
 
 void Trainer::Record()
 {
 	//记录统计信息
+	const std::vector<TrainStatistic> & statistics = mEndStatistics;
+
+#ifndef WIN32
+	if(mBatchPipe >= 0) //批量训练时交给父进程汇总
+	{
+		FILE *file = fdopen(mBatchPipe, "w");
+		mBatchPipe = -1;
+		if(file == 0)
+		{
+			PRINT_ERROR("cannot report to batch trainer");
+			return;
+		}
+		fprintf(file, "%u %d %u %s\n", mTrainCount, mConverse? 1: 0, mTrainTime, mTrainRcg[0]? mTrainRcg: "-");
+		for(vector<TrainStatistic>::const_iterator it = statistics.begin(); it != statistics.end(); it++)
+		{
+			fprintf(file, "%d %d %d %d %d %s\n", it->mCount, it->mMaxInterval, it->mMaxTime, it->mMinInterval, it->mMinTime, it->mName.c_str());
+		}
+		fclose(file);
+		return;
+	}
+#endif
+
 	ofstream os;
 	os.open("./train/train.report");
 	if(mConverse)
 		os << "Converse Train!!" << endl;
 	os << "Total Train Count:" << mTrainCount << endl;
-	mpEndCondition->Report(os);
+	WriteReport(os, statistics);
+	os.close();
+}
+
+bool Trainer::RunBatch()
+{
+	std::vector<int> ports;
+	std::string port_list = PlayerParam::instance().TrainPorts();
+	std::replace(port_list.begin(), port_list.end(), ',', ' ');
+	stringstream sin(port_list);
+	int port;
+	while(sin >> port)
+	{
+		ports.push_back(port);
+	}
+
+	if(ports.empty())
+	{
+		return false;
+	}
+
+#ifdef WIN32
+	PRINT_ERROR("batch training is not supported on windows");
+	return false;
+#else
+	std::vector<pid_t> children;
+	std::vector<int> pipes;
+
+	std::cout.flush();
+	std::cerr.flush();
+
+	for(unsigned int i = 0; i < ports.size(); i++)
+	{
+		int fd[2];
+		if(pipe(fd) != 0)
+		{
+			PRINT_ERROR("pipe error");
+			break;
+		}
+
+		pid_t pid = fork();
+		if(pid == 0) //子进程作为普通的Trainer连接第i个server
+		{
+			close(fd[0]);
+			for(vector<int>::const_iterator it = pipes.begin(); it != pipes.end(); it++)
+			{
+				close(*it);
+			}
+			ServerParam::instance().setOfflineCoachPort(ports[i]);
+			mBatchIndex = i;
+			mBatchPipe = fd[1];
+			return false;
+		}
+
+		close(fd[1]);
+		if(pid < 0)
+		{
+			PRINT_ERROR("fork error");
+			close(fd[0]);
+			break;
+		}
+		children.push_back(pid);
+		pipes.push_back(fd[0]);
+	}
+
+	std::cerr << "#" << PlayerParam::instance().teamName() << " Trainer: batch of " << children.size() << " servers started" << std::endl;
+
+	unsigned int total_count = 0;
+	bool converse = false;
+	std::vector<TrainStatistic> statistics;
+	std::vector<std::string> servers;
+
+	for(unsigned int i = 0; i < pipes.size(); i++)
+	{
+		FILE *file = fdopen(pipes[i], "r");
+		char line[512];
+		unsigned int count, time;
+		int is_converse;
+		char rcg[128];
+
+		if(fgets(line, sizeof(line), file) && sscanf(line, "%u %d %u %127s", &count, &is_converse, &time, rcg) == 4)
+		{
+			total_count += count;
+			converse = converse || is_converse;
+			sprintf(line, "Port %d Scene %u %s Train Count:%u", ports[i], time, rcg, count);
+			servers.push_back(line);
+
+			for(unsigned int k = 0; fgets(line, sizeof(line), file); k++)
+			{
+				TrainStatistic statistic;
+				int n = 0;
+				if(sscanf(line, "%d %d %d %d %d %n", &statistic.mCount, &statistic.mMaxInterval, &statistic.mMaxTime,
+						&statistic.mMinInterval, &statistic.mMinTime, &n) < 5 || n == 0)
+				{
+					break;
+				}
+				statistic.mName = std::string(line + n);
+				statistic.mName.erase(statistic.mName.find_last_not_of("\r\n") + 1);
+
+				if(k < statistics.size())
+				{
+					statistics[k].Merge(statistic); //各进程的终止条件相同，顺序一致
+				}
+				else
+				{
+					statistics.push_back(statistic);
+				}
+			}
+		}
+		else
+		{
+			PRINT_ERROR("no train report from port " << ports[i]);
+		}
+		fclose(file);
+	}
+
+	for(vector<pid_t>::const_iterator it = children.begin(); it != children.end(); it++)
+	{
+		waitpid(*it, 0, 0);
+	}
+
+	ofstream os;
+	os.open("./train/train.report");
+	if(converse)
+		os << "Converse Train!!" << endl;
+	os << "Total Train Count:" << total_count << endl;
+	for(vector<string>::const_iterator it = servers.begin(); it != servers.end(); it++)
+	{
+		os << *it << endl;
+	}
+	WriteReport(os, statistics);
 	os.close();
+
+	return true;
+#endif
 }
 
 bool Trainer::CheckOpponent() const
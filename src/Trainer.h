@@ -42,6 +42,21 @@
 
 using namespace std;
 
+/**
+ * 一个终止条件的统计，批量训练时由各个训练进程汇总到父进程
+ */
+struct TrainStatistic
+{
+	std::string mName;
+	int mCount; //该条件出现次数
+	int mMaxInterval;//满足该终止条件最长时间
+	int mMaxTime;//满足该终止条件最长时间开始一次训练时的周期
+	int mMinInterval;//满足该终止条件最短时间
+	int mMinTime;//满足该终止条件最短时间开始一次训练时的周期
+
+	void Merge(const TrainStatistic & other);
+};
+
 class Trainer: public Client
 {
 
@@ -70,20 +85,36 @@ class Trainer: public Client
 		ET_ORComplex//复合或条件，满足一个即可
 	};
 
+	/**
+	 * 编译后的终止条件。条件树按短路求值的顺序展开成一条指令序列，每周期从头到尾执行一遍，
+	 * 不需要递归：叶子条件的结果放在一个累加器中，复合条件用条件跳转实现短路
+	 */
+	struct ConditionInstruction
+	{
+		enum OpCode
+		{
+			OP_Check, //检测一个叶子条件，结果放入累加器
+			OP_False, //累加器置为false（空条件）
+			OP_JumpIfTrue, //或条件：已经满足时跳过其余子条件
+			OP_JumpIfFalse //与条件：已经不满足时跳过其余子条件
+		};
+
+		OpCode mOpCode;
+		Trainer::ConditionType mType;
+		double mArg1;
+		double mArg2;
+		bool mConverse; //场景对调时按对称的坐标检测
+		int mTarget; //跳转的目标，OP_Check时为统计的序号
+	};
+
 	struct Condition
 	{
-		Condition(Trainer * trainer, Trainer::ConditionType type, double arg1, double arg2, Trainer::Condition * pSuper, bool converse)
+		Condition(Trainer::ConditionType type, double arg1, double arg2, Trainer::Condition * pSuper, bool converse)
 		{
-			mpTrainer = trainer;
 			mType = type;
 			mArg1 = arg1;
 			mArg2 = arg2;
 			mpSuperCondition = pSuper;
-			mMaxInterval = 0;
-			mMinInterval = 6000;
-			mMinTime = 0;
-			mMaxTime = 0;
-			mCount = 0;
 			mConverse = converse;
 		}
 
@@ -96,8 +127,11 @@ class Trainer: public Client
 		std::vector<Trainer::Condition> & GetSubConditions() {return mSubCondition;}
 		Trainer::Condition * AddSubCondition(Trainer::Condition sub) { sub.SetSuperCondition( this ); mSubCondition.push_back(sub); return &(mSubCondition.back());}
 		void OptimizeConditionTree(); //对之前产生的条件树进行优化，删掉所有的空条件
-		bool CheckState(const WorldState & state);
-		void Report(ofstream & os) const;
+
+		/**
+		 * 把条件树编译成指令序列，每个叶子条件对应一条统计
+		 */
+		void Compile(std::vector<Trainer::ConditionInstruction> & program, std::vector<TrainStatistic> & statistics) const;
 
 	private:
 		Trainer::ConditionType mType; //终止条件类型
@@ -105,12 +139,6 @@ class Trainer: public Client
 		double mArg2;//终止参数二
 		std::vector<Trainer::Condition> mSubCondition;
 		Trainer::Condition * mpSuperCondition;
-		Trainer * mpTrainer;
-		int mMaxInterval;//满足该终止条件最长时间
-		int mMinInterval;//满足该终止条件最短时间
-		int mMinTime;//满足该终止条件最短时间开始一次训练时的周期
-		int mMaxTime;//满足该终止条件最长时间开始一次训练时的周期
-		int mCount; //该条件出现次数
 		bool mConverse;
 	};
 
@@ -123,7 +151,14 @@ public:
 
 	void Run();
 	void SendOptionToServer();
-	int GetLastStopTime() { return mLastStopTime;}
+
+	/**
+	 * 批量训练：train_ports中的每个server由一个子进程训练，各自训练train_episodes次后结束，
+	 * 子进程按顺序选择[Scene]中的场景，统计结果通过管道汇总到父进程写入train.report。
+	 * 必须在构造Trainer之前调用（连接server的端口在构造时确定）
+	 * @return 父进程返回true，之后直接退出；没有配置批量训练或者在子进程中返回false，继续正常训练
+	 */
+	static bool RunBatch();
 
 private:
 	void DoDecisionMaking();
@@ -132,7 +167,9 @@ private:
 	void ReadConfigFile();
 	void Parse(const std::string & section, const std::vector<std::string> & content);
 	void ParseCondition(const std::string & content);
+	bool CheckEndCondition(const WorldState & state);
 	void Record();
+	static void WriteReport(ofstream & os, const std::vector<TrainStatistic> & statistics);
 	void ReadConverseConf(const std::string & str); //场景对调，这个可以试试看能不能找到一些新方法
 	void AddCondition(Trainer::Condition * superCondition, const char * name, const char * buffer);
 	void InitializeStadium();
@@ -166,20 +203,27 @@ private:
 	bool mPrepared;
 	bool mHaveRcg;
 	bool mConverse;
+	bool mFinished; //已经训练了train_episodes次
 	int mTm2Opp[12]; //解决对手和我们相同号码不同角色的问题
 	int mOpp2Tm[12]; //和上面那个刚好是倒过来的，一个用于自己变对手，一个用于
 	PlayMode mTrainPM;
 	unsigned int mTrainTime;	//训练场景所在rcg的时间
 	unsigned int mTrainCount; //总共训练次数
 	char mTrainRcg[128];
+	vector<pair<unsigned int, string> > mSceneList; //[Scene]中的所有场景，训练其中第mBatchIndex个
 	vector<vector<Trainer::PlayerState> > mPlayerStatesList;
 	unsigned int mInitialTime;
 	vector<Unum> mNeedOpponentList;
 	Trainer::Condition * mpEndCondition;
+	vector<Trainer::ConditionInstruction> mEndProgram; //编译后的mpEndCondition
+	vector<TrainStatistic> mEndStatistics; //各个叶子条件的统计，和mEndProgram中的OP_Check对应
 	vector<pair<Vector, Vector> > mBallStateList;
 	vector<ServerPlayMode> mServerPlayModeList;
 	ServerPlayMode mCurrentServerPlayMode;
 	unsigned int mLastStopTime;
+
+	static int mBatchIndex; //批量训练时本进程的序号，非批量训练时为0
+	static int mBatchPipe; //批量训练时向父进程汇报统计的管道，非批量训练时为-1
 };
 
 #endif /* TRAINER_H_ */
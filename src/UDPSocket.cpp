@@ -114,7 +114,7 @@ void UDPSocket::Initial(const char *host, int port)
 
 
 //==============================================================================
-int UDPSocket::Receive(char *msg)
+int UDPSocket::Receive(char *msg, bool wait)
 {
 #ifdef WIN32
 	int servlen;
@@ -124,7 +124,13 @@ int UDPSocket::Receive(char *msg)
 
 	sockaddr_in serv_addr;
 	servlen = sizeof(serv_addr);
-	int n = recvfrom(mSockfd, msg, MAX_MESSAGE, 0, (sockaddr *)&serv_addr, &servlen);
+#ifdef WIN32
+	int flags = 0;
+	(void) wait;
+#else
+	int flags = wait? 0: MSG_DONTWAIT;
+#endif
+	int n = recvfrom(mSockfd, msg, MAX_MESSAGE, flags, (sockaddr *)&serv_addr, &servlen);
 	if (n > 0)
 	{
 		msg[n] = '\0' ; // rccparser will crash if msg has no end
@@ -60,9 +60,19 @@ public:
     static UDPSocket & instance();
     void Initial(const char *host, int port);
 
-    int Receive(char *msg) ;
+    /**
+     * 接收一条消息
+     * @param wait 为false时没有消息立即返回（非Windows平台）
+     */
+    int Receive(char *msg, bool wait = true) ;
     int Send(const char *msg);
 
+#ifdef WIN32
+    SOCKET GetSocket() const { return mSockfd; }
+#else
+    int GetSocket() const { return mSockfd; }
+#endif
+
 private:
     bool        mIsInitialOK;
     sockaddr_in mAddress;
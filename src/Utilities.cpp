@@ -177,6 +177,10 @@ ServerPlayModeMap & ServerPlayModeMap::instance() {
 }
 
 ServerPlayModeMap::ServerPlayModeMap() {
+	for (int i = 0; i < HASH_TABLE_SIZE; ++i) {
+		mHashTable[i] = SPM_Null;
+	}
+
 	Bind("before_kick_off", SPM_BeforeKickOff);
 	Bind("time_over", SPM_TimeOver);
 	Bind("play_on", SPM_PlayOn);
@@ -241,27 +245,35 @@ ServerPlayModeMap::ServerPlayModeMap() {
 	Bind("time_up", SPM_TimeUp);
 	Bind("time_extended", SPM_TimeExtended);
 
-	Assert(mString2Enum.size() == SPM_MAX - 1);
+	for (int i = SPM_Null + 1; i < SPM_MAX; ++i) {
+		Assert(!mEnum2String[i].empty());
+	}
 }
 
-void ServerPlayModeMap::Bind(const std::string & str, ServerPlayMode spm) {
-	Assert(mString2Enum.count(str) == 0);
-	Assert(mEnum2String.count(spm) == 0);
+void ServerPlayModeMap::Bind(const char *str, ServerPlayMode spm) {
+	unsigned slot = HashSlot(str);
 
-	mString2Enum[str] = spm;
+	if (mHashTable[slot] != SPM_Null) {
+		PRINT_ERROR("server playmode hash collision: " << str << " and " << mEnum2String[mHashTable[slot]]);
+	}
+	Assert(mEnum2String[spm].empty());
+
+	mHashTable[slot] = spm;
 	mEnum2String[spm] = str;
 }
 
-ServerPlayMode ServerPlayModeMap::GetServerPlayMode(const std::string & str) {
+ServerPlayMode ServerPlayModeMap::GetServerPlayMode(const char *str) {
 	//special case: server 发过来的是 goal_[lr]_[[:digit:]]
-	if (strncmp(str.c_str(), "goal_l", strlen("goal_l")) == 0) {
-		return mString2Enum["goal_l"];
+	if (strncmp(str, "goal_l", 6) == 0) {
+		return SPM_AfterGoal_Left;
 	}
-	else if (strncmp(str.c_str(), "goal_r", strlen("goal_r")) == 0) {
-		return mString2Enum["goal_r"];
+	else if (strncmp(str, "goal_r", 6) == 0) {
+		return SPM_AfterGoal_Right;
 	}
-	else if (mString2Enum.count(str)) {
-		return mString2Enum[str];
+
+	ServerPlayMode spm = mHashTable[HashSlot(str)];
+	if (spm != SPM_Null && mEnum2String[spm] == str) {
+		return spm;
 	}
 	else {
 		Assert(!"server playmode error");
@@ -270,7 +282,7 @@ ServerPlayMode ServerPlayModeMap::GetServerPlayMode(const std::string & str) {
 }
 
 const char * ServerPlayModeMap::GetPlayModeString(ServerPlayMode spm) {
-	if (mEnum2String.count(spm)) {
+	if (spm > SPM_Null && spm < SPM_MAX) {
 		return mEnum2String[spm].c_str();
 	}
 	else {
@@ -513,14 +513,91 @@ private:
  * bellow is parse utilities
  */
 namespace parser {
+/**
+ * 快速解析十进制浮点数，用法同strtod。
+ * 有效数字不超过15位且指数绝对值不超过22时（server发来的数几乎都是这种情况），
+ * 整数尾数和10的幂都能精确表示，一次乘除得到的就是正确舍入的结果，与strtod完全一致；
+ * 其他情况交给strtod处理。
+ * Fast decimal parsing with the same result as strtod. Short mantissas with small exponents
+ * are exact in double, so one multiplication or division rounds correctly; others fall back to strtod.
+ */
+inline double fast_strtod(char *str, char **end_ptr){
+	static const double pow10[] = {
+			1.0e0, 1.0e1, 1.0e2, 1.0e3, 1.0e4, 1.0e5, 1.0e6, 1.0e7, 1.0e8, 1.0e9, 1.0e10, 1.0e11,
+			1.0e12, 1.0e13, 1.0e14, 1.0e15, 1.0e16, 1.0e17, 1.0e18, 1.0e19, 1.0e20, 1.0e21, 1.0e22
+	};
+
+	char *p = str;
+	bool negative = false;
+	if (*p == '-' || *p == '+') {
+		negative = (*p == '-');
+		++p;
+	}
+
+	long long mantissa = 0;
+	int digits = 0; // 有效数字位数
+	int exponent = 0;
+	bool has_digit = false;
+
+	for (; *p >= '0' && *p <= '9'; ++p) {
+		has_digit = true;
+		if (mantissa != 0 || *p != '0') {
+			mantissa = mantissa * 10 + (*p - '0');
+			++digits;
+			if (digits > 15) break;
+		}
+	}
+	if (*p == '.' && digits <= 15) {
+		for (++p; *p >= '0' && *p <= '9'; ++p) {
+			has_digit = true;
+			--exponent;
+			if (mantissa != 0 || *p != '0') {
+				mantissa = mantissa * 10 + (*p - '0');
+				++digits;
+				if (digits > 15) break;
+			}
+		}
+	}
+	if (!has_digit || digits > 15) {
+		return strtod(str, end_ptr);
+	}
+	if (*p == 'e' || *p == 'E') {
+		char *e = p + 1;
+		bool exp_negative = false;
+		if (*e == '-' || *e == '+') {
+			exp_negative = (*e == '-');
+			++e;
+		}
+		if (*e < '0' || *e > '9') {
+			return strtod(str, end_ptr);
+		}
+		int exp = 0;
+		for (; *e >= '0' && *e <= '9' && exp < 1000; ++e) {
+			exp = exp * 10 + (*e - '0');
+		}
+		exponent += exp_negative? -exp: exp;
+		p = e;
+	}
+	if (exponent < -22 || exponent > 22 || (*p >= '0' && *p <= '9') || *p == 'x' || *p == 'X') {
+		return strtod(str, end_ptr);
+	}
+
+	double value = static_cast<double>(mantissa);
+	value = (exponent < 0)? value / pow10[-exponent]: value * pow10[exponent];
+	if (end_ptr) {
+		*end_ptr = p;
+	}
+	return negative? -value: value;
+}
+
 inline double get_double(char **str_ptr){
 	while (!isdigit(**str_ptr) && **str_ptr != '-' && **str_ptr != '+' && **str_ptr != '.' && **str_ptr) (*str_ptr)++;
-	return strtod(*str_ptr, str_ptr);
+	return fast_strtod(*str_ptr, str_ptr);
 }
 
 inline double get_double(char *str){
 	while (!isdigit(*str) && *str != '-' && *str != '+' && *str != '.' && *str) str++;
-	return strtod(str, (char **) 0);
+	return fast_strtod(str, (char **) 0);
 }
 
 inline int get_int(char **str_ptr){
@@ -542,6 +619,20 @@ inline char * get_next_word(char **str_ptr){
 	while ( isalpha(**str_ptr) ) (*str_ptr)++;
 	return get_word(str_ptr);
 }
+
+/**
+ * 名字的乘法散列，读到end_char或字符串结束为止。
+ * 对固定的名字集合选好乘数和表大小后就是完美散列（没有冲突），查表后只需再比较一次字符串，
+ * 见ServerPlayModeMap和Parser::ParseMarker。
+ * Multiplicative hash of a name up to end_char; with a tuned multiplier it is collision free for a fixed name set.
+ */
+inline unsigned hash_name(const char *str, unsigned multiplier, char end_char = '\0'){
+	unsigned hash = 0;
+	while (*str != end_char && *str) {
+		hash = hash * multiplier + static_cast<unsigned char>(*str++);
+	}
+	return hash;
+}
 }
 
 namespace sight {
@@ -634,16 +725,27 @@ private:
 class ServerPlayModeMap {
 public:
 	static ServerPlayModeMap & instance();
-	ServerPlayMode GetServerPlayMode(const std::string & str);
+	ServerPlayMode GetServerPlayMode(const char *str);
+	ServerPlayMode GetServerPlayMode(const std::string & str) { return GetServerPlayMode(str.c_str()); }
 	const char * GetPlayModeString(ServerPlayMode spm);
 
 private:
 	ServerPlayModeMap();
-	void Bind(const std::string & str, ServerPlayMode spm);
+	void Bind(const char *str, ServerPlayMode spm);
+
+	/**
+	 * 所有play mode的名字在这个乘数和表大小下没有冲突，增加新的play mode时如果冲突需要重新选乘数
+	 */
+	static unsigned HashSlot(const char *str) { return parser::hash_name(str, HASH_MULTIPLIER) & (HASH_TABLE_SIZE - 1); }
+
+	enum {
+		HASH_MULTIPLIER = 41,
+		HASH_TABLE_SIZE = 512
+	};
 
 private:
-	std::map<std::string, ServerPlayMode> mString2Enum;
-	std::map<ServerPlayMode, std::string> mEnum2String;
+	ServerPlayMode mHashTable[HASH_TABLE_SIZE];
+	std::string mEnum2String[SPM_MAX];
 };
 
 
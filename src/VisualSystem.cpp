@@ -40,6 +40,7 @@
 #include "Agent.h"
 #include "BehaviorShoot.h"
 #include "Logger.h"
+#include "Tracer.h"
 
 VisualSystem::VisualSystem()
 {
@@ -110,6 +111,8 @@ void VisualSystem::ResetVisualRequest()
 
 void VisualSystem::Decision()
 {
+	TRACE_SPAN(TS_VisualDecision);
+
 	if (mpAgent->GetActionEffector().IsTurnNeck()) return; //其他地方已经产生了转脖子动作
 	if (mForbidden) return;
 
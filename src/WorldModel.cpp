@@ -34,13 +34,18 @@
 #include "Observer.h"
 #include "WorldState.h"
 #include "InfoState.h"
+#include "Tracer.h"
 
 WorldModel::WorldModel() {
 	mpHistoryState[0] = new HistoryState;
 	mpWorldState[0] = new WorldState(mpHistoryState[0]); //队友的世界状态
 
-	mpHistoryState[1] = new HistoryState;
+	mpHistoryState[1] = new HistoryState(mpHistoryState[0]); //对手视角的历史，用到时由己方的历史反算
 	mpWorldState[1] = new WorldState(mpHistoryState[1]); //供反算时用的，对手的世界状态
+
+	mIsReverseUpdated = false;
+	mReverseCount = 0;
+	mUpdateCount = 0;
 }
 
 WorldModel::~WorldModel() {
@@ -53,21 +58,40 @@ WorldModel::~WorldModel() {
 
 void WorldModel::Update(Observer *observer)
 {
+	TRACE_SPAN(TS_WorldUpdate);
+
 	//存储一下当前的世界
-	mpHistoryState[0]->UpdateHistory(*mpWorldState[0]);
-	mpHistoryState[1]->UpdateHistory(*mpWorldState[1]);
+	mpHistoryState[0]->UpdateHistory(*mpWorldState[0]); //对手视角的历史不用记录，见HistoryState
 
 	mpWorldState[0]->UpdateFromObserver(observer); //自己方决策使用的世界状态
-	mpWorldState[1]->GetReverseFrom(mpWorldState[0]); //可供反算对手时使用的世界状态
+	mIsReverseUpdated = false; //可供反算对手时使用的世界状态，用到时再反算
+	++mUpdateCount;
+}
+
+void WorldModel::UpdateReverse() const
+{
+	if (!mIsReverseUpdated) {
+		mpWorldState[1]->GetReverseFrom(mpWorldState[0]);
+		mIsReverseUpdated = true;
+		++mReverseCount;
+	}
 }
 
 const WorldState & WorldModel::GetWorldState(bool reverse) const
 {
-	return *(reverse? mpWorldState[1]: mpWorldState[0]);
+	if (reverse) {
+		UpdateReverse();
+		return *mpWorldState[1];
+	}
+	return *mpWorldState[0];
 }
 
 WorldState & WorldModel::World(bool reverse)
 {
-	return *(reverse? mpWorldState[1]: mpWorldState[0]);
+	if (reverse) {
+		UpdateReverse();
+		return *mpWorldState[1];
+	}
+	return *mpWorldState[0];
 }
 
@@ -48,12 +48,29 @@ public:
 
 	void Update(Observer *observer);
 
+	/**
+	 * 对手的世界状态在每周期第一次被取用时才由队友的世界状态反算得到，
+	 * 所以反算对手的Agent应在当前周期创建（见Agent::CreateOpponentAgent）
+	 */
 	const WorldState & GetWorldState(bool reverse) const;
 	WorldState       & World(bool reverse);
 
+	/**
+	 * 对手的世界状态实际被反算的周期数和更新的总周期数，用来观察反算的使用频率
+	 */
+	int GetReverseCount() const { return mReverseCount; }
+	int GetUpdateCount() const { return mUpdateCount; }
+
+private:
+	void UpdateReverse() const;
+
 private:
 	WorldState *mpWorldState[2];
 	HistoryState *mpHistoryState[2];
+
+	mutable bool mIsReverseUpdated; // 本周期是否已经反算过对手的世界状态
+	mutable int mReverseCount;
+	int mUpdateCount;
 };
 
 #endif /* WORLDMODEL_H_ */
@@ -32,6 +32,8 @@
 
 #include <cstdlib>
 #include "WorldState.h"
+#include "Assignment.h"
+#include "Localization.h"
 #include "ActionEffector.h"
 #include "Formation.h"
 #include "Observer.h"
@@ -52,7 +54,8 @@ WorldState::WorldState(HistoryState* history_state):
 	mOpponentGoalieUnum( 0),
 	mTeammateScore( 0),
 	mOpponentScore( 0),
-	mIsCycleStopped( false)
+	mIsCycleStopped( false),
+	mIdentityHypothesisCount( 0)
 {
 	//为各个球员分配号码
 	for ( Unum i = 1; i <= TEAMSIZE; i++) {
@@ -1619,44 +1622,31 @@ bool WorldStateUpdater::ComputeSelfDir(double& angle)
 
 bool WorldStateUpdater::ComputeSelfPos(Vector &vec ,double& eps)
 {
-	//寻找最近的标志
-	int sample = FLAG_NONE; //最近标志的标示
-	double min = 2000.0;      //最近标志的距离 初始值应该不能比这个更小了吧！
+	//用看到的所有标志定位，只看到一个标志时与原来只用最近标志的结果相同
+	Localization localization;
+	const AngleDeg neck_dir = GetNeckGlobalDirFromSightDelay(mSightDelay);
 
 	for (int i = 0;i < FLAG_MAX;i++)
 	{
-		if (mpObserver->Marker((MarkerType)i).GetDir().time() == mpObserver->LatestSightTime())
+		const MarkerObserver & marker = mpObserver->Marker((MarkerType)i);
+		if (marker.GetDir().time() == mpObserver->LatestSightTime())
 		{
-			if (mpObserver->Marker((MarkerType)i).Dist() < min)
-			{
-				min = mpObserver->Marker((MarkerType)i).Dist();
-				sample = i;
-			}
+			localization.AddMarker(marker.GlobalPosition(), marker.Dist(), neck_dir + marker.Dir());
 		}
 	}
 
 	//没有看到的 则返回false
-	if (sample == FLAG_NONE)
+	if (!localization.Estimate(vec, eps))
 	{
 		return false;
 	}
 
-	//修正及计算eps
-	min = PlayerParam::instance().ConvertMarkDist(min);
-	eps = PlayerParam::instance().GetEpsInMark(min);
-
-	eps = calcEps(min , min+eps , 1);
-
 	if (GetSelf().GetBodyDirDelay() != mSightDelay)
 	{
 		//不去计算身体角度误差，没有更新认为其极不准
 		eps = 10000;
 	}
 
-	//计算公式见USTC_Material 第七章
-	//playerPos = flagPos – polar2vector(flagDist, neckGlobalAngle + flagDir)
-	vec = mpObserver->Marker((MarkerType)sample).GlobalPosition() - Polar2Vector(min , GetNeckGlobalDirFromSightDelay(mSightDelay) + mpObserver->Marker((MarkerType)sample).Dir());
-
 	return true;
 }
 
@@ -1739,12 +1729,15 @@ void WorldStateUpdater::UpdateUnknownPlayers()
 
 	////============================================更新不知道球员号码的==========================================================
 	bool Unknown[TEAMSIZE * 2][TEAMSIZE * 2 + 1]; //与未知球员接近的已知球员的队列.例如如果己方球员i与第j个未知球员可能相同 则Unknown[j][i] = true;  对每一行 0~TEAMSIZE-1为己方球员 其它为对方球员
-	int UnknownCount[TEAMSIZE * 2];               //标记未知球员可能的属于球员的个数
+	double UnknownCost[TEAMSIZE * 2][TEAMSIZE * 2 + 1]; //配对的代价：距离与最大可能距离之比
+	Vector UnknownPos[TEAMSIZE * 2];
+	double UnknownBuffer[TEAMSIZE * 2];
 
 	bool UnknownUpdate[TEAMSIZE*2];
 
+	ReviseIdentityHypotheses();
+
 	for (int i = 0; i < TEAMSIZE * 2; ++i){
-		UnknownCount[i] = 0;
 		UnknownUpdate[i] = false;
 		for (int j = 0; j < TEAMSIZE * 2 + 1; ++j){
 			Unknown[i][j] = false;
@@ -1768,13 +1761,15 @@ void WorldStateUpdater::UpdateUnknownPlayers()
 
 		//double disbuf = PlayerParam::instance().GetEpsInSight(mpObserver->UnknownPlayer(i).Dist()); // please look at line 3301 in MemPosition.C in WE2008a
 		double disbuf = 0.1 * mpObserver->UnknownPlayer(i).Dist() + 0.66;
+		UnknownPos[i] = pos;
+		UnknownBuffer[i] = disbuf;
 		if (mpObserver->UnknownPlayerBugInfo(i).mSide == mpObserver->UnknownPlayerBugInfo(i).mSupSide)
 		{
 			if (mpObserver->UnknownPlayerBugInfo(i).mLeastNum == mpObserver->UnknownPlayerBugInfo(i).mSupNum)
 			{
-				UnknownCount[i] = 1;
 				int index = mpObserver->UnknownPlayerBugInfo(i).mSide == self_side ?  mpObserver->UnknownPlayerBugInfo(i).mLeastNum : mpObserver->UnknownPlayerBugInfo(i).mLeastNum  + TEAMSIZE;
 				Unknown[i][index] = true;
+				UnknownCost[i][index] = 0.0; //号码已经确定
 				continue;
 			}
 
@@ -1789,9 +1784,9 @@ void WorldStateUpdater::UpdateUnknownPlayers()
 					if (player.GetPosDelay() != 0&& ComputePlayerMaySeeOrNot(player) && (pos - player.GetPos()).Mod() <= dist)
 					{
 						//可能成为的队员
-						UnknownCount[i]++;
 						int index = mpObserver->UnknownPlayerBugInfo(i).mSide == self_side ? j : j + TEAMSIZE;
 						Unknown[i][index] = true;
+						UnknownCost[i][index] = (pos - player.GetPos()).Mod() / dist;
 					}
 				}
 		}
@@ -1813,9 +1808,9 @@ void WorldStateUpdater::UpdateUnknownPlayers()
 					if (player.GetPosDelay() != 0&& ComputePlayerMaySeeOrNot(player) && (pos - player.GetPos()).Mod() <= dist)
 					{
 						//可能成为的队员
-						UnknownCount[i]++;
 						int index = mpObserver->UnknownPlayerBugInfo(i).mSide == self_side ? j : j + TEAMSIZE;
 						Unknown[i][index] = true;
+						UnknownCost[i][index] = (pos - player.GetPos()).Mod() / dist;
 					}
 			}
 
@@ -1830,241 +1825,99 @@ void WorldStateUpdater::UpdateUnknownPlayers()
 					if (player.GetPosDelay() != 0&& ComputePlayerMaySeeOrNot(player) && (pos - player.GetPos()).Mod() <= dist)
 					{
 						//可能成为的队员
-						UnknownCount[i]++;
 						int index = mpObserver->UnknownPlayerBugInfo(i).mSide == self_side ? j + TEAMSIZE : j;
 						Unknown[i][index] = true;
+						UnknownCost[i][index] = (pos - player.GetPos()).Mod() / dist;
 					}
 			}
 		}
 	}
 
-	//2.对所有未知球员oj，当oj 的匹配列表只有1 个元素时，把该元素对应的老球员pi 与oj 匹配，从O 集合移除oj，并通过pi 匹配列表查询到
-	//其它可能与其匹配的未知球员，将pi 从它们的匹配列表中移除。
-	for (int i = 0;i < player_num;i++)
+	//2.求总代价最小的指派：每个未知球员配一个匹配列表中的球员，或者不配（留给后面按最近的球员更新），
+	//  代价为距离与最大可能距离之比。同时求出代价次优的指派，代价相近时作为备选假设保留到之后的周期
+	std::vector<int> candidates; //出现在匹配列表中的球员，作为指派的列
+	int candidate_col[TEAMSIZE * 2 + 1];
+	for (int k = 1;k <= 2*TEAMSIZE;k++)
 	{
-		bool is_update = false; //判断有没有更新
-		for (int j = 0;j < player_num;j++)
+		candidate_col[k] = -1;
+		for (int i = 0;i < player_num;i++)
 		{
-			if (UnknownCount[j] == 1)
+			if (Unknown[i][k])
 			{
-				//更新
-				int k = 0;
-				for (k = 1;k <= 2*TEAMSIZE;k++)
-				{
-					//判断是否在已知
-					if (Unknown[j][k])
-					{
-						if (k <= TEAMSIZE)
-						{
-#ifdef __UNKNOWN_TEST
-test_num++;					//更新队友
-file << mpObserver->LatestSightTime() << "unknown guess teammate: " << k << std::endl;
-#endif
-							UpdateSpecificUnknownPlayer(mpObserver->UnknownPlayer(j) , k , true);
-						}
-						else
-						{
-#ifdef __UNKNOWN_TEST
-test_num++;							//更新对手
-file << mpObserver->LatestSightTime() << "unknown guess opponent: " << k - TEAMSIZE << std::endl;
-#endif
-							UpdateSpecificUnknownPlayer(mpObserver->UnknownPlayer(j) , k - TEAMSIZE , false);
-						}
-						UnknownUpdate[j] = true;
-						break;
-					}
-				}
+				candidate_col[k] = candidates.size();
+				candidates.push_back(k);
+				break;
+			}
+		}
+	}
 
-				//没有则继续
-				if (k > 2*TEAMSIZE )
-				{
-					UnknownCount[j] = 0;
-					std::cout << " error : 数组与值不相符!" << std::endl;
-					continue;
-				}
+	if (!candidates.empty())
+	{
+		static const double UNMATCHED_COST = 2.0; //大于任何可能的配对，只要有可能就配对
+		static const int HYPOTHESIS_COUNT = 2; //最优的和次优的指派
+		static const double HYPOTHESIS_MARGIN = 0.5; //次优指派的代价与最优的差距小于这个值时保留为备选
 
-				//从原有的数组中去除该配对
-				for (int m = 0;m < player_num;m++)
+		bool is_ambiguous = false; //有未知球员可能是多个球员时才需要备选的指派
+		Assignment assignment(player_num, candidates.size() + player_num);
+		for (int i = 0;i < player_num;i++)
+		{
+			int count = 0;
+			for (int k = 1;k <= 2*TEAMSIZE;k++)
+			{
+				if (Unknown[i][k])
 				{
-					if (Unknown[m][k])
-					{
-						Unknown[m][k] = false;
-						UnknownCount[m]--;
-					}
-/*
-					//利用server的bug，发回的号码是从大到小的顺序的
-					if (m < j)
-					{
-						int bound = TEAMSIZE;
-						if (k > TEAMSIZE)
-						{
-							bound = TEAMSIZE * 2;
-						}
-
-						for (int n = k + 1;n <= bound;n++)
-						{
-							if (Unknown[m][n])
-							{
-								Unknown[m][n] = false;
-								UnknownCount[m]--;
-							}
-						}
-					}
-					else if (m > j)
-					{
-						int bound = 1;
-						if ( k > TEAMSIZE)
-						{
-							bound = TEAMSIZE + 1;
-						}
-
-						for (int n = bound;n < k;n++)
-						{
-							if (Unknown[m][n])
-							{
-								Unknown[m][n] = false;
-								UnknownCount[m]--;
-							}
-						}
-					}*/
+					assignment.Cost(i, candidate_col[k]) = UnknownCost[i][k];
+					count++;
 				}
-				is_update = true;
-
 			}
+			assignment.Cost(i, candidates.size() + i) = UNMATCHED_COST;
+			is_ambiguous = is_ambiguous || count > 1;
 		}
 
-		//本周期没有更新 使用distance(pi,oj)最小的原则 保证更新一个 觉得不是太好 改进一下：个数最少中选最近的
-		if (!is_update)
+		std::vector<std::vector<int> > solutions;
+		std::vector<double> costs;
+		assignment.SolveKBest(is_ambiguous ? HYPOTHESIS_COUNT : 1, solutions, costs);
+
+		for (int i = 0;i < player_num;i++)
 		{
-			int min = 200 * TEAMSIZE;
-			int index = -1;
-			bool is_all_zero = true; //
-			for (int j = 0;j < player_num;j++)
+			const int col = solutions[0][i];
+			if (col < (int)candidates.size())
 			{
-				if (UnknownCount[j] > 0 && UnknownCount[j] < min)
-				{
-					min = UnknownCount[j];
-					index = j;
-				}
-
-				if (is_all_zero && UnknownCount[j] > 0)
-				{
-					is_all_zero = false;
-				}
+				const int k = candidates[col];
+#ifdef __UNKNOWN_TEST
+test_num++;
+file << mpObserver->LatestSightTime() << "unknown guess " << (k <= TEAMSIZE ? "teammate: " : "opponent: ") << (k <= TEAMSIZE ? k : k - TEAMSIZE) << std::endl;
+#endif
+				UpdateSpecificUnknownPlayer(mpObserver->UnknownPlayer(i) , k <= TEAMSIZE ? k : k - TEAMSIZE , k <= TEAMSIZE);
+				UnknownUpdate[i] = true;
 			}
+		}
 
-			//全为零表示更新完毕
-			if (is_all_zero)
+		for (unsigned h = 1;h < solutions.size();h++)
+		{
+			if (costs[h] - costs[0] > HYPOTHESIS_MARGIN)
 			{
 				break;
 			}
 
-			//寻找最近的更新
-			if (index != -1)
+			for (int i = 0;i < player_num && mpWorldState->mIdentityHypothesisCount < WorldState::MAX_IDENTITY_HYPOTHESES;i++)
 			{
-				//寻找最近的球员
-				Vector pos = Polar2Vector(PlayerParam::instance().ConvertSightDist(mpObserver->UnknownPlayer(index).Dist()) , GetNeckGlobalDirFromSightDelay(mSightDelay) + mpObserver->UnknownPlayer(index).Dir()) + GetSelf().GetPos();
-				double min_dist = 200000;
-				int min_index = -1;
-				for (int k = 1;k <= 2*TEAMSIZE;k++)
-				{
-					if (Unknown[index][k])
-					{
-						Vector compare_pos;
-						if (k <= TEAMSIZE)
-						{
-							compare_pos = GetTeammate(k).GetPos();
-						}
-						else
-						{
-							compare_pos = GetOpponent(k - TEAMSIZE).GetPos();
-						}
-
-						if ( (pos - compare_pos).Mod() < min_dist)
-						{
-							min_dist = (pos - compare_pos).Mod();
-							min_index = k;
-						}
-					}
-				}
-
-				if (min_index <= TEAMSIZE && min_index > 0)
+				const int col = solutions[0][i];
+				const int alt_col = solutions[h][i];
+				if (col != alt_col && col < (int)candidates.size() && alt_col < (int)candidates.size())
 				{
-#ifdef __UNKNOWN_TEST
-test_num++;					//更新队友
-file << mpObserver->LatestSightTime() << "unknown guess teammate: " << min_index << std::endl;
-#endif
-					UpdateSpecificUnknownPlayer(mpObserver->UnknownPlayer(index) , min_index , true);
-					UnknownUpdate[index] = true;
+					const int k = candidates[col];
+					const int alt_k = candidates[alt_col];
+					WorldState::IdentityHypothesis & hypothesis = mpWorldState->mIdentityHypotheses[mpWorldState->mIdentityHypothesisCount++];
+					hypothesis.mTime = mpObserver->LatestSightTime().T();
+					hypothesis.mX = UnknownPos[i].X();
+					hypothesis.mY = UnknownPos[i].Y();
+					hypothesis.mBuffer = UnknownBuffer[i];
+					hypothesis.mUnum = k <= TEAMSIZE ? k : -(k - TEAMSIZE);
+					hypothesis.mAltUnum = alt_k <= TEAMSIZE ? alt_k : -(alt_k - TEAMSIZE);
 				}
-				else if (min_index > TEAMSIZE && min_index <= TEAMSIZE * 2)
-				{
-#ifdef __UNKNOWN_TEST
-test_num++;					//更新对手
-file << mpObserver->LatestSightTime() << "unknown guess opponent: " << min_index - TEAMSIZE << std::endl;
-#endif
-					UpdateSpecificUnknownPlayer(mpObserver->UnknownPlayer(index) , min_index - TEAMSIZE , false);
-					UnknownUpdate[index] = true;
-				}
-				else if (min_index == -1) //此时应该没有队员了
-				{
-					UnknownCount[index] = 0;
-					continue;
-				}
-
-				//生成的count置为零
-				UnknownCount[index] = 0;
-
-				//从原有的数组中去除该配对
-				for (int m = 0;m < player_num;m++)
-				{
-					if (Unknown[m][min_index])
-					{
-						Unknown[m][min_index] = false;
-						UnknownCount[m]--;
-					}
-/*
-					//利用server的bug，发回的号码是从大到小的顺序的
-					if (m < index)
-					{
-						int bound = TEAMSIZE;
-						if (min_index > TEAMSIZE)
-						{
-							bound = TEAMSIZE * 2;
-						}
-
-						for (int n = min_index + 1;n <= bound;n++)
-						{
-							if (Unknown[m][n])
-							{
-								Unknown[m][n] = false;
-								UnknownCount[m]--;
-							}
-						}
-					}
-					else if (m > index)
-					{
-						int bound = 1;
-						if ( min_index > TEAMSIZE)
-						{
-							bound = TEAMSIZE + 1;
-						}
-
-						for (int n = bound;n < min_index;n++)
-						{
-							if (Unknown[m][n])
-							{
-								Unknown[m][n] = false;
-								UnknownCount[m]--;
-							}
-						}
-					}*/
-				}
-
-				is_update = true;
 			}
 		}
-
 	}
 
 	for (int i = 0;i < player_num;i++)
@@ -2153,6 +2006,47 @@ file << mpObserver->LatestSightTime() << "unknown guess opponent: " << min_index
 
 }
 
+void WorldStateUpdater::ReviseIdentityHypotheses()
+{
+	static const int HYPOTHESIS_CYCLES = 5; //备选指派保留的周期数
+
+	const int now = mpObserver->LatestSightTime().T();
+	int count = 0;
+
+	for (int i = 0;i < mpWorldState->mIdentityHypothesisCount;i++)
+	{
+		const WorldState::IdentityHypothesis & hypothesis = mpWorldState->mIdentityHypotheses[i];
+		const int elapsed = now - hypothesis.mTime;
+		if (elapsed <= 0 || elapsed > HYPOTHESIS_CYCLES)
+		{
+			continue; //过期
+		}
+
+		const PlayerState & player = mpWorldState->GetPlayer(hypothesis.mUnum);
+		if (player.GetPosDelay() != mSightDelay)
+		{
+			mpWorldState->mIdentityHypotheses[count++] = hypothesis; //本次没有看清它的号码，继续保留
+			continue;
+		}
+
+		const Vector pos(hypothesis.mX, hypothesis.mY);
+		const double max_dist = PlayerParam::instance().HeteroPlayer(player.GetPlayerType()).effectiveSpeedMax() * elapsed + hypothesis.mBuffer;
+		if (player.GetPos().Dist(pos) <= max_dist)
+		{
+			continue; //与最优指派一致
+		}
+
+		//那次看到的不可能是mUnum，改为备选的球员，除非之后已经看到过它
+		PlayerState & alt_player = hypothesis.mAltUnum > 0 ? Teammate(hypothesis.mAltUnum) : Opponent(-hypothesis.mAltUnum);
+		if (alt_player.GetPosDelay() > elapsed + mSightDelay)
+		{
+			alt_player.UpdatePos(pos, elapsed + mSightDelay, mPlayerConf);
+		}
+	}
+
+	mpWorldState->mIdentityHypothesisCount = count;
+}
+
 bool  WorldStateUpdater::UpdateMostSimilarPlayer(const Vector & pos ,int index)
 {
 	bool is_known_side = mpObserver->UnknownPlayer(index).IsKnownSide();
@@ -3232,7 +3126,10 @@ double WorldStateUpdater::ComputeTackleProb(const Unum & unum, bool foul)
 
 void HistoryState::UpdateHistory(const WorldState &world)
 {
+	Assert(mpReverseSource == 0); // 反算历史不需要记录
+
 	mNum = mNum % HISTORY_SIZE;
+	++mVersion[mNum];
 	mRecord[mNum++] = world;
 }
 
@@ -3240,6 +3137,20 @@ WorldState *HistoryState::GetHistory(int num)
 {
 	Assert(num > 0);
 
+	if (mpReverseSource != 0)
+	{
+		WorldState *source = mpReverseSource->GetHistory(num);
+		int index = source - &mpReverseSource->mRecord[0];
+
+		if (mVersion[index] != mpReverseSource->mVersion[index])
+		{
+			mRecord[index].GetReverseFrom(source);
+			mRecord[index].mpHistory = this;
+			mVersion[index] = mpReverseSource->mVersion[index];
+		}
+		return &mRecord[index];
+	}
+
 	num = num % HISTORY_SIZE;
 	num = (mNum + HISTORY_SIZE - num) % HISTORY_SIZE;
 
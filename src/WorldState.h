@@ -58,6 +58,7 @@ class BeliefState;
  */
 class WorldState {
     friend class WorldStateUpdater;
+    friend class HistoryState;
     WorldState(const WorldState &);
 
 public:
@@ -140,6 +141,27 @@ private:
 	int mOpponentScore;
 
 	bool mIsCycleStopped;
+
+	/**
+	 * 看不清号码的球员的备选指派（见WorldStateUpdater::UpdateUnknownPlayers）：第mTime周期在(mX, mY)看到的球员
+	 * 按最优指派认为是mUnum，按代价相近的次优指派则是mAltUnum，号码为负表示对手。
+	 * 只用基本类型，以便Array可以直接清零
+	 */
+	struct IdentityHypothesis
+	{
+		int mTime;
+		double mX, mY;
+		double mBuffer; //视觉误差
+		Unum mUnum;
+		Unum mAltUnum;
+	};
+
+	enum {
+		MAX_IDENTITY_HYPOTHESES = TEAMSIZE * 2
+	};
+
+	Array<IdentityHypothesis, MAX_IDENTITY_HYPOTHESES> mIdentityHypotheses;
+	int mIdentityHypothesisCount;
 };
 
 /**
@@ -237,6 +259,11 @@ private:
 
 	bool UpdateMostSimilarPlayer(const Vector & pos ,int index);
 
+	/**
+	 * 检查之前的备选指派：看清号码后发现最优指派不可能成立时，把那次看到的位置给备选的球员
+	 */
+	void ReviseIdentityHypotheses();
+
     /** 更新某一个特定的队员 */
     void UpdateSpecificPlayer(const PlayerObserver& player , Unum unum , bool is_teammate);
 
@@ -469,7 +496,11 @@ private:
 class HistoryState
 {
 public:
-    HistoryState(): mNum(0) {
+    /**
+     * @param reverse_source 不为空时，本历史是reverse_source的反算（对手视角）历史，
+     * 不单独记录，某个记录第一次被取用时才由reverse_source中对应的记录反算得到
+     */
+    HistoryState(HistoryState *reverse_source = 0): mNum(0), mpReverseSource(reverse_source) {
     }
 
     enum {
@@ -487,11 +518,17 @@ public:
     WorldState *GetHistory(int num);
 
 private:
-    /**记录StateWorld的数组*/
+    /**记录StateWorld的环形数组*/
     Array<WorldState, HISTORY_SIZE> mRecord;
 
+    /**每个记录被写入的次数，反算历史用它判断对应记录是否已经过期*/
+    Array<long, HISTORY_SIZE, true> mVersion;
+
     /**记录数组当前的置顶前一个空白*/
     int mNum;
+
+    /**反算历史的来源，为空表示自己记录历史*/
+    HistoryState *mpReverseSource;
 };
 
 #endif /* WORLDSTATE_H_ */
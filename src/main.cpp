@@ -97,6 +97,9 @@ int main(int argc, char* argv[])
 		client = new Coach;
 	}
 	else if (PlayerParam::instance().isTrainer()) {
+		if (Trainer::RunBatch()) {
+			return 0; // 批量训练的父进程只负责汇总统计
+		}
 		client = new Trainer;
 	}
 	else {
@@ -104,7 +107,21 @@ int main(int argc, char* argv[])
 	}
 
 	if (PlayerParam::instance().DynamicDebugMode()) {
-		client->RunDynamicDebug(); // 进入动态调试模式
+		if (PlayerParam::instance().DynamicDebugBenchmark().empty()) {
+			client->RunDynamicDebug(); // 进入动态调试模式
+		}
+		else {
+			client->RunDynamicDebugBenchmark(); // 回放记录的server信息，统计各阶段耗时
+		}
+	}
+	else if (PlayerParam::instance().KickerMode() == 1 && !PlayerParam::instance().KickerParamFile().empty()) {
+		client->RunKickerGenerator(); // 不连接server，离线计算kicker_value
+	}
+	else if (!PlayerParam::instance().NetTrainFile().empty()) {
+		client->RunNetTrainer(); // 不连接server，离线训练神经网络
+	}
+	else if (PlayerParam::instance().SimulatorMode()) {
+		client->RunSimulation(); // 进入离线比赛模拟模式
 	}
 	else {
 		client->RunNormal(); // 进入正常比赛模式
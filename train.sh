@@ -25,20 +25,21 @@ OPP_DIR="/home/test"
 SELF_DIR=`pwd`
 PLAYER_SEED=-1
 TRAIN_DIR="./train"
+SERVERS=1 # 同时训练的server数，第k个server使用PORT+3k开始的三个端口
+EPISODES=0 # 每个server的训练次数，0表示不限
 
-while getopts  "h:p:v:b:t:s:" flag; do
+while getopts  "h:p:v:b:t:s:n:e:" flag; do
     case "$flag" in
         p) PORT=$OPTARG;;
         v) VERSION=$OPTARG;;
         b) BINARY=$OPTARG;;
         t) TEAM_NAME=$OPTARG;;
-	s) PLAYER_SEED=$OPTARG
+	s) PLAYER_SEED=$OPTARG;;
+	n) SERVERS=$OPTARG;;
+	e) EPISODES=$OPTARG
     esac
 done
 
-COACH_PORT=`expr $PORT + 1`
-OLCOACH_PORT=`expr $PORT + 2`
-
 flag="false"
 while read myline  
 do  
@@ -63,21 +64,6 @@ do
 	fi
 done < $TRAIN_DIR/demo.rcg
 
-cd $TRAIN_DIR
-
-OPTIONS="$OPTIONS -server::port=$PORT"
-OPTIONS="$OPTIONS -server::coach_port=$COACH_PORT"
-OPTIONS="$OPTIONS -server::olcoach_port=$OLCOACH_PORT"
-OPTIONS="$OPTIONS -player::random_seed=$PLAYER_SEED -server::coach=true -server::coach_w_referee=true"
-
-rcssserver $OPTIONS &
-
-cd $SELF_DIR
-
-sleep 1
-
-rcssmonitor --server-host $HOST --server-port $PORT &
-
 if [ $VERSION = "Debug" ]; then
     ulimit -c unlimited
     make debug
@@ -89,36 +75,83 @@ CLIENT="./$VERSION/$BINARY"
 LOG_DIR="Logfiles"
 mkdir $LOG_DIR 2>/dev/null
 SLEEP_TIME=0.1
+TRAIN_PORTS=""
 
-N_PARAM="-team_name $TEAM_NAME -host $HOST -port $PORT -coach_port $COACH_PORT -olcoach_port $OLCOACH_PORT -log_dir $LOG_DIR"
-G_PARAM="$N_PARAM -goalie on"
-C_PARAM="$N_PARAM -coach on"
-T_PARAM="$N_PARAM -trainer on"
+k=0
+while [ $k -lt $SERVERS ]; do
+	SERVER_PORT=`expr $PORT + 3 \* $k`
+	COACH_PORT=`expr $SERVER_PORT + 1`
+	OLCOACH_PORT=`expr $SERVER_PORT + 2`
+	SERVER_LOG_DIR="./server_$SERVER_PORT"
 
-echo ">>>>>>>>>>>>>>>>>>>>>> $TEAM_NAME Goalie: 1"
-$CLIENT $G_PARAM &
-sleep 1
+	cd $TRAIN_DIR
+	mkdir $SERVER_LOG_DIR 2>/dev/null
 
-i=2
-while [ $i -le 11 ]; do
-	echo ">>>>>>>>>>>>>>>>>>>>>> $TEAM_NAME Player: $i"
-	$CLIENT $N_PARAM &
-	sleep $SLEEP_TIME
-	i=`expr $i + 1`
-done
+	OPTIONS="-server::port=$SERVER_PORT"
+	OPTIONS="$OPTIONS -server::coach_port=$COACH_PORT"
+	OPTIONS="$OPTIONS -server::olcoach_port=$OLCOACH_PORT"
+	OPTIONS="$OPTIONS -server::game_log_dir=$SERVER_LOG_DIR -server::text_log_dir=$SERVER_LOG_DIR"
+	OPTIONS="$OPTIONS -player::random_seed=$PLAYER_SEED -server::coach=true -server::coach_w_referee=true"
 
-sleep 1
-cd $OPP_DIR
-./start.sh >/dev/null &
-sleep 1
-cd $SELF_DIR
+	echo ">>>>>>>>>>>>>>>>>>>>>> Server: $SERVER_PORT"
+	rcssserver $OPTIONS &
+
+	cd $SELF_DIR
+
+	sleep 1
 
+	if [ $k -eq 0 ]; then
+		rcssmonitor --server-host $HOST --server-port $SERVER_PORT &
+	fi
+
+	CLIENT_LOG_DIR=$LOG_DIR
+	if [ $SERVERS -gt 1 ]; then
+		CLIENT_LOG_DIR="$LOG_DIR/$SERVER_PORT" # 各队的log文件同名，分开存放
+		mkdir $CLIENT_LOG_DIR 2>/dev/null
+	fi
+
+	N_PARAM="-team_name $TEAM_NAME -host $HOST -port $SERVER_PORT -coach_port $COACH_PORT -olcoach_port $OLCOACH_PORT -log_dir $CLIENT_LOG_DIR"
+	G_PARAM="$N_PARAM -goalie on"
+	C_PARAM="$N_PARAM -coach on"
+
+	echo ">>>>>>>>>>>>>>>>>>>>>> $TEAM_NAME Goalie: 1"
+	$CLIENT $G_PARAM &
+	sleep 1
+
+	i=2
+	while [ $i -le 11 ]; do
+		echo ">>>>>>>>>>>>>>>>>>>>>> $TEAM_NAME Player: $i"
+		$CLIENT $N_PARAM &
+		sleep $SLEEP_TIME
+		i=`expr $i + 1`
+	done
 
-echo ">>>>>>>>>>>>>>>>>>>>>> $TEAM_NAME Coach"
-$CLIENT $C_PARAM &
+	sleep 1
+	cd $OPP_DIR
+	./start.sh -h $HOST -p $SERVER_PORT >/dev/null &
+	sleep 1
+	cd $SELF_DIR
+
+	echo ">>>>>>>>>>>>>>>>>>>>>> $TEAM_NAME Coach"
+	$CLIENT $C_PARAM &
+
+	if [ -z "$TRAIN_PORTS" ]; then
+		TRAIN_PORTS="$OLCOACH_PORT"
+	else
+		TRAIN_PORTS="$TRAIN_PORTS,$OLCOACH_PORT"
+	fi
+
+	k=`expr $k + 1`
+done
 
 sleep 1
 
+# 一个trainer进程按train_ports为每个server分出一个子进程，最后汇总各server的统计
+T_PARAM="-team_name $TEAM_NAME -host $HOST -port $PORT -coach_port `expr $PORT + 1` -olcoach_port `expr $PORT + 2` -log_dir $LOG_DIR -trainer on -train_episodes $EPISODES"
+if [ $SERVERS -gt 1 ]; then
+	T_PARAM="$T_PARAM -train_ports $TRAIN_PORTS"
+fi
+
 echo ">>>>>>>>>>>>>>>>>>>>>> $TEAM_NAME Trainer"
 $CLIENT $T_PARAM &
 